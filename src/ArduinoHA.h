@@ -5,23 +5,39 @@
 #include "HAMqtt.h"
 #include "HAUtils.h"
 #include "device-types/HABinarySensor.h"
+#include "device-types/HABinarySensorBank.h"
 #include "device-types/HAButton.h"
 #include "device-types/HACamera.h"
 #include "device-types/HACover.h"
 #include "device-types/HADeviceTracker.h"
 #include "device-types/HADeviceTrigger.h"
+#include "device-types/HAEntityTable.h"
 #include "device-types/HALock.h"
 #include "device-types/HASensor.h"
+#include "device-types/HASensorAggregate.h"
 #include "device-types/HASensorFloat.h"
 #include "device-types/HASensorInteger.h"
 #include "device-types/HASwitch.h"
 #include "device-types/HATagScanner.h"
+#include "utils/HAGestureRecognizer.h"
+#include "transports/HAMqttTransport.h"
+#include "transports/HAPubSubClientTransport.h"
+#include "utils/HASessionStorage.h"
+#include "utils/HARtcSessionStorage.h"
 
 #ifdef ARDUINOHA_TEST
 #include "mocks/AUnitHelpers.h"
+#include "mocks/BrokerClientMock.h"
+#include "mocks/BrokerMock.h"
+#include "mocks/FileSessionStorageMock.h"
 #include "mocks/PubSubClientMock.h"
 #include "utils/HADictionary.h"
 #include "utils/HASerializer.h"
+#include "utils/HATopicAliases.h"
+#include "utils/HAInflightWindow.h"
+#include "utils/HAEventQueue.h"
+#include "utils/HASessionState.h"
+#include "utils/HAPayloadParser.h"
 #endif
 
 #endif
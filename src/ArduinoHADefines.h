@@ -9,6 +9,7 @@
 // #define EX_ARDUINOHA_COVER
 // #define EX_ARDUINOHA_DEVICE_TRACKER
 // #define EX_ARDUINOHA_DEVICE_TRIGGER
+// #define EX_ARDUINOHA_ENTITY_TABLE
 // #define EX_ARDUINOHA_LOCK
 // #define EX_ARDUINOHA_SENSOR
 // #define EX_ARDUINOHA_SWITCH
@@ -26,4 +27,11 @@
     #define ARDUINOHA_DEBUG_PRINTLN(x)
     #define ARDUINOHA_DEBUG_PRINT(x)
     #define ARDUINOHA_DEBUG_PRINTF(...)
-#endif
\ No newline at end of file
+#endif
+
+// Functions that may be called from the interrupt handlers need to be placed in RAM on ESP boards.
+#if defined(ESP8266) || defined(ESP32)
+    #define ARDUINOHA_ISR_ATTR IRAM_ATTR
+#else
+    #define ARDUINOHA_ISR_ATTR
+#endif
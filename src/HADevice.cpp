@@ -8,10 +8,12 @@
     _serializer(new HASerializer(nullptr, 5)), \
     _availabilityTopic(nullptr), \
     _sharedAvailability(false), \
-    _available(true) // device will be available by default
+    _available(true), /* device will be available by default */ \
+    _mqtt(nullptr)
 
 HADevice::HADevice() :
     _uniqueId(nullptr),
+    _uniqueIdLength(0),
     HADEVICE_INIT
 {
 
@@ -19,6 +21,7 @@ HADevice::HADevice() :
 
 HADevice::HADevice(const char* uniqueId) :
     _uniqueId(uniqueId),
+    _uniqueIdLength(uniqueId ? strlen(uniqueId) : 0),
     HADEVICE_INIT
 {
     _serializer->set(HADeviceIdentifiersProperty, _uniqueId);
@@ -26,6 +29,7 @@ HADevice::HADevice(const char* uniqueId) :
 
 HADevice::HADevice(const byte* uniqueId, const uint16_t length) :
     _uniqueId(HAUtils::byteArrayToStr(uniqueId, length)),
+    _uniqueIdLength(length * 2),
     HADEVICE_INIT
 {
     _serializer->set(HADeviceIdentifiersProperty, _uniqueId);
@@ -33,10 +37,14 @@ HADevice::HADevice(const byte* uniqueId, const uint16_t length) :
 
 HADevice::~HADevice()
 {
+    if (_mqtt) {
+        _mqtt->removeDevice(*this);
+    }
+
     delete _serializer;
 
     if (_availabilityTopic) {
-        delete _availabilityTopic;
+        delete[] _availabilityTopic;
     }
 }
 
@@ -47,6 +55,7 @@ bool HADevice::setUniqueId(const byte* uniqueId, const uint16_t length)
     }
 
     _uniqueId = HAUtils::byteArrayToStr(uniqueId, length);
+    _uniqueIdLength = length * 2;
     _serializer->set(HADeviceIdentifiersProperty, _uniqueId);
     return true;
 }
@@ -83,36 +92,66 @@ bool HADevice::enableSharedAvailability()
         return true; // already enabled
     }
 
+    if (!_uniqueId) {
+        return false;
+    }
+
+    _sharedAvailability = true;
+    if (!_mqtt) {
+        return true; // the topic is generated once the device is bound to the HAMqtt
+    }
+
+    return generateAvailabilityTopic();
+}
+
+void HADevice::bind(HAMqtt* mqtt)
+{
+    _mqtt = mqtt;
+
+    if (_mqtt && _sharedAvailability && !_availabilityTopic) {
+        generateAvailabilityTopic();
+    }
+}
+
+bool HADevice::generateAvailabilityTopic()
+{
+    const HAMqttContext* context = &_mqtt->getContext();
     const uint16_t topicLength = HASerializer::calculateDataTopicLength(
+        context,
         nullptr,
-        HAAvailabilityTopic
+        HAAvailabilityTopic,
+        this
     );
     if (topicLength == 0) {
+        _sharedAvailability = false;
         return false;
     }
 
     _availabilityTopic = new char[topicLength];
 
     if (HASerializer::generateDataTopic(
+        context,
         _availabilityTopic,
         nullptr,
-        HAAvailabilityTopic
+        HAAvailabilityTopic,
+        this
     ) > 0) {
-        _sharedAvailability = true;
         return true;
     }
 
+    delete[] _availabilityTopic;
+    _availabilityTopic = nullptr;
+    _sharedAvailability = false;
     return false;
 }
 
 void HADevice::enableLastWill()
 {
-    HAMqtt* mqtt = HAMqtt::instance();
-    if (!mqtt || !_availabilityTopic) {
+    if (!_mqtt || !_availabilityTopic) {
         return;
     }
 
-    mqtt->setLastWill(
+    _mqtt->setLastWill(
         _availabilityTopic,
         "offline",
         true
@@ -121,16 +160,19 @@ void HADevice::enableLastWill()
 
 void HADevice::publishAvailability()
 {
-    HAMqtt* mqtt = HAMqtt::instance();
-    if (!_availabilityTopic || !mqtt) {
+    if (!_availabilityTopic || !_mqtt) {
         return;
     }
 
     const char* payload = _available ? HAOnline : HAOffline;
-    const uint16_t length = strlen_P(payload);
-
-    if (mqtt->beginPublish(_availabilityTopic, length, true)) {
-        mqtt->writePayload_P(payload);
-        mqtt->endPublish();
+    const uint16_t length = _available
+        ? HADictionaryLength(HAOnline)
+        : HADictionaryLength(HAOffline);
+
+    // the availability is always published, because the broker might have
+    // published the last will while the device was sleeping
+    if (_mqtt->beginPublish(_availabilityTopic, length, true)) {
+        _mqtt->writePayload_P(payload);
+        _mqtt->endPublish();
     }
 }
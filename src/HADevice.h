@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 
+class HAMqtt;
 class HASerializer;
 
 /**
@@ -49,6 +50,12 @@ public:
     inline const char* getUniqueId() const
         { return _uniqueId; }
 
+    /**
+     * Returns length of the unique ID (precomputed when the ID is set).
+     */
+    inline uint16_t getUniqueIdLength() const
+        { return _uniqueIdLength; }
+
     /**
      * Returns the instance of the HASerializer used by the device.
      * This method is used by all entities to serialize device's representation.
@@ -123,6 +130,8 @@ public:
 
     /**
      * Enables the shared availability feature.
+     * If the device is not bound to the HAMqtt yet, the availability topic
+     * is generated when the device gets bound (see HADevice::mqtt).
      */
     bool enableSharedAvailability();
 
@@ -139,10 +148,20 @@ public:
      */
     void publishAvailability();
 
+    /**
+     * Returns the HAMqtt instance that owns the device or nullptr if the device is not bound yet.
+     * The device is bound by the HAMqtt's constructor or HAMqtt::addDevice method.
+     */
+    inline HAMqtt* mqtt() const
+        { return _mqtt; }
+
 private:
     /// The unique ID of the device. It can be a memory allocated by HADevice::setUniqueId method.
     const char* _uniqueId;
 
+    /// Length of the unique ID.
+    uint16_t _uniqueIdLength;
+
     /// JSON serializer of the HADevice class. It's allocated in the constructor.
     HASerializer* _serializer;
 
@@ -154,6 +173,23 @@ private:
 
     /// Specifies whether the device is available (online / offline).
     bool _available;
+
+    /// The HAMqtt instance that owns the device.
+    HAMqtt* _mqtt;
+
+    /**
+     * Binds the device to the given HAMqtt instance (nullptr unbinds it).
+     * It's called by the HAMqtt.
+     */
+    void bind(HAMqtt* mqtt);
+
+    /**
+     * Allocates and generates the shared availability topic using the bound HAMqtt's context.
+     * The shared availability is disabled if the topic cannot be generated.
+     */
+    bool generateAvailabilityTopic();
+
+    friend class HAMqtt;
 };
 
 #endif
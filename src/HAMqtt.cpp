@@ -1,21 +1,26 @@
 #include "HAMqtt.h"
-
-#ifndef ARDUINOHA_TEST
-#include <PubSubClient.h>
-#endif
-
 #include "HADevice.h"
+#include "HAUtils.h"
 #include "device-types/HABaseDeviceType.h"
 #include "mocks/PubSubClientMock.h"
+#include "transports/HAPubSubClientTransport.h"
+#include "utils/HADictionary.h"
+#include "utils/HASerializer.h"
+#include "utils/HATopicAliases.h"
+#include "utils/HAInflightWindow.h"
+#include "utils/HAEventQueue.h"
+#include "utils/HASessionState.h"
 
 #define HAMQTT_INIT \
     _device(device), \
     _messageCallback(nullptr), \
     _connectedCallback(nullptr), \
     _connectionFailedCallback(nullptr), \
+    _brokerSwitchedCallback(nullptr), \
+    _statesRestoredCallback(nullptr), \
+    _payloadCallback(nullptr), \
     _initialized(false), \
-    _discoveryPrefix(DefaultDiscoveryPrefix), \
-    _dataPrefix(DefaultDataPrefix), \
+    _context(this, &device, DefaultDiscoveryPrefix, DefaultDataPrefix), \
     _username(nullptr), \
     _password(nullptr), \
     _lastConnectionAttemptAt(0), \
@@ -24,55 +29,163 @@
     _devicesTypes(new HABaseDeviceType*[maxDevicesTypesNb]), \
     _lastWillTopic(nullptr), \
     _lastWillMessage(nullptr), \
-    _lastWillRetain(false)
+    _lastWillRetain(false), \
+    _topicAliases(nullptr), \
+    _pendingAlias(0), \
+    _inflightWindow(nullptr), \
+    _lastPacketId(0), \
+    _commandWildcard(false), \
+    _eventQueue(nullptr), \
+    _baseTopicEnabled(false), \
+    _payloadStats(), \
+    _devices(nullptr), \
+    _devicesNb(0), \
+    _maxDevicesNb(0), \
+    _brokers(nullptr), \
+    _brokersNb(0), \
+    _maxBrokersNb(0), \
+    _activeBroker(0), \
+    _failedAttemptsNb(0), \
+    _maxFailedAttemptsNb(0), \
+    _standby(nullptr), \
+    _ownsStandby(false), \
+    _standbyBroker(0), \
+    _lastStandbyAttemptAt(0), \
+    _lastOutgoingAt(0), \
+    _lastIncomingAt(0), \
+    _pingResponsePending(false), \
+    _sessionStorage(nullptr), \
+    _sessionState(nullptr), \
+    _configVersion(0), \
+    _hashingPayload(false), \
+    _payloadHash(0), \
+    _sessionRestored(false), \
+    _resumed(false), \
+    _resuming(false), \
+    _sweeping(false), \
+    _sweepStartedAt(0), \
+    _sweepDuration(0), \
+    _purgedConfigsNb(0), \
+    _restoringStates(false), \
+    _stateRestoreStartedAt(0), \
+    _stateRestoreTimeout(DefaultStateRestoreTimeout)
 
 static const char* DefaultDiscoveryPrefix = "homeassistant";
 static const char* DefaultDataPrefix = "aha";
+static const char* SingleLevelWildcard = "+";
 
 HAMqtt* HAMqtt::_instance = nullptr;
+HAMqtt* HAMqtt::_activeInstance = nullptr;
 
 void onMessageReceived(char* topic, uint8_t* payload, unsigned int length)
 {
-    if (HAMqtt::instance() == nullptr || length > UINT16_MAX) {
+    if (HAMqtt::active() == nullptr || length > UINT16_MAX) {
+        return;
+    }
+
+    HAMqtt::active()->processMessage(topic, payload, static_cast<uint16_t>(length));
+}
+
+void onPublishAcknowledged(uint16_t packetId)
+{
+    if (HAMqtt::active() == nullptr) {
         return;
     }
 
-    HAMqtt::instance()->processMessage(topic, payload, static_cast<uint16_t>(length));
+    HAMqtt::active()->processAck(packetId);
 }
 
 #ifdef ARDUINOHA_TEST
 HAMqtt::HAMqtt(
     PubSubClientMock* pubSub,
     HADevice& device,
-    uint8_t maxDevicesTypesNb
+    uint16_t maxDevicesTypesNb
 ) :
     _mqtt(pubSub),
+    _ownsTransport(true),
     HAMQTT_INIT
 {
     _instance = this;
+    _device.bind(this);
     memset(_devicesTypes, 0, sizeof(HABaseDeviceType*) * maxDevicesTypesNb);
 }
 #else
 HAMqtt::HAMqtt(
     Client& netClient,
     HADevice& device,
-    uint8_t maxDevicesTypesNb
+    uint16_t maxDevicesTypesNb
 ) :
-    _mqtt(new PubSubClient(netClient)),
+    _mqtt(new HAPubSubClientTransport(netClient)),
+    _ownsTransport(true),
     HAMQTT_INIT
 {
     _instance = this;
+    _device.bind(this);
     memset(_devicesTypes, 0, sizeof(HABaseDeviceType*) * maxDevicesTypesNb);
 }
 #endif
 
+HAMqtt::HAMqtt(
+    HAMqttTransport& transport,
+    HADevice& device,
+    uint16_t maxDevicesTypesNb
+) :
+    _mqtt(&transport),
+    _ownsTransport(false),
+    HAMQTT_INIT
+{
+    _instance = this;
+    _device.bind(this);
+    memset(_devicesTypes, 0, sizeof(HABaseDeviceType*) * maxDevicesTypesNb);
+}
+
 HAMqtt::~HAMqtt()
 {
-    if (_mqtt) {
+    if (_mqtt && _ownsTransport) {
         delete _mqtt;
     }
 
-    _instance = nullptr;
+    if (_topicAliases) {
+        delete _topicAliases;
+    }
+
+    if (_inflightWindow) {
+        delete _inflightWindow;
+    }
+
+    if (_eventQueue) {
+        delete _eventQueue;
+    }
+
+    if (_device.mqtt() == this) {
+        _device.bind(nullptr);
+    }
+
+    if (_devices) {
+        for (uint16_t i = 0; i < _devicesNb; i++) {
+            _devices[i]->bind(nullptr);
+        }
+
+        delete[] _devices;
+    }
+
+    if (_brokers) {
+        delete[] _brokers;
+    }
+
+    if (_sessionState) {
+        delete _sessionState;
+    }
+
+    delete[] _devicesTypes;
+
+    if (_standby && _ownsStandby) {
+        delete _standby;
+    }
+
+    if (_instance == this) {
+        _instance = nullptr;
+    }
 }
 
 bool HAMqtt::begin(
@@ -98,8 +211,10 @@ bool HAMqtt::begin(
     _password = password;
     _initialized = true;
 
+    setBroker(0, nullptr, serverIp, serverPort);
     _mqtt->setServer(serverIp, serverPort);
     _mqtt->setCallback(onMessageReceived);
+    _mqtt->setAckCallback(onPublishAcknowledged);
 
     return true;
 }
@@ -136,8 +251,10 @@ bool HAMqtt::begin(
     _password = password;
     _initialized = true;
 
+    setBroker(0, hostname, IPAddress(), serverPort);
     _mqtt->setServer(hostname, serverPort);
     _mqtt->setCallback(onMessageReceived);
+    _mqtt->setAckCallback(onPublishAcknowledged);
 
     return true;
 }
@@ -161,16 +278,36 @@ bool HAMqtt::disconnect()
 
     _initialized = false;
     _lastConnectionAttemptAt = 0;
+    _sweeping = false;
+    _restoringStates = false;
     _mqtt->disconnect();
 
+    if (_standby) {
+        _standby->disconnect();
+        _lastStandbyAttemptAt = 0;
+    }
+
     return true;
 }
 
 void HAMqtt::loop()
 {
-    if (_initialized && !_mqtt->loop()) {
+    _activeInstance = this;
+
+    if (_initialized && isConnected()) {
+        trackKeepAlive();
+    }
+
+    if (_initialized && !_mqtt->loop() && !promoteStandby()) {
         connectToServer();
     }
+
+    maintainStandby();
+    processStateRestore();
+    processSweep();
+
+    processEventQueue();
+    _activeInstance = nullptr;
 }
 
 bool HAMqtt::isConnected()
@@ -178,103 +315,1165 @@ bool HAMqtt::isConnected()
     return _mqtt->connected();
 }
 
-void HAMqtt::addDeviceType(HABaseDeviceType* deviceType)
+uint32_t HAMqtt::getIdleTimeout()
 {
-    if (_devicesTypesNb + 1 >= _maxDevicesTypesNb) {
-        return;
+    if (!_initialized) {
+        return NoIdleTimeout;
+    }
+
+    if (_eventQueue && !_eventQueue->isEmpty()) {
+        return 0;
+    }
+
+    const uint32_t now = HAUtils::now();
+    if (!isConnected()) {
+        return _lastConnectionAttemptAt > 0
+            ? remainingTime(now, _lastConnectionAttemptAt, ReconnectInterval)
+            : 0;
+    }
+
+    uint32_t timeout = NoIdleTimeout;
+    const uint32_t keepAlive = static_cast<uint32_t>(_mqtt->getKeepAlive()) * 1000;
+    if (keepAlive > 0) {
+        if (_pingResponsePending) {
+            // half of the interval is enough to receive the response
+            timeout = remainingTime(now, _lastOutgoingAt, keepAlive / 2);
+        } else {
+            const uint32_t lastActivityAt =
+                (now - _lastOutgoingAt) > (now - _lastIncomingAt)
+                ? _lastOutgoingAt
+                : _lastIncomingAt;
+
+            // the transport pings once the interval is exceeded
+            timeout = remainingTime(now, lastActivityAt, keepAlive + 1);
+        }
+    }
+
+    if (_standby && _brokersNb > 1 && !_standby->connected()) {
+        const uint32_t standbyTimeout = _lastStandbyAttemptAt > 0
+            ? remainingTime(now, _lastStandbyAttemptAt, ReconnectInterval)
+            : 0;
+
+        if (standbyTimeout < timeout) {
+            timeout = standbyTimeout;
+        }
+    }
+
+    if (_restoringStates) {
+        const uint32_t restoreTimeout = remainingTime(
+            now,
+            _stateRestoreStartedAt,
+            _stateRestoreTimeout
+        );
+        if (restoreTimeout < timeout) {
+            timeout = restoreTimeout;
+        }
+    }
+
+    if (_sweeping) {
+        const uint32_t sweepTimeout = remainingTime(now, _sweepStartedAt, _sweepDuration);
+        if (sweepTimeout < timeout) {
+            timeout = sweepTimeout;
+        }
+    }
+
+    return timeout;
+}
+
+bool HAMqtt::addDeviceType(HABaseDeviceType* deviceType)
+{
+    if (deviceType->mqtt() == this) {
+        return true; // already added
+    }
+
+    if (_devicesTypesNb >= _maxDevicesTypesNb) {
+        ARDUINOHA_DEBUG_PRINTLN("AHA: too many device types");
+        return false;
     }
 
+    deviceType->unbind();
+    deviceType->_mqtt = this;
     _devicesTypes[_devicesTypesNb++] = deviceType;
+    return true;
 }
 
-bool HAMqtt::beginPublish(
-    const char* topic,
-    uint16_t payloadLength,
-    bool retained
+bool HAMqtt::removeDeviceType(HABaseDeviceType* deviceType, const bool purge)
+{
+    if (!deviceType || deviceType->mqtt() != this) {
+        return false;
+    }
+
+    if (purge) {
+        if (!isConnected() || !deviceType->unpublishConfig()) {
+            return false;
+        }
+    }
+
+    deviceType->unbind(); // it calls HAMqtt::detachDeviceType
+    return true;
+}
+
+bool HAMqtt::detachDeviceType(HABaseDeviceType* deviceType)
+{
+    uint16_t index = 0;
+    while (index < _devicesTypesNb && _devicesTypes[index] != deviceType) {
+        index++;
+    }
+
+    if (index == _devicesTypesNb) {
+        return false;
+    }
+
+    // the order of the device types is preserved
+    for (uint16_t i = index + 1; i < _devicesTypesNb; i++) {
+        _devicesTypes[i - 1] = _devicesTypes[i];
+    }
+
+    _devicesTypes[--_devicesTypesNb] = nullptr;
+    return true;
+}
+
+bool HAMqtt::purgeConfig(
+    const char* component,
+    const char* objectId,
+    const HADevice* device
 )
 {
-    ARDUINOHA_DEBUG_PRINTF("AHA: being publish %s, len: %d\n", topic, payloadLength);
+    const uint16_t topicLength = _context.calculateConfigTopicLength(
+        component,
+        objectId,
+        device
+    );
+    if (topicLength == 0) {
+        return false;
+    }
 
-    return _mqtt->beginPublish(topic, payloadLength, retained);
+    char topic[topicLength];
+    if (!_context.generateConfigTopic(topic, component, objectId, device)) {
+        return false;
+    }
+
+    ARDUINOHA_DEBUG_PRINTF("AHA: purging config %s\n", topic);
+
+    // empty retained message removes the retained config from the broker
+    return beginPublish(topic, 0, true) && endPublish();
 }
 
-void HAMqtt::writePayload(const char* data, uint16_t length)
+bool HAMqtt::sweepOrphanedConfigs(const uint32_t duration)
 {
-    _mqtt->write((const uint8_t*)(data), length);
+    if (_sweeping || !_initialized || !isConnected()) {
+        return false;
+    }
+
+    _sweeping = true;
+    _sweepStartedAt = HAUtils::now();
+    _sweepDuration = duration;
+
+    subscribeConfigWildcard(&_device, true);
+    for (uint16_t i = 0; i < _devicesNb; i++) {
+        subscribeConfigWildcard(_devices[i], true);
+    }
+
+    return true;
 }
 
-void HAMqtt::writePayload_P(const char* src)
+bool HAMqtt::enableGatewayMode(const uint16_t maxDevicesNb)
 {
-    _mqtt->print((const __FlashStringHelper*)(src));
+    if (_devices || maxDevicesNb == 0) {
+        return false;
+    }
+
+    _devices = new HADevice*[maxDevicesNb];
+    _maxDevicesNb = maxDevicesNb;
+    return true;
 }
 
-bool HAMqtt::endPublish()
+bool HAMqtt::addDevice(HADevice& device)
+{
+    if (&device == &_device) {
+        return true;
+    }
+
+    if (!_devices) {
+        return false;
+    }
+
+    if (device.mqtt() == this) {
+        return true; // already registered
+    }
+
+    if (device.mqtt() || _devicesNb >= _maxDevicesNb) {
+        return false; // owned by another instance or the limit was reached
+    }
+
+    _devices[_devicesNb++] = &device;
+    device.bind(this);
+    return true;
+}
+
+bool HAMqtt::removeDevice(HADevice& device)
 {
-    return _mqtt->endPublish();
+    uint16_t index = 0;
+    while (index < _devicesNb && _devices[index] != &device) {
+        index++;
+    }
+
+    if (index == _devicesNb) {
+        return false;
+    }
+
+    // device types of the removed device must not fall back to the default one
+    uint16_t i = 0;
+    while (i < _devicesTypesNb) {
+        if (_devicesTypes[i]->_device == &device) {
+            _devicesTypes[i]->unbind(); // the device type is removed from the array
+        } else {
+            i++;
+        }
+    }
+
+    for (i = index + 1; i < _devicesNb; i++) {
+        _devices[i - 1] = _devices[i];
+    }
+
+    _devices[--_devicesNb] = nullptr;
+    device.bind(nullptr);
+    return true;
 }
 
-bool HAMqtt::subscribe(const char* topic)
+bool HAMqtt::enableFailover(
+    const uint8_t maxBrokersNb,
+    const uint8_t maxFailedAttemptsNb
+)
 {
-    ARDUINOHA_DEBUG_PRINTF("AHA: subscribing %s\n", topic);
+    if (_brokers || _initialized || maxBrokersNb < 2 || maxFailedAttemptsNb == 0) {
+        return false;
+    }
 
-    return _mqtt->subscribe(topic);
+    _brokers = new HAMqttBroker[maxBrokersNb];
+    _brokersNb = 1; // the first slot is reserved for the broker passed to the "begin" method
+    _maxBrokersNb = maxBrokersNb;
+    _maxFailedAttemptsNb = maxFailedAttemptsNb;
+    return true;
 }
 
-void HAMqtt::processMessage(const char* topic, const uint8_t* payload, uint16_t length)
+bool HAMqtt::addBroker(const char* hostname, const uint16_t port)
 {
-    ARDUINOHA_DEBUG_PRINTF("AHA: received call %s, len: %d\n", topic, length);
+    if (!_brokers || !hostname || _brokersNb >= _maxBrokersNb) {
+        return false;
+    }
 
-    if (_messageCallback) {
-        _messageCallback(topic, payload, length);
+    setBroker(_brokersNb++, hostname, IPAddress(), port);
+    return true;
+}
+
+bool HAMqtt::addBroker(const IPAddress ip, const uint16_t port)
+{
+    if (!_brokers || _brokersNb >= _maxBrokersNb) {
+        return false;
     }
 
-    for (uint8_t i = 0; i < _devicesTypesNb; i++) {
-        _devicesTypes[i]->onMqttMessage(topic, payload, length);
+    setBroker(_brokersNb++, nullptr, ip, port);
+    return true;
+}
+
+bool HAMqtt::setStandbyTransport(HAMqttTransport& transport)
+{
+    if (_standby || _initialized || &transport == _mqtt) {
+        return false;
     }
+
+    _standby = &transport;
+    _ownsStandby = false;
+    _standby->setCallback(onMessageReceived);
+    _standby->setAckCallback(onPublishAcknowledged);
+    return true;
 }
 
-void HAMqtt::connectToServer()
+bool HAMqtt::enableFastResume(
+    HASessionStorage& storage,
+    const uint8_t maxValuesNb,
+    const uint32_t configVersion
+)
 {
-    if (_lastConnectionAttemptAt > 0 &&
-            (millis() - _lastConnectionAttemptAt) < ReconnectInterval) {
-        return;
+    if (_sessionState || _initialized || maxValuesNb == 0) {
+        return false;
     }
 
-    _lastConnectionAttemptAt = millis();
-    ARDUINOHA_DEBUG_PRINTF("AHA: connecting, client ID %s\n", _device.getUniqueId());
+    _sessionStorage = &storage;
+    _sessionState = new HASessionState(maxValuesNb);
+    _configVersion = configVersion;
+    _sessionRestored = _sessionState->load(storage);
+    return true;
+}
 
-    _mqtt->connect(
-        _device.getUniqueId(),
-        _username,
-        _password,
-        _lastWillTopic,
-        0,
-        _lastWillRetain,
-        _lastWillMessage,
-        true
+bool HAMqtt::saveSession()
+{
+    if (!_sessionState) {
+        return false;
+    }
+
+    return _sessionState->save(*_sessionStorage);
+}
+
+bool HAMqtt::isPublished(
+    const char* topic,
+    const char* value,
+    const uint16_t length,
+    const bool isProgmemValue
+) const
+{
+    if (!_sessionState) {
+        return false;
+    }
+
+    return _sessionState->isUnchanged(
+        HASessionState::hash(HASessionState::HashSeed, topic, strlen(topic)),
+        HASessionState::hash(HASessionState::HashSeed, value, length, isProgmemValue)
     );
+}
 
-    if (isConnected()) {
-        ARDUINOHA_DEBUG_PRINTLN("AHA: connected");
-        onConnectedLogic();
-    } else {
-        ARDUINOHA_DEBUG_PRINTLN("AHA: failed to connect");
+void HAMqtt::markPublished(
+    const char* topic,
+    const char* value,
+    const uint16_t length,
+    const bool isProgmemValue
+)
+{
+    if (!_sessionState) {
+        return;
+    }
 
-        if (_connectionFailedCallback) {
-            _connectionFailedCallback();
-        }
+    _sessionState->set(
+        HASessionState::hash(HASessionState::HashSeed, topic, strlen(topic)),
+        HASessionState::hash(HASessionState::HashSeed, value, length, isProgmemValue)
+    );
+}
+
+void HAMqtt::beginStateRestore()
+{
+    if (_restoringStates) {
+        return;
     }
+
+    _restoringStates = true;
+    _stateRestoreStartedAt = HAUtils::now();
 }
 
-void HAMqtt::onConnectedLogic()
+bool HAMqtt::enableTopicAliases(const uint16_t maxAliasesNb)
 {
-    if (_connectedCallback) {
-        _connectedCallback();
+    if (
+        _topicAliases ||
+        maxAliasesNb == 0 ||
+        !_mqtt ||
+        !_mqtt->supportsTopicAliases()
+    ) {
+        return false;
     }
 
-    _device.publishAvailability();
+    _topicAliases = new HATopicAliases(maxAliasesNb);
+    return true;
+}
 
-    for (uint8_t i = 0; i < _devicesTypesNb; i++) {
-        _devicesTypes[i]->onMqttConnected();
+bool HAMqtt::enableInflightWindow(const uint8_t size)
+{
+    if (
+        _inflightWindow ||
+        size == 0 ||
+        !_mqtt ||
+        !_mqtt->supportsQos()
+    ) {
+        return false;
+    }
+
+    _inflightWindow = new HAInflightWindow(size);
+    return true;
+}
+
+bool HAMqtt::enableEventQueue(const uint8_t size)
+{
+    if (_eventQueue || size == 0) {
+        return false;
+    }
+
+    _eventQueue = new HAEventQueue(size);
+    return true;
+}
+
+ARDUINOHA_ISR_ATTR bool HAMqtt::queueEvent(
+    HABaseDeviceType* deviceType,
+    const uint8_t value
+)
+{
+    if (!_eventQueue || !deviceType) {
+        return false;
+    }
+
+    return _eventQueue->push(deviceType, value);
+}
+
+bool HAMqtt::publishReliably(
+    HABaseDeviceType* deviceType,
+    const char* topicP,
+    const char* topic,
+    const char* payload,
+    uint16_t length,
+    bool retained,
+    bool isProgmemPayload
+)
+{
+    if (!_inflightWindow || length > HAInflightMessage::MaxPayloadSize) {
+        if (!beginPublish(topic, length, retained, true)) {
+            return false;
+        }
+    } else {
+        if (_inflightWindow->isFull()) {
+            ARDUINOHA_DEBUG_PRINTF("AHA: in-flight window is full, topic: %s\n", topic);
+            return false;
+        }
+
+        const uint16_t packetId = nextPacketId();
+        ARDUINOHA_DEBUG_PRINTF("AHA: begin QoS 1 publish %s, id: %d\n", topic, packetId);
+
+        if (!_mqtt->beginPublish(topic, length, retained, 1, packetId, false)) {
+            return false;
+        }
+
+        HAInflightMessage* message = _inflightWindow->acquire(packetId);
+        message->deviceType = deviceType;
+        message->index = deviceType->getSelectedIndex();
+        message->topicP = topicP;
+        message->length = length;
+        message->retained = retained;
+
+        if (isProgmemPayload) {
+            memcpy_P(message->payload, payload, length);
+        } else {
+            memcpy(message->payload, payload, length);
+        }
+    }
+
+    if (isProgmemPayload) {
+        writePayload_P(payload);
+    } else {
+        writePayload(payload, length);
+    }
+
+    return endPublish();
+}
+
+void HAMqtt::processAck(uint16_t packetId)
+{
+    _lastIncomingAt = HAUtils::now();
+
+    if (_inflightWindow) {
+        _inflightWindow->release(packetId);
+    }
+}
+
+uint16_t HAMqtt::getMaxPacketSize() const
+{
+    return _mqtt ? _mqtt->getMaxPacketSize() : 0;
+}
+
+uint16_t HAMqtt::getMaxTopicLength() const
+{
+    return _mqtt ? _mqtt->getMaxTopicLength() : 0;
+}
+
+bool HAMqtt::fitsPacket(uint16_t topicLength, uint16_t payloadLength) const
+{
+    const uint16_t maxTopicLength = getMaxTopicLength();
+    if (maxTopicLength > 0 && topicLength > maxTopicLength) {
+        return false;
+    }
+
+    const uint16_t maxPacketSize = getMaxPacketSize();
+    return (
+        maxPacketSize == 0 ||
+        calculatePacketSize(topicLength, payloadLength) <= maxPacketSize
+    );
+}
+
+uint32_t HAMqtt::calculatePacketSize(uint16_t topicLength, uint16_t payloadLength)
+{
+    // variable header (topic length + topic) + payload
+    const uint32_t remainingLength =
+        2 + static_cast<uint32_t>(topicLength) + payloadLength;
+
+    // fixed header: control byte + remaining length (1-4 bytes)
+    uint32_t size = 1 + remainingLength;
+    uint32_t length = remainingLength;
+    do {
+        size++;
+        length /= 128;
+    } while (length > 0);
+
+    return size;
+}
+
+void HAMqtt::reportOversizePayload(
+    HABaseDeviceType* deviceType,
+    uint32_t packetSize,
+    bool published
+)
+{
+    ARDUINOHA_DEBUG_PRINTF("AHA: payload too large, size: %lu\n", (unsigned long)packetSize);
+
+    _payloadStats.oversizeNb++;
+    if (published) {
+        _payloadStats.degradedNb++;
+    } else {
+        _payloadStats.droppedNb++;
+    }
+
+    if (packetSize > _payloadStats.largestPacketSize) {
+        _payloadStats.largestPacketSize = packetSize;
+    }
+
+    if (_payloadCallback) {
+        _payloadCallback(deviceType, packetSize, published);
+    }
+}
+
+bool HAMqtt::beginPublish(
+    const char* topic,
+    uint16_t payloadLength,
+    bool retained,
+    bool useTopicAlias
+)
+{
+    ARDUINOHA_DEBUG_PRINTF("AHA: being publish %s, len: %d\n", topic, payloadLength);
+
+    if (getMaxPacketSize() > 0 || getMaxTopicLength() > 0) {
+        const uint16_t topicLength = strlen(topic);
+        if (!fitsPacket(topicLength, payloadLength)) {
+            reportOversizePayload(
+                nullptr,
+                calculatePacketSize(topicLength, payloadLength),
+                false
+            );
+            return false;
+        }
+    }
+
+    _pendingAlias = 0;
+
+    if (useTopicAlias && _topicAliases) {
+        uint16_t alias = _topicAliases->find(topic);
+        if (alias > 0) {
+            return _mqtt->beginPublish("", payloadLength, retained, alias);
+        }
+
+        alias = _topicAliases->assign(topic);
+        if (alias > 0) {
+            // the broker learns the alias only if the message is delivered
+            if (!_mqtt->beginPublish(topic, payloadLength, retained, alias)) {
+                _topicAliases->release(alias);
+                return false;
+            }
+
+            _pendingAlias = alias;
+            return true;
+        }
+    }
+
+    return _mqtt->beginPublish(topic, payloadLength, retained);
+}
+
+void HAMqtt::writePayload(const char* data, uint16_t length)
+{
+    if (_hashingPayload) {
+        _payloadHash = HASessionState::hash(_payloadHash, data, length);
+        return;
+    }
+
+    _mqtt->write((const uint8_t*)(data), length);
+}
+
+void HAMqtt::writePayload_P(const char* src)
+{
+    if (_hashingPayload) {
+        _payloadHash = HASessionState::hash(_payloadHash, src, strlen_P(src), true);
+        return;
+    }
+
+    _mqtt->write_P(src);
+}
+
+bool HAMqtt::endPublish()
+{
+    _lastOutgoingAt = HAUtils::now();
+
+    const bool result = _mqtt->endPublish();
+    if (!result && _pendingAlias > 0) {
+        _topicAliases->release(_pendingAlias);
+    }
+
+    _pendingAlias = 0;
+    return result;
+}
+
+bool HAMqtt::subscribe(const char* topic)
+{
+    ARDUINOHA_DEBUG_PRINTF("AHA: subscribing %s\n", topic);
+
+    _lastOutgoingAt = HAUtils::now();
+    return _mqtt->subscribe(topic);
+}
+
+bool HAMqtt::unsubscribe(const char* topic)
+{
+    ARDUINOHA_DEBUG_PRINTF("AHA: unsubscribing %s\n", topic);
+
+    _lastOutgoingAt = HAUtils::now();
+    return _mqtt->unsubscribe(topic);
+}
+
+void HAMqtt::processMessage(const char* topic, const uint8_t* payload, uint16_t length)
+{
+    ARDUINOHA_DEBUG_PRINTF("AHA: received call %s, len: %d\n", topic, length);
+
+    _lastIncomingAt = HAUtils::now();
+
+    if (_sweeping && sweepConfig(topic, length)) {
+        return;
+    }
+
+    if (_messageCallback) {
+        _messageCallback(topic, payload, length);
+    }
+
+    for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+        _devicesTypes[i]->onMqttMessage(topic, payload, length);
+    }
+}
+
+void HAMqtt::connectToServer()
+{
+    if (_lastConnectionAttemptAt > 0 &&
+            (HAUtils::now() - _lastConnectionAttemptAt) < ReconnectInterval) {
+        return;
+    }
+
+    _lastConnectionAttemptAt = HAUtils::now();
+    ARDUINOHA_DEBUG_PRINTF("AHA: connecting, client ID %s\n", _device.getUniqueId());
+
+    if (connectTransport(_mqtt)) {
+        ARDUINOHA_DEBUG_PRINTLN("AHA: connected");
+        _failedAttemptsNb = 0;
+        onConnectedLogic();
+    } else {
+        ARDUINOHA_DEBUG_PRINTLN("AHA: failed to connect");
+
+        if (_connectionFailedCallback) {
+            _connectionFailedCallback();
+        }
+
+        if (_brokersNb > 1 && ++_failedAttemptsNb >= _maxFailedAttemptsNb) {
+            switchBroker((_activeBroker + 1) % _brokersNb);
+        }
+    }
+}
+
+void HAMqtt::setBroker(
+    const uint8_t index,
+    const char* hostname,
+    const IPAddress ip,
+    const uint16_t port
+)
+{
+    if (!_brokers || index >= _maxBrokersNb) {
+        return;
+    }
+
+    _brokers[index].hostname = hostname;
+    _brokers[index].ip = ip;
+    _brokers[index].port = port;
+}
+
+void HAMqtt::applyBroker(HAMqttTransport* transport, const uint8_t index)
+{
+    const HAMqttBroker& broker = _brokers[index];
+    if (broker.hostname) {
+        transport->setServer(broker.hostname, broker.port);
+    } else {
+        transport->setServer(broker.ip, broker.port);
+    }
+}
+
+bool HAMqtt::connectTransport(HAMqttTransport* transport)
+{
+    transport->connect(
+        _device.getUniqueId(),
+        _username,
+        _password,
+        _lastWillTopic,
+        0,
+        _lastWillRetain,
+        _lastWillMessage,
+        _sessionState == nullptr // the fast resume uses a persistent session
+    );
+
+    return transport->connected();
+}
+
+void HAMqtt::switchBroker(const uint8_t index)
+{
+    ARDUINOHA_DEBUG_PRINTF("AHA: switching to broker %d\n", index);
+
+    if (_standby && _standbyBroker == index) {
+        _standby->disconnect(); // the standby can't be connected to the active broker
+    }
+
+    _activeBroker = index;
+    _failedAttemptsNb = 0;
+    _lastConnectionAttemptAt = 0; // try the new broker immediately
+    applyBroker(_mqtt, index);
+
+    if (_brokerSwitchedCallback) {
+        _brokerSwitchedCallback();
+    }
+}
+
+bool HAMqtt::promoteStandby()
+{
+    if (!_standby || !_standby->connected() || _standbyBroker == _activeBroker) {
+        return false;
+    }
+
+    ARDUINOHA_DEBUG_PRINTF("AHA: promoting standby, broker %d\n", _standbyBroker);
+
+    HAMqttTransport* transport = _mqtt;
+    const bool ownsTransport = _ownsTransport;
+    const uint8_t broker = _activeBroker;
+
+    _mqtt = _standby;
+    _ownsTransport = _ownsStandby;
+    _activeBroker = _standbyBroker;
+
+    _standby = transport;
+    _ownsStandby = ownsTransport;
+    _standbyBroker = broker;
+    _standby->disconnect();
+
+    _failedAttemptsNb = 0;
+    _lastConnectionAttemptAt = 0;
+    _lastStandbyAttemptAt = 0;
+
+    if (_brokerSwitchedCallback) {
+        _brokerSwitchedCallback();
+    }
+
+    onConnectedLogic();
+    return true;
+}
+
+void HAMqtt::maintainStandby()
+{
+    if (!_standby || !_initialized || _brokersNb < 2) {
+        return;
+    }
+
+    const uint8_t target = (_activeBroker + 1) % _brokersNb;
+    if (_standby->connected()) {
+        if (_standbyBroker == target) {
+            _standby->loop();
+            return;
+        }
+
+        _standby->disconnect(); // the active broker has changed
+    }
+
+    if (
+        _lastStandbyAttemptAt > 0 &&
+        (HAUtils::now() - _lastStandbyAttemptAt) < ReconnectInterval
+    ) {
+        return;
+    }
+
+    _lastStandbyAttemptAt = HAUtils::now();
+    _standbyBroker = target;
+    applyBroker(_standby, target);
+    connectTransport(_standby);
+}
+
+void HAMqtt::onConnectedLogic()
+{
+    _lastOutgoingAt = HAUtils::now();
+    _lastIncomingAt = _lastOutgoingAt;
+    _pingResponsePending = false;
+    _sweeping = false; // the subscription of the previous connection is gone
+    _restoringStates = false;
+
+    if (_sessionState) {
+        const uint32_t fingerprint = calculateFingerprint();
+        _resumed = _sessionRestored && _sessionState->getFingerprint() == fingerprint;
+        _sessionRestored = false; // only the first connection after the wake up can be resumed
+
+        if (!_resumed) {
+            _sessionState->clear();
+            _sessionState->setFingerprint(fingerprint);
+        }
+    }
+
+    _resuming = _resumed;
+
+    if (_topicAliases) {
+        _topicAliases->clear(); // aliases are valid within a single connection
+    }
+
+    if (_connectedCallback) {
+        _connectedCallback();
+    }
+
+    _device.publishAvailability();
+    for (uint16_t i = 0; i < _devicesNb; i++) {
+        _devices[i]->publishAvailability();
+    }
+
+    retransmitInflight();
+    subscribeCommandWildcard();
+
+    for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+        _devicesTypes[i]->onMqttConnected();
+    }
+
+    _resuming = false;
+}
+
+uint32_t HAMqtt::calculateFingerprint()
+{
+    uint32_t hash = HASessionState::hash(HASessionState::HashSeed, _configVersion);
+    hash = HASessionState::hash(
+        hash,
+        _device.getUniqueId(),
+        _device.getUniqueIdLength()
+    );
+    hash = HASessionState::hash(
+        hash,
+        _context.getDiscoveryPrefix(),
+        _context.getDiscoveryPrefixLength()
+    );
+    hash = HASessionState::hash(
+        hash,
+        _context.getDataPrefix(),
+        _context.getDataPrefixLength()
+    );
+
+    for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+        hash = _devicesTypes[i]->calculateFingerprint(hash);
+    }
+
+    return hash;
+}
+
+uint32_t HAMqtt::hashConfig(const HASerializer* serializer, uint32_t hash)
+{
+    _hashingPayload = true;
+    _payloadHash = hash;
+    serializer->flush(this);
+    _hashingPayload = false;
+
+    return _payloadHash;
+}
+
+uint16_t HAMqtt::nextPacketId()
+{
+    do {
+        _lastPacketId++;
+        if (_lastPacketId == 0) {
+            _lastPacketId = 1; // zero is not a valid packet ID
+        }
+    } while (_inflightWindow && _inflightWindow->contains(_lastPacketId));
+
+    return _lastPacketId;
+}
+
+void HAMqtt::retransmitInflight()
+{
+    if (!_inflightWindow) {
+        return;
+    }
+
+    // the order is preserved, so the broker doesn't end up with a stale retained state
+    for (
+        HAInflightMessage* message = _inflightWindow->next(nullptr);
+        message;
+        message = _inflightWindow->next(message)
+    ) {
+        message->deviceType->selectIndex(message->index);
+        const uint16_t topicLength = _context.calculateDataTopicLength(
+            message->deviceType->uniqueId(),
+            message->topicP,
+            message->deviceType->getDevice()
+        );
+        if (topicLength == 0) {
+            continue;
+        }
+
+        char topic[topicLength];
+        if (!_context.generateDataTopic(
+            topic,
+            message->deviceType->uniqueId(),
+            message->topicP,
+            message->deviceType->getDevice()
+        )) {
+            continue;
+        }
+
+        ARDUINOHA_DEBUG_PRINTF("AHA: retransmitting %s, id: %d\n", topic, message->packetId);
+
+        if (_mqtt->beginPublish(
+            topic,
+            message->length,
+            message->retained,
+            1,
+            message->packetId,
+            true
+        )) {
+            writePayload(message->payload, message->length);
+            endPublish();
+        }
+    }
+}
+
+bool HAMqtt::setCommandWildcard(bool enabled)
+{
+    if (_initialized) {
+        return false;
+    }
+
+    _commandWildcard = enabled;
+    return true;
+}
+
+void HAMqtt::subscribeCommandWildcard()
+{
+    if (!_commandWildcard) {
+        return;
+    }
+
+    subscribeCommandWildcard(&_device);
+    for (uint16_t i = 0; i < _devicesNb; i++) {
+        subscribeCommandWildcard(_devices[i]);
+    }
+}
+
+void HAMqtt::subscribeCommandWildcard(const HADevice* device)
+{
+    const uint16_t topicLength = _context.calculateDataTopicLength(
+        SingleLevelWildcard,
+        HACommandTopic,
+        device
+    );
+    if (topicLength == 0) {
+        return;
+    }
+
+    char topic[topicLength];
+    if (!_context.generateDataTopic(
+        topic,
+        SingleLevelWildcard,
+        HACommandTopic,
+        device
+    )) {
+        return;
+    }
+
+    subscribe(topic);
+}
+
+void HAMqtt::subscribeConfigWildcard(const HADevice* device, const bool subscribe)
+{
+    const uint16_t topicLength = _context.calculateConfigTopicLength(
+        SingleLevelWildcard,
+        SingleLevelWildcard,
+        device
+    );
+    if (topicLength == 0) {
+        return;
+    }
+
+    char topic[topicLength];
+    if (!_context.generateConfigTopic(
+        topic,
+        SingleLevelWildcard,
+        SingleLevelWildcard,
+        device
+    )) {
+        return;
+    }
+
+    if (subscribe) {
+        this->subscribe(topic);
+    } else {
+        unsubscribe(topic);
+    }
+}
+
+void HAMqtt::processStateRestore()
+{
+    if (
+        !_restoringStates ||
+        (HAUtils::now() - _stateRestoreStartedAt) < _stateRestoreTimeout
+    ) {
+        return;
+    }
+
+    _restoringStates = false;
+    if (!isConnected()) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+        _devicesTypes[i]->onStateRestoreFinished();
+    }
+
+    if (_statesRestoredCallback) {
+        _statesRestoredCallback();
+    }
+}
+
+void HAMqtt::processSweep()
+{
+    if (!_sweeping || (HAUtils::now() - _sweepStartedAt) < _sweepDuration) {
+        return;
+    }
+
+    _sweeping = false;
+    if (!isConnected()) {
+        return;
+    }
+
+    subscribeConfigWildcard(&_device, false);
+    for (uint16_t i = 0; i < _devicesNb; i++) {
+        subscribeConfigWildcard(_devices[i], false);
+    }
+}
+
+bool HAMqtt::sweepConfig(const char* topic, const uint16_t length)
+{
+    const char* prefix = _context.getDiscoveryPrefix();
+    const uint16_t prefixLength = _context.getDiscoveryPrefixLength();
+    if (
+        !prefix ||
+        strncmp(topic, prefix, prefixLength) != 0 ||
+        topic[prefixLength] != '/'
+    ) {
+        return false;
+    }
+
+    // the length of the topic is controlled by the broker, so it's not copied to the stack
+    char* levels = new char[strlen(topic) - prefixLength];
+    strcpy(levels, &topic[prefixLength + 1]);
+
+    const bool result = sweepConfigLevels(levels, length);
+    delete[] levels;
+
+    return result;
+}
+
+bool HAMqtt::sweepConfigLevels(char* levels, const uint16_t length)
+{
+    // <component>/<device ID>/<object ID>/config
+    char* component = levels;
+    char* deviceId = strchr(component, '/');
+    char* objectId = deviceId ? strchr(deviceId + 1, '/') : nullptr;
+    char* suffix = objectId ? strchr(objectId + 1, '/') : nullptr;
+    if (!suffix || strcmp_P(suffix + 1, HAConfigTopic) != 0) {
+        return false;
+    }
+
+    *deviceId++ = 0;
+    *objectId++ = 0;
+    *suffix = 0;
+
+    const HADevice* device = findDevice(deviceId);
+    if (!device) {
+        return false;
+    }
+
+    if (length == 0) {
+        return true; // already purged
+    }
+
+    for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+        if (
+            _devicesTypes[i]->getDevice() == device &&
+            _devicesTypes[i]->hasConfig(component, objectId)
+        ) {
+            return true;
+        }
+    }
+
+    if (purgeConfig(component, objectId, device)) {
+        _purgedConfigsNb++;
+    }
+
+    return true;
+}
+
+const HADevice* HAMqtt::findDevice(const char* uniqueId) const
+{
+    if (_device.getUniqueId() && strcmp(_device.getUniqueId(), uniqueId) == 0) {
+        return &_device;
+    }
+
+    for (uint16_t i = 0; i < _devicesNb; i++) {
+        const char* deviceId = _devices[i]->getUniqueId();
+        if (deviceId && strcmp(deviceId, uniqueId) == 0) {
+            return _devices[i];
+        }
+    }
+
+    return nullptr;
+}
+
+void HAMqtt::trackKeepAlive()
+{
+    const uint32_t keepAlive = static_cast<uint32_t>(_mqtt->getKeepAlive()) * 1000;
+    if (keepAlive == 0) {
+        return;
+    }
+
+    const uint32_t now = HAUtils::now();
+    if (_pingResponsePending) {
+        if ((now - _lastOutgoingAt) >= keepAlive / 2) {
+            _lastIncomingAt = now;
+            _pingResponsePending = false;
+        }
+
+        return;
+    }
+
+    if ((now - _lastOutgoingAt) > keepAlive || (now - _lastIncomingAt) > keepAlive) {
+        _lastOutgoingAt = now;
+        _lastIncomingAt = now;
+        _pingResponsePending = true;
+    }
+}
+
+uint32_t HAMqtt::remainingTime(
+    const uint32_t now,
+    const uint32_t startedAt,
+    const uint32_t interval
+)
+{
+    const uint32_t elapsed = now - startedAt;
+    return elapsed < interval ? interval - elapsed : 0;
+}
+
+void HAMqtt::processEventQueue()
+{
+    if (!_eventQueue) {
+        return;
+    }
+
+    HAQueuedEvent event;
+    while (_eventQueue->pop(event)) {
+        if (event.deviceType) {
+            event.deviceType->onQueuedEvent(event.value);
+        }
     }
 }
@@ -4,43 +4,129 @@
 #include <Client.h>
 #include <IPAddress.h>
 #include "ArduinoHADefines.h"
+#include "utils/HAMqttContext.h"
 
 #define HAMQTT_CALLBACK(name) void (*name)()
 #define HAMQTT_MESSAGE_CALLBACK(name) void (*name)(const char* topic, const uint8_t* payload, uint16_t length)
+#define HAMQTT_PAYLOAD_CALLBACK(name) void (*name)(HABaseDeviceType* deviceType, uint32_t packetSize, bool published)
 #define HAMQTT_DEFAULT_PORT 1883
 
 #ifdef ARDUINOHA_TEST
 class PubSubClientMock;
-#else
-class PubSubClient;
 #endif
 
+class HAMqttTransport;
 class HADevice;
 class HABaseDeviceType;
+class HATopicAliases;
+class HAInflightWindow;
+class HAEventQueue;
+class HASessionState;
+class HASessionStorage;
+class HASerializer;
+
+/**
+ * Statistics of the payloads that exceeded the max packet size of the transport.
+ */
+struct HAPayloadStats
+{
+    /// The number of messages that didn't fit the packet in their original form.
+    uint16_t oversizeNb;
+
+    /// The number of discovery configs that were published after the fallback.
+    uint16_t degradedNb;
+
+    /// The number of messages that were not published at all.
+    uint16_t droppedNb;
+
+    /// The size of the largest rejected packet (in bytes).
+    uint32_t largestPacketSize;
+};
+
+/**
+ * Address of the MQTT broker used by the failover (see HAMqtt::enableFailover).
+ * If the hostname is nullptr then the IP address is used.
+ */
+struct HAMqttBroker
+{
+    const char* hostname;
+    IPAddress ip;
+    uint16_t port;
+
+    HAMqttBroker() :
+        hostname(nullptr),
+        ip(),
+        port(HAMQTT_DEFAULT_PORT)
+    { }
+};
 
 class HAMqtt
 {
 public:
     static const uint16_t ReconnectInterval = 5000; // ms
+    static const uint32_t NoIdleTimeout = UINT32_MAX;
+    static const uint16_t DefaultSweepDuration = 3000; // ms
+    static const uint16_t DefaultStateRestoreTimeout = 1000; // ms
 
+    /**
+     * Returns the most recently constructed instance of the HAMqtt.
+     * Device types bind to this instance at construction, so if you use multiple
+     * instances (e.g. primary and backup broker), create device types right after
+     * the HAMqtt they belong to.
+     */
     inline static HAMqtt* instance()
         { return _instance; }
 
+    /**
+     * Returns the instance whose loop is currently running (or the default instance).
+     * Transport callbacks are called from within the loop, so this instance
+     * is the owner of the received messages.
+     */
+    inline static HAMqtt* active()
+        { return _activeInstance ? _activeInstance : _instance; }
+
 #ifdef ARDUINOHA_TEST
     explicit HAMqtt(
         PubSubClientMock* pubSub,
         HADevice& device,
-        const uint8_t maxDevicesTypesNb = 6
+        const uint16_t maxDevicesTypesNb = 6
     );
 #else
+    /**
+     * Creates HAMqtt that uses PubSubClient (HAPubSubClientTransport) as the MQTT client.
+     *
+     * @param netClient Network client (e.g. EthernetClient, WiFiClient).
+     * @param device Device that owns all entities.
+     * @param maxDevicesTypesNb Maximum number of entities.
+     */
     explicit HAMqtt(
         Client& netClient,
         HADevice& device,
-        const uint8_t maxDevicesTypesNb = 6
+        const uint16_t maxDevicesTypesNb = 6
     );
 #endif
+
+    /**
+     * Creates HAMqtt that uses the given MQTT client implementation.
+     * The transport is not owned by the HAMqtt, so it needs to outlive it.
+     *
+     * @param transport Implementation of the MQTT client.
+     * @param device Device that owns all entities.
+     * @param maxDevicesTypesNb Maximum number of entities.
+     */
+    explicit HAMqtt(
+        HAMqttTransport& transport,
+        HADevice& device,
+        const uint16_t maxDevicesTypesNb = 6
+    );
     ~HAMqtt();
 
+    /**
+     * Returns the MQTT client used by the HAMqtt.
+     */
+    inline HAMqttTransport* getTransport() const
+        { return _mqtt; }
+
     /**
      * Sets prefix for Home Assistant discovery.
      * It needs to match prefix set in the HA admin panel.
@@ -49,13 +135,13 @@ public:
      * @param prefix
      */
     inline void setDiscoveryPrefix(const char* prefix)
-        { _discoveryPrefix = prefix; }
+        { _context.setDiscoveryPrefix(prefix); }
 
     /**
      * Returns discovery prefix.
      */
     inline const char* getDiscoveryPrefix() const
-        { return _discoveryPrefix; }
+        { return _context.getDiscoveryPrefix(); }
 
     /**
      * Sets prefix that will be used for topics different than discovery.
@@ -64,13 +150,20 @@ public:
      * @param prefix
      */
     inline void setDataPrefix(const char* prefix)
-        { _dataPrefix = prefix; }
+        { _context.setDataPrefix(prefix); }
 
     /**
      * Returns data prefix.
      */
     inline const char* getDataPrefix() const
-        { return _dataPrefix; }
+        { return _context.getDataPrefix(); }
+
+    /**
+     * Returns the context shared by all device types bound to this instance.
+     * It generates topics using the precomputed prefixes and device ID.
+     */
+    inline const HAMqttContext& getContext() const
+        { return _context; }
 
     /**
      * Returns instance of the device assigned to the HAMqtt class.
@@ -102,6 +195,74 @@ public:
     inline void onConnectionFailed(HAMQTT_CALLBACK(callback))
         { _connectionFailedCallback = callback; }
 
+    /**
+     * Given callback will be called each time the library switches to another broker
+     * (see HAMqtt::enableFailover).
+     *
+     * @param callback
+     */
+    inline void onBrokerSwitched(HAMQTT_CALLBACK(callback))
+        { _brokerSwitchedCallback = callback; }
+
+    /**
+     * Enables failover between the ordered list of brokers.
+     * The broker passed to the "begin" method is the first one on the list
+     * and the next ones can be added using HAMqtt::addBroker method.
+     * The library switches to the next broker after the given number of failed
+     * connection attempts. Discovery and availability are republished to the new broker.
+     * This method needs to be called before the "begin" method.
+     *
+     * @param maxBrokersNb The max number of brokers (including the one passed to the "begin" method).
+     * @param maxFailedAttemptsNb The number of failed connection attempts that triggers the failover.
+     * @returns Returns true if the failover has been enabled.
+     */
+    bool enableFailover(const uint8_t maxBrokersNb, const uint8_t maxFailedAttemptsNb = 3);
+
+    /**
+     * Adds the next broker to the failover list.
+     *
+     * @param hostname Hostname of the broker.
+     * @param port Port of the broker.
+     */
+    bool addBroker(const char* hostname, const uint16_t port = HAMQTT_DEFAULT_PORT);
+
+    /**
+     * Adds the next broker to the failover list.
+     *
+     * @param ip IP address of the broker.
+     * @param port Port of the broker.
+     */
+    bool addBroker(const IPAddress ip, const uint16_t port = HAMQTT_DEFAULT_PORT);
+
+    /**
+     * Returns the number of brokers on the failover list.
+     */
+    inline uint8_t getBrokersNb() const
+        { return _brokersNb; }
+
+    /**
+     * Returns index of the broker that's currently used (0 is the broker passed to the "begin" method).
+     */
+    inline uint8_t getActiveBroker() const
+        { return _activeBroker; }
+
+    /**
+     * Sets transport that's kept connected to the next broker on the failover list (hot standby).
+     * If the active connection is lost and the standby is connected,
+     * the library switches to the standby without waiting for the reconnect interval.
+     * The standby needs to use a separate network client.
+     * This method needs to be called before the "begin" method.
+     *
+     * @param transport Standby transport.
+     */
+    bool setStandbyTransport(HAMqttTransport& transport);
+
+    /**
+     * Returns the standby transport (it changes after each switch).
+     */
+    inline HAMqttTransport* getStandbyTransport() const
+        { return _standby; }
+
     /**
      * Sets parameters of the connection to the MQTT broker.
      * The library will try to connect to the broker in first loop cycle.
@@ -160,15 +321,450 @@ public:
     bool isConnected();
 
     /**
-     * Adds a new device's type to the MQTT.
+     * Returns number of milliseconds until the "loop" method needs to be called again.
+     * The deadline takes into account the keep alive of the transport (ping and its response),
+     * the reconnect interval, the standby connection and the event queue.
+     * The application may sleep until this deadline (or an external wake up, e.g. GPIO)
+     * instead of calling the "loop" method continuously.
+     * Incoming messages are not predictable, so the network needs to be able to wake up the device
+     * if the entities expect commands from Home Assistant.
+     *
+     * @returns Returns zero if the loop needs to be called immediately
+     *          or HAMqtt::NoIdleTimeout if nothing is scheduled (e.g. the library is not initialized).
+     */
+    uint32_t getIdleTimeout();
+
+    /**
+     * Adds a new device's type to the MQTT and binds it to this instance.
      * Each time the connection with MQTT broker is acquired, the HAMqtt class
      * calls "onMqttConnected" method in all devices' types instances.
+     * Device types are added to the most recently constructed HAMqtt automatically.
+     * If the device's type is bound to another instance, it's moved to this one.
      *
      * @param deviceType Instance of the device's type (eg. HATriggers).
+     * @returns Returns false if the limit of the devices' types was reached (see the constructor).
+     *          In this case the device's type is not bound to any instance (HABaseDeviceType::mqtt returns nullptr).
+     */
+    bool addDeviceType(HABaseDeviceType* deviceType);
+
+    /**
+     * Removes the device's type from the MQTT, so it's not published after the next connection
+     * and it doesn't receive messages anymore.
+     * Its in-flight messages and queued events are discarded and it's not bound to any instance
+     * until it's added again using HAMqtt::addDeviceType (the device set by HABaseDeviceType::setDevice is reset).
+     * The device's type is removed automatically when it's destroyed.
+     *
+     * @param deviceType Instance of the device's type.
+     * @param purge Publishes empty retained config, so Home Assistant deletes the entity.
+     *              The purge requires the connection with the broker.
+     * @returns Returns false if the device's type wasn't registered
+     *          or the purge was requested while the connection is not established.
+     */
+    bool removeDeviceType(HABaseDeviceType* deviceType, const bool purge = false);
+
+    /**
+     * Publishes empty retained config of the given entity, so Home Assistant deletes it.
+     * It allows to remove entities that are not present in the firmware anymore.
+     *
+     * @param component Name of the component (e.g. "switch").
+     * @param objectId Unique ID of the entity.
+     * @param device Device that owns the entity. Nullptr means the device passed to the constructor.
+     * @returns Returns true if the message has been published successfully.
+     */
+    bool purgeConfig(
+        const char* component,
+        const char* objectId,
+        const HADevice* device = nullptr
+    );
+
+    /**
+     * Starts the sweep of orphaned configs, i.e. retained configs published on the device's
+     * discovery topics by entities that are not registered in the HAMqtt anymore.
+     * The HAMqtt subscribes to "<discovery prefix>/+/<device ID>/+/config" (for each device
+     * in the gateway mode), the broker replays the retained configs and the orphaned ones
+     * are purged with empty retained messages.
+     * The subscription is removed after the given duration.
+     * Received configs are not passed to the device types nor the message callback.
+     * The sweep is cancelled if the connection is lost.
+     *
+     * @param duration Time (in milliseconds) for the broker to replay the retained configs.
+     * @returns Returns false if the connection is not established or the sweep is in progress.
+     */
+    bool sweepOrphanedConfigs(const uint32_t duration = DefaultSweepDuration);
+
+    /**
+     * Returns true if the sweep of orphaned configs is in progress.
+     */
+    inline bool isSweeping() const
+        { return _sweeping; }
+
+    /**
+     * Returns number of configs purged by the sweeps since the HAMqtt was created.
+     */
+    inline uint16_t getPurgedConfigsNb() const
+        { return _purgedConfigsNb; }
+
+    /**
+     * Enables the gateway mode in which a single connection hosts many devices.
+     * Device types are assigned to the devices using HABaseDeviceType::setDevice method.
+     * Each device has its own topics, device block in the discovery configs
+     * and shared availability (if enabled).
+     * Please note that the last will can be set only for the device passed to the constructor,
+     * so availability of other devices needs to be managed manually.
+     *
+     * @param maxDevicesNb The max number of devices hosted besides the device passed to the constructor.
+     * @returns Returns true if the gateway mode has been enabled.
+     */
+    bool enableGatewayMode(const uint16_t maxDevicesNb);
+
+    /**
+     * Returns true if the gateway mode is enabled.
+     */
+    inline bool isGatewayModeEnabled() const
+        { return (_devices != nullptr); }
+
+    /**
+     * Registers the device in the gateway mode.
+     * It's called by the HABaseDeviceType::setDevice method, so there is no need to call it manually.
+     *
+     * @param device Device to register.
+     * @returns Returns false if the gateway mode is disabled, the limit of devices was reached
+     *          or the device is owned by another HAMqtt instance.
+     */
+    bool addDevice(HADevice& device);
+
+    /**
+     * Unregisters the device from the gateway mode.
+     * Device types assigned to the device are removed from the MQTT as well.
+     * It's called automatically when the device is destroyed.
+     *
+     * @param device Device to unregister.
+     * @returns Returns false if the device wasn't registered in the gateway mode.
+     */
+    bool removeDevice(HADevice& device);
+
+    /**
+     * Returns the number of devices registered in the gateway mode.
+     */
+    inline uint16_t getDevicesNb() const
+        { return _devicesNb; }
+
+    /**
+     * Enables MQTT 5 topic aliases for the data topics (state, position, etc.).
+     * The alias is assigned after the first publish on the topic and all subsequent
+     * messages are sent with the zero-length topic.
+     * Please note that PubSubClient supports MQTT 3.1.1 only, so aliases
+     * can be enabled only if the transport speaks MQTT 5
+     * (see HAMqttTransport::supportsTopicAliases).
+     *
+     * @param maxAliasesNb The "Topic Alias Maximum" announced by the broker.
+     * @returns Returns true if aliases have been enabled.
+     */
+    bool enableTopicAliases(const uint16_t maxAliasesNb);
+
+    /**
+     * Returns true if the topic aliases are enabled.
+     */
+    inline bool isTopicAliasesEnabled() const
+        { return (_topicAliases != nullptr); }
+
+    /**
+     * Enables QoS 1 publishing for the entities that have QoS set (see HABaseDeviceType::setQos).
+     * Messages that weren't acknowledged by the broker are kept in the fixed-size window
+     * and they're retransmitted (with DUP flag) after reconnection.
+     * Please note that PubSubClient publishes with QoS 0 only, so the window
+     * can be enabled only if the transport supports QoS 1 (see HAMqttTransport::supportsQos).
+     *
+     * @param size Maximum number of the in-flight messages.
+     * @returns Returns true if the window has been enabled.
+     */
+    bool enableInflightWindow(const uint8_t size);
+
+    /**
+     * Returns the in-flight window or nullptr if QoS 1 publishing is disabled.
+     */
+    inline HAInflightWindow* getInflightWindow() const
+        { return _inflightWindow; }
+
+    /**
+     * Publishes the message with QoS 1 and keeps it in the in-flight window until
+     * the broker acknowledges it. Payloads that don't fit in the window's slot
+     * are published with QoS 0.
+     *
+     * @param deviceType Entity that owns the message.
+     * @param topicP Suffix of the data topic (used for regenerating the topic).
+     * @param topic Full topic of the message.
+     * @param payload Content of the message.
+     * @param length Length of the payload.
+     * @param retained Specifies whether the message should be retained.
+     * @param isProgmemPayload Specifies whether the payload is stored in the flash memory.
+     * @returns Returns false if the window is full or the transport failed.
+     */
+    bool publishReliably(
+        HABaseDeviceType* deviceType,
+        const char* topicP,
+        const char* topic,
+        const char* payload,
+        uint16_t length,
+        bool retained,
+        bool isProgmemPayload
+    );
+
+    /**
+     * Processes PUBACK received from the broker.
+     *
+     * @param packetId Identifier of the acknowledged message.
+     */
+    void processAck(uint16_t packetId);
+
+    /**
+     * Enables queue of the events recorded in the interrupt handlers
+     * (e.g. HABinarySensor::setStateFromISR, HADeviceTrigger::triggerFromISR).
+     * The queue is drained in the loop method, so the MQTT messages are never
+     * published from the interrupt context.
+     *
+     * @param size Maximum number of the pending events.
+     * @returns Returns true if the queue has been enabled.
+     */
+    bool enableEventQueue(const uint8_t size);
+
+    /**
+     * Returns the event queue or nullptr if it's disabled.
+     */
+    inline HAEventQueue* getEventQueue() const
+        { return _eventQueue; }
+
+    /**
+     * Adds the event of the given entity to the queue.
+     * It's safe to call this method from the interrupt handler.
+     *
+     * @param deviceType Entity that will process the event in the loop.
+     * @param value Value passed to the entity.
+     * @returns Returns false if the queue is disabled or full.
+     */
+    bool queueEvent(HABaseDeviceType* deviceType, const uint8_t value);
+
+    /**
+     * Enables the fast resume for the nodes that wake up from the deep sleep.
+     * The discovery fingerprint and hashes of the published values are persisted in the given storage.
+     * If the fingerprint matches after the wake up, the configs are not published again
+     * and the values published while the connection is being resumed (the initial states
+     * and the values set in the HAMqtt::onConnected callback) are skipped if they didn't change
+     * since the deep sleep. The availability and the values set later on are always published.
+     * The connection uses a persistent session (clean session flag is not set).
+     * Only the first connection after the wake up is resumed, reconnections publish everything.
+     * This method needs to be called before the "begin" method.
+     *
+     * @param storage Storage that survives the deep sleep (e.g. HARtcSessionStorage).
+     * @param maxValuesNb Maximum number of the persisted values (one per topic).
+     * @param configVersion Version of the entities' configuration. The fingerprint covers
+     *                      the entities and their serialized configs, so the version only needs
+     *                      to be changed to force publishing the discovery again.
+     * @returns Returns true if the fast resume has been enabled.
+     */
+    bool enableFastResume(
+        HASessionStorage& storage,
+        const uint8_t maxValuesNb,
+        const uint32_t configVersion = 0
+    );
+
+    /**
+     * Returns the session state or nullptr if the fast resume is disabled.
+     */
+    inline HASessionState* getSessionState() const
+        { return _sessionState; }
+
+    /**
+     * Returns true if the current connection resumed the persisted session.
+     */
+    inline bool isResumed() const
+        { return _resumed; }
+
+    /**
+     * Returns true while the resumed connection is being set up,
+     * so the device types can skip publishing their configs and unchanged initial states.
+     */
+    inline bool isResuming() const
+        { return _resuming; }
+
+    /**
+     * Writes the session state to the storage.
+     * It needs to be called before going to the deep sleep.
+     *
+     * @returns Returns false if the fast resume is disabled or the write failed.
+     */
+    bool saveSession();
+
+    /**
+     * Returns true if the value was the last one published on the topic (the fast resume only).
+     * It's meant to be used while the connection is being resumed (see HAMqtt::isResuming).
+     *
+     * @param topic Topic of the message.
+     * @param value Payload of the message.
+     * @param length Length of the payload.
+     * @param isProgmemValue Set to true if the payload is stored in the flash memory.
+     */
+    bool isPublished(
+        const char* topic,
+        const char* value,
+        const uint16_t length,
+        const bool isProgmemValue = false
+    ) const;
+
+    /**
+     * Remembers the value published on the topic, so it's not published again after the wake up.
+     * The parameters are the same as in the HAMqtt::isPublished method.
+     */
+    void markPublished(
+        const char* topic,
+        const char* value,
+        const uint16_t length,
+        const bool isProgmemValue = false
+    );
+
+    /**
+     * Sets time (in milliseconds) that entities with the state restore enabled
+     * (e.g. HASwitch::setStateRestore) wait for the retained states after the connection is acquired.
+     * The states that weren't received within this time are published as usual.
+     *
+     * @param timeout
+     */
+    inline void setStateRestoreTimeout(const uint16_t timeout)
+        { _stateRestoreTimeout = timeout; }
+
+    /**
+     * Given callback will be called each time the state restore ends.
+     * The restored states are available in the entities (e.g. HASwitch::getCurrentState).
+     *
+     * @param callback
      */
-    void addDeviceType(HABaseDeviceType* deviceType);
+    inline void onStatesRestored(HAMQTT_CALLBACK(callback))
+        { _statesRestoredCallback = callback; }
 
-    bool beginPublish(const char* topic, uint16_t payloadLength, bool retained = false);
+    /**
+     * Returns true while entities wait for their retained states.
+     */
+    inline bool isRestoringStates() const
+        { return _restoringStates; }
+
+    /**
+     * Starts the state restore (if it's not running yet).
+     * It's called by the entities that subscribed to their retained states in the "onMqttConnected" method,
+     * so there is no need to call it manually.
+     */
+    void beginStateRestore();
+
+    /**
+     * Enables base topic ("~") abbreviation in the discovery configs.
+     * The "<data prefix>/<device ID>/<object ID>" part is sent once in the "~" property
+     * and data topics are written as "~/stat_t", "~/cmd_t", etc.
+     * The abbreviation is used only for entities with at least two data topics,
+     * because otherwise the config would be longer.
+     *
+     * @param enabled
+     */
+    inline void setBaseTopicEnabled(bool enabled)
+        { _baseTopicEnabled = enabled; }
+
+    /**
+     * Returns true if the base topic abbreviation is enabled.
+     */
+    inline bool isBaseTopicEnabled() const
+        { return _baseTopicEnabled; }
+
+    /**
+     * Enables single wildcard subscription of the command topics.
+     * Instead of subscribing to the command topic of each entity separately,
+     * the HAMqtt subscribes to "<data prefix>/<device ID>/+/cmd_t" once per connection.
+     * Received messages are routed to the entities in the same way as before.
+     * This method needs to be called before the "begin" method.
+     *
+     * @param enabled
+     * @returns Returns false if the MQTT has been already initialized.
+     */
+    bool setCommandWildcard(bool enabled);
+
+    /**
+     * Returns true if the wildcard subscription of the command topics is enabled.
+     */
+    inline bool isCommandWildcardEnabled() const
+        { return _commandWildcard; }
+
+    /**
+     * Returns the max packet size reported by the transport.
+     * Zero means that the limit is unknown.
+     */
+    uint16_t getMaxPacketSize() const;
+
+    /**
+     * Returns the max topic length reported by the transport.
+     * Zero means that the limit is unknown.
+     */
+    uint16_t getMaxTopicLength() const;
+
+    /**
+     * Returns true if the PUBLISH packet with the given topic and payload
+     * fits the max packet size and the max topic length of the transport.
+     *
+     * @param topicLength Length of the topic.
+     * @param payloadLength Length of the payload.
+     */
+    bool fitsPacket(uint16_t topicLength, uint16_t payloadLength) const;
+
+    /**
+     * Calculates size of the MQTT 3.1.1 PUBLISH packet (QoS 0).
+     *
+     * @param topicLength Length of the topic.
+     * @param payloadLength Length of the payload.
+     */
+    static uint32_t calculatePacketSize(uint16_t topicLength, uint16_t payloadLength);
+
+    /**
+     * Registers callback that will be called each time the message doesn't fit
+     * the max packet size of the transport.
+     * The discovery configs are degraded before they're dropped: the base topic ("~")
+     * is forced and then the optional properties are removed (icon, name, device class).
+     * The "published" argument tells whether the config was eventually published.
+     * Other messages are always dropped and the device type is nullptr in their case.
+     *
+     * @param callback
+     */
+    inline void onPayloadTooLarge(HAMQTT_PAYLOAD_CALLBACK(callback))
+        { _payloadCallback = callback; }
+
+    /**
+     * Returns statistics of the payloads that exceeded the max packet size.
+     */
+    inline const HAPayloadStats& getPayloadStats() const
+        { return _payloadStats; }
+
+    /**
+     * Updates statistics and calls the callback registered using onPayloadTooLarge method.
+     *
+     * @param deviceType Device type that owns the message (may be nullptr).
+     * @param packetSize Size of the packet in its original form.
+     * @param published Specifies whether the message was published after the fallback.
+     */
+    void reportOversizePayload(
+        HABaseDeviceType* deviceType,
+        uint32_t packetSize,
+        bool published
+    );
+
+    /**
+     * Begins publishing of the MQTT message.
+     *
+     * @param topic Topic of the message.
+     * @param payloadLength Length of the payload that's going to be written.
+     * @param retained Specifies whether the message should be retained.
+     * @param useTopicAlias Allows to send the message using the topic alias (if enabled).
+     */
+    bool beginPublish(
+        const char* topic,
+        uint16_t payloadLength,
+        bool retained = false,
+        bool useTopicAlias = false
+    );
     void writePayload(const char* data, uint16_t length);
     void writePayload_P(const char* src);
     bool endPublish();
@@ -185,6 +781,13 @@ public:
      */
     bool subscribe(const char* topic);
 
+    /**
+     * Unsubscribes from the given topic.
+     *
+     * @param topic Topic to unsubscribe
+     */
+    bool unsubscribe(const char* topic);
+
     /**
      * Enables last will message that will be produced when device disconnects from the broker.
      * If you want to change availability of the device in Home Assistant panel
@@ -214,7 +817,7 @@ public:
     void processMessage(const char* topic, const uint8_t* payload, uint16_t length);
 
 #ifdef ARDUINOHA_TEST
-    inline uint8_t getDevicesTypesNb() const
+    inline uint16_t getDevicesTypesNb() const
         { return _devicesTypesNb; }
 
     inline HABaseDeviceType** getDevicesTypes() const
@@ -223,6 +826,7 @@ public:
 
 private:
     static HAMqtt* _instance;
+    static HAMqtt* _activeInstance;
 
     /**
      * Attempts to connect to the MQTT broker.
@@ -235,27 +839,203 @@ private:
      */
     void onConnectedLogic();
 
-#ifdef ARDUINOHA_TEST
-    PubSubClientMock* _mqtt;
-#else
-    PubSubClient* _mqtt;
-#endif
+    /**
+     * Returns the next packet ID that's not used by the in-flight messages.
+     */
+    uint16_t nextPacketId();
+
+    /**
+     * Resends all in-flight messages with DUP flag.
+     */
+    void retransmitInflight();
+
+    /**
+     * Removes the device's type from the array of the registered types.
+     * It's called by the HABaseDeviceType::unbind method.
+     *
+     * @param deviceType Instance of the device's type.
+     * @returns Returns false if the device's type wasn't registered.
+     */
+    bool detachDeviceType(HABaseDeviceType* deviceType);
+
+    /**
+     * Calculates fingerprint of the discovery (device, prefixes, entities and their configs).
+     */
+    uint32_t calculateFingerprint();
+
+    /**
+     * Extends the hash with the config written by the serializer.
+     * The payload is hashed instead of being sent to the transport.
+     *
+     * @param serializer Serializer of the entity's config.
+     * @param hash Current hash.
+     */
+    uint32_t hashConfig(const HASerializer* serializer, uint32_t hash);
+
+    /**
+     * Stores address of the broker on the failover list.
+     */
+    void setBroker(
+        const uint8_t index,
+        const char* hostname,
+        const IPAddress ip,
+        const uint16_t port
+    );
+
+    /**
+     * Sets server of the given transport to the broker from the failover list.
+     */
+    void applyBroker(HAMqttTransport* transport, const uint8_t index);
+
+    /**
+     * Connects the transport using the device's ID, credentials and last will.
+     */
+    bool connectTransport(HAMqttTransport* transport);
+
+    /**
+     * Switches to the given broker after too many failed connection attempts.
+     */
+    void switchBroker(const uint8_t index);
+
+    /**
+     * Swaps the active transport with the standby one if the standby is connected.
+     */
+    bool promoteStandby();
+
+    /**
+     * Keeps the standby transport connected to the next broker on the list.
+     */
+    void maintainStandby();
+
+    /**
+     * Subscribes to the command topics of all entities using the single-level wildcard.
+     */
+    void subscribeCommandWildcard();
+
+    /**
+     * Subscribes to the command topics of the given device using the single-level wildcard.
+     */
+    void subscribeCommandWildcard(const HADevice* device);
+
+    /**
+     * Subscribes to (or unsubscribes from) the config topics of the given device
+     * using the single-level wildcards.
+     */
+    void subscribeConfigWildcard(const HADevice* device, const bool subscribe);
+
+    /**
+     * Finishes the state restore once its timeout passes.
+     */
+    void processStateRestore();
+
+    /**
+     * Finishes the sweep of orphaned configs once its duration passes.
+     */
+    void processSweep();
+
+    /**
+     * Purges the received config if it's orphaned.
+     *
+     * @returns Returns false if the topic is not the config topic of the HAMqtt's devices.
+     */
+    bool sweepConfig(const char* topic, const uint16_t length);
+
+    /**
+     * Purges the config if it's orphaned. The levels of the topic (without the discovery prefix)
+     * are split in place.
+     */
+    bool sweepConfigLevels(char* levels, const uint16_t length);
+
+    /**
+     * Returns device with the given ID (the one passed to the constructor or gateway's device).
+     */
+    const HADevice* findDevice(const char* uniqueId) const;
+
+    /**
+     * Passes all queued events to the entities.
+     */
+    void processEventQueue();
+
+    /**
+     * Follows the keep alive of the transport, so the next ping can be predicted.
+     * The transport sends the ping in the loop once the interval has passed since the last
+     * outgoing or incoming packet, and the response is read in one of the following loops.
+     */
+    void trackKeepAlive();
+
+    /**
+     * Returns number of milliseconds until the given interval passes.
+     */
+    static uint32_t remainingTime(
+        const uint32_t now,
+        const uint32_t startedAt,
+        const uint32_t interval
+    );
+
+    HAMqttTransport* _mqtt;
+    bool _ownsTransport;
     HADevice& _device;
     HAMQTT_MESSAGE_CALLBACK(_messageCallback);
     HAMQTT_CALLBACK(_connectedCallback);
     HAMQTT_CALLBACK(_connectionFailedCallback);
+    HAMQTT_CALLBACK(_brokerSwitchedCallback);
+    HAMQTT_CALLBACK(_statesRestoredCallback);
+    HAMQTT_PAYLOAD_CALLBACK(_payloadCallback);
     bool _initialized;
-    const char* _discoveryPrefix;
-    const char* _dataPrefix;
+    HAMqttContext _context;
     const char* _username;
     const char* _password;
     uint32_t _lastConnectionAttemptAt;
-    uint8_t _devicesTypesNb;
-    uint8_t _maxDevicesTypesNb;
+    uint16_t _devicesTypesNb;
+    uint16_t _maxDevicesTypesNb;
     HABaseDeviceType** _devicesTypes;
     const char* _lastWillTopic;
     const char* _lastWillMessage;
     bool _lastWillRetain;
+    HATopicAliases* _topicAliases;
+
+    /// The alias assigned by the pending publish, it's released if the publish fails.
+    uint16_t _pendingAlias;
+
+    HAInflightWindow* _inflightWindow;
+    uint16_t _lastPacketId;
+    bool _commandWildcard;
+    HAEventQueue* _eventQueue;
+    bool _baseTopicEnabled;
+    HAPayloadStats _payloadStats;
+    HADevice** _devices;
+    uint16_t _devicesNb;
+    uint16_t _maxDevicesNb;
+    HAMqttBroker* _brokers;
+    uint8_t _brokersNb;
+    uint8_t _maxBrokersNb;
+    uint8_t _activeBroker;
+    uint8_t _failedAttemptsNb;
+    uint8_t _maxFailedAttemptsNb;
+    HAMqttTransport* _standby;
+    bool _ownsStandby;
+    uint8_t _standbyBroker;
+    uint32_t _lastStandbyAttemptAt;
+    uint32_t _lastOutgoingAt;
+    uint32_t _lastIncomingAt;
+    bool _pingResponsePending;
+    HASessionStorage* _sessionStorage;
+    HASessionState* _sessionState;
+    uint32_t _configVersion;
+    bool _hashingPayload;
+    uint32_t _payloadHash;
+    bool _sessionRestored;
+    bool _resumed;
+    bool _resuming;
+    bool _sweeping;
+    uint32_t _sweepStartedAt;
+    uint32_t _sweepDuration;
+    uint16_t _purgedConfigsNb;
+    bool _restoringStates;
+    uint32_t _stateRestoreStartedAt;
+    uint16_t _stateRestoreTimeout;
+
+    friend class HABaseDeviceType;
 };
 
 #endif
\ No newline at end of file
@@ -51,13 +51,13 @@ char* HAUtils::byteArrayToStr(
 uint8_t HAUtils::calculateNumberSize(int32_t value)
 {
     const bool isSigned = value < 0;
-    if (isSigned) {
-        value *= -1;
-    }
+    uint32_t absValue = isSigned
+        ? static_cast<uint32_t>(-(value + 1)) + 1
+        : static_cast<uint32_t>(value);
 
     uint8_t digitsNb = 1;
-    while (value > 9) {
-        value /= 10;
+    while (absValue > 9) {
+        absValue /= 10;
         digitsNb++;
     }
 
@@ -76,15 +76,96 @@ void HAUtils::numberToStr(char* dst, int32_t value)
     }
 
     const uint8_t digitsNb = calculateNumberSize(value);
+    uint32_t absValue = static_cast<uint32_t>(value);
     if (value < 0) {
-        value *= -1;
+        absValue = static_cast<uint32_t>(-(value + 1)) + 1;
         dst[0] = 0x2D; // hyphen
     }
 
     char* ch = &dst[digitsNb - 1];
-    while (value != 0) {
-       *ch = (value % 10) + '0';
-       value /= 10;
+    while (absValue != 0) {
+       *ch = (absValue % 10) + '0';
+       absValue /= 10;
        ch--;
     }
 }
+
+uint8_t HAUtils::calculateDecimalSize(int32_t value, const uint8_t precision)
+{
+    if (precision == 0) {
+        return calculateNumberSize(value);
+    }
+
+    const bool isSigned = value < 0;
+    uint32_t absValue = isSigned
+        ? static_cast<uint32_t>(-(value + 1)) + 1
+        : static_cast<uint32_t>(value);
+
+    uint8_t digitsNb = 1;
+    while (absValue > 9) {
+        absValue /= 10;
+        digitsNb++;
+    }
+
+    if (digitsNb <= precision) {
+        digitsNb = precision + 1; // leading zero
+    }
+
+    return digitsNb + 1 + (isSigned ? 1 : 0); // decimal point and sign
+}
+
+void HAUtils::decimalToStr(char* dst, int32_t value, const uint8_t precision)
+{
+    const uint8_t size = calculateDecimalSize(value, precision);
+    uint32_t absValue = value < 0
+        ? static_cast<uint32_t>(-(value + 1)) + 1
+        : static_cast<uint32_t>(value);
+
+    if (value < 0) {
+        dst[0] = 0x2D; // hyphen
+    }
+
+    char* ch = &dst[size - 1];
+    uint8_t digitsNb = 0;
+    do {
+        if (precision > 0 && digitsNb == precision) {
+            *ch-- = '.';
+        }
+
+        *ch-- = (absValue % 10) + '0';
+        absValue /= 10;
+        digitsNb++;
+    } while (absValue != 0 || digitsNb <= precision);
+}
+
+uint32_t HAUtils::now()
+{
+#ifdef ARDUINOHA_TEST
+    if (_timeSimulated) {
+        return _simulatedTime;
+    }
+#endif
+
+    return millis();
+}
+
+#ifdef ARDUINOHA_TEST
+bool HAUtils::_timeSimulated = false;
+uint32_t HAUtils::_simulatedTime = 0;
+
+void HAUtils::setSimulatedTime(const uint32_t time)
+{
+    _timeSimulated = true;
+    _simulatedTime = time;
+}
+
+void HAUtils::advanceSimulatedTime(const uint32_t ms)
+{
+    _simulatedTime += ms;
+}
+
+void HAUtils::disableSimulatedTime()
+{
+    _timeSimulated = false;
+}
+#endif
@@ -64,6 +64,54 @@ public:
      * @note The `dst` size should be calculated using HAUtils::calculateNumberSize method plus 1 extra byte for the null terminator.
      */
     static void numberToStr(char* dst, int32_t value);
+
+    /**
+     * Calculates the length of the decimal representation of the fixed-point number.
+     * 
+     * @param value Input number multiplied by 10^precision. It can be signed value.
+     * @param precision Number of digits after the decimal point.
+     * @returns Number of characters (including the sign and the decimal point).
+     */
+    static uint8_t calculateDecimalSize(int32_t value, const uint8_t precision);
+
+    /**
+     * Converts the given fixed-point number to the decimal string.
+     * For example, value 1234 with precision 2 is converted to "12.34"
+     * and value -5 with precision 2 is converted to "-0.05".
+     * 
+     * @param dst Destination where the number will be saved.
+     * @param value Number multiplied by 10^precision.
+     * @param precision Number of digits after the decimal point.
+     * @note The `dst` size should be calculated using HAUtils::calculateDecimalSize method plus 1 extra byte for the null terminator.
+     */
+    static void decimalToStr(char* dst, int32_t value, const uint8_t precision);
+
+    /**
+     * Returns number of milliseconds since the boot.
+     * All timers of the library use this clock, so it can be simulated in the tests.
+     */
+    static uint32_t now();
+
+#ifdef ARDUINOHA_TEST
+    /**
+     * Replaces the real clock with the simulated one set to the given time.
+     */
+    static void setSimulatedTime(const uint32_t time);
+
+    /**
+     * Moves the simulated clock forward.
+     */
+    static void advanceSimulatedTime(const uint32_t ms);
+
+    /**
+     * Restores the real clock.
+     */
+    static void disableSimulatedTime();
+
+private:
+    static bool _timeSimulated;
+    static uint32_t _simulatedTime;
+#endif
 };
 
 #endif
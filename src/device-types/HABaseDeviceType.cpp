@@ -3,6 +3,9 @@
 #include "../HADevice.h"
 #include "../HAUtils.h"
 #include "../utils/HASerializer.h"
+#include "../utils/HAInflightWindow.h"
+#include "../utils/HAEventQueue.h"
+#include "../utils/HASessionState.h"
 
 HABaseDeviceType::HABaseDeviceType(
     const char* componentName,
@@ -12,16 +15,21 @@ HABaseDeviceType::HABaseDeviceType(
     _uniqueId(uniqueId),
     _name(nullptr),
     _serializer(nullptr),
-    _availability(AvailabilityDefault)
+    _device(nullptr),
+    _mqtt(nullptr),
+    _availability(AvailabilityDefault),
+    _qos(0)
 {
-    if (mqtt()) {
-        mqtt()->addDeviceType(this);
+    // the default binding, it can be changed using HAMqtt::addDeviceType
+    HAMqtt* mqtt = HAMqtt::instance();
+    if (mqtt) {
+        mqtt->addDeviceType(this);
     }
 }
 
 HABaseDeviceType::~HABaseDeviceType()
 {
-
+    unbind();
 }
 
 void HABaseDeviceType::setAvailability(bool online)
@@ -30,9 +38,60 @@ void HABaseDeviceType::setAvailability(bool online)
     publishAvailability();
 }
 
-HAMqtt* HABaseDeviceType::mqtt() const
+bool HABaseDeviceType::setDevice(HADevice& device)
 {
-    return HAMqtt::instance();
+    // the device type follows the HAMqtt instance that owns the device
+    HAMqtt* owner = device.mqtt() ? device.mqtt() : mqtt();
+    if (!owner) {
+        return false;
+    }
+
+    const bool registered = (device.mqtt() == owner);
+    if (!owner->addDevice(device)) {
+        return false;
+    }
+
+    if (owner != mqtt() && !owner->addDeviceType(this)) {
+        // the device registered above must not occupy the gateway's slot
+        if (!registered) {
+            owner->removeDevice(device);
+        }
+
+        return false;
+    }
+
+    _device = (&device == mqtt()->getDevice() ? nullptr : &device);
+    onBindingChanged();
+    return true;
+}
+
+void HABaseDeviceType::unbind()
+{
+    if (!mqtt()) {
+        return;
+    }
+
+    if (mqtt()->getInflightWindow()) {
+        mqtt()->getInflightWindow()->releaseAll(this);
+    }
+
+    if (mqtt()->getEventQueue()) {
+        mqtt()->getEventQueue()->invalidate(this);
+    }
+
+    mqtt()->detachDeviceType(this);
+    _mqtt = nullptr;
+    _device = nullptr;
+    onBindingChanged();
+}
+
+const HADevice* HABaseDeviceType::getDevice() const
+{
+    if (_device) {
+        return _device;
+    }
+
+    return mqtt() ? mqtt()->getDevice() : nullptr;
 }
 
 void HABaseDeviceType::subscribeTopic(
@@ -40,24 +99,66 @@ void HABaseDeviceType::subscribeTopic(
     const char* topicP
 )
 {
-    const uint16_t topicLength = HASerializer::calculateDataTopicLength(
+    if (
+        !mqtt() ||
+        (topicP == HACommandTopic && mqtt()->isCommandWildcardEnabled())
+    ) {
+        return; // covered by the wildcard subscription
+    }
+
+    const HAMqttContext& context = mqtt()->getContext();
+    const uint16_t topicLength = context.calculateDataTopicLength(
         uniqueId,
-        topicP
+        topicP,
+        _device
     );
     if (topicLength == 0) {
         return;
     }
 
     char topic[topicLength];
-    if (!HASerializer::generateDataTopic(
+    if (!context.generateDataTopic(
         topic,
         uniqueId,
-        topicP
+        topicP,
+        _device
     )) {
         return;
     }
 
-    HAMqtt::instance()->subscribe(topic);
+    mqtt()->subscribe(topic);
+}
+
+void HABaseDeviceType::unsubscribeTopic(
+    const char* uniqueId,
+    const char* topicP
+)
+{
+    if (!mqtt()) {
+        return;
+    }
+
+    const HAMqttContext& context = mqtt()->getContext();
+    const uint16_t topicLength = context.calculateDataTopicLength(
+        uniqueId,
+        topicP,
+        _device
+    );
+    if (topicLength == 0) {
+        return;
+    }
+
+    char topic[topicLength];
+    if (!context.generateDataTopic(
+        topic,
+        uniqueId,
+        topicP,
+        _device
+    )) {
+        return;
+    }
+
+    mqtt()->unsubscribe(topic);
 }
 
 void HABaseDeviceType::onMqttMessage(
@@ -81,24 +182,47 @@ void HABaseDeviceType::destroySerializer()
 
 void HABaseDeviceType::publishConfig()
 {
+    if (mqtt()->isResuming()) {
+        return; // the retained config was published before the deep sleep
+    }
+
     buildSerializer();
 
-    const uint16_t topicLength = HASerializer::calculateConfigTopicLength(
+    const HAMqttContext& context = mqtt()->getContext();
+    const uint16_t topicLength = context.calculateConfigTopicLength(
         componentName(),
-        uniqueId()
+        uniqueId(),
+        _device
     );
-    const uint16_t dataLength = _serializer->calculateSize();
+    uint16_t dataLength = _serializer->calculateSize();
 
     if (topicLength == 0 || dataLength == 0) {
         destroySerializer();
         return;
     }
 
+    // topicLength includes the null terminator
+    if (!mqtt()->fitsPacket(topicLength - 1, dataLength)) {
+        const uint32_t packetSize = HAMqtt::calculatePacketSize(
+            topicLength - 1,
+            dataLength
+        );
+
+        dataLength = degradeConfig(topicLength - 1);
+        mqtt()->reportOversizePayload(this, packetSize, dataLength > 0);
+
+        if (dataLength == 0) {
+            destroySerializer();
+            return;
+        }
+    }
+
     char topic[topicLength];
-    HASerializer::generateConfigTopic(
+    context.generateConfigTopic(
         topic,
         componentName(),
-        uniqueId()
+        uniqueId(),
+        _device
     );
 
     if (mqtt()->beginPublish(topic, dataLength, true)) {
@@ -109,9 +233,81 @@ void HABaseDeviceType::publishConfig()
     destroySerializer();
 }
 
+bool HABaseDeviceType::unpublishConfig()
+{
+    if (!mqtt() || !uniqueId()) {
+        return false;
+    }
+
+    return mqtt()->purgeConfig(componentName(), uniqueId(), _device);
+}
+
+bool HABaseDeviceType::hasConfig(const char* component, const char* objectId) const
+{
+    if (!_componentName || !_uniqueId) {
+        return false;
+    }
+
+    return (
+        strcmp(_componentName, component) == 0 &&
+        strcmp(_uniqueId, objectId) == 0
+    );
+}
+
+uint32_t HABaseDeviceType::calculateFingerprint(uint32_t hash)
+{
+    if (!_componentName || !uniqueId()) {
+        return hash;
+    }
+
+    hash = HASessionState::hash(hash, _componentName, strlen(_componentName));
+    hash = HASessionState::hash(hash, uniqueId(), strlen(uniqueId()));
+
+    buildSerializer();
+    if (_serializer) {
+        hash = mqtt()->hashConfig(_serializer, hash);
+    }
+
+    destroySerializer();
+
+    return hash;
+}
+
+uint16_t HABaseDeviceType::degradeConfig(const uint16_t topicLength)
+{
+    // optional properties in the order of removal
+    static const char* const optionalProperties[] = {
+        HAIconProperty,
+        HANameProperty,
+        HADeviceClassProperty
+    };
+
+    _serializer->setBaseTopicForced(true);
+
+    uint16_t dataLength = _serializer->calculateSize();
+    if (mqtt()->fitsPacket(topicLength, dataLength)) {
+        return dataLength;
+    }
+
+    const uint8_t optionalPropertiesNb =
+        sizeof(optionalProperties) / sizeof(optionalProperties[0]);
+    for (uint8_t i = 0; i < optionalPropertiesNb; i++) {
+        if (!_serializer->remove(optionalProperties[i])) {
+            continue;
+        }
+
+        dataLength = _serializer->calculateSize();
+        if (mqtt()->fitsPacket(topicLength, dataLength)) {
+            return dataLength;
+        }
+    }
+
+    return 0;
+}
+
 void HABaseDeviceType::publishAvailability()
 {
-    const HADevice* device = mqtt()->getDevice();
+    const HADevice* device = getDevice();
     if (
         !device ||
         device->isSharedAvailabilityEnabled() ||
@@ -141,19 +337,26 @@ bool HABaseDeviceType::publishOnDataTopic(
         return false;
     }
 
-    const uint16_t topicLength = HASerializer::calculateDataTopicLength(
+    if (!mqtt()) {
+        return false;
+    }
+
+    const HAMqttContext& context = mqtt()->getContext();
+    const uint16_t topicLength = context.calculateDataTopicLength(
         uniqueId(),
-        topicP
+        topicP,
+        _device
     );
     if (topicLength == 0) {
         return false;
     }
 
     char topic[topicLength];
-    if (!HASerializer::generateDataTopic(
+    if (!context.generateDataTopic(
         topic,
         uniqueId(),
-        topicP
+        topicP,
+        _device
     )) {
         return false;
     }
@@ -162,15 +365,37 @@ bool HABaseDeviceType::publishOnDataTopic(
         ? strlen_P(value)
         : strlen(value);
 
-    if (mqtt()->beginPublish(topic, valueLength, retained)) {
+    if (
+        mqtt()->isResuming() &&
+        mqtt()->isPublished(topic, value, valueLength, isProgmemValue)
+    ) {
+        return true; // the value was published before the deep sleep
+    }
+
+    bool result = false;
+    if (_qos > 0 && mqtt()->getInflightWindow()) {
+        result = mqtt()->publishReliably(
+            this,
+            topicP,
+            topic,
+            value,
+            valueLength,
+            retained,
+            isProgmemValue
+        );
+    } else if (mqtt()->beginPublish(topic, valueLength, retained, true)) {
         if (isProgmemValue) {
             mqtt()->writePayload_P(value);
         } else {
             mqtt()->writePayload(value, valueLength);
         }
 
-        return mqtt()->endPublish();
+        result = mqtt()->endPublish();
+    }
+
+    if (result) {
+        mqtt()->markPublished(topic, value, valueLength, isProgmemValue);
     }
 
-    return false;
+    return result;
 }
@@ -6,6 +6,7 @@
 #include "../ArduinoHADefines.h"
 
 class HAMqtt;
+class HADevice;
 class HASerializer;
 
 class HABaseDeviceType
@@ -37,6 +38,45 @@ public:
 
     virtual void setAvailability(bool online);
 
+    /**
+     * Assigns the device type to the given device (gateway mode).
+     * By default, all device types belong to the device passed to the HAMqtt.
+     * The device is registered in the HAMqtt, so the gateway mode needs
+     * to be enabled first (see HAMqtt::enableGatewayMode).
+     * This method needs to be called before the connection with the broker is established.
+     *
+     * @param device Device that owns the device type.
+     * @returns Returns false if the device couldn't be registered in the HAMqtt.
+     */
+    bool setDevice(HADevice& device);
+
+    /**
+     * Returns the device that owns the device type.
+     */
+    const HADevice* getDevice() const;
+
+    /**
+     * Returns the HAMqtt instance that the device type is bound to.
+     * The device type is bound to the most recently constructed HAMqtt at construction,
+     * unless it's added to another instance (see HAMqtt::addDeviceType)
+     * or assigned to the device owned by another instance (see HABaseDeviceType::setDevice).
+     */
+    inline HAMqtt* mqtt() const
+        { return _mqtt; }
+
+    /**
+     * Sets QoS of the messages published on the data topics (state, position, etc.).
+     * QoS 1 is used only if the in-flight window is enabled in the HAMqtt
+     * (see HAMqtt::enableInflightWindow). Otherwise messages are published with QoS 0.
+     *
+     * @param qos QoS level (0 or 1).
+     */
+    inline void setQos(const uint8_t qos)
+        { _qos = (qos > 1 ? 1 : qos); }
+
+    inline uint8_t getQos() const
+        { return _qos; }
+
 #ifdef ARDUINOHA_TEST
     inline HASerializer* getSerializer() const
         { return _serializer; }
@@ -46,8 +86,11 @@ public:
 #endif
 
 protected:
-    HAMqtt* mqtt() const;
-    static void subscribeTopic(
+    void subscribeTopic(
+        const char* uniqueId,
+        const char* topicP
+    );
+    void unsubscribeTopic(
         const char* uniqueId,
         const char* topicP
     );
@@ -56,13 +99,71 @@ protected:
     virtual void destroySerializer();
 
     virtual void onMqttConnected() = 0;
+
+    /**
+     * Called when the device type is unbound from the HAMqtt instance or its device changes.
+     * Data cached for the previous binding (e.g. generated topics) needs to be released.
+     */
+    virtual void onBindingChanged() { }
+
+    /**
+     * Returns index of the entity that's currently served by the device type.
+     * Device types that serve multiple entities (e.g. HABinarySensorBank) override it,
+     * so the in-flight messages are retransmitted on the topic of the right entity.
+     */
+    virtual uint8_t getSelectedIndex() const { return 0; }
+
+    /**
+     * Points the device type to the entity with the given index (see getSelectedIndex).
+     */
+    virtual void selectIndex(const uint8_t index) { (void)index; }
+
     virtual void onMqttMessage(
         const char* topic,
         const uint8_t* payload,
         const uint16_t length
     );
 
+    /**
+     * Processes the event recorded in the interrupt handler (see HAMqtt::queueEvent).
+     * This method is called from the HAMqtt::loop.
+     *
+     * @param value Value of the event.
+     */
+    virtual void onQueuedEvent(const uint8_t value) { (void)value; }
+
+    /**
+     * Called when the state restore ends (see HAMqtt::beginStateRestore).
+     * The entity publishes the states that weren't restored from the broker.
+     */
+    virtual void onStateRestoreFinished() { }
+
     virtual void publishConfig();
+
+    /**
+     * Publishes empty retained config, so Home Assistant deletes the entity.
+     * It's called by the HAMqtt::removeDeviceType method.
+     */
+    virtual bool unpublishConfig();
+
+    /**
+     * Returns true if the device type publishes config of the given entity.
+     * It's used by the sweep of orphaned configs (see HAMqtt::sweepOrphanedConfigs).
+     *
+     * @param component Name of the component (e.g. "switch").
+     * @param objectId Unique ID of the entity.
+     */
+    virtual bool hasConfig(const char* component, const char* objectId) const;
+
+    /**
+     * Extends the discovery fingerprint (see HAMqtt::enableFastResume) with the component,
+     * unique ID and config of the entity. Device types that serve multiple entities
+     * (e.g. HABinarySensorBank) hash each of them.
+     *
+     * @param hash Current hash.
+     * @returns Returns the extended hash.
+     */
+    virtual uint32_t calculateFingerprint(uint32_t hash);
     virtual void publishAvailability();
     virtual bool publishOnDataTopic(
         const char* topicP,
@@ -71,11 +172,17 @@ protected:
         bool isProgmemValue = false
     );
 
-    const char* const _componentName;
+    const char* _componentName;
     const char* _uniqueId;
     const char* _name;
     HASerializer* _serializer;
 
+    /// The device that owns the device type. Nullptr means the device passed to the HAMqtt.
+    HADevice* _device;
+
+    /// The HAMqtt instance that the device type is bound to.
+    HAMqtt* _mqtt;
+
 private:
     enum Availability {
         AvailabilityDefault = 0,
@@ -83,7 +190,22 @@ private:
         AvailabilityOffline
     };
 
+    /**
+     * Shrinks the config built in the serializer until it fits the max packet size
+     * of the transport. Returns length of the config or zero if it can't fit.
+     *
+     * @param topicLength Length of the config topic.
+     */
+    uint16_t degradeConfig(const uint16_t topicLength);
+
+    /**
+     * Detaches the device type from the bound HAMqtt instance,
+     * so it's not published and it doesn't receive messages anymore.
+     */
+    void unbind();
+
     Availability _availability;
+    uint8_t _qos;
     friend class HAMqtt;
 };
 
@@ -27,6 +27,11 @@ bool HABinarySensor::setState(const bool state, const bool force)
     return false;
 }
 
+ARDUINOHA_ISR_ATTR bool HABinarySensor::setStateFromISR(const bool state)
+{
+    return (mqtt() && mqtt()->queueEvent(this, state));
+}
+
 void HABinarySensor::buildSerializer()
 {
     if (_serializer || !uniqueId()) {
@@ -54,6 +59,14 @@ void HABinarySensor::onMqttConnected()
     publishState(_currentState);
 }
 
+void HABinarySensor::onQueuedEvent(const uint8_t value)
+{
+    const bool state = (value != 0);
+    if (!setState(state)) {
+        setCurrentState(state); // it will be published once the connection is acquired
+    }
+}
+
 bool HABinarySensor::publishState(const bool state)
 {
     return publishOnDataTopic(
@@ -39,6 +39,17 @@ public:
      */
     bool setState(const bool state, const bool force = false);
 
+    /**
+     * Records a new state of the sensor without publishing it.
+     * It's safe to call this method from the interrupt handler.
+     * The state is published in the next HAMqtt::loop call.
+     * Please note that the event queue needs to be enabled using HAMqtt::enableEventQueue method.
+     *
+     * @param state New state of the sensor.
+     * @returns Returns false if the event couldn't be queued.
+     */
+    bool setStateFromISR(const bool state);
+
     /**
      * Sets current state of the sensor without publishing it to Home Assistant.
      * This method may be useful if you want to change state before connection
@@ -59,6 +70,7 @@ public:
 protected:
     virtual void buildSerializer() override;
     virtual void onMqttConnected() override;
+    virtual void onQueuedEvent(const uint8_t value) override;
 
 private:
     bool publishState(bool state);
@@ -0,0 +1,283 @@
+#include "HABinarySensorBank.h"
+#ifndef EX_ARDUINOHA_BINARY_SENSOR
+
+#include "../HAMqtt.h"
+#include "../HAUtils.h"
+#include "../utils/HASerializer.h"
+
+HABinarySensorBank::HABinarySensorBank(const char* bankId, const uint8_t inputsNb) :
+    HABaseDeviceType("binary_sensor", nullptr),
+    _bankId(bankId),
+    _objectId(nullptr),
+    _inputName(nullptr),
+    _selectedIndex(0),
+    _inputsNb(inputsNb),
+    _wordsNb((inputsNb + BitsPerWord - 1) / BitsPerWord),
+    _states(new uint32_t[_wordsNb]),
+    _class(nullptr),
+    _icon(nullptr)
+{
+    memset(_states, 0, sizeof(uint32_t) * _wordsNb);
+
+    if (_bankId) {
+        // bank ID + underscore + index (max 3 digits) + null terminator
+        _objectId = new char[strlen(_bankId) + 5];
+        selectInput(0);
+    }
+}
+
+HABinarySensorBank::~HABinarySensorBank()
+{
+    destroySerializer();
+    delete[] _states;
+
+    if (_objectId) {
+        delete[] _objectId;
+    }
+}
+
+bool HABinarySensorBank::setState(
+    const uint8_t index,
+    const bool state,
+    const bool force
+)
+{
+    if (index >= _inputsNb) {
+        return false;
+    }
+
+    if (!force && state == getCurrentState(index)) {
+        return true;
+    }
+
+    if (publishState(index, state)) {
+        setCurrentState(index, state);
+        return true;
+    }
+
+    return false;
+}
+
+bool HABinarySensorBank::setStates(const uint8_t wordIndex, const uint32_t states)
+{
+    if (wordIndex >= _wordsNb) {
+        return false;
+    }
+
+    uint32_t changes = _states[wordIndex] ^ states;
+    bool result = true;
+    uint8_t index = wordIndex * BitsPerWord;
+
+    while (changes != 0 && index < _inputsNb) {
+        if (changes & 1) {
+            result &= setState(index, !getCurrentState(index));
+        }
+
+        changes >>= 1;
+        index++;
+    }
+
+    return result;
+}
+
+void HABinarySensorBank::setCurrentState(const uint8_t index, const bool state)
+{
+    if (index >= _inputsNb) {
+        return;
+    }
+
+    const uint32_t mask = (uint32_t)1 << (index % BitsPerWord);
+    if (state) {
+        _states[index / BitsPerWord] |= mask;
+    } else {
+        _states[index / BitsPerWord] &= ~mask;
+    }
+}
+
+bool HABinarySensorBank::getCurrentState(const uint8_t index) const
+{
+    if (index >= _inputsNb) {
+        return false;
+    }
+
+    return (_states[index / BitsPerWord] >> (index % BitsPerWord)) & 1;
+}
+
+void HABinarySensorBank::buildSerializer()
+{
+    if (_serializer || !uniqueId()) {
+        return;
+    }
+
+    if (_name) {
+        // name + space + index (max 3 digits) + null terminator
+        const size_t nameLength = strlen(_name);
+        _inputName = new char[nameLength + 5];
+        memcpy(_inputName, _name, nameLength);
+        _inputName[nameLength] = ' ';
+
+        char* indexStr = &_inputName[nameLength + 1];
+        memset(indexStr, 0, 4);
+        HAUtils::numberToStr(indexStr, _selectedIndex);
+    }
+
+    _serializer = new HASerializer(this, 7); // 7 - max properties nb
+    _serializer->set(HANameProperty, _inputName);
+    _serializer->set(HAUniqueIdProperty, _uniqueId);
+    _serializer->set(HADeviceClassProperty, _class);
+    _serializer->set(HAIconProperty, _icon);
+    _serializer->set(HASerializer::WithDevice);
+    _serializer->set(HASerializer::WithAvailability);
+    _serializer->topic(HAStateTopic);
+}
+
+void HABinarySensorBank::destroySerializer()
+{
+    HABaseDeviceType::destroySerializer();
+
+    if (_inputName) {
+        delete[] _inputName;
+        _inputName = nullptr;
+    }
+}
+
+void HABinarySensorBank::onMqttConnected()
+{
+    if (!uniqueId()) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _inputsNb; i++) {
+        selectInput(i);
+        publishConfig();
+        HABaseDeviceType::publishAvailability();
+        publishOnDataTopic(
+            HAStateTopic,
+            getCurrentState(i) ? HAStateOn : HAStateOff,
+            true,
+            true
+        );
+    }
+}
+
+void HABinarySensorBank::publishAvailability()
+{
+    if (!uniqueId()) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _inputsNb; i++) {
+        selectInput(i);
+        HABaseDeviceType::publishAvailability();
+    }
+}
+
+bool HABinarySensorBank::unpublishConfig()
+{
+    if (!uniqueId()) {
+        return false;
+    }
+
+    bool result = true;
+    for (uint8_t i = 0; i < _inputsNb; i++) {
+        selectInput(i);
+        result &= HABaseDeviceType::unpublishConfig();
+    }
+
+    return result;
+}
+
+bool HABinarySensorBank::hasConfig(
+    const char* component,
+    const char* objectId
+) const
+{
+    if (!_bankId || strcmp(_componentName, component) != 0) {
+        return false;
+    }
+
+    // <bankId>_<index>
+    const size_t bankIdLength = strlen(_bankId);
+    if (
+        strncmp(objectId, _bankId, bankIdLength) != 0 ||
+        objectId[bankIdLength] != '_'
+    ) {
+        return false;
+    }
+
+    const char* indexStr = &objectId[bankIdLength + 1];
+    const size_t indexLength = strlen(indexStr);
+    if (indexLength == 0 || indexLength > 3 || (indexStr[0] == '0' && indexLength > 1)) {
+        return false;
+    }
+
+    uint16_t index = 0;
+    for (size_t i = 0; i < indexLength; i++) {
+        if (indexStr[i] < '0' || indexStr[i] > '9') {
+            return false;
+        }
+
+        index = index * 10 + (indexStr[i] - '0');
+    }
+
+    return index < _inputsNb;
+}
+
+uint32_t HABinarySensorBank::calculateFingerprint(uint32_t hash)
+{
+    if (!uniqueId()) {
+        return hash;
+    }
+
+    for (uint8_t i = 0; i < _inputsNb; i++) {
+        selectInput(i);
+        hash = HABaseDeviceType::calculateFingerprint(hash);
+    }
+
+    return hash;
+}
+
+uint8_t HABinarySensorBank::getSelectedIndex() const
+{
+    return _selectedIndex;
+}
+
+void HABinarySensorBank::selectIndex(const uint8_t index)
+{
+    selectInput(index);
+}
+
+void HABinarySensorBank::selectInput(const uint8_t index)
+{
+    if (!_objectId) {
+        return;
+    }
+
+    const size_t bankIdLength = strlen(_bankId);
+    memcpy(_objectId, _bankId, bankIdLength);
+    _objectId[bankIdLength] = '_';
+
+    char* indexStr = &_objectId[bankIdLength + 1];
+    memset(indexStr, 0, 4);
+    HAUtils::numberToStr(indexStr, index);
+
+    _uniqueId = _objectId;
+    _selectedIndex = index;
+}
+
+bool HABinarySensorBank::publishState(const uint8_t index, const bool state)
+{
+    if (!uniqueId()) {
+        return false;
+    }
+
+    selectInput(index);
+    return publishOnDataTopic(
+        HAStateTopic,
+        state ? HAStateOn : HAStateOff,
+        true,
+        true
+    );
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef AHA_HABINARYSENSORBANK_H
+#define AHA_HABINARYSENSORBANK_H
+
+#include "HABaseDeviceType.h"
+
+#ifndef EX_ARDUINOHA_BINARY_SENSOR
+
+/**
+ * Group of binary sensors that share the device class and icon.
+ * States are stored in the bitset and changes are detected word by word,
+ * so the bank is much cheaper than the same number of HABinarySensor objects.
+ * Each input is still exposed as a separate entity in Home Assistant.
+ * Unique ID of the input is generated using the following pattern: <bankId>_<index>
+ * The name set using the setName method is a prefix of the inputs' names: <name> <index>
+ */
+class HABinarySensorBank : public HABaseDeviceType
+{
+public:
+    static const uint8_t BitsPerWord = 32;
+
+    /**
+     * @param bankId Prefix of the unique IDs. Recommended characters: [a-z0-9\-_]
+     * @param inputsNb Number of the inputs in the bank.
+     */
+    HABinarySensorBank(const char* bankId, const uint8_t inputsNb);
+    virtual ~HABinarySensorBank();
+
+    /**
+     * Sets class of the inputs.
+     * You can find list of available values here: https://www.home-assistant.io/integrations/binary_sensor/#device-class
+     *
+     * @param class Class name
+     */
+    inline void setDeviceClass(const char* deviceClass)
+        { _class = deviceClass; }
+
+    /**
+     * Sets icon of the inputs.
+     * Any icon from MaterialDesignIcons.com. Prefix name with mdi:, ie mdi:home.
+     *
+     * @param class Icon name
+     */
+    inline void setIcon(const char* icon)
+        { _icon = icon; }
+
+    inline uint8_t getInputsNb() const
+        { return _inputsNb; }
+
+    /**
+     * Changes state of the single input and publishes MQTT message.
+     *
+     * @param index Index of the input.
+     * @param state New state of the input.
+     * @param force Forces to update state without comparing it to previous known state.
+     * @returns Returns true if MQTT message has been published successfully.
+     */
+    bool setState(const uint8_t index, const bool state, const bool force = false);
+
+    /**
+     * Changes states of 32 inputs at once.
+     * Only inputs that changed are published.
+     *
+     * @param wordIndex Index of the word (inputs from wordIndex * 32 to wordIndex * 32 + 31).
+     * @param states Bits of the inputs. The least significant bit is the first input.
+     * @returns Returns true if all changes have been published successfully.
+     */
+    bool setStates(const uint8_t wordIndex, const uint32_t states);
+
+    /**
+     * Sets current state of the input without publishing it to Home Assistant.
+     *
+     * @param index Index of the input.
+     * @param state New state of the input.
+     */
+    void setCurrentState(const uint8_t index, const bool state);
+
+    /**
+     * Returns last known state of the input.
+     */
+    bool getCurrentState(const uint8_t index) const;
+
+    /**
+     * Returns last known states of 32 inputs.
+     */
+    inline uint32_t getCurrentStates(const uint8_t wordIndex) const
+        { return (wordIndex < _wordsNb ? _states[wordIndex] : 0); }
+
+protected:
+    virtual void buildSerializer() override;
+    virtual void destroySerializer() override;
+    virtual void onMqttConnected() override;
+    virtual void publishAvailability() override;
+    virtual bool unpublishConfig() override;
+    virtual bool hasConfig(const char* component, const char* objectId) const override;
+    virtual uint32_t calculateFingerprint(uint32_t hash) override;
+    virtual uint8_t getSelectedIndex() const override;
+    virtual void selectIndex(const uint8_t index) override;
+
+private:
+    /**
+     * Points the unique ID of the entity to the given input.
+     */
+    void selectInput(const uint8_t index);
+    bool publishState(const uint8_t index, const bool state);
+
+    const char* _bankId;
+    char* _objectId;
+    char* _inputName;
+    uint8_t _selectedIndex;
+    const uint8_t _inputsNb;
+    const uint8_t _wordsNb;
+    uint32_t* _states;
+    const char* _class;
+    const char* _icon;
+};
+
+#endif
+#endif
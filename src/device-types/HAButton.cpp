@@ -56,10 +56,11 @@ void HAButton::onMqttMessage(
     (void)payload;
     (void)length;
 
-    if (_commandCallback && HASerializer::compareDataTopics(
+    if (_commandCallback && mqtt()->getContext().compareDataTopics(
         topic,
         uniqueId(),
-        HACommandTopic
+        HACommandTopic,
+        _device
     )) {
         _commandCallback(this);
     }
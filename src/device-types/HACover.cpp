@@ -3,23 +3,29 @@
 
 #include "../HAMqtt.h"
 #include "../HAUtils.h"
+#include "../utils/HAPayloadParser.h"
 #include "../utils/HASerializer.h"
 
 HACover::HACover(const char* uniqueId) :
     HABaseDeviceType("cover", uniqueId),
     _commandCallback(nullptr),
+    _positionCallback(nullptr),
     _currentState(StateUnknown),
     _currentPosition(DefaultPosition),
     _class(nullptr),
     _icon(nullptr),
-    _retain(false)
+    _retain(false),
+    _stateRestore(false),
+    _restoring(0)
 {
 
 }
 
 bool HACover::setState(const CoverState state, const bool force)
 {
-    if (!force && _currentState == state) {
+    // the state known by the broker wasn't received yet, so it may differ
+    const bool restoring = stopStateRestore(RestoredState);
+    if (!force && !restoring && _currentState == state) {
         return true;
     }
 
@@ -33,7 +39,8 @@ bool HACover::setState(const CoverState state, const bool force)
 
 bool HACover::setPosition(const int16_t position, const bool force)
 {
-    if (!force && _currentPosition == position) {
+    const bool restoring = stopStateRestore(RestoredPosition);
+    if (!force && !restoring && _currentPosition == position) {
         return true;
     }
 
@@ -52,7 +59,7 @@ void HACover::buildSerializer()
         return;
     }
 
-    _serializer = new HASerializer(this, 10); // 10 - max properties nb
+    _serializer = new HASerializer(this, 11); // 11 - max properties nb
     _serializer->set(HANameProperty, _name);
     _serializer->set(HAUniqueIdProperty, _uniqueId);
     _serializer->set(HADeviceClassProperty, _class);
@@ -68,6 +75,10 @@ void HACover::buildSerializer()
     _serializer->topic(HAStateTopic);
     _serializer->topic(HACommandTopic);
     _serializer->topic(HAPositionTopic);
+
+    if (_positionCallback) {
+        _serializer->topic(HASetPositionTopic);
+    }
 }
 
 void HACover::onMqttConnected()
@@ -79,12 +90,21 @@ void HACover::onMqttConnected()
     publishConfig();
     publishAvailability();
 
-    if (!_retain) {
+    if (_stateRestore) {
+        _restoring = RestoredState | RestoredPosition;
+        subscribeTopic(uniqueId(), HAStateTopic);
+        subscribeTopic(uniqueId(), HAPositionTopic);
+        mqtt()->beginStateRestore();
+    } else if (!_retain) {
         publishState(_currentState);
         publishPosition(_currentPosition);
     }
 
     subscribeTopic(uniqueId(), HACommandTopic);
+
+    if (_positionCallback) {
+        subscribeTopic(uniqueId(), HASetPositionTopic);
+    }
 }
 
 void HACover::onMqttMessage(
@@ -93,18 +113,117 @@ void HACover::onMqttMessage(
     const uint16_t length
 )
 {
-    if (_commandCallback && HASerializer::compareDataTopics(
+    const HAMqttContext& context = mqtt()->getContext();
+    if (
+        (_restoring & RestoredState) &&
+        context.compareDataTopics(topic, uniqueId(), HAStateTopic, _device)
+    ) {
+        restoreState(payload, length);
+        return;
+    }
+
+    if (
+        (_restoring & RestoredPosition) &&
+        context.compareDataTopics(topic, uniqueId(), HAPositionTopic, _device)
+    ) {
+        restorePosition(payload, length);
+        return;
+    }
+
+    if (_commandCallback && context.compareDataTopics(
+        topic,
+        uniqueId(),
+        HACommandTopic,
+        _device
+    )) {
+        handleCommand(payload, length);
+        return;
+    }
+
+    if (_positionCallback && context.compareDataTopics(
         topic,
         uniqueId(),
-        HACommandTopic
+        HASetPositionTopic,
+        _device
     )) {
-        char cmd[length + 1];
-        memset(cmd, 0, sizeof(cmd));
-        memcpy(cmd, payload, length);
-        handleCommand(cmd);
+        handlePositionCommand(payload, length);
     }
 }
 
+void HACover::onStateRestoreFinished()
+{
+    const uint8_t pending = _restoring;
+    if (!stopStateRestore(RestoredState | RestoredPosition) || _retain) {
+        return;
+    }
+
+    if (pending & RestoredState) {
+        publishState(_currentState);
+    }
+
+    if (pending & RestoredPosition) {
+        publishPosition(_currentPosition);
+    }
+}
+
+bool HACover::stopStateRestore(const uint8_t values)
+{
+    const uint8_t stopped = _restoring & values;
+    _restoring &= ~values;
+
+    if (stopped & RestoredState) {
+        unsubscribeTopic(uniqueId(), HAStateTopic);
+    }
+
+    if (stopped & RestoredPosition) {
+        unsubscribeTopic(uniqueId(), HAPositionTopic);
+    }
+
+    return (stopped != 0);
+}
+
+void HACover::restoreState(const uint8_t* state, const uint16_t length)
+{
+    static const char* const states[] = {
+        HAClosedState,
+        HAClosingState,
+        HAOpenState,
+        HAOpeningState,
+        HAStoppedState
+    };
+
+    const uint8_t index = HAPayloadParser::parseEnum(
+        state,
+        length,
+        states,
+        sizeof(states) / sizeof(states[0])
+    );
+    if (index == HAPayloadParser::NoMatch) {
+        return; // the current state will be published after the timeout
+    }
+
+    // the order of the states matches CoverState enum
+    _currentState = static_cast<CoverState>(StateClosed + index);
+    stopStateRestore(RestoredState);
+}
+
+void HACover::restorePosition(const uint8_t* position, const uint16_t length)
+{
+    int32_t value;
+    if (!HAPayloadParser::parseInteger(
+        position,
+        length,
+        value,
+        DefaultPosition + 1,
+        INT16_MAX
+    )) {
+        return; // the current position will be published after the timeout
+    }
+
+    _currentPosition = static_cast<int16_t>(value);
+    stopStateRestore(RestoredPosition);
+}
+
 bool HACover::publishState(CoverState state)
 {
     if (!uniqueId() || state == StateUnknown) {
@@ -158,18 +277,41 @@ bool HACover::publishPosition(int16_t position)
     return publishOnDataTopic(HAPositionTopic, str, true);
 }
 
-void HACover::handleCommand(const char* cmd)
+void HACover::handleCommand(const uint8_t* cmd, const uint16_t length)
 {
     if (!_commandCallback) {
         return;
     }
 
-    if (strcmp_P(cmd, HACloseCommand) == 0) {
-        _commandCallback(CommandClose, this);
-    } else if (strcmp_P(cmd, HAOpenCommand) == 0) {
-        _commandCallback(CommandOpen, this);
-    } else if (strcmp_P(cmd, HAStopCommand) == 0) {
-        _commandCallback(CommandStop, this);
+    static const char* const commands[] = {
+        HAOpenCommand,
+        HACloseCommand,
+        HAStopCommand
+    };
+
+    const uint8_t index = HAPayloadParser::parseEnum(
+        cmd,
+        length,
+        commands,
+        sizeof(commands) / sizeof(commands[0])
+    );
+    if (index != HAPayloadParser::NoMatch) {
+        // the order of the commands matches CoverCommand enum
+        _commandCallback(static_cast<CoverCommand>(CommandOpen + index), this);
+    }
+}
+
+void HACover::handlePositionCommand(const uint8_t* position, const uint16_t length)
+{
+    int32_t value;
+    if (_positionCallback && HAPayloadParser::parseInteger(
+        position,
+        length,
+        value,
+        ClosedPosition,
+        OpenPosition
+    )) {
+        _positionCallback(static_cast<int16_t>(value), this);
     }
 }
 
@@ -6,11 +6,14 @@
 #ifndef EX_ARDUINOHA_COVER
 
 #define HACOVER_CALLBACK(name) void (*name)(CoverCommand cmd, HACover* sender)
+#define HACOVER_POSITION_CALLBACK(name) void (*name)(int16_t position, HACover* sender)
 
 class HACover : public HABaseDeviceType
 {
 public:
     static const int16_t DefaultPosition = -32768;
+    static const int16_t ClosedPosition = 0;
+    static const int16_t OpenPosition = 100;
 
     enum CoverState {
         StateUnknown = 0,
@@ -112,6 +115,19 @@ public:
     inline void setRetain(const bool retain)
         { _retain = retain; }
 
+    /**
+     * Enables restore of the state and position from the broker.
+     * Each time the connection is acquired, the cover subscribes to its retained state and position
+     * and the current values are replaced by the received ones, so they don't flap after reboot.
+     * The current values are published only if the retained ones weren't received within
+     * the timeout (see HAMqtt::setStateRestoreTimeout).
+     * The restore of the value is stopped if the setState or setPosition method is called in the meantime.
+     *
+     * @param restore
+     */
+    inline void setStateRestore(const bool restore)
+        { _stateRestore = restore; }
+
     /**
      * Registers callback that will be called each time the command from HA is received.
      * Please note that it's not possible to register multiple callbacks for the same covers.
@@ -121,6 +137,18 @@ public:
     inline void onCommand(HACOVER_CALLBACK(callback))
         { _commandCallback = callback; }
 
+    /**
+     * Registers callback that will be called each time the position is set in HA.
+     * The position is in range from HACover::ClosedPosition to HACover::OpenPosition,
+     * other payloads are ignored. The position slider is shown in HA only if the callback is registered.
+     * Please note that the position of the cover is not changed automatically,
+     * so you need to call HACover::setPosition once the cover is moved.
+     *
+     * @param callback
+     */
+    inline void onPositionCommand(HACOVER_POSITION_CALLBACK(callback))
+        { _positionCallback = callback; }
+
 protected:
     virtual void buildSerializer() override;
     virtual void onMqttConnected() override;
@@ -129,18 +157,36 @@ protected:
         const uint8_t* payload,
         const uint16_t length
     ) override;
+    virtual void onStateRestoreFinished() override;
 
 private:
+    enum RestoredValue {
+        RestoredState = 1,
+        RestoredPosition = 2
+    };
+
     bool publishState(const CoverState state);
     bool publishPosition(const int16_t position);
-    void handleCommand(const char* cmd);
+    void handleCommand(const uint8_t* cmd, const uint16_t length);
+    void handlePositionCommand(const uint8_t* position, const uint16_t length);
+    void restoreState(const uint8_t* state, const uint16_t length);
+    void restorePosition(const uint8_t* position, const uint16_t length);
+
+    /**
+     * Unsubscribes from the given retained values (RestoredValue flags).
+     * Returns true if the restore of any of them was in progress.
+     */
+    bool stopStateRestore(const uint8_t values);
 
     HACOVER_CALLBACK(_commandCallback);
+    HACOVER_POSITION_CALLBACK(_positionCallback);
     CoverState _currentState;
     int16_t _currentPosition;
     const char* _class;
     const char* _icon;
     bool _retain;
+    bool _stateRestore;
+    uint8_t _restoring;
 };
 
 #endif
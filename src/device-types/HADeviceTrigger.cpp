@@ -9,7 +9,8 @@ HADeviceTrigger::HADeviceTrigger(const char* type, const char* subtype) :
     _type(type),
     _subtype(subtype),
     _isProgmemType(false),
-    _isProgmemSubtype(false)
+    _isProgmemSubtype(false),
+    _topic(nullptr)
 {
     buildUniqueId();
 }
@@ -19,7 +20,8 @@ HADeviceTrigger::HADeviceTrigger(TriggerType type, const char* subtype) :
     _type(determineProgmemType(type)),
     _subtype(subtype),
     _isProgmemType(true),
-    _isProgmemSubtype(false)
+    _isProgmemSubtype(false),
+    _topic(nullptr)
 {
     buildUniqueId();
 }
@@ -29,7 +31,8 @@ HADeviceTrigger::HADeviceTrigger(const char* type, TriggerSubtype subtype) :
     _type(type),
     _subtype(determineProgmemSubtype(subtype)),
     _isProgmemType(false),
-    _isProgmemSubtype(true)
+    _isProgmemSubtype(true),
+    _topic(nullptr)
 {
     buildUniqueId();
 }
@@ -39,18 +42,43 @@ HADeviceTrigger::HADeviceTrigger(TriggerType type, TriggerSubtype subtype) :
     _type(determineProgmemType(type)),
     _subtype(determineProgmemSubtype(subtype)),
     _isProgmemType(true),
-    _isProgmemSubtype(true)
+    _isProgmemSubtype(true),
+    _topic(nullptr)
 {
     buildUniqueId();
 }
 
+HADeviceTrigger::~HADeviceTrigger()
+{
+    if (_topic) {
+        delete[] _topic;
+    }
+
+    if (_uniqueId) {
+        delete[] _uniqueId;
+    }
+}
+
 bool HADeviceTrigger::trigger()
 {
-    if (!_type || !_subtype) {
+    if (!mqtt() || !_type || !_subtype || (!_topic && !buildTopic())) {
         return false;
     }
 
-    return publishOnDataTopic(HATopic, "");
+    if (getQos() > 0 && mqtt()->getInflightWindow()) {
+        return mqtt()->publishReliably(this, HATopic, _topic, "", 0, false, false);
+    }
+
+    // the payload is empty, so there is nothing to write between begin and end
+    return (
+        mqtt()->beginPublish(_topic, 0, false, true) &&
+        mqtt()->endPublish()
+    );
+}
+
+ARDUINOHA_ISR_ATTR bool HADeviceTrigger::triggerFromISR()
+{
+    return (mqtt() && mqtt()->queueEvent(this, 0));
 }
 
 void HADeviceTrigger::buildSerializer()
@@ -71,12 +99,28 @@ void HADeviceTrigger::buildSerializer()
     _serializer->topic(HATopic);
 }
 
+void HADeviceTrigger::onBindingChanged()
+{
+    // the topic is generated again for the new binding on the next trigger
+    if (_topic) {
+        delete[] _topic;
+        _topic = nullptr;
+    }
+}
+
+void HADeviceTrigger::onQueuedEvent(const uint8_t value)
+{
+    (void)value;
+    trigger(); // events that occurred while disconnected are dropped
+}
+
 void HADeviceTrigger::onMqttConnected()
 {
     if (!uniqueId()) {
         return;
     }
 
+    buildTopic(); // the data prefix may change between connections
     publishConfig();
 }
 
@@ -95,6 +139,37 @@ uint16_t HADeviceTrigger::calculateIdSize() const
     return typeSize + subtypeSize + 2;
 }
 
+bool HADeviceTrigger::buildTopic()
+{
+    if (_topic) {
+        delete[] _topic;
+        _topic = nullptr;
+    }
+
+    if (!mqtt()) {
+        return false;
+    }
+
+    const HAMqttContext& context = mqtt()->getContext();
+    const uint16_t topicLength = context.calculateDataTopicLength(
+        uniqueId(),
+        HATopic,
+        _device
+    );
+    if (topicLength == 0 || !uniqueId()) {
+        return false;
+    }
+
+    _topic = new char[topicLength];
+    if (!context.generateDataTopic(_topic, uniqueId(), HATopic, _device)) {
+        delete[] _topic;
+        _topic = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
 void HADeviceTrigger::buildUniqueId()
 {
     const uint16_t idSize = calculateIdSize();
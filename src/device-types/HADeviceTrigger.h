@@ -41,6 +41,7 @@ public:
     HADeviceTrigger(TriggerType type, const char* subtype);
     HADeviceTrigger(const char* type, TriggerSubtype subtype);
     HADeviceTrigger(TriggerType type, TriggerSubtype subtype);
+    virtual ~HADeviceTrigger();
 
     /**
      * Returns type of the trigger.
@@ -80,18 +81,37 @@ public:
 
     /**
      * Publishes MQTT message with the trigger event.
+     * The topic is generated once per connection, so the trigger doesn't allocate
+     * or format anything on the hot path.
      *
      * @returns Returns true if MQTT message has been published successfully.
      */
     bool trigger();
 
+    /**
+     * Records the trigger event without publishing it.
+     * It's safe to call this method from the interrupt handler.
+     * The event is published in the next HAMqtt::loop call.
+     * Please note that the event queue needs to be enabled using HAMqtt::enableEventQueue method.
+     *
+     * @returns Returns false if the event couldn't be queued.
+     */
+    bool triggerFromISR();
+
 protected:
     virtual void buildSerializer() override;
     virtual void onMqttConnected() override;
+    virtual void onBindingChanged() override;
+    virtual void onQueuedEvent(const uint8_t value) override;
 
 private:
     uint16_t calculateIdSize() const;
     void buildUniqueId();
+
+    /**
+     * Generates the topic that's used by the trigger method.
+     */
+    bool buildTopic();
     const char* determineProgmemType(TriggerType type) const;
     const char* determineProgmemSubtype(TriggerSubtype subtype) const;
 
@@ -100,6 +120,7 @@ private:
     const char* _subtype;
     bool _isProgmemType;
     bool _isProgmemSubtype;
+    char* _topic;
 };
 
 #endif
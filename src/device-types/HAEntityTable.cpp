@@ -0,0 +1,405 @@
+#include "HAEntityTable.h"
+#ifndef EX_ARDUINOHA_ENTITY_TABLE
+
+#include "../HAMqtt.h"
+#include "../utils/HAPayloadParser.h"
+#include "../utils/HASerializer.h"
+#include "../utils/HASessionState.h"
+
+static const char* ComponentNames[HAEntityTable::ComponentsNb] = {
+    "binary_sensor",
+    "sensor",
+    "switch",
+    "button"
+};
+
+HAEntityTable::HAEntityTable(
+    const HAEntityDescriptor* descriptors,
+    const uint8_t descriptorsNb
+) :
+    HABaseDeviceType(ComponentNames[BinarySensor], nullptr),
+    _descriptors(descriptors),
+    _descriptorsNb(descriptorsNb),
+    _enabled(new uint8_t[(descriptorsNb + 7) / 8]),
+    _states(new uint8_t[(descriptorsNb + 7) / 8]),
+    _objectId(nullptr),
+    _selected(),
+    _selectedIndex(0),
+    _materialized(nullptr),
+    _materializedNb(0),
+    _commandCallback(nullptr)
+{
+    memset(_enabled, 0, (descriptorsNb + 7) / 8);
+    memset(_states, 0, (descriptorsNb + 7) / 8);
+
+    size_t maxIdLength = 0;
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        HAEntityDescriptor descriptor;
+        memcpy_P(&descriptor, &_descriptors[i], sizeof(HAEntityDescriptor));
+
+        const size_t idLength = strlen_P(descriptor.uniqueId);
+        if (idLength > maxIdLength) {
+            maxIdLength = idLength;
+        }
+
+        setBit(_enabled, i, descriptor.flags & EnabledByDefault);
+    }
+
+    if (_descriptorsNb > 0) {
+        _objectId = new char[maxIdLength + 1];
+        selectEntity(0);
+    }
+}
+
+HAEntityTable::~HAEntityTable()
+{
+    for (uint8_t i = 0; i < _materializedNb; i++) {
+        delete _materialized[i].deviceType;
+        delete[] _materialized[i].uniqueId;
+    }
+
+    if (_materialized) {
+        delete[] _materialized;
+    }
+
+    if (_objectId) {
+        delete[] _objectId;
+    }
+
+    delete[] _enabled;
+    delete[] _states;
+}
+
+void HAEntityTable::setEnabled(const uint8_t index, const bool enabled)
+{
+    if (index >= _descriptorsNb) {
+        return;
+    }
+
+    setBit(_enabled, index, enabled);
+}
+
+bool HAEntityTable::isEnabled(const uint8_t index) const
+{
+    if (index >= _descriptorsNb) {
+        return false;
+    }
+
+    return getBit(_enabled, index);
+}
+
+uint8_t HAEntityTable::getEnabledNb() const
+{
+    uint8_t enabledNb = 0;
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        if (getBit(_enabled, i)) {
+            enabledNb++;
+        }
+    }
+
+    return enabledNb;
+}
+
+bool HAEntityTable::setState(
+    const uint8_t index,
+    const bool state,
+    const bool force
+)
+{
+    if (!isServed(index)) {
+        return false;
+    }
+
+    selectEntity(index);
+    if (_selected.component != BinarySensor && _selected.component != Switch) {
+        return false;
+    }
+
+    if (!force && state == getBit(_states, index)) {
+        return true;
+    }
+
+    if (publishOnDataTopic(
+        HAStateTopic,
+        state ? HAStateOn : HAStateOff,
+        _selected.flags & RetainState,
+        true
+    )) {
+        setBit(_states, index, state);
+        return true;
+    }
+
+    return false;
+}
+
+bool HAEntityTable::getCurrentState(const uint8_t index) const
+{
+    if (index >= _descriptorsNb) {
+        return false;
+    }
+
+    return getBit(_states, index);
+}
+
+bool HAEntityTable::setValue(const uint8_t index, const char* value)
+{
+    if (!isServed(index)) {
+        return false;
+    }
+
+    selectEntity(index);
+    if (_selected.component != Sensor) {
+        return false;
+    }
+
+    return publishOnDataTopic(HAStateTopic, value, _selected.flags & RetainState);
+}
+
+HABaseDeviceType* HAEntityTable::materialize(
+    const uint8_t index,
+    HAENTITYTABLE_FACTORY(factory)
+)
+{
+    if (!factory || !isServed(index)) {
+        return nullptr;
+    }
+
+    selectEntity(index);
+    char* uniqueId = new char[strlen(_objectId) + 1];
+    strcpy(uniqueId, _objectId);
+
+    HABaseDeviceType* deviceType = factory(index, uniqueId);
+    if (!deviceType) {
+        delete[] uniqueId;
+        return nullptr;
+    }
+
+    MaterializedEntity* materialized = new MaterializedEntity[_materializedNb + 1];
+    if (_materialized) {
+        memcpy(materialized, _materialized, sizeof(MaterializedEntity) * _materializedNb);
+        delete[] _materialized;
+    }
+
+    _materialized = materialized;
+    _materialized[_materializedNb].index = index;
+    _materialized[_materializedNb].uniqueId = uniqueId;
+    _materialized[_materializedNb].deviceType = deviceType;
+    _materializedNb++;
+
+    return deviceType;
+}
+
+HABaseDeviceType* HAEntityTable::getMaterialized(const uint8_t index) const
+{
+    for (uint8_t i = 0; i < _materializedNb; i++) {
+        if (_materialized[i].index == index) {
+            return _materialized[i].deviceType;
+        }
+    }
+
+    return nullptr;
+}
+
+void HAEntityTable::buildSerializer()
+{
+    if (_serializer || !uniqueId()) {
+        return;
+    }
+
+    _serializer = new HASerializer(this, 6); // 6 - max properties nb
+    _serializer->set(HAUniqueIdProperty, _uniqueId);
+    _serializer->set(HASerializer::WithDevice);
+    _serializer->set(HASerializer::WithAvailability);
+
+    if (_selected.component != Button) {
+        _serializer->topic(HAStateTopic);
+    }
+
+    if (_selected.component == Switch || _selected.component == Button) {
+        _serializer->topic(HACommandTopic);
+    }
+}
+
+void HAEntityTable::onMqttConnected()
+{
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        if (!isServed(i)) {
+            continue;
+        }
+
+        selectEntity(i);
+        publishConfig();
+        HABaseDeviceType::publishAvailability();
+
+        if (_selected.component == BinarySensor || _selected.component == Switch) {
+            publishOnDataTopic(
+                HAStateTopic,
+                getBit(_states, i) ? HAStateOn : HAStateOff,
+                _selected.flags & RetainState,
+                true
+            );
+        }
+
+        if (_selected.component == Switch || _selected.component == Button) {
+            subscribeTopic(uniqueId(), HACommandTopic);
+        }
+    }
+}
+
+void HAEntityTable::publishAvailability()
+{
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        if (isServed(i)) {
+            selectEntity(i);
+            HABaseDeviceType::publishAvailability();
+        }
+    }
+}
+
+bool HAEntityTable::unpublishConfig()
+{
+    bool result = true;
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        if (isServed(i)) {
+            selectEntity(i);
+            result &= HABaseDeviceType::unpublishConfig();
+        }
+    }
+
+    return result;
+}
+
+bool HAEntityTable::hasConfig(const char* component, const char* objectId) const
+{
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        if (!isServed(i)) {
+            continue;
+        }
+
+        HAEntityDescriptor descriptor;
+        memcpy_P(&descriptor, &_descriptors[i], sizeof(HAEntityDescriptor));
+        if (
+            strcmp(ComponentNames[descriptor.component], component) == 0 &&
+            strcmp_P(objectId, descriptor.uniqueId) == 0
+        ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void HAEntityTable::onMqttMessage(
+    const char* topic,
+    const uint8_t* payload,
+    const uint16_t length
+)
+{
+    if (!_commandCallback) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        if (!isServed(i)) {
+            continue;
+        }
+
+        selectEntity(i);
+        if (
+            (_selected.component == Switch || _selected.component == Button) &&
+            mqtt()->getContext().compareDataTopics(
+                topic,
+                uniqueId(),
+                HACommandTopic,
+                _device
+            )
+        ) {
+            bool state = true;
+            if (
+                _selected.component == Button ||
+                HAPayloadParser::parseBool(payload, length, state)
+            ) {
+                _commandCallback(i, state, this);
+            }
+
+            return;
+        }
+    }
+}
+
+uint32_t HAEntityTable::calculateFingerprint(uint32_t hash)
+{
+    if (!_objectId) {
+        return hash;
+    }
+
+    // enabling the entity changes the discovery even if it's materialized
+    hash = HASessionState::hash(hash, (const char*)_enabled, (_descriptorsNb + 7) / 8);
+
+    for (uint8_t i = 0; i < _descriptorsNb; i++) {
+        if (isServed(i)) {
+            selectEntity(i);
+            hash = HABaseDeviceType::calculateFingerprint(hash);
+        }
+    }
+
+    return hash;
+}
+
+uint8_t HAEntityTable::getSelectedIndex() const
+{
+    return _selectedIndex;
+}
+
+void HAEntityTable::selectIndex(const uint8_t index)
+{
+    selectEntity(index);
+}
+
+void HAEntityTable::selectEntity(const uint8_t index)
+{
+    if (!_objectId || index >= _descriptorsNb) {
+        return;
+    }
+
+    memcpy_P(&_selected, &_descriptors[index], sizeof(HAEntityDescriptor));
+    strcpy_P(_objectId, _selected.uniqueId);
+
+    _uniqueId = _objectId;
+    _componentName = _selected.component < ComponentsNb
+        ? ComponentNames[_selected.component]
+        : ComponentNames[BinarySensor];
+    _selectedIndex = index;
+}
+
+bool HAEntityTable::isServed(const uint8_t index) const
+{
+    if (index >= _descriptorsNb || !getBit(_enabled, index)) {
+        return false;
+    }
+
+    HAEntityDescriptor descriptor;
+    memcpy_P(&descriptor, &_descriptors[index], sizeof(HAEntityDescriptor));
+    if (descriptor.component >= ComponentsNb) {
+        return false;
+    }
+
+    return getMaterialized(index) == nullptr;
+}
+
+bool HAEntityTable::getBit(const uint8_t* bits, const uint8_t index)
+{
+    return (bits[index / 8] >> (index % 8)) & 1;
+}
+
+void HAEntityTable::setBit(uint8_t* bits, const uint8_t index, const bool value)
+{
+    const uint8_t mask = 1 << (index % 8);
+    if (value) {
+        bits[index / 8] |= mask;
+    } else {
+        bits[index / 8] &= ~mask;
+    }
+}
+
+#endif
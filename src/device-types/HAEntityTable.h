@@ -0,0 +1,181 @@
+#ifndef AHA_HAENTITYTABLE_H
+#define AHA_HAENTITYTABLE_H
+
+#include "HABaseDeviceType.h"
+
+#ifndef EX_ARDUINOHA_ENTITY_TABLE
+
+class HAEntityTable;
+
+#define HAENTITYTABLE_COMMAND_CALLBACK(name) void (*name)(uint8_t index, bool state, HAEntityTable* sender)
+#define HAENTITYTABLE_FACTORY(name) HABaseDeviceType* (*name)(uint8_t index, const char* uniqueId)
+
+/**
+ * Static description of the entity. The table of descriptors and the unique IDs
+ * need to be stored in the flash memory (PROGMEM), for example:
+ *
+ * const char relayId[] PROGMEM = "relay";
+ * const HAEntityDescriptor entities[] PROGMEM = {
+ *     {relayId, HAEntityTable::Switch, HAEntityTable::EnabledByDefault}
+ * };
+ */
+struct HAEntityDescriptor
+{
+    const char* uniqueId;
+    uint8_t component;
+    uint8_t flags;
+};
+
+/**
+ * Set of entities described by the static table of descriptors.
+ * Enabled entities are exposed to Home Assistant by a single object that's pointed
+ * to each entity in turn, so the entity costs two bits of RAM (enabled flag and state).
+ * Entities that need the full functionality can be materialized into regular
+ * device types using the factory (see HAEntityTable::materialize).
+ */
+class HAEntityTable : public HABaseDeviceType
+{
+public:
+    enum Component {
+        BinarySensor = 0,
+        Sensor,
+        Switch,
+        Button,
+        ComponentsNb
+    };
+
+    enum Flags {
+        EnabledByDefault = 1,
+        RetainState = 2
+    };
+
+    /**
+     * @param descriptors Table of descriptors stored in the flash memory.
+     * @param descriptorsNb Number of descriptors in the table.
+     */
+    HAEntityTable(const HAEntityDescriptor* descriptors, const uint8_t descriptorsNb);
+    virtual ~HAEntityTable();
+
+    inline uint8_t getDescriptorsNb() const
+        { return _descriptorsNb; }
+
+    /**
+     * Enables or disables the entity.
+     * It needs to be done before the connection with the broker is established.
+     *
+     * @param index Index of the descriptor.
+     * @param enabled New state of the entity.
+     */
+    void setEnabled(const uint8_t index, const bool enabled);
+
+    /**
+     * Returns true if the entity is enabled.
+     */
+    bool isEnabled(const uint8_t index) const;
+
+    /**
+     * Returns number of the enabled entities.
+     */
+    uint8_t getEnabledNb() const;
+
+    /**
+     * Changes state of the binary sensor or switch and publishes MQTT message.
+     *
+     * @param index Index of the descriptor.
+     * @param state New state of the entity.
+     * @param force Forces to update state without comparing it to previous known state.
+     * @returns Returns true if MQTT message has been published successfully.
+     */
+    bool setState(const uint8_t index, const bool state, const bool force = false);
+
+    /**
+     * Returns last known state of the binary sensor or switch.
+     */
+    bool getCurrentState(const uint8_t index) const;
+
+    /**
+     * Publishes value of the sensor. The value is not stored in the table.
+     *
+     * @param index Index of the descriptor.
+     * @param value Value to publish.
+     * @returns Returns true if MQTT message has been published successfully.
+     */
+    bool setValue(const uint8_t index, const char* value);
+
+    /**
+     * Registers callback that will be called each time the command for a switch or button
+     * is received from Home Assistant. The state is always true for buttons.
+     * States of switches are not changed automatically, so you need to call HAEntityTable::setState.
+     *
+     * @param callback
+     */
+    inline void onCommand(HAENTITYTABLE_COMMAND_CALLBACK(callback))
+        { _commandCallback = callback; }
+
+    /**
+     * Creates the regular device type for the enabled entity using the given factory.
+     * The factory receives unique ID copied to RAM that's valid as long as the table exists.
+     * The materialized entity is not handled by the table anymore and it's deleted with the table.
+     * It needs to be done before the connection with the broker is established.
+     *
+     * @param index Index of the descriptor.
+     * @param factory Function that creates the device type.
+     * @returns Returns the created device type or nullptr if the entity is disabled or already materialized.
+     */
+    HABaseDeviceType* materialize(const uint8_t index, HAENTITYTABLE_FACTORY(factory));
+
+    /**
+     * Returns the materialized device type of the entity or nullptr.
+     */
+    HABaseDeviceType* getMaterialized(const uint8_t index) const;
+
+protected:
+    virtual void buildSerializer() override;
+    virtual void onMqttConnected() override;
+    virtual void publishAvailability() override;
+    virtual bool unpublishConfig() override;
+    virtual bool hasConfig(const char* component, const char* objectId) const override;
+    virtual uint32_t calculateFingerprint(uint32_t hash) override;
+    virtual void onMqttMessage(
+        const char* topic,
+        const uint8_t* payload,
+        const uint16_t length
+    ) override;
+    virtual uint8_t getSelectedIndex() const override;
+    virtual void selectIndex(const uint8_t index) override;
+
+private:
+    struct MaterializedEntity
+    {
+        uint8_t index;
+        char* uniqueId;
+        HABaseDeviceType* deviceType;
+    };
+
+    /**
+     * Points the component and unique ID of the object to the given entity.
+     */
+    void selectEntity(const uint8_t index);
+
+    /**
+     * Returns true if the entity is enabled and handled by the table.
+     */
+    bool isServed(const uint8_t index) const;
+
+    static bool getBit(const uint8_t* bits, const uint8_t index);
+    static void setBit(uint8_t* bits, const uint8_t index, const bool value);
+
+    const HAEntityDescriptor* _descriptors;
+    const uint8_t _descriptorsNb;
+    uint8_t* _enabled;
+    uint8_t* _states;
+    char* _objectId;
+    HAEntityDescriptor _selected;
+    uint8_t _selectedIndex;
+    MaterializedEntity* _materialized;
+    uint8_t _materializedNb;
+    HAENTITYTABLE_COMMAND_CALLBACK(_commandCallback);
+};
+
+#endif
+#endif
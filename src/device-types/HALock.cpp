@@ -2,6 +2,7 @@
 #ifndef EX_ARDUINOHA_LOCK
 
 #include "../HAMqtt.h"
+#include "../utils/HAPayloadParser.h"
 #include "../utils/HASerializer.h"
 
 HALock::HALock(const char* uniqueId) :
@@ -9,6 +10,8 @@ HALock::HALock(const char* uniqueId) :
     _icon(nullptr),
     _retain(false),
     _currentState(StateUnknown),
+    _stateRestore(false),
+    _restoringState(false),
     _commandCallback(nullptr)
 {
 
@@ -16,7 +19,9 @@ HALock::HALock(const char* uniqueId) :
 
 bool HALock::setState(const LockState state, const bool force)
 {
-    if (!force && state == _currentState) {
+    // the state known by the broker wasn't received yet, so it may differ
+    const bool restoring = stopStateRestore();
+    if (!force && !restoring && state == _currentState) {
         return true;
     }
 
@@ -63,7 +68,11 @@ void HALock::onMqttConnected()
     publishConfig();
     publishAvailability();
 
-    if (!_retain) {
+    if (_stateRestore) {
+        _restoringState = true;
+        subscribeTopic(uniqueId(), HAStateTopic);
+        mqtt()->beginStateRestore();
+    } else if (!_retain) {
         publishState(_currentState);
     }
 
@@ -76,19 +85,42 @@ void HALock::onMqttMessage(
     const uint16_t length
 )
 {
-    (void)payload;
-    (void)length;
+    if (_restoringState && mqtt()->getContext().compareDataTopics(
+        topic,
+        uniqueId(),
+        HAStateTopic,
+        _device
+    )) {
+        restoreState(payload, length);
+        return;
+    }
 
-    if (_commandCallback && HASerializer::compareDataTopics(
+    if (_commandCallback && mqtt()->getContext().compareDataTopics(
         topic,
         uniqueId(),
-        HACommandTopic
+        HACommandTopic,
+        _device
     )) {
-        char cmd[length + 1];
-        memset(cmd, 0, sizeof(cmd));
-        memcpy(cmd, payload, length);
-        handleCommand(cmd);
+        handleCommand(payload, length);
+    }
+}
+
+void HALock::onStateRestoreFinished()
+{
+    if (stopStateRestore() && !_retain) {
+        publishState(_currentState);
+    }
+}
+
+bool HALock::stopStateRestore()
+{
+    if (!_restoringState) {
+        return false;
     }
+
+    _restoringState = false;
+    unsubscribeTopic(uniqueId(), HAStateTopic);
+    return true;
 }
 
 bool HALock::publishState(const LockState state)
@@ -105,19 +137,50 @@ bool HALock::publishState(const LockState state)
     );
 }
 
-void HALock::handleCommand(const char* cmd)
+void HALock::handleCommand(const uint8_t* cmd, const uint16_t length)
 {
     if (!_commandCallback) {
         return;
     }
 
-    if (strcmp_P(cmd, HALockCommand) == 0) {
-        _commandCallback(CommandLock, this);
-    } else if (strcmp_P(cmd, HAUnlockCommand) == 0) {
-        _commandCallback(CommandUnlock, this);
-    } else if (strcmp_P(cmd, HAOpenCommand) == 0) {
-        _commandCallback(CommandOpen, this);
+    static const char* const commands[] = {
+        HALockCommand,
+        HAUnlockCommand,
+        HAOpenCommand
+    };
+
+    const uint8_t index = HAPayloadParser::parseEnum(
+        cmd,
+        length,
+        commands,
+        sizeof(commands) / sizeof(commands[0])
+    );
+    if (index != HAPayloadParser::NoMatch) {
+        // the order of the commands matches LockCommand enum
+        _commandCallback(static_cast<LockCommand>(CommandLock + index), this);
+    }
+}
+
+void HALock::restoreState(const uint8_t* state, const uint16_t length)
+{
+    static const char* const states[] = {
+        HAStateLocked,
+        HAStateUnlocked
+    };
+
+    const uint8_t index = HAPayloadParser::parseEnum(
+        state,
+        length,
+        states,
+        sizeof(states) / sizeof(states[0])
+    );
+    if (index == HAPayloadParser::NoMatch) {
+        return; // the current state will be published after the timeout
     }
+
+    // the order of the states matches LockState enum
+    _currentState = static_cast<LockState>(StateLocked + index);
+    stopStateRestore();
 }
 
 #endif
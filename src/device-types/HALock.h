@@ -42,6 +42,19 @@ public:
     inline void setRetain(const bool retain)
         { _retain = retain; }
 
+    /**
+     * Enables restore of the state from the broker.
+     * Each time the connection is acquired, the lock subscribes to its retained state
+     * and the current state is replaced by the received one, so the state doesn't flap after reboot.
+     * The current state is published only if the retained state wasn't received within
+     * the timeout (see HAMqtt::setStateRestoreTimeout).
+     * The restore is stopped if the setState method is called in the meantime.
+     *
+     * @param restore
+     */
+    inline void setStateRestore(const bool restore)
+        { _stateRestore = restore; }
+
     /**
      * Changes state of the lock and publishes MQTT message.
      * Please note that if a new value is the same as previous one,
@@ -87,14 +100,24 @@ protected:
         const uint8_t* payload,
         const uint16_t length
     ) override;
+    virtual void onStateRestoreFinished() override;
 
 private:
     bool publishState(const LockState state);
-    void handleCommand(const char* cmd);
+    void handleCommand(const uint8_t* cmd, const uint16_t length);
+    void restoreState(const uint8_t* state, const uint16_t length);
+
+    /**
+     * Unsubscribes from the retained state.
+     * Returns true if the restore was in progress.
+     */
+    bool stopStateRestore();
 
     const char* _icon;
     bool _retain;
     LockState _currentState;
+    bool _stateRestore;
+    bool _restoringState;
     HALOCK_CALLBACK(_commandCallback);
 };
 
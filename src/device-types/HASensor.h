@@ -57,6 +57,9 @@ public:
     inline void setValueTemplate(const char* valueTemplate)
         { _valueTemplate = valueTemplate; }   
 
+    inline const char* getValueTemplate() const
+        { return _valueTemplate; }
+
     /**
      * Publishes value of the sensor.
      * 
@@ -0,0 +1,51 @@
+#include "HASensorAggregate.h"
+#ifndef EX_ARDUINOHA_SENSOR
+
+HASensorAggregate::HASensorAggregate(
+    const char* uniqueId,
+    HAAccumulator& accumulator,
+    const Statistic statistic,
+    const Precision precision
+) :
+    HASensorFloat(uniqueId, precision),
+    _accumulator(accumulator),
+    _statistic(statistic)
+{
+    _accumulator.addListener(this);
+}
+
+HASensorAggregate::~HASensorAggregate()
+{
+    _accumulator.removeListener(this);
+}
+
+void HASensorAggregate::onWindowCompleted(const HAAccumulator& accumulator)
+{
+    switch (_statistic) {
+    case StatisticMin:
+        setValue(accumulator.getMin());
+        break;
+
+    case StatisticMax:
+        setValue(accumulator.getMax());
+        break;
+
+    case StatisticSum:
+        setValue(accumulator.getSum());
+        break;
+
+    case StatisticCount:
+        setValue(accumulator.getCount());
+        break;
+
+    case StatisticStdDev:
+        setValue(accumulator.getStdDev());
+        break;
+
+    default:
+        setValue(accumulator.getMean());
+        break;
+    }
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef AHA_HASENSORAGGREGATE_H
+#define AHA_HASENSORAGGREGATE_H
+
+#include "HASensorFloat.h"
+#include "../utils/HAAccumulator.h"
+
+#ifndef EX_ARDUINOHA_SENSOR
+
+/**
+ * Sensor that publishes a summary of the samples collected by the HAAccumulator.
+ * Multiple sensors (e.g. mean and max) can share the same accumulator.
+ * The value is published each time the accumulator's window is completed.
+ */
+class HASensorAggregate : public HASensorFloat, public HAAccumulatorListener
+{
+public:
+    enum Statistic {
+        StatisticMean,
+        StatisticMin,
+        StatisticMax,
+        StatisticSum,
+        StatisticCount,
+        StatisticStdDev
+    };
+
+    HASensorAggregate(
+        const char* uniqueId,
+        HAAccumulator& accumulator,
+        const Statistic statistic = StatisticMean,
+        const Precision precision = PrecisionP2
+    );
+    virtual ~HASensorAggregate();
+
+    inline Statistic getStatistic() const
+        { return _statistic; }
+
+    virtual void onWindowCompleted(const HAAccumulator& accumulator) override;
+
+private:
+    HAAccumulator& _accumulator;
+    const Statistic _statistic;
+};
+
+#endif
+#endif
@@ -7,14 +7,16 @@
 HASensorFloat::HASensorFloat(const char* uniqueId, const Precision precision) :
     HASensor(uniqueId),
     _precision(precision),
-    _currentValue(0)
+    _currentValue(0),
+    _hysteresis(0),
+    _decimalMode(false)
 {
     initValueTemplate();
 }
 
 bool HASensorFloat::setValue(const float value, const bool force)
 {
-    if (!force && value == _currentValue) {
+    if (!force && isWithinHysteresis(value)) {
         return true;
     }
 
@@ -26,6 +28,22 @@ bool HASensorFloat::setValue(const float value, const bool force)
     return false;
 }
 
+void HASensorFloat::setDecimalMode(const bool enabled)
+{
+    _decimalMode = enabled;
+
+    // the template set by the user is kept
+    if (!hasDefaultValueTemplate()) {
+        return;
+    }
+
+    if (_decimalMode) {
+        setValueTemplate(nullptr);
+    } else {
+        initValueTemplate();
+    }
+}
+
 void HASensorFloat::onMqttConnected()
 {
     if (!uniqueId()) {
@@ -39,14 +57,21 @@ void HASensorFloat::onMqttConnected()
 bool HASensorFloat::publishValue(const float value)
 {
     int32_t number = processValue(value);
-    uint8_t size = HAUtils::calculateNumberSize(number);
+    uint8_t size = _decimalMode
+        ? HAUtils::calculateDecimalSize(number, _precision)
+        : HAUtils::calculateNumberSize(number);
     if (size == 0) {
         return false;
     }
 
     char str[size + 1]; // with null terminator
     memset(str, 0, sizeof(str));
-    HAUtils::numberToStr(str, number);
+
+    if (_decimalMode) {
+        HAUtils::decimalToStr(str, number, _precision);
+    } else {
+        HAUtils::numberToStr(str, number);
+    }
 
     return publishOnDataTopic(
         HAStateTopic,
@@ -79,6 +104,27 @@ void HASensorFloat::initValueTemplate()
     }
 }
 
+bool HASensorFloat::hasDefaultValueTemplate() const
+{
+    const char* valueTemplate = getValueTemplate();
+    return (
+        valueTemplate == nullptr ||
+        valueTemplate == HAValueTemplateFloatP1 ||
+        valueTemplate == HAValueTemplateFloatP2 ||
+        valueTemplate == HAValueTemplateFloatP3 ||
+        valueTemplate == HAValueTemplateFloatP4
+    );
+}
+
+bool HASensorFloat::isWithinHysteresis(const float value) const
+{
+    // values that render to the same number are considered equal
+    const int64_t delta =
+        static_cast<int64_t>(processValue(value)) - processValue(_currentValue);
+
+    return (delta >= -static_cast<int64_t>(_hysteresis) && delta <= _hysteresis);
+}
+
 int32_t HASensorFloat::processValue(const float value) const
 {
     // using pow() increases flash size by ~1k
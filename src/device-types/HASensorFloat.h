@@ -28,16 +28,53 @@ public:
     inline float getCurrentValue() const
         { return _currentValue; }
 
+    /**
+     * Sets hysteresis band in the quantized units (value multiplied by 10^precision).
+     * The new value is published only if it differs from the last published value
+     * by more than the given number of units. For example, band 5 with PrecisionP2
+     * suppresses changes smaller than or equal to 0.05.
+     *
+     * @param units Width of the band. Zero means that any change is published.
+     */
+    inline void setHysteresis(const uint32_t units)
+        { _hysteresis = units; }
+
+    inline uint32_t getHysteresis() const
+        { return _hysteresis; }
+
+    /**
+     * Enables rendering of the decimal value on the device.
+     * By default the value is published as an integer multiplied by 10^precision
+     * and the value template in Home Assistant divides it back. In the decimal mode
+     * the value is published as a decimal string (e.g. "21.53") and the value
+     * template is omitted from the discovery config (a template set by the user is kept).
+     * Please note that this method needs to be called before the connection is acquired.
+     *
+     * @param enabled
+     */
+    void setDecimalMode(const bool enabled);
+
+    inline bool isDecimalMode() const
+        { return _decimalMode; }
+
 protected:
     virtual void onMqttConnected() override;
 
 private:
     bool publishValue(const float value);
     void initValueTemplate();
+
+    /**
+     * Returns true if the value template is not set or it's one of the built-in templates.
+     */
+    bool hasDefaultValueTemplate() const;
     int32_t processValue(const float value) const;
+    bool isWithinHysteresis(const float value) const;
 
     Precision _precision;
     float _currentValue;
+    uint32_t _hysteresis;
+    bool _decimalMode;
 };
 
 #endif
@@ -2,6 +2,7 @@
 #ifndef EX_ARDUINOHA_SWITCH
 
 #include "../HAMqtt.h"
+#include "../utils/HAPayloadParser.h"
 #include "../utils/HASerializer.h"
 
 HASwitch::HASwitch(const char* uniqueId) :
@@ -11,6 +12,8 @@ HASwitch::HASwitch(const char* uniqueId) :
     _retain(false),
     _optimistic(false),
     _currentState(false),
+    _stateRestore(false),
+    _restoringState(false),
     _commandCallback(nullptr)
 {
 
@@ -18,7 +21,9 @@ HASwitch::HASwitch(const char* uniqueId) :
 
 bool HASwitch::setState(const bool state, const bool force)
 {
-    if (!force && state == _currentState) {
+    // the state known by the broker wasn't received yet, so it may differ
+    const bool restoring = stopStateRestore();
+    if (!force && !restoring && state == _currentState) {
         return true;
     }
 
@@ -71,7 +76,11 @@ void HASwitch::onMqttConnected()
     publishConfig();
     publishAvailability();
 
-    if (!_retain) {
+    if (_stateRestore) {
+        _restoringState = true;
+        subscribeTopic(uniqueId(), HAStateTopic);
+        mqtt()->beginStateRestore();
+    } else if (!_retain) {
         publishState(_currentState);
     }
 
@@ -84,18 +93,51 @@ void HASwitch::onMqttMessage(
     const uint16_t length
 )
 {
-    (void)payload;
+    if (_restoringState && mqtt()->getContext().compareDataTopics(
+        topic,
+        uniqueId(),
+        HAStateTopic,
+        _device
+    )) {
+        // invalid state will be replaced by the current one after the timeout
+        if (HAPayloadParser::parseBool(payload, length, _currentState)) {
+            stopStateRestore();
+        }
 
-    if (_commandCallback && HASerializer::compareDataTopics(
+        return;
+    }
+
+    if (_commandCallback && mqtt()->getContext().compareDataTopics(
         topic,
         uniqueId(),
-        HACommandTopic
+        HACommandTopic,
+        _device
     )) {
-        bool state = length == strlen_P(HAStateOn);
-        _commandCallback(state, this);
+        bool state;
+        if (HAPayloadParser::parseBool(payload, length, state)) {
+            _commandCallback(state, this);
+        }
     }
 }
 
+void HASwitch::onStateRestoreFinished()
+{
+    if (stopStateRestore() && !_retain) {
+        publishState(_currentState);
+    }
+}
+
+bool HASwitch::stopStateRestore()
+{
+    if (!_restoringState) {
+        return false;
+    }
+
+    _restoringState = false;
+    unsubscribeTopic(uniqueId(), HAStateTopic);
+    return true;
+}
+
 bool HASwitch::publishState(const bool state)
 {
     return publishOnDataTopic(
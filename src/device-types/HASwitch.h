@@ -47,6 +47,19 @@ public:
     inline void setOptimistic(const bool optimistic)
         { _optimistic = optimistic; }
 
+    /**
+     * Enables restore of the state from the broker.
+     * Each time the connection is acquired, the switch subscribes to its retained state
+     * and the current state is replaced by the received one, so the state doesn't flap after reboot.
+     * The current state is published only if the retained state wasn't received within
+     * the timeout (see HAMqtt::setStateRestoreTimeout).
+     * The restore is stopped if the setState method is called in the meantime.
+     *
+     * @param restore
+     */
+    inline void setStateRestore(const bool restore)
+        { _stateRestore = restore; }
+
     /**
      * Changes state of the switch and publishes MQTT message.
      * Please note that if a new value is the same as previous one,
@@ -104,16 +117,25 @@ protected:
         const uint8_t* payload,
         const uint16_t length
     ) override;
+    virtual void onStateRestoreFinished() override;
 
 private:
     bool publishState(const bool state);
     void handleCommand(const char* cmd);
 
+    /**
+     * Unsubscribes from the retained state.
+     * Returns true if the restore was in progress.
+     */
+    bool stopStateRestore();
+
     const char* _class;
     const char* _icon;
     bool _retain;
     bool _optimistic;
     bool _currentState;
+    bool _stateRestore;
+    bool _restoringState;
     HASWITCH_CALLBACK(_commandCallback);
 };
 
@@ -1,11 +1,14 @@
 #ifndef AHA_AUNITHELPERS_H
 #define AHA_AUNITHELPERS_H
 
-#define initMqttTest(testDeviceId) \
+#define initMqttTestWithoutBegin(testDeviceId) \
     PubSubClientMock* mock = new PubSubClientMock(); \
     HADevice device(testDeviceId); \
     HAMqtt mqtt(mock, device); \
-    mqtt.setDataPrefix("testData"); \
+    mqtt.setDataPrefix("testData");
+
+#define initMqttTest(testDeviceId) \
+    initMqttTestWithoutBegin(testDeviceId) \
     mqtt.begin("testHost", "testUser", "testPass");
 
 #define assertNoMqttMessage() \
@@ -0,0 +1,254 @@
+#include "BrokerClientMock.h"
+#ifdef ARDUINOHA_TEST
+
+#include "BrokerMock.h"
+
+BrokerClientMock::BrokerClientMock(BrokerMock& broker) :
+    _broker(broker),
+    _connected(false),
+    _id(nullptr),
+    _willTopic(nullptr),
+    _willMessage(nullptr),
+    _willRetain(false),
+    _cleanSession(true),
+    _pendingTopic(nullptr),
+    _pendingPayload(nullptr),
+    _pendingLength(0),
+    _pendingOffset(0),
+    _pendingRetained(false),
+    _receivedNb(0),
+    _connectAttemptsNb(0),
+    _callback(nullptr)
+{
+
+}
+
+BrokerClientMock::~BrokerClientMock()
+{
+    if (_connected) {
+        _broker.disconnect(this, true);
+    }
+
+    _broker.forget(this);
+    clearPendingMessage();
+}
+
+bool BrokerClientMock::loop()
+{
+    if (!_connected) {
+        return false;
+    }
+
+    _broker.deliver(this);
+    return _connected; // the callback may close the connection
+}
+
+bool BrokerClientMock::connected()
+{
+    return _connected;
+}
+
+bool BrokerClientMock::connect(
+    const char* id,
+    const char* user,
+    const char* pass,
+    const char* willTopic,
+    uint8_t willQos,
+    bool willRetain,
+    const char* willMessage,
+    bool cleanSession
+)
+{
+    (void)user;
+    (void)pass;
+    (void)willQos;
+
+    _connectAttemptsNb++;
+    _id = id;
+    _willTopic = willTopic;
+    _willMessage = willMessage;
+    _willRetain = willRetain;
+    _cleanSession = cleanSession;
+    _connected = _broker.connect(this);
+
+    return _connected;
+}
+
+void BrokerClientMock::disconnect()
+{
+    if (!_connected) {
+        return;
+    }
+
+    _connected = false;
+    _broker.disconnect(this, true);
+}
+
+void BrokerClientMock::setServer(IPAddress ip, uint16_t port)
+{
+    (void)ip;
+    (void)port;
+}
+
+void BrokerClientMock::setServer(const char* domain, uint16_t port)
+{
+    (void)domain;
+    (void)port;
+}
+
+void BrokerClientMock::setCallback(HAMQTT_TRANSPORT_CALLBACK(callback))
+{
+    _callback = callback;
+}
+
+bool BrokerClientMock::beginPublish(
+    const char* topic,
+    uint16_t length,
+    bool retained
+)
+{
+    if (!_connected || !topic) {
+        return false;
+    }
+
+    clearPendingMessage();
+
+    const uint16_t topicSize = strlen(topic) + 1;
+    _pendingTopic = new char[topicSize];
+    memcpy(_pendingTopic, topic, topicSize);
+    _pendingPayload = new uint8_t[length + 1];
+    _pendingLength = length;
+    _pendingOffset = 0;
+    _pendingRetained = retained;
+
+    return true;
+}
+
+size_t BrokerClientMock::write(const uint8_t* data, size_t length)
+{
+    if (!_pendingPayload || _pendingOffset + length > _pendingLength) {
+        return 0;
+    }
+
+    memcpy(&_pendingPayload[_pendingOffset], data, length);
+    _pendingOffset += length;
+
+    return length;
+}
+
+size_t BrokerClientMock::write_P(const char* src)
+{
+    const size_t length = strlen_P(src);
+    char data[length + 1];
+    strcpy_P(data, src);
+
+    return write(reinterpret_cast<const uint8_t*>(data), length);
+}
+
+bool BrokerClientMock::endPublish()
+{
+    if (!_pendingTopic || _pendingOffset != _pendingLength) {
+        clearPendingMessage();
+        return false;
+    }
+
+    const bool result = _broker.publish(
+        this,
+        _pendingTopic,
+        _pendingPayload,
+        _pendingLength,
+        _pendingRetained
+    );
+
+    clearPendingMessage();
+    return result;
+}
+
+bool BrokerClientMock::subscribe(const char* topic)
+{
+    if (!_connected) {
+        return false;
+    }
+
+    return _broker.subscribe(this, topic);
+}
+
+bool BrokerClientMock::unsubscribe(const char* topic)
+{
+    if (!_connected) {
+        return false;
+    }
+
+    return _broker.unsubscribe(this, topic);
+}
+
+bool BrokerClientMock::connectDummy(const char* id)
+{
+    return connect(id, nullptr, nullptr, nullptr, 0, false, nullptr, true);
+}
+
+bool BrokerClientMock::publish(
+    const char* topic,
+    const char* payload,
+    bool retained,
+    uint8_t qos
+)
+{
+    if (!_connected) {
+        return false;
+    }
+
+    return _broker.publish(
+        this,
+        topic,
+        reinterpret_cast<const uint8_t*>(payload),
+        payload ? strlen(payload) : 0,
+        retained,
+        qos
+    );
+}
+
+void BrokerClientMock::dropConnection()
+{
+    if (!_connected) {
+        return;
+    }
+
+    _connected = false;
+    _broker.disconnect(this, false);
+}
+
+void BrokerClientMock::receive(
+    const char* topic,
+    const uint8_t* payload,
+    uint16_t length
+)
+{
+    _receivedNb++;
+
+    if (_callback) {
+        _callback(
+            const_cast<char*>(topic),
+            const_cast<uint8_t*>(payload),
+            length
+        );
+    }
+}
+
+void BrokerClientMock::clearPendingMessage()
+{
+    if (_pendingTopic) {
+        delete[] _pendingTopic;
+        _pendingTopic = nullptr;
+    }
+
+    if (_pendingPayload) {
+        delete[] _pendingPayload;
+        _pendingPayload = nullptr;
+    }
+
+    _pendingLength = 0;
+    _pendingOffset = 0;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef AHA_BROKERCLIENTMOCK_H
+#define AHA_BROKERCLIENTMOCK_H
+
+#ifdef ARDUINOHA_TEST
+
+#include <Arduino.h>
+#include "../transports/HAMqttTransport.h"
+
+class BrokerMock;
+
+/**
+ * MQTT transport that is attached to the in-process BrokerMock.
+ * It can be used with HAMqtt or directly to publish/receive messages in tests.
+ */
+class BrokerClientMock : public HAMqttTransport
+{
+public:
+    explicit BrokerClientMock(BrokerMock& broker);
+    virtual ~BrokerClientMock();
+
+    virtual bool loop() override;
+    virtual bool connected() override;
+    virtual bool connect(
+        const char* id,
+        const char* user,
+        const char* pass,
+        const char* willTopic,
+        uint8_t willQos,
+        bool willRetain,
+        const char* willMessage,
+        bool cleanSession
+    ) override;
+    virtual void disconnect() override;
+    virtual void setServer(IPAddress ip, uint16_t port) override;
+    virtual void setServer(const char* domain, uint16_t port) override;
+    virtual void setCallback(HAMQTT_TRANSPORT_CALLBACK(callback)) override;
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t length,
+        bool retained
+    ) override;
+    using HAMqttTransport::beginPublish;
+    virtual size_t write(const uint8_t* data, size_t length) override;
+    virtual size_t write_P(const char* src) override;
+    virtual bool endPublish() override;
+    virtual bool subscribe(const char* topic) override;
+    virtual bool unsubscribe(const char* topic) override;
+
+    /**
+     * Connects with the given ID and without credentials and LWT.
+     */
+    bool connectDummy(const char* id = "dummyId");
+
+    /**
+     * Publishes the whole message at once.
+     */
+    bool publish(
+        const char* topic,
+        const char* payload,
+        bool retained = false,
+        uint8_t qos = 0
+    );
+
+    /**
+     * Simulates broken connection (the broker publishes the LWT message).
+     */
+    void dropConnection();
+
+    /**
+     * Called by the broker for each delivered message.
+     */
+    void receive(const char* topic, const uint8_t* payload, uint16_t length);
+
+    inline const char* getId() const
+        { return _id; }
+
+    inline bool isCleanSession() const
+        { return _cleanSession; }
+
+    inline const char* getWillTopic() const
+        { return _willTopic; }
+
+    inline const char* getWillMessage() const
+        { return _willMessage; }
+
+    inline bool getWillRetain() const
+        { return _willRetain; }
+
+    inline uint32_t getReceivedNb() const
+        { return _receivedNb; }
+
+    inline uint32_t getConnectAttemptsNb() const
+        { return _connectAttemptsNb; }
+
+private:
+    BrokerMock& _broker;
+    bool _connected;
+    const char* _id;
+    const char* _willTopic;
+    const char* _willMessage;
+    bool _willRetain;
+    bool _cleanSession;
+    char* _pendingTopic;
+    uint8_t* _pendingPayload;
+    uint16_t _pendingLength;
+    uint16_t _pendingOffset;
+    bool _pendingRetained;
+    uint32_t _receivedNb;
+    uint32_t _connectAttemptsNb;
+    HAMQTT_TRANSPORT_CALLBACK(_callback);
+
+    void clearPendingMessage();
+};
+
+#endif
+#endif
@@ -0,0 +1,591 @@
+#include "BrokerMock.h"
+#ifdef ARDUINOHA_TEST
+
+#include "BrokerClientMock.h"
+
+#define BROKERMOCK_MAX_RECIPIENTS 32
+#define BROKERMOCK_PACKET_OVERHEAD 4 // fixed header and topic length (approx)
+
+BrokerMock::BrokerMock() :
+    _time(0),
+    _latency(0),
+    _bandwidth(0),
+    _linkBusyUntil(0),
+    _packetLoss(0),
+    _seed(1),
+    _accepting(true),
+    _root(new BrokerTopicNode()),
+    _retained(nullptr),
+    _retainedNb(0),
+    _pending(nullptr),
+    _pendingNb(0)
+{
+
+}
+
+BrokerMock::~BrokerMock()
+{
+    destroyNode(_root);
+
+    while (_retained) {
+        BrokerRetainedMessage* next = _retained->next;
+        delete[] _retained->topic;
+        delete[] _retained->payload;
+        delete _retained;
+        _retained = next;
+    }
+
+    while (_pending) {
+        BrokerDelivery* next = _pending->next;
+        destroyDelivery(_pending);
+        _pending = next;
+    }
+}
+
+const BrokerRetainedMessage* BrokerMock::getRetained(const char* topic) const
+{
+    for (BrokerRetainedMessage* m = _retained; m; m = m->next) {
+        if (strcmp(m->topic, topic) == 0) {
+            return m;
+        }
+    }
+
+    return nullptr;
+}
+
+bool BrokerMock::connect(BrokerClientMock* client)
+{
+    if (!_accepting) {
+        _stats.refusedConnectionsNb++;
+        return false;
+    }
+
+    if (client->isCleanSession()) {
+        forget(client);
+    }
+
+    _stats.connectionsNb++;
+    return true;
+}
+
+void BrokerMock::disconnect(BrokerClientMock* client, bool graceful)
+{
+    removePending(client);
+
+    if (client->isCleanSession()) {
+        forget(client);
+    }
+
+    if (!graceful && client->getWillTopic() && client->getWillMessage()) {
+        publish(
+            nullptr,
+            client->getWillTopic(),
+            reinterpret_cast<const uint8_t*>(client->getWillMessage()),
+            strlen(client->getWillMessage()),
+            client->getWillRetain()
+        );
+    }
+}
+
+void BrokerMock::forget(BrokerClientMock* client)
+{
+    removeSubscriber(_root, client);
+}
+
+bool BrokerMock::subscribe(BrokerClientMock* client, const char* filter)
+{
+    if (!filter || strlen(filter) == 0) {
+        return false;
+    }
+
+    BrokerTopicNode* node = _root;
+    const char* level = filter;
+
+    while (level) {
+        const char* slash = strchr(level, '/');
+        const uint16_t length = slash ? (slash - level) : strlen(level);
+
+        BrokerTopicNode* child = findChild(node, level, length);
+        if (!child) {
+            child = new BrokerTopicNode();
+            child->level = new char[length + 1];
+            memcpy(child->level, level, length);
+            child->level[length] = 0;
+            child->sibling = node->child;
+            node->child = child;
+        }
+
+        node = child;
+        level = slash ? slash + 1 : nullptr;
+    }
+
+    for (uint8_t i = 0; i < node->subscribersNb; i++) {
+        if (node->subscribers[i] == client) {
+            return true; // already subscribed
+        }
+    }
+
+    node->subscribersNb++;
+    node->subscribers = static_cast<BrokerClientMock**>(
+        realloc(node->subscribers, node->subscribersNb * sizeof(BrokerClientMock*))
+    );
+    node->subscribers[node->subscribersNb - 1] = client;
+    _stats.subscriptionsNb++;
+
+    // replay retained messages
+    for (BrokerRetainedMessage* m = _retained; m; m = m->next) {
+        if (matchTopic(filter, m->topic)) {
+            enqueue(client, m->topic, m->payload, m->length, 0);
+        }
+    }
+
+    return true;
+}
+
+bool BrokerMock::unsubscribe(BrokerClientMock* client, const char* filter)
+{
+    if (!filter) {
+        return false;
+    }
+
+    BrokerTopicNode* node = _root;
+    const char* level = filter;
+
+    while (node && level) {
+        const char* slash = strchr(level, '/');
+        const uint16_t length = slash ? (slash - level) : strlen(level);
+
+        node = findChild(node, level, length);
+        level = slash ? slash + 1 : nullptr;
+    }
+
+    if (!node) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < node->subscribersNb; i++) {
+        if (node->subscribers[i] == client) {
+            node->subscribers[i] = node->subscribers[node->subscribersNb - 1];
+            node->subscribersNb--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BrokerMock::publish(
+    BrokerClientMock* sender,
+    const char* topic,
+    const uint8_t* payload,
+    uint16_t length,
+    bool retained,
+    uint8_t qos
+)
+{
+    (void)sender;
+
+    if (!topic || strlen(topic) == 0) {
+        return false;
+    }
+
+    _stats.publishedNb++;
+    _stats.bytesNb += BROKERMOCK_PACKET_OVERHEAD + strlen(topic) + length;
+
+    if (retained) {
+        storeRetained(topic, payload, length);
+    }
+
+    BrokerClientMock* clients[BROKERMOCK_MAX_RECIPIENTS];
+    uint8_t clientsNb = 0;
+
+    if (topic[0] != '$') { // wildcards don't match system topics
+        collectSubscribers(
+            _root,
+            topic,
+            clients,
+            clientsNb,
+            BROKERMOCK_MAX_RECIPIENTS
+        );
+    }
+
+    for (uint8_t i = 0; i < clientsNb; i++) {
+        enqueue(clients[i], topic, payload, length, qos);
+    }
+
+    return true;
+}
+
+uint16_t BrokerMock::deliver(BrokerClientMock* client)
+{
+    uint16_t deliveredNb = 0;
+    bool found = true;
+
+    // the callback may publish new messages, so the list is scanned from the beginning each time
+    while (found) {
+        found = false;
+        BrokerDelivery* prev = nullptr;
+
+        for (BrokerDelivery* d = _pending; d; prev = d, d = d->next) {
+            if (d->deliverAt > _time) {
+                break; // the list is sorted
+            }
+
+            if (d->client != client) {
+                continue;
+            }
+
+            if (prev) {
+                prev->next = d->next;
+            } else {
+                _pending = d->next;
+            }
+
+            _pendingNb--;
+
+            const uint32_t latency = d->deliverAt - d->publishedAt;
+            _stats.deliveredNb++;
+            _stats.latencySum += latency;
+            if (latency > _stats.maxLatency) {
+                _stats.maxLatency = latency;
+            }
+
+            client->receive(d->topic, d->payload, d->length);
+            destroyDelivery(d);
+
+            deliveredNb++;
+            found = true;
+            break;
+        }
+    }
+
+    return deliveredNb;
+}
+
+bool BrokerMock::matchTopic(const char* filter, const char* topic)
+{
+    if (!filter || !topic) {
+        return false;
+    }
+
+    if (topic[0] == '$' && (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+
+    while (*filter) {
+        if (*filter == '#') {
+            return true;
+        }
+
+        if (*filter == '+') {
+            while (*topic && *topic != '/') {
+                topic++;
+            }
+
+            filter++;
+            continue;
+        }
+
+        if (*topic == 0) {
+            // "a/#" matches "a"
+            return (strcmp(filter, "/#") == 0);
+        }
+
+        if (*filter != *topic) {
+            return false;
+        }
+
+        filter++;
+        topic++;
+    }
+
+    return (*topic == 0);
+}
+
+uint32_t BrokerMock::random()
+{
+    // xorshift32
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+
+    return _seed;
+}
+
+void BrokerMock::storeRetained(
+    const char* topic,
+    const uint8_t* payload,
+    uint16_t length
+)
+{
+    BrokerRetainedMessage* prev = nullptr;
+    BrokerRetainedMessage* m = _retained;
+
+    while (m && strcmp(m->topic, topic) != 0) {
+        prev = m;
+        m = m->next;
+    }
+
+    if (m) {
+        delete[] m->payload;
+        m->payload = nullptr;
+        m->length = 0;
+
+        if (length == 0) { // empty retained message removes the topic
+            if (prev) {
+                prev->next = m->next;
+            } else {
+                _retained = m->next;
+            }
+
+            delete[] m->topic;
+            delete m;
+            _retainedNb--;
+            return;
+        }
+    } else {
+        if (length == 0) {
+            return;
+        }
+
+        const uint16_t topicSize = strlen(topic) + 1;
+        m = new BrokerRetainedMessage();
+        m->topic = new char[topicSize];
+        memcpy(m->topic, topic, topicSize);
+
+        // keep the insertion order
+        if (prev) {
+            prev->next = m;
+        } else {
+            _retained = m;
+        }
+
+        _retainedNb++;
+    }
+
+    m->payload = new uint8_t[length];
+    memcpy(m->payload, payload, length);
+    m->length = length;
+}
+
+void BrokerMock::enqueue(
+    BrokerClientMock* client,
+    const char* topic,
+    const uint8_t* payload,
+    uint16_t length,
+    uint8_t qos
+)
+{
+    const uint16_t topicSize = strlen(topic) + 1;
+    const uint32_t packetSize = BROKERMOCK_PACKET_OVERHEAD + topicSize - 1 + length;
+    // the link is tracked in microseconds, so small packets don't take a whole millisecond each
+    const uint64_t txTimeUs = _bandwidth > 0
+        ? ((uint64_t)packetSize * 1000000 + _bandwidth - 1) / _bandwidth
+        : 0;
+    const uint32_t txTime = (txTimeUs + 999) / 1000;
+
+    const uint64_t now = (uint64_t)_time * 1000;
+    const uint64_t start = now > _linkBusyUntil ? now : _linkBusyUntil;
+    _linkBusyUntil = start + txTimeUs;
+    uint32_t deliverAt = (uint32_t)((_linkBusyUntil + 999) / 1000) + _latency;
+
+    while (_packetLoss > 0 && (random() % 100) < _packetLoss) {
+        if (qos == 0) {
+            _stats.droppedNb++;
+            return;
+        }
+
+        // QoS 1: the message is sent again after the acknowledgment timeout
+        _stats.retransmittedNb++;
+        deliverAt += 2 * _latency + txTime + 1;
+    }
+
+    BrokerDelivery* delivery = new BrokerDelivery();
+    delivery->client = client;
+    delivery->topic = new char[topicSize];
+    memcpy(delivery->topic, topic, topicSize);
+    delivery->payload = new uint8_t[length + 1];
+    memcpy(delivery->payload, payload, length);
+    delivery->payload[length] = 0;
+    delivery->length = length;
+    delivery->qos = qos;
+    delivery->publishedAt = _time;
+    delivery->deliverAt = deliverAt;
+
+    // sorted by the delivery time (FIFO for equal times)
+    BrokerDelivery* prev = nullptr;
+    BrokerDelivery* next = _pending;
+    while (next && next->deliverAt <= deliverAt) {
+        prev = next;
+        next = next->next;
+    }
+
+    delivery->next = next;
+    if (prev) {
+        prev->next = delivery;
+    } else {
+        _pending = delivery;
+    }
+
+    _pendingNb++;
+    if (_pendingNb > _stats.maxPendingNb) {
+        _stats.maxPendingNb = _pendingNb;
+    }
+}
+
+void BrokerMock::collectSubscribers(
+    BrokerTopicNode* node,
+    const char* levels,
+    BrokerClientMock** clients,
+    uint8_t& clientsNb,
+    uint8_t maxClientsNb
+) const
+{
+    for (BrokerTopicNode* child = node->child; child; child = child->sibling) {
+        bool matched = false;
+
+        if (strcmp(child->level, "#") == 0) {
+            matched = true;
+        } else if (levels) {
+            const char* slash = strchr(levels, '/');
+            const uint16_t length = slash ? (slash - levels) : strlen(levels);
+
+            if (
+                strcmp(child->level, "+") == 0 ||
+                matchLevel(child->level, levels, length)
+            ) {
+                if (slash) {
+                    collectSubscribers(
+                        child,
+                        slash + 1,
+                        clients,
+                        clientsNb,
+                        maxClientsNb
+                    );
+                } else {
+                    matched = true;
+
+                    // trailing "#" matches the parent level
+                    collectSubscribers(
+                        child,
+                        nullptr,
+                        clients,
+                        clientsNb,
+                        maxClientsNb
+                    );
+                }
+            }
+        }
+
+        if (!matched) {
+            continue;
+        }
+
+        for (uint8_t i = 0; i < child->subscribersNb; i++) {
+            bool duplicate = false;
+            for (uint8_t j = 0; j < clientsNb; j++) {
+                if (clients[j] == child->subscribers[i]) {
+                    duplicate = true;
+                    break;
+                }
+            }
+
+            if (!duplicate && clientsNb < maxClientsNb) {
+                clients[clientsNb++] = child->subscribers[i];
+            }
+        }
+    }
+}
+
+void BrokerMock::removeSubscriber(
+    BrokerTopicNode* node,
+    BrokerClientMock* client
+)
+{
+    for (uint8_t i = 0; i < node->subscribersNb; i++) {
+        if (node->subscribers[i] == client) {
+            node->subscribers[i] = node->subscribers[node->subscribersNb - 1];
+            node->subscribersNb--;
+            break;
+        }
+    }
+
+    for (BrokerTopicNode* child = node->child; child; child = child->sibling) {
+        removeSubscriber(child, client);
+    }
+}
+
+void BrokerMock::removePending(BrokerClientMock* client)
+{
+    BrokerDelivery* prev = nullptr;
+    BrokerDelivery* d = _pending;
+
+    while (d) {
+        BrokerDelivery* next = d->next;
+
+        if (d->client == client) {
+            if (prev) {
+                prev->next = next;
+            } else {
+                _pending = next;
+            }
+
+            destroyDelivery(d);
+            _pendingNb--;
+        } else {
+            prev = d;
+        }
+
+        d = next;
+    }
+}
+
+void BrokerMock::destroyDelivery(BrokerDelivery* delivery)
+{
+    delete[] delivery->topic;
+    delete[] delivery->payload;
+    delete delivery;
+}
+
+void BrokerMock::destroyNode(BrokerTopicNode* node)
+{
+    BrokerTopicNode* child = node->child;
+    while (child) {
+        BrokerTopicNode* next = child->sibling;
+        destroyNode(child);
+        child = next;
+    }
+
+    if (node->level) {
+        delete[] node->level;
+    }
+
+    free(node->subscribers);
+    delete node;
+}
+
+BrokerTopicNode* BrokerMock::findChild(
+    BrokerTopicNode* node,
+    const char* level,
+    uint16_t length
+)
+{
+    for (BrokerTopicNode* child = node->child; child; child = child->sibling) {
+        if (matchLevel(child->level, level, length)) {
+            return child;
+        }
+    }
+
+    return nullptr;
+}
+
+bool BrokerMock::matchLevel(
+    const char* level,
+    const char* value,
+    uint16_t length
+)
+{
+    return (strlen(level) == length && strncmp(level, value, length) == 0);
+}
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef AHA_BROKERMOCK_H
+#define AHA_BROKERMOCK_H
+
+#ifdef ARDUINOHA_TEST
+
+#include <Arduino.h>
+
+class BrokerClientMock;
+
+struct BrokerTopicNode
+{
+    char* level;
+    BrokerTopicNode* child;
+    BrokerTopicNode* sibling;
+    BrokerClientMock** subscribers;
+    uint8_t subscribersNb;
+
+    BrokerTopicNode() :
+        level(nullptr),
+        child(nullptr),
+        sibling(nullptr),
+        subscribers(nullptr),
+        subscribersNb(0)
+    {
+
+    }
+};
+
+struct BrokerRetainedMessage
+{
+    char* topic;
+    uint8_t* payload;
+    uint16_t length;
+    BrokerRetainedMessage* next;
+
+    BrokerRetainedMessage() :
+        topic(nullptr),
+        payload(nullptr),
+        length(0),
+        next(nullptr)
+    {
+
+    }
+};
+
+struct BrokerDelivery
+{
+    BrokerClientMock* client;
+    char* topic;
+    uint8_t* payload;
+    uint16_t length;
+    uint8_t qos;
+    uint32_t publishedAt;
+    uint32_t deliverAt;
+    BrokerDelivery* next;
+
+    BrokerDelivery() :
+        client(nullptr),
+        topic(nullptr),
+        payload(nullptr),
+        length(0),
+        qos(0),
+        publishedAt(0),
+        deliverAt(0),
+        next(nullptr)
+    {
+
+    }
+};
+
+struct BrokerStats
+{
+    uint32_t connectionsNb;
+    uint32_t refusedConnectionsNb;
+    uint32_t publishedNb;
+    uint32_t deliveredNb;
+    uint32_t droppedNb;
+    uint32_t retransmittedNb;
+    uint32_t subscriptionsNb;
+    uint32_t bytesNb;
+    uint32_t latencySum;
+    uint32_t maxLatency;
+    uint16_t maxPendingNb;
+
+    BrokerStats() :
+        connectionsNb(0),
+        refusedConnectionsNb(0),
+        publishedNb(0),
+        deliveredNb(0),
+        droppedNb(0),
+        retransmittedNb(0),
+        subscriptionsNb(0),
+        bytesNb(0),
+        latencySum(0),
+        maxLatency(0),
+        maxPendingNb(0)
+    {
+
+    }
+};
+
+/**
+ * In-process stand-in of the MQTT broker.
+ * Clients (BrokerClientMock) attach to the broker and all messages are routed
+ * through the subscriptions trie, so multiple clients can talk to each other.
+ * The broker uses a virtual clock that is moved forward with the advance method,
+ * which makes latency, bandwidth and packet loss simulation deterministic.
+ */
+class BrokerMock
+{
+public:
+    BrokerMock();
+    ~BrokerMock();
+
+    /**
+     * Sets one-way latency of the network in milliseconds.
+     */
+    inline void setLatency(uint32_t latency)
+        { _latency = latency; }
+
+    /**
+     * Sets bandwidth of the broker's egress link in bytes per second.
+     * Zero means unlimited bandwidth.
+     */
+    inline void setBandwidth(uint32_t bytesPerSecond)
+        { _bandwidth = bytesPerSecond; }
+
+    /**
+     * Sets probability (0-100%) of losing a packet.
+     * Lost QoS 0 messages are dropped, QoS 1 messages are retransmitted.
+     */
+    inline void setPacketLoss(uint8_t percent)
+        { _packetLoss = percent; }
+
+    /**
+     * Sets seed of the pseudorandom generator used by the packet loss simulation.
+     */
+    inline void setSeed(uint32_t seed)
+        { _seed = (seed == 0 ? 1 : seed); }
+
+    /**
+     * Specifies whether the broker accepts new connections.
+     * It allows to simulate broker's downtime.
+     */
+    inline void setAcceptingConnections(bool accepting)
+        { _accepting = accepting; }
+
+    inline bool isAcceptingConnections() const
+        { return _accepting; }
+
+    inline uint32_t getTime() const
+        { return _time; }
+
+    inline const BrokerStats& getStats() const
+        { return _stats; }
+
+    /**
+     * Clears the statistics, so each phase of the test can be measured separately.
+     */
+    inline void resetStats()
+        { _stats = BrokerStats(); }
+
+    inline uint16_t getPendingNb() const
+        { return _pendingNb; }
+
+    inline uint16_t getRetainedNb() const
+        { return _retainedNb; }
+
+    /**
+     * Moves the virtual clock forward.
+     */
+    inline void advance(uint32_t ms)
+        { _time += ms; }
+
+    /**
+     * Returns retained message of the given topic or nullptr.
+     */
+    const BrokerRetainedMessage* getRetained(const char* topic) const;
+
+    bool connect(BrokerClientMock* client);
+    void disconnect(BrokerClientMock* client, bool graceful);
+
+    /**
+     * Removes all subscriptions of the client (including persistent session).
+     */
+    void forget(BrokerClientMock* client);
+    bool subscribe(BrokerClientMock* client, const char* filter);
+    bool unsubscribe(BrokerClientMock* client, const char* filter);
+    bool publish(
+        BrokerClientMock* sender,
+        const char* topic,
+        const uint8_t* payload,
+        uint16_t length,
+        bool retained,
+        uint8_t qos = 0
+    );
+
+    /**
+     * Passes all messages that are due to the given client.
+     *
+     * @returns Number of delivered messages.
+     */
+    uint16_t deliver(BrokerClientMock* client);
+
+    /**
+     * Returns true if the given topic matches the filter (wildcards are supported).
+     */
+    static bool matchTopic(const char* filter, const char* topic);
+
+private:
+    uint32_t _time;
+    uint32_t _latency;
+    uint32_t _bandwidth;
+    uint64_t _linkBusyUntil; // us
+    uint8_t _packetLoss;
+    uint32_t _seed;
+    bool _accepting;
+    BrokerTopicNode* _root;
+    BrokerRetainedMessage* _retained;
+    uint16_t _retainedNb;
+    BrokerDelivery* _pending;
+    uint16_t _pendingNb;
+    BrokerStats _stats;
+
+    uint32_t random();
+    void storeRetained(const char* topic, const uint8_t* payload, uint16_t length);
+    void enqueue(
+        BrokerClientMock* client,
+        const char* topic,
+        const uint8_t* payload,
+        uint16_t length,
+        uint8_t qos
+    );
+    void collectSubscribers(
+        BrokerTopicNode* node,
+        const char* levels,
+        BrokerClientMock** clients,
+        uint8_t& clientsNb,
+        uint8_t maxClientsNb
+    ) const;
+    void removeSubscriber(BrokerTopicNode* node, BrokerClientMock* client);
+    void removePending(BrokerClientMock* client);
+    void destroyDelivery(BrokerDelivery* delivery);
+    static void destroyNode(BrokerTopicNode* node);
+    static BrokerTopicNode* findChild(
+        BrokerTopicNode* node,
+        const char* level,
+        uint16_t length
+    );
+    static bool matchLevel(
+        const char* level,
+        const char* value,
+        uint16_t length
+    );
+};
+
+#endif
+#endif
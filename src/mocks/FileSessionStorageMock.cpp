@@ -0,0 +1,56 @@
+#include "FileSessionStorageMock.h"
+#ifdef ARDUINOHA_TEST
+
+#include <stdio.h>
+
+FileSessionStorageMock::FileSessionStorageMock(const char* path, const uint16_t size) :
+    _path(path),
+    _size(size),
+    _writesNb(0)
+{
+
+}
+
+bool FileSessionStorageMock::read(uint8_t* data, const uint16_t length)
+{
+    if (length > _size) {
+        return false;
+    }
+
+    memset(data, 0, length); // unwritten memory
+
+    FILE* file = fopen(_path, "rb");
+    if (!file) {
+        return true;
+    }
+
+    fread(data, 1, length, file);
+    fclose(file);
+
+    return true;
+}
+
+bool FileSessionStorageMock::write(const uint8_t* data, const uint16_t length)
+{
+    if (length > _size) {
+        return false;
+    }
+
+    FILE* file = fopen(_path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    const size_t writtenNb = fwrite(data, 1, length, file);
+    fclose(file);
+    _writesNb++;
+
+    return writtenNb == length;
+}
+
+void FileSessionStorageMock::erase()
+{
+    remove(_path);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef AHA_FILESESSIONSTORAGEMOCK_H
+#define AHA_FILESESSIONSTORAGEMOCK_H
+
+#ifdef ARDUINOHA_TEST
+
+#include <Arduino.h>
+#include "../utils/HASessionStorage.h"
+
+/**
+ * Host stand-in of the RTC memory that keeps the session in a file,
+ * so it survives the "reboot" (destruction of the HAMqtt) between deep sleep cycles.
+ */
+class FileSessionStorageMock : public HASessionStorage
+{
+public:
+    FileSessionStorageMock(const char* path, const uint16_t size = 256);
+
+    virtual uint16_t getSize() const override
+        { return _size; }
+
+    virtual bool read(uint8_t* data, const uint16_t length) override;
+    virtual bool write(const uint8_t* data, const uint16_t length) override;
+
+    /**
+     * Removes the file (simulates the power loss).
+     */
+    void erase();
+
+    inline uint16_t getWritesNb() const
+        { return _writesNb; }
+
+private:
+    const char* _path;
+    const uint16_t _size;
+    uint16_t _writesNb;
+};
+
+#endif
+#endif
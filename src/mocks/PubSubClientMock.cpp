@@ -7,7 +7,16 @@ PubSubClientMock::PubSubClientMock() :
     _flushedMessagesNb(0),
     _subscriptions(nullptr),
     _subscriptionsNb(0),
-    callback(nullptr)
+    _publishedBytesNb(0),
+    _topicAliases(nullptr),
+    _topicAliasesNb(0),
+    _maxPacketSize(0),
+    _maxTopicLength(0),
+    _unreachableHost(nullptr),
+    _connectAttemptsNb(0),
+    _keepAlive(HAMQTT_DEFAULT_KEEPALIVE),
+    _callback(nullptr),
+    _ackCallback(nullptr)
 {
 
 }
@@ -18,11 +27,16 @@ PubSubClientMock::~PubSubClientMock()
         delete _pendingMessage;
     }
 
+    for (uint16_t i = 0; i < _subscriptionsNb; i++) {
+        delete[] _subscriptions[i].topic;
+    }
+
     if (_subscriptions) {
-        delete _subscriptions;
+        free(_subscriptions); // allocated with realloc
     }
 
     clearFlushedMessages();
+    clearTopicAliases();
 }
 
 bool PubSubClientMock::loop()
@@ -52,17 +66,29 @@ bool PubSubClientMock::connect(
 )
 {
     (void)willQos;
-    (void)cleanSession;
+
+    _connectAttemptsNb++;
+
+    if (
+        _unreachableHost &&
+        _connection.domain &&
+        strcmp(_connection.domain, _unreachableHost) == 0
+    ) {
+        _connection.connected = false;
+        return false;
+    }
 
     _connection.connected = true;
     _connection.id = id;
     _connection.user = user;
     _connection.pass = pass;
+    _connection.cleanSession = cleanSession;
 
     _lastWill.topic = willTopic;
     _lastWill.message = willMessage;
     _lastWill.retain = willRetain;
 
+    clearTopicAliases(); // aliases are valid within a single connection
     return true;
 }
 
@@ -80,65 +106,131 @@ bool PubSubClientMock::connectDummy()
     return true;
 }
 
-PubSubClientMock& PubSubClientMock::setServer(IPAddress ip, uint16_t port)
+void PubSubClientMock::setServer(IPAddress ip, uint16_t port)
 {
+    _connection.domain = nullptr;
     _connection.ip = ip;
     _connection.port = port;
-
-    return *this;
 }
 
-PubSubClientMock& PubSubClientMock::setServer(
+void PubSubClientMock::setServer(
     const char * domain,
     uint16_t port
 )
 {
     _connection.domain = domain;
     _connection.port = port;
-
-    return *this;
 }
 
-PubSubClientMock& PubSubClientMock::setCallback(MQTT_CALLBACK_SIGNATURE)
+void PubSubClientMock::setCallback(HAMQTT_TRANSPORT_CALLBACK(callback))
 {
-    this->callback = callback;
-    return *this;
+    _callback = callback;
 }
 
 bool PubSubClientMock::beginPublish(
     const char* topic,
-    unsigned int plength,
+    uint16_t plength,
     bool retained
 )
 {
-    if (!connected()) {
+    // MQTT 3.1.1: fixed header + topic length + topic + payload
+    const uint32_t remainingLength = 2 + strlen(topic) + plength;
+    const uint32_t packetSize =
+        1 + calculateRemainingLengthSize(remainingLength) + remainingLength;
+    if (_maxPacketSize > 0 && packetSize > _maxPacketSize) {
+        return false; // the same behavior as PubSubClient with too small buffer
+    }
+
+    if (_maxTopicLength > 0 && strlen(topic) > _maxTopicLength) {
         return false;
     }
 
-    if (_pendingMessage) {
-        delete _pendingMessage;
+    if (!beginPublishMessage(topic, plength, retained, 0)) {
+        return false;
     }
 
-    _pendingMessage = new MqttMessage();
-    _pendingMessage->retained = retained; 
+    _publishedBytesNb += packetSize;
 
-    {
-        size_t size = strlen(topic) + 1;
-        _pendingMessage->topic = new char[size];
-        _pendingMessage->topicSize = size;
+    return true;
+}
 
-        memset(_pendingMessage->topic, 0, size);
-        memcpy(_pendingMessage->topic, topic, size);
+bool PubSubClientMock::beginPublish(
+    const char* topic,
+    uint16_t plength,
+    bool retained,
+    uint16_t topicAlias
+)
+{
+    if (!connected() || topicAlias == 0) {
+        return false;
     }
 
-    {
-        size_t size = plength + 1;
-        _pendingMessage->buffer = new char[size];
-        _pendingMessage->bufferSize = size;
+    const size_t topicLength = strlen(topic);
+    if (topicLength == 0) {
+        if (topicAlias > _topicAliasesNb) {
+            return false; // unknown alias
+        }
+
+        topic = _topicAliases[topicAlias - 1];
+    } else if (topicAlias <= _topicAliasesNb) {
+        delete[] _topicAliases[topicAlias - 1];
+        _topicAliases[topicAlias - 1] = nullptr;
+    } else if (topicAlias == _topicAliasesNb + 1) {
+        _topicAliasesNb++;
+        _topicAliases = static_cast<char**>(
+            realloc(_topicAliases, _topicAliasesNb * sizeof(char*))
+        );
+        _topicAliases[topicAlias - 1] = nullptr;
+    } else {
+        return false; // aliases are expected to be assigned incrementally
+    }
 
-        memset(_pendingMessage->buffer, 0, size);
+    if (topicLength > 0) {
+        char* aliasTopic = new char[topicLength + 1];
+        memcpy(aliasTopic, topic, topicLength + 1);
+        _topicAliases[topicAlias - 1] = aliasTopic;
+    }
+
+    if (!beginPublishMessage(topic, plength, retained, topicAlias)) {
+        return false;
     }
 
+    // MQTT 5: fixed header + topic length + topic + properties length
+    // + topic alias property (identifier and two bytes integer) + payload
+    const uint32_t remainingLength = 2 + topicLength + 1 + 3 + plength;
+    _publishedBytesNb +=
+        1 + calculateRemainingLengthSize(remainingLength) + remainingLength;
+
+    return true;
+}
+
+bool PubSubClientMock::beginPublish(
+    const char* topic,
+    uint16_t plength,
+    bool retained,
+    uint8_t qos,
+    uint16_t packetId,
+    bool duplicate
+)
+{
+    if (qos > 0 && packetId == 0) {
+        return false;
+    }
+
+    if (!beginPublishMessage(topic, plength, retained, 0)) {
+        return false;
+    }
+
+    _pendingMessage->qos = qos;
+    _pendingMessage->packetId = packetId;
+    _pendingMessage->duplicate = duplicate;
+
+    // MQTT 3.1.1: fixed header + topic length + topic + packet ID + payload
+    const uint32_t remainingLength =
+        2 + strlen(topic) + (qos > 0 ? 2 : 0) + plength;
+    _publishedBytesNb +=
+        1 + calculateRemainingLengthSize(remainingLength) + remainingLength;
+
     return true;
 }
 
@@ -148,27 +240,32 @@ size_t PubSubClientMock::write(const uint8_t *buffer, size_t size)
         return 0;
     }
 
+    // the payload can't be longer than the length declared in beginPublish
+    const size_t length = strlen(_pendingMessage->buffer);
+    if (length + size >= _pendingMessage->bufferSize) {
+        return 0;
+    }
+
     strncat(_pendingMessage->buffer, (const char*)buffer, size);
     return size;
 }
 
-size_t PubSubClientMock::print(const __FlashStringHelper* buffer)
+size_t PubSubClientMock::write_P(const char* buffer)
 {
-    const size_t len = strlen_P(reinterpret_cast<const char*>(buffer));
-    char data[len];
-    strcpy_P(data, reinterpret_cast<const char*>(buffer));
+    const size_t len = strlen_P(buffer);
+    char data[len + 1]; // including null terminator
+    strcpy_P(data, buffer);
 
     return write((const uint8_t*)(data), len);
 }
 
-int PubSubClientMock::endPublish()
+bool PubSubClientMock::endPublish()
 {
     if (!_pendingMessage) {
-        return 0;
+        return false;
     }
 
-    size_t messageSize = _pendingMessage->bufferSize;
-    uint8_t index = _flushedMessagesNb;
+    uint16_t index = _flushedMessagesNb;
 
     _flushedMessagesNb++;
     _flushedMessages = static_cast<MqttMessage*>(
@@ -176,14 +273,17 @@ int PubSubClientMock::endPublish()
     );
 
     _flushedMessages[index] = *_pendingMessage; // handover memory responsibility
-    _pendingMessage = nullptr; // do not call destructor
+    _pendingMessage->topic = nullptr;
+    _pendingMessage->buffer = nullptr;
+    delete _pendingMessage;
+    _pendingMessage = nullptr;
 
-    return messageSize;
+    return true;
 }
 
 bool PubSubClientMock::subscribe(const char* topic)
 {
-    uint8_t index = _subscriptionsNb;
+    uint16_t index = _subscriptionsNb;
 
     _subscriptionsNb++;
     _subscriptions = static_cast<MqttSubscription*>(
@@ -198,22 +298,127 @@ bool PubSubClientMock::subscribe(const char* topic)
     return true;
 }
 
+bool PubSubClientMock::unsubscribe(const char* topic)
+{
+    for (uint16_t i = 0; i < _subscriptionsNb; i++) {
+        if (strcmp(_subscriptions[i].topic, topic) != 0) {
+            continue;
+        }
+
+        delete[] _subscriptions[i].topic;
+        memmove(
+            &_subscriptions[i],
+            &_subscriptions[i + 1],
+            (_subscriptionsNb - i - 1) * sizeof(MqttSubscription)
+        );
+        _subscriptionsNb--;
+
+        if (_subscriptionsNb == 0) {
+            free(_subscriptions); // allocated with realloc
+            _subscriptions = nullptr;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
 void PubSubClientMock::clearFlushedMessages()
 {
+    for (uint16_t i = 0; i < _flushedMessagesNb; i++) {
+        delete[] _flushedMessages[i].topic;
+        delete[] _flushedMessages[i].buffer;
+    }
+
     if (_flushedMessages) {
-        delete _flushedMessages;
+        free(_flushedMessages); // allocated with realloc
+        _flushedMessages = nullptr;
     }
 
     _flushedMessagesNb = 0;
 }
 
+bool PubSubClientMock::beginPublishMessage(
+    const char* topic,
+    unsigned int plength,
+    bool retained,
+    uint16_t topicAlias
+)
+{
+    if (!connected()) {
+        return false;
+    }
+
+    if (_pendingMessage) {
+        delete _pendingMessage;
+    }
+
+    _pendingMessage = new MqttMessage();
+    _pendingMessage->retained = retained;
+    _pendingMessage->topicAlias = topicAlias;
+
+    {
+        size_t size = strlen(topic) + 1;
+        _pendingMessage->topic = new char[size];
+        _pendingMessage->topicSize = size;
+
+        memset(_pendingMessage->topic, 0, size);
+        memcpy(_pendingMessage->topic, topic, size);
+    }
+
+    {
+        size_t size = plength + 1;
+        _pendingMessage->buffer = new char[size];
+        _pendingMessage->bufferSize = size;
+
+        memset(_pendingMessage->buffer, 0, size);
+    }
+
+    return true;
+}
+
+void PubSubClientMock::clearTopicAliases()
+{
+    for (uint16_t i = 0; i < _topicAliasesNb; i++) {
+        if (_topicAliases[i]) {
+            delete[] _topicAliases[i];
+        }
+    }
+
+    if (_topicAliases) {
+        free(_topicAliases);
+        _topicAliases = nullptr;
+    }
+
+    _topicAliasesNb = 0;
+}
+
+uint8_t PubSubClientMock::calculateRemainingLengthSize(uint32_t length)
+{
+    uint8_t size = 1;
+    while (length > 127) {
+        length /= 128;
+        size++;
+    }
+
+    return size;
+}
+
+void PubSubClientMock::fakeAck(uint16_t packetId)
+{
+    if (_ackCallback) {
+        _ackCallback(packetId);
+    }
+}
+
 void PubSubClientMock::fakeMessage(const char* topic, const char* message)
 {
-    if (!callback) {
+    if (!_callback) {
         return;
     }
 
-    callback(
+    _callback(
         const_cast<char*>(topic), // hack
         const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(message)), // hack
         strlen(message)
@@ -5,13 +5,7 @@
 
 #include <Arduino.h>
 #include <IPAddress.h>
-
-#if defined(ESP8266) || defined(ESP32)
-#include <functional>
-#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
-#else
-#define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
-#endif
+#include "../transports/HAMqttTransport.h"
 
 struct MqttMessage
 {
@@ -20,13 +14,21 @@ struct MqttMessage
     char* buffer;
     size_t bufferSize;
     bool retained;
+    uint16_t topicAlias;
+    uint8_t qos;
+    uint16_t packetId;
+    bool duplicate;
 
     MqttMessage() :
         topic(nullptr),
         topicSize(0),
         buffer(nullptr),
         bufferSize(0),
-        retained(false)
+        retained(false),
+        topicAlias(0),
+        qos(0),
+        packetId(0),
+        duplicate(false)
     {
 
     }
@@ -34,11 +36,11 @@ struct MqttMessage
     ~MqttMessage()
     {
         if (topic) {
-            delete topic;
+            delete[] topic;
         }
 
         if (buffer) {
-            delete buffer;
+            delete[] buffer;
         }
     }
 };
@@ -55,7 +57,7 @@ struct MqttSubscription {
     ~MqttSubscription()
     {
         if (topic) {
-            delete topic;
+            delete[] topic;
         }
     }
 };
@@ -69,6 +71,7 @@ struct MqttConnection
     const char* id;
     const char* user;
     const char* pass;
+    bool cleanSession;
 
     MqttConnection() :
         connected(false),
@@ -76,7 +79,8 @@ struct MqttConnection
         port(0),
         id(nullptr),
         user(nullptr),
-        pass(nullptr)
+        pass(nullptr),
+        cleanSession(true)
     {
 
     }
@@ -97,16 +101,16 @@ struct MqttWill
     }
 };
 
-class PubSubClientMock
+class PubSubClientMock : public HAMqttTransport
 {
 public:
     PubSubClientMock();
-    ~PubSubClientMock();
+    virtual ~PubSubClientMock();
 
-    bool loop();
-    void disconnect();
-    bool connected();
-    bool connect(
+    virtual bool loop() override;
+    virtual void disconnect() override;
+    virtual bool connected() override;
+    virtual bool connect(
         const char *id,
         const char *user,
         const char *pass,
@@ -115,25 +119,87 @@ public:
         bool willRetain,
         const char* willMessage,
         bool cleanSession
-    );
+    ) override;
     bool connectDummy();
-    PubSubClientMock& setServer(IPAddress ip, uint16_t port);
-    PubSubClientMock& setServer(const char* domain, uint16_t port);
-    PubSubClientMock& setCallback(MQTT_CALLBACK_SIGNATURE);
+    virtual void setServer(IPAddress ip, uint16_t port) override;
+    virtual void setServer(const char* domain, uint16_t port) override;
+    virtual void setCallback(HAMQTT_TRANSPORT_CALLBACK(callback)) override;
+
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t plength,
+        bool retained
+    ) override;
+
+    /**
+     * Begins MQTT 5 publish with the topic alias.
+     * If the topic is empty then the alias needs to be already known by the mock
+     * and the message's topic is resolved from the alias.
+     * Otherwise, the alias is (re)assigned to the given topic.
+     */
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t plength,
+        bool retained,
+        uint16_t topicAlias
+    ) override;
+
+    virtual bool supportsTopicAliases() const override
+        { return true; }
+
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t plength,
+        bool retained,
+        uint8_t qos,
+        uint16_t packetId,
+        bool duplicate
+    ) override;
+
+    virtual bool supportsQos() const override
+        { return true; }
+
+    virtual void setAckCallback(HAMQTT_TRANSPORT_ACK_CALLBACK(callback)) override
+        { _ackCallback = callback; }
+
+    virtual uint16_t getMaxPacketSize() const override
+        { return _maxPacketSize; }
+
+    /**
+     * Sets the packet size limit reported to the HAMqtt.
+     * Plain publishes that exceed the limit are rejected by the mock.
+     */
+    inline void setMaxPacketSize(uint16_t size)
+        { _maxPacketSize = size; }
 
-    bool beginPublish(const char* topic, unsigned int plength, bool retained);
-    size_t write(const uint8_t *buffer, size_t size);
-    size_t print(const __FlashStringHelper* buffer);
-    int endPublish();
-    bool subscribe(const char* topic);
+    virtual uint16_t getMaxTopicLength() const override
+        { return _maxTopicLength; }
 
-    inline uint8_t getFlushedMessagesNb() const
+    /**
+     * Sets the topic length limit reported to the HAMqtt.
+     */
+    inline void setMaxTopicLength(uint16_t length)
+        { _maxTopicLength = length; }
+
+    virtual uint16_t getKeepAlive() const override
+        { return _keepAlive; }
+
+    inline void setKeepAlive(uint16_t keepAlive)
+        { _keepAlive = keepAlive; }
+
+    virtual size_t write(const uint8_t *buffer, size_t size) override;
+    virtual size_t write_P(const char* buffer) override;
+    virtual bool endPublish() override;
+    virtual bool subscribe(const char* topic) override;
+    virtual bool unsubscribe(const char* topic) override;
+
+    inline uint16_t getFlushedMessagesNb() const
         { return _flushedMessagesNb; }
 
     inline MqttMessage* getFlushedMessages() const
         { return _flushedMessages; }
 
-    inline uint8_t getSubscriptionsNb() const
+    inline uint16_t getSubscriptionsNb() const
         { return _subscriptionsNb; }
 
     inline MqttSubscription* getSubscriptions() const
@@ -145,18 +211,64 @@ public:
     inline const MqttWill& getLastWill() const
         { return _lastWill; }
 
+    /**
+     * Returns number of bytes of all PUBLISH packets that would be sent
+     * to the broker (fixed header, variable header and payload).
+     */
+    inline uint32_t getPublishedBytesNb() const
+        { return _publishedBytesNb; }
+
+    inline uint16_t getTopicAliasesNb() const
+        { return _topicAliasesNb; }
+
+    /**
+     * Simulates the broker that can't be reached.
+     * Connection attempts to the given hostname fail until it's set to nullptr.
+     */
+    inline void setUnreachableHost(const char* hostname)
+        { _unreachableHost = hostname; }
+
+    /**
+     * Returns number of connection attempts (both successful and failed).
+     */
+    inline uint16_t getConnectAttemptsNb() const
+        { return _connectAttemptsNb; }
+
     void clearFlushedMessages();
     void fakeMessage(const char* topic, const char* message);
 
+    /**
+     * Simulates PUBACK received from the broker.
+     */
+    void fakeAck(uint16_t packetId);
+
 private:
     MqttMessage* _pendingMessage;
     MqttMessage* _flushedMessages;
-    uint8_t _flushedMessagesNb;
+    uint16_t _flushedMessagesNb;
     MqttSubscription* _subscriptions;
-    uint8_t _subscriptionsNb;
+    uint16_t _subscriptionsNb;
     MqttConnection _connection;
     MqttWill _lastWill;
-    MQTT_CALLBACK_SIGNATURE;
+    uint32_t _publishedBytesNb;
+    char** _topicAliases;
+    uint16_t _topicAliasesNb;
+    uint16_t _maxPacketSize;
+    uint16_t _maxTopicLength;
+    const char* _unreachableHost;
+    uint16_t _connectAttemptsNb;
+    uint16_t _keepAlive;
+    HAMQTT_TRANSPORT_CALLBACK(_callback);
+    HAMQTT_TRANSPORT_ACK_CALLBACK(_ackCallback);
+
+    bool beginPublishMessage(
+        const char* topic,
+        unsigned int plength,
+        bool retained,
+        uint16_t topicAlias
+    );
+    void clearTopicAliases();
+    static uint8_t calculateRemainingLengthSize(uint32_t length);
 };
 
 #endif
@@ -0,0 +1,196 @@
+#ifndef AHA_HAMQTTTRANSPORT_H
+#define AHA_HAMQTTTRANSPORT_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+#define HAMQTT_TRANSPORT_CALLBACK(name) void (*name)(char* topic, uint8_t* payload, unsigned int length)
+#define HAMQTT_TRANSPORT_ACK_CALLBACK(name) void (*name)(uint16_t packetId)
+#define HAMQTT_DEFAULT_KEEPALIVE 15 // seconds, the same as in PubSubClient
+
+/**
+ * This class is an interface of the MQTT client used by the HAMqtt.
+ * By default the library uses PubSubClient (see HAPubSubClientTransport),
+ * but you can provide your own implementation (e.g. an asynchronous client)
+ * and pass it to the HAMqtt constructor. Devices types are not aware of the transport.
+ */
+class HAMqttTransport
+{
+public:
+    virtual ~HAMqttTransport() { }
+
+    /**
+     * Processes incoming messages and maintains the connection.
+     *
+     * @returns Returns false if the client is not connected.
+     */
+    virtual bool loop() = 0;
+
+    /**
+     * Returns true if connection with the broker is established.
+     */
+    virtual bool connected() = 0;
+
+    /**
+     * Connects to the broker set using the setServer method.
+     */
+    virtual bool connect(
+        const char* id,
+        const char* user,
+        const char* pass,
+        const char* willTopic,
+        uint8_t willQos,
+        bool willRetain,
+        const char* willMessage,
+        bool cleanSession
+    ) = 0;
+
+    /**
+     * Closes connection with the broker.
+     */
+    virtual void disconnect() = 0;
+
+    virtual void setServer(IPAddress ip, uint16_t port) = 0;
+    virtual void setServer(const char* domain, uint16_t port) = 0;
+
+    /**
+     * Sets callback that needs to be called for each message received from the broker.
+     */
+    virtual void setCallback(HAMQTT_TRANSPORT_CALLBACK(callback)) = 0;
+
+    /**
+     * Begins publishing of the message.
+     * The payload is written using write/write_P methods and the message
+     * is completed with the endPublish method.
+     *
+     * @param topic Topic of the message.
+     * @param length Total length of the payload.
+     * @param retained Specifies whether the message should be retained.
+     */
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t length,
+        bool retained
+    ) = 0;
+
+    /**
+     * Begins publishing of the message using MQTT 5 topic alias.
+     * The topic is empty if the alias was already sent to the broker.
+     * Implement this method only if the transport speaks MQTT 5.
+     */
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t length,
+        bool retained,
+        uint16_t topicAlias
+    ) {
+        (void)topic;
+        (void)length;
+        (void)retained;
+        (void)topicAlias;
+
+        return false;
+    }
+
+    /**
+     * Returns true if the beginPublish method with the topic alias is implemented.
+     */
+    virtual bool supportsTopicAliases() const
+        { return false; }
+
+    /**
+     * Begins publishing of the QoS 1 message.
+     * The transport needs to call the callback set using setAckCallback method
+     * once PUBACK with the given packet ID is received.
+     * Implement this method only if the transport supports QoS 1 publishing.
+     *
+     * @param topic Topic of the message.
+     * @param length Total length of the payload.
+     * @param retained Specifies whether the message should be retained.
+     * @param qos QoS of the message.
+     * @param packetId Packet identifier assigned by the HAMqtt.
+     * @param duplicate DUP flag (set for retransmissions).
+     */
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t length,
+        bool retained,
+        uint8_t qos,
+        uint16_t packetId,
+        bool duplicate
+    ) {
+        (void)topic;
+        (void)length;
+        (void)retained;
+        (void)qos;
+        (void)packetId;
+        (void)duplicate;
+
+        return false;
+    }
+
+    /**
+     * Returns true if the beginPublish method with QoS is implemented.
+     */
+    virtual bool supportsQos() const
+        { return false; }
+
+    /**
+     * Sets callback that needs to be called for each received PUBACK.
+     */
+    virtual void setAckCallback(HAMQTT_TRANSPORT_ACK_CALLBACK(callback))
+        { (void)callback; }
+
+    /**
+     * Returns the maximum size of a single MQTT packet (fixed header, topic and payload)
+     * that the transport is able to send.
+     * Zero means that the limit is unknown and payloads are not validated.
+     */
+    virtual uint16_t getMaxPacketSize() const
+        { return 0; }
+
+    /**
+     * Returns the maximum length of the topic that the transport is able to send.
+     * It's meant for transports that stream the payload but buffer the topic.
+     * Zero means that the limit is unknown and topics are not validated.
+     */
+    virtual uint16_t getMaxTopicLength() const
+        { return 0; }
+
+    /**
+     * Returns the keep alive interval (in seconds) used by the transport.
+     * The transport needs to be looped at least once per interval to keep the connection alive.
+     * Zero means that the keep alive is disabled.
+     */
+    virtual uint16_t getKeepAlive() const
+        { return HAMQTT_DEFAULT_KEEPALIVE; }
+
+    /**
+     * Writes part of the payload.
+     */
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * Writes part of the payload stored in the flash memory.
+     */
+    virtual size_t write_P(const char* src) = 0;
+
+    /**
+     * Completes the message started with the beginPublish method.
+     */
+    virtual bool endPublish() = 0;
+
+    /**
+     * Subscribes to the given topic.
+     */
+    virtual bool subscribe(const char* topic) = 0;
+
+    /**
+     * Unsubscribes from the given topic.
+     * Transports that don't support it leave the subscription until the session ends.
+     */
+    virtual bool unsubscribe(const char* topic)
+        { (void)topic; return false; }
+};
+
+#endif
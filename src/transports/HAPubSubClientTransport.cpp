@@ -0,0 +1,120 @@
+#include "HAPubSubClientTransport.h"
+#ifndef ARDUINOHA_TEST
+
+HAPubSubClientTransport::HAPubSubClientTransport(Client& netClient) :
+    _client(netClient),
+    _keepAlive(MQTT_KEEPALIVE)
+{
+
+}
+
+void HAPubSubClientTransport::setKeepAlive(uint16_t keepAlive)
+{
+    _keepAlive = keepAlive;
+    _client.setKeepAlive(keepAlive);
+}
+
+bool HAPubSubClientTransport::loop()
+{
+    return _client.loop();
+}
+
+bool HAPubSubClientTransport::connected()
+{
+    return _client.connected();
+}
+
+bool HAPubSubClientTransport::connect(
+    const char* id,
+    const char* user,
+    const char* pass,
+    const char* willTopic,
+    uint8_t willQos,
+    bool willRetain,
+    const char* willMessage,
+    bool cleanSession
+)
+{
+    return _client.connect(
+        id,
+        user,
+        pass,
+        willTopic,
+        willQos,
+        willRetain,
+        willMessage,
+        cleanSession
+    );
+}
+
+void HAPubSubClientTransport::disconnect()
+{
+    _client.disconnect();
+}
+
+void HAPubSubClientTransport::setServer(IPAddress ip, uint16_t port)
+{
+    _client.setServer(ip, port);
+}
+
+void HAPubSubClientTransport::setServer(const char* domain, uint16_t port)
+{
+    _client.setServer(domain, port);
+}
+
+void HAPubSubClientTransport::setCallback(
+    HAMQTT_TRANSPORT_CALLBACK(callback)
+)
+{
+    _client.setCallback(callback);
+}
+
+bool HAPubSubClientTransport::beginPublish(
+    const char* topic,
+    uint16_t length,
+    bool retained
+)
+{
+    return _client.beginPublish(topic, length, retained);
+}
+
+uint16_t HAPubSubClientTransport::getMaxTopicLength() const
+{
+    // The payload is streamed after beginPublish, so only the fixed header
+    // and the topic need to fit the buffer of the PubSubClient.
+    // getBufferSize() is not marked as const in PubSubClient.
+    const uint16_t bufferSize = const_cast<PubSubClient&>(_client).getBufferSize();
+    const uint16_t overhead = MQTT_MAX_HEADER_SIZE + 2;
+    if (bufferSize <= overhead) {
+        return 1; // zero would disable the validation
+    }
+
+    return bufferSize - overhead;
+}
+
+size_t HAPubSubClientTransport::write(const uint8_t* data, size_t length)
+{
+    return _client.write(data, length);
+}
+
+size_t HAPubSubClientTransport::write_P(const char* src)
+{
+    return _client.print(reinterpret_cast<const __FlashStringHelper*>(src));
+}
+
+bool HAPubSubClientTransport::endPublish()
+{
+    return _client.endPublish();
+}
+
+bool HAPubSubClientTransport::subscribe(const char* topic)
+{
+    return _client.subscribe(topic);
+}
+
+bool HAPubSubClientTransport::unsubscribe(const char* topic)
+{
+    return _client.unsubscribe(topic);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef AHA_HAPUBSUBCLIENTTRANSPORT_H
+#define AHA_HAPUBSUBCLIENTTRANSPORT_H
+
+#ifndef ARDUINOHA_TEST
+
+#include <PubSubClient.h>
+#include "HAMqttTransport.h"
+
+/**
+ * The default transport of the library that uses PubSubClient.
+ * PubSubClient has a single fixed-size packet buffer and supports MQTT 3.1.1 only.
+ */
+class HAPubSubClientTransport : public HAMqttTransport
+{
+public:
+    explicit HAPubSubClientTransport(Client& netClient);
+
+    /**
+     * Returns instance of the PubSubClient used by the transport.
+     * It may be useful if you need to change settings of the client (e.g. buffer size).
+     */
+    inline PubSubClient& getClient()
+        { return _client; }
+
+    /**
+     * Sets the keep alive interval of the PubSubClient.
+     * Please use this method instead of PubSubClient::setKeepAlive,
+     * so the HAMqtt is aware of the interval (see HAMqtt::getIdleTimeout).
+     *
+     * @param keepAlive Interval in seconds.
+     */
+    void setKeepAlive(uint16_t keepAlive);
+
+    virtual bool loop() override;
+    virtual bool connected() override;
+    virtual bool connect(
+        const char* id,
+        const char* user,
+        const char* pass,
+        const char* willTopic,
+        uint8_t willQos,
+        bool willRetain,
+        const char* willMessage,
+        bool cleanSession
+    ) override;
+    virtual void disconnect() override;
+    virtual void setServer(IPAddress ip, uint16_t port) override;
+    virtual void setServer(const char* domain, uint16_t port) override;
+    virtual void setCallback(HAMQTT_TRANSPORT_CALLBACK(callback)) override;
+    virtual bool beginPublish(
+        const char* topic,
+        uint16_t length,
+        bool retained
+    ) override;
+    using HAMqttTransport::beginPublish;
+    virtual uint16_t getMaxTopicLength() const override;
+    virtual uint16_t getKeepAlive() const override
+        { return _keepAlive; }
+    virtual size_t write(const uint8_t* data, size_t length) override;
+    virtual size_t write_P(const char* src) override;
+    virtual bool endPublish() override;
+    virtual bool subscribe(const char* topic) override;
+    virtual bool unsubscribe(const char* topic) override;
+
+private:
+    PubSubClient _client;
+    uint16_t _keepAlive;
+};
+
+#endif
+#endif
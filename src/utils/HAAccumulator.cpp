@@ -0,0 +1,99 @@
+#include <Arduino.h>
+
+#include "HAAccumulator.h"
+
+HAAccumulator::HAAccumulator(const uint16_t windowSize) :
+    _windowSize(windowSize),
+    _listenersNb(0)
+{
+    reset();
+}
+
+bool HAAccumulator::add(const float value)
+{
+    _count++;
+    _sum += value;
+
+    if (_count == 1 || value < _min) {
+        _min = value;
+    }
+
+    if (_count == 1 || value > _max) {
+        _max = value;
+    }
+
+    const float delta = value - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (value - _mean);
+
+    // the counter can't go any further, so the time based window is closed as well
+    if ((_windowSize > 0 && _count >= _windowSize) || _count == UINT16_MAX) {
+        flush();
+        return true;
+    }
+
+    return false;
+}
+
+void HAAccumulator::flush()
+{
+    if (_count == 0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _listenersNb; i++) {
+        _listeners[i]->onWindowCompleted(*this);
+    }
+
+    reset();
+}
+
+void HAAccumulator::reset()
+{
+    _count = 0;
+    _sum = 0;
+    _min = 0;
+    _max = 0;
+    _mean = 0;
+    _m2 = 0;
+}
+
+bool HAAccumulator::addListener(HAAccumulatorListener* listener)
+{
+    if (!listener || _listenersNb >= MaxListenersNb) {
+        return false;
+    }
+
+    _listeners[_listenersNb++] = listener;
+    return true;
+}
+
+void HAAccumulator::removeListener(HAAccumulatorListener* listener)
+{
+    for (uint8_t i = 0; i < _listenersNb; i++) {
+        if (_listeners[i] != listener) {
+            continue;
+        }
+
+        for (uint8_t j = i + 1; j < _listenersNb; j++) {
+            _listeners[j - 1] = _listeners[j];
+        }
+
+        _listenersNb--;
+        return;
+    }
+}
+
+float HAAccumulator::getVariance() const
+{
+    if (_count < 2) {
+        return 0;
+    }
+
+    return _m2 / (_count - 1);
+}
+
+float HAAccumulator::getStdDev() const
+{
+    return sqrt(getVariance());
+}
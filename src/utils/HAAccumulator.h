@@ -0,0 +1,111 @@
+#ifndef AHA_HAACCUMULATOR_H
+#define AHA_HAACCUMULATOR_H
+
+#include <stdint.h>
+
+class HAAccumulator;
+
+/**
+ * Receives the summary of the accumulator's window once it's completed.
+ */
+class HAAccumulatorListener
+{
+public:
+    virtual ~HAAccumulatorListener() { }
+    virtual void onWindowCompleted(const HAAccumulator& accumulator) = 0;
+};
+
+/**
+ * Running statistics of the samples (count, sum, min, max, mean and variance).
+ * Memory usage is constant regardless of the number of samples.
+ * The variance is calculated using Welford's algorithm.
+ */
+class HAAccumulator
+{
+public:
+    static const uint8_t MaxListenersNb = 6;
+
+    /**
+     * @param windowSize Number of samples in the window. Once the window is completed
+     *                   the listeners are notified and the accumulator is reset.
+     *                   Zero means that the window needs to be closed manually using the flush method
+     *                   (it's flushed automatically once it reaches 65535 samples).
+     */
+    HAAccumulator(const uint16_t windowSize = 0);
+
+    /**
+     * Adds a new sample to the window.
+     * The window is completed when it reaches the window size or 65535 samples
+     * (the limit of the counter), whichever comes first.
+     *
+     * @returns Returns true if the sample completed the window.
+     */
+    bool add(const float value);
+
+    /**
+     * Notifies listeners about the current window (if it's not empty) and resets the accumulator.
+     * It may be used for time based windows.
+     */
+    void flush();
+
+    /**
+     * Clears all samples without notifying listeners.
+     */
+    void reset();
+
+    /**
+     * Registers listener of the window.
+     *
+     * @returns Returns false if the limit of listeners was reached.
+     */
+    bool addListener(HAAccumulatorListener* listener);
+
+    /**
+     * Unregisters the given listener.
+     */
+    void removeListener(HAAccumulatorListener* listener);
+
+    inline void setWindowSize(const uint16_t windowSize)
+        { _windowSize = windowSize; }
+
+    inline uint16_t getWindowSize() const
+        { return _windowSize; }
+
+    inline uint16_t getCount() const
+        { return _count; }
+
+    inline float getSum() const
+        { return _sum; }
+
+    inline float getMin() const
+        { return _min; }
+
+    inline float getMax() const
+        { return _max; }
+
+    inline float getMean() const
+        { return _mean; }
+
+    /**
+     * Returns sample variance of the window (zero if there are less than two samples).
+     */
+    float getVariance() const;
+
+    /**
+     * Returns sample standard deviation of the window.
+     */
+    float getStdDev() const;
+
+private:
+    uint16_t _windowSize;
+    uint16_t _count;
+    float _sum;
+    float _min;
+    float _max;
+    float _mean;
+    float _m2;
+    uint8_t _listenersNb;
+    HAAccumulatorListener* _listeners[MaxListenersNb];
+};
+
+#endif
@@ -1,105 +1,118 @@
 #ifndef AHA_HADICTIONARY_H
 #define AHA_HADICTIONARY_H
 
-// decorators
-extern const char HASerializerSlash[];
-extern const char HASerializerJsonDataPrefix[];
-extern const char HASerializerJsonDataSuffix[];
-extern const char HASerializerJsonPropertyPrefix[];
-extern const char HASerializerJsonPropertySuffix[];
-extern const char HASerializerJsonEscapeChar[];
-extern const char HASerializerJsonPropertiesSeparator[];
-extern const char HASerializerJsonArrayPrefix[];
-extern const char HASerializerJsonArraySuffix[];
-extern const char HASerializerUnderscore[];
+#include <stddef.h>
+#include <stdint.h>
 
-// properties
-extern const char HADeviceIdentifiersProperty[];
-extern const char HADeviceManufacturerProperty[];
-extern const char HADeviceModelProperty[];
-extern const char HADeviceSoftwareVersionProperty[];
-extern const char HANameProperty[];
-extern const char HAUniqueIdProperty[];
-extern const char HADeviceProperty[];
-extern const char HADeviceClassProperty[];
-extern const char HAIconProperty[];
-extern const char HARetainProperty[];
-extern const char HASourceTypeProperty[];
-extern const char HAEncodingProperty[];
-extern const char HAOptimisticProperty[];
-extern const char HAAutomationTypeProperty[];
-extern const char HATypeProperty[];
-extern const char HASubtypeProperty[];
-extern const char HAForceUpdateProperty[];
-extern const char HAUnitOfMeasurementProperty[];
-extern const char HAValueTemplateProperty[];
+/**
+ * All strings of the library in the single table. Each entry is expanded to
+ * the PROGMEM array in HADictionary.cpp and to the sized extern declaration below,
+ * so the length of the string is known at compile time (see HADictionaryLength).
+ */
+#define HADICTIONARY(X) \
+    /* decorators */ \
+    X(HASerializerSlash, "/") \
+    X(HASerializerJsonDataPrefix, "{") \
+    X(HASerializerJsonDataSuffix, "}") \
+    X(HASerializerJsonPropertyPrefix, "\"") \
+    X(HASerializerJsonPropertySuffix, "\":") \
+    X(HASerializerJsonEscapeChar, "\"") \
+    X(HASerializerJsonPropertiesSeparator, ",") \
+    X(HASerializerJsonArrayPrefix, "[") \
+    X(HASerializerJsonArraySuffix, "]") \
+    X(HASerializerUnderscore, "_") \
+    /* properties */ \
+    X(HADeviceIdentifiersProperty, "ids") \
+    X(HADeviceManufacturerProperty, "mf") \
+    X(HADeviceModelProperty, "mdl") \
+    X(HADeviceSoftwareVersionProperty, "sw") \
+    X(HANameProperty, "name") \
+    X(HAUniqueIdProperty, "uniq_id") \
+    X(HADeviceProperty, "dev") \
+    X(HADeviceClassProperty, "dev_cla") \
+    X(HAIconProperty, "ic") \
+    X(HARetainProperty, "ret") \
+    X(HASourceTypeProperty, "src_type") \
+    X(HAEncodingProperty, "e") \
+    X(HAOptimisticProperty, "opt") \
+    X(HAAutomationTypeProperty, "atype") \
+    X(HATypeProperty, "type") \
+    X(HASubtypeProperty, "stype") \
+    X(HAForceUpdateProperty, "frc_upd") \
+    X(HAUnitOfMeasurementProperty, "unit_of_meas") \
+    X(HAValueTemplateProperty, "val_tpl") \
+    X(HABaseTopicProperty, "~") \
+    /* topics */ \
+    X(HAConfigTopic, "config") \
+    X(HAAvailabilityTopic, "avty_t") \
+    X(HATopic, "t") \
+    X(HAStateTopic, "stat_t") \
+    X(HACommandTopic, "cmd_t") \
+    X(HAPositionTopic, "pos_t") \
+    X(HASetPositionTopic, "set_pos_t") \
+    /* misc */ \
+    X(HAOnline, "online") \
+    X(HAOffline, "offline") \
+    X(HAStateOn, "on") \
+    X(HAStateOff, "off") \
+    X(HAStateLocked, "locked") \
+    X(HAStateUnlocked, "unlocked") \
+    X(HATrue, "true") \
+    X(HAFalse, "false") \
+    X(HAHome, "home") \
+    X(HANotHome, "not_home") \
+    X(HATrigger, "trigger") \
+    /* covers */ \
+    X(HAClosedState, "closed") \
+    X(HAClosingState, "closing") \
+    X(HAOpenState, "open") \
+    X(HAOpeningState, "opening") \
+    X(HAStoppedState, "stopped") \
+    /* commands */ \
+    X(HAOpenCommand, "OPEN") \
+    X(HACloseCommand, "CLOSE") \
+    X(HAStopCommand, "STOP") \
+    X(HALockCommand, "LOCK") \
+    X(HAUnlockCommand, "UNLOCK") \
+    /* device tracker */ \
+    X(HAGPSType, "gps") \
+    X(HARouterType, "router") \
+    X(HABluetoothType, "bluetooth") \
+    X(HABluetoothLEType, "bluetooth_le") \
+    /* camera */ \
+    X(HAEncodingBase64, "b64") \
+    /* trigger */ \
+    X(HAButtonShortPressType, "button_short_press") \
+    X(HAButtonShortReleaseType, "button_short_release") \
+    X(HAButtonLongPressType, "button_long_press") \
+    X(HAButtonLongReleaseType, "button_long_release") \
+    X(HAButtonDoublePressType, "button_double_press") \
+    X(HAButtonTriplePressType, "button_triple_press") \
+    X(HAButtonQuadruplePressType, "button_quadruple_press") \
+    X(HAButtonQuintuplePressType, "button_quintuple_press") \
+    X(HATurnOnSubtype, "turn_on") \
+    X(HATurnOffSubtype, "turn_off") \
+    X(HAButton1Subtype, "button_1") \
+    X(HAButton2Subtype, "button_2") \
+    X(HAButton3Subtype, "button_3") \
+    X(HAButton4Subtype, "button_4") \
+    X(HAButton5Subtype, "button_5") \
+    X(HAButton6Subtype, "button_6") \
+    /* value templates */ \
+    X(HAValueTemplateFloatP1, "{{float(value)/10**1}}") \
+    X(HAValueTemplateFloatP2, "{{float(value)/10**2}}") \
+    X(HAValueTemplateFloatP3, "{{float(value)/10**3}}") \
+    X(HAValueTemplateFloatP4, "{{float(value)/10**4}}")
 
-// topics
-extern const char HAConfigTopic[];
-extern const char HAAvailabilityTopic[];
-extern const char HATopic[];
-extern const char HAStateTopic[];
-extern const char HACommandTopic[];
-extern const char HAPositionTopic[];
+#define HADICTIONARY_DECLARE(name, value) extern const char name[sizeof(value)];
+HADICTIONARY(HADICTIONARY_DECLARE)
 
-// misc
-extern const char HAOnline[];
-extern const char HAOffline[];
-extern const char HAStateOn[];
-extern const char HAStateOff[];
-extern const char HAStateLocked[];
-extern const char HAStateUnlocked[];
-extern const char HATrue[];
-extern const char HAFalse[];
-extern const char HAHome[];
-extern const char HANotHome[];
-extern const char HATrigger[];
-
-// covers
-extern const char HAClosedState[];
-extern const char HAClosingState[];
-extern const char HAOpenState[];
-extern const char HAOpeningState[];
-extern const char HAStoppedState[];
-
-// commands
-extern const char HAOpenCommand[];
-extern const char HACloseCommand[];
-extern const char HAStopCommand[];
-extern const char HALockCommand[];
-extern const char HAUnlockCommand[];
-
-// device tracker
-extern const char HAGPSType[];
-extern const char HARouterType[];
-extern const char HABluetoothType[];
-extern const char HABluetoothLEType[];
-
-// camera
-extern const char HAEncodingBase64[];
-
-// trigger
-extern const char HAButtonShortPressType[];
-extern const char HAButtonShortReleaseType[];
-extern const char HAButtonLongPressType[];
-extern const char HAButtonLongReleaseType[];
-extern const char HAButtonDoublePressType[];
-extern const char HAButtonTriplePressType[];
-extern const char HAButtonQuadruplePressType[];
-extern const char HAButtonQuintuplePressType[];
-extern const char HATurnOnSubtype[];
-extern const char HATurnOffSubtype[];
-extern const char HAButton1Subtype[];
-extern const char HAButton2Subtype[];
-extern const char HAButton3Subtype[];
-extern const char HAButton4Subtype[];
-extern const char HAButton5Subtype[];
-extern const char HAButton6Subtype[];
-
-// value templates
-extern const char HAValueTemplateFloatP1[];
-extern const char HAValueTemplateFloatP2[];
-extern const char HAValueTemplateFloatP3[];
-extern const char HAValueTemplateFloatP4[];
+/**
+ * Returns length of the dictionary string (without null terminator).
+ * It's evaluated at compile time, so there is no need to call strlen_P.
+ */
+template <size_t N>
+constexpr uint16_t HADictionaryLength(const char (&)[N])
+    { return N - 1; }
 
 #endif
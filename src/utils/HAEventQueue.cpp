@@ -0,0 +1,79 @@
+#include <Arduino.h>
+
+#include "HAEventQueue.h"
+#include "../ArduinoHADefines.h"
+
+#if defined(__AVR__)
+    // single core, the compiler barrier is enough
+    #define HAEVENTQUEUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+    #define HAEVENTQUEUE_BARRIER() __sync_synchronize()
+#endif
+
+HAEventQueue::HAEventQueue(const uint8_t size) :
+    _capacity(size < UINT8_MAX ? size + 1 : UINT8_MAX), // one slot is always empty
+    _events(new HAQueuedEvent[_capacity]),
+    _head(0),
+    _tail(0),
+    _droppedNb(0)
+{
+
+}
+
+HAEventQueue::~HAEventQueue()
+{
+    delete[] _events;
+}
+
+ARDUINOHA_ISR_ATTR bool HAEventQueue::push(
+    HABaseDeviceType* deviceType,
+    const uint8_t value
+)
+{
+    const uint8_t head = _head;
+    const uint8_t next = (head + 1) % _capacity;
+
+    if (next == _tail) {
+        if (_droppedNb < UINT8_MAX) {
+            _droppedNb++;
+        }
+
+        return false;
+    }
+
+    _events[head].deviceType = deviceType;
+    _events[head].value = value;
+
+    HAEVENTQUEUE_BARRIER(); // the event needs to be written before it's visible for the consumer
+    _head = next;
+
+    return true;
+}
+
+bool HAEventQueue::pop(HAQueuedEvent& event)
+{
+    const uint8_t tail = _tail;
+    if (tail == _head) {
+        return false;
+    }
+
+    HAEVENTQUEUE_BARRIER();
+    event = _events[tail];
+
+    HAEVENTQUEUE_BARRIER(); // the slot needs to be read before it's released
+    _tail = (tail + 1) % _capacity;
+
+    return true;
+}
+
+void HAEventQueue::invalidate(const HABaseDeviceType* deviceType)
+{
+    const uint8_t head = _head;
+    HAEVENTQUEUE_BARRIER();
+
+    for (uint8_t i = _tail; i != head; i = (i + 1) % _capacity) {
+        if (_events[i].deviceType == deviceType) {
+            _events[i].deviceType = nullptr;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef AHA_HAEVENTQUEUE_H
+#define AHA_HAEVENTQUEUE_H
+
+#include <stdint.h>
+
+class HABaseDeviceType;
+
+/**
+ * Event recorded in the interrupt handler that's waiting for the HAMqtt::loop.
+ */
+struct HAQueuedEvent
+{
+    HABaseDeviceType* deviceType; // nullptr means that the event was invalidated
+    uint8_t value;
+};
+
+/**
+ * Lock-free single-producer/single-consumer ring of the events.
+ * The producer (interrupt handler) only moves the head and the consumer (loop) only moves the tail.
+ * Both indexes are single bytes, so they're read and written atomically on all supported boards.
+ */
+class HAEventQueue
+{
+public:
+    /**
+     * @param size Maximum number of the pending events.
+     */
+    HAEventQueue(const uint8_t size);
+    ~HAEventQueue();
+
+    inline uint8_t getSize() const
+        { return _capacity - 1; }
+
+    inline bool isEmpty() const
+        { return (_head == _tail); }
+
+    /**
+     * Returns number of events that were dropped because the queue was full (saturates at 255).
+     */
+    inline uint8_t getDroppedNb() const
+        { return _droppedNb; }
+
+    /**
+     * Adds the event to the queue. It's safe to call this method from the interrupt handler.
+     *
+     * @returns Returns false if the queue is full.
+     */
+    bool push(HABaseDeviceType* deviceType, const uint8_t value);
+
+    /**
+     * Takes the oldest event from the queue.
+     *
+     * @returns Returns false if the queue is empty.
+     */
+    bool pop(HAQueuedEvent& event);
+
+    /**
+     * Invalidates pending events of the given entity (consumer side only).
+     */
+    void invalidate(const HABaseDeviceType* deviceType);
+
+private:
+    const uint8_t _capacity;
+    HAQueuedEvent* _events;
+    volatile uint8_t _head;
+    volatile uint8_t _tail;
+    volatile uint8_t _droppedNb;
+};
+
+#endif
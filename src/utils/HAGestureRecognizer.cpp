@@ -0,0 +1,174 @@
+#include <Arduino.h>
+
+#include "HAGestureRecognizer.h"
+#ifndef EX_ARDUINOHA_DEVICE_TRIGGER
+
+#include "HADictionary.h"
+#include "../device-types/HADeviceTrigger.h"
+
+// rows: states, columns: events (press, release, multi-press timeout, long press timeout)
+const HABaseGestureRecognizer::Transition HABaseGestureRecognizer::Transitions[StatesNb][EventsNb] PROGMEM = {
+    { // idle
+        {StatePressed, ActionCountPress},
+        {StateIdle, ActionNone},
+        {StateIdle, ActionNone},
+        {StateIdle, ActionNone}
+    },
+    { // pressed
+        {StatePressed, ActionNone},
+        {StateReleased, ActionRestartTimer},
+        {StatePressed, ActionNone},
+        {StateLongPressed, ActionFireLongPress}
+    },
+    { // released
+        {StatePressed, ActionCountPress},
+        {StateReleased, ActionNone},
+        {StateIdle, ActionFireMultiPress},
+        {StateReleased, ActionNone}
+    },
+    { // long pressed
+        {StateLongPressed, ActionNone},
+        {StateIdle, ActionFireLongRelease},
+        {StateLongPressed, ActionNone},
+        {StateLongPressed, ActionNone}
+    }
+};
+
+HABaseGestureRecognizer::HABaseGestureRecognizer(
+    Button* buttons,
+    const uint8_t buttonsNb,
+    Binding* bindings,
+    const uint8_t maxBindingsNb
+) :
+    _buttonsNb(buttonsNb),
+    _maxBindingsNb(maxBindingsNb),
+    _bindingsNb(0),
+    _buttons(buttons),
+    _bindings(bindings),
+    _readCallback(nullptr),
+    _debounceTime(DefaultDebounceTime),
+    _multiPressTime(DefaultMultiPressTime),
+    _longPressTime(DefaultLongPressTime)
+{
+
+}
+
+bool HABaseGestureRecognizer::bind(const uint8_t button, HADeviceTrigger* trigger)
+{
+    if (!trigger || button >= _buttonsNb || _bindingsNb >= _maxBindingsNb) {
+        return false;
+    }
+
+    _bindings[_bindingsNb].button = button;
+    _bindings[_bindingsNb].trigger = trigger;
+    _bindingsNb++;
+
+    return true;
+}
+
+void HABaseGestureRecognizer::tick(const uint32_t now)
+{
+    if (!_readCallback) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _buttonsNb; i++) {
+        Button& button = _buttons[i];
+        const bool level = _readCallback(i);
+
+        if (level != button.rawLevel) {
+            button.rawLevel = level;
+            button.rawChangedAt = now;
+        }
+
+        if (
+            button.rawLevel != button.stableLevel &&
+            (now - button.rawChangedAt) >= _debounceTime
+        ) {
+            button.stableLevel = button.rawLevel;
+            processEvent(i, button.stableLevel ? EventPress : EventRelease, now);
+        }
+
+        if (
+            button.state == StatePressed &&
+            (now - button.timerAt) >= _longPressTime
+        ) {
+            processEvent(i, EventLongPressTimeout, now);
+        } else if (
+            button.state == StateReleased &&
+            (now - button.timerAt) >= _multiPressTime
+        ) {
+            processEvent(i, EventMultiPressTimeout, now);
+        }
+    }
+}
+
+void HABaseGestureRecognizer::processEvent(
+    const uint8_t index,
+    const Event event,
+    const uint32_t now
+)
+{
+    Button& button = _buttons[index];
+    const Transition* transition = &Transitions[button.state][event];
+    button.state = pgm_read_byte(&transition->nextState);
+
+    switch (pgm_read_byte(&transition->action)) {
+    case ActionCountPress:
+        if (button.pressesNb < UINT8_MAX) {
+            button.pressesNb++;
+        }
+
+        button.timerAt = now;
+        break;
+
+    case ActionRestartTimer:
+        button.timerAt = now;
+        break;
+
+    case ActionFireLongPress:
+        fire(index, HAButtonLongPressType);
+        break;
+
+    case ActionFireLongRelease:
+        fire(index, HAButtonLongReleaseType);
+        button.pressesNb = 0;
+        break;
+
+    case ActionFireMultiPress:
+        if (button.pressesNb == 1) {
+            fire(index, HAButtonShortPressType);
+            fire(index, HAButtonShortReleaseType);
+        } else if (button.pressesNb == 2) {
+            fire(index, HAButtonDoublePressType);
+        } else if (button.pressesNb == 3) {
+            fire(index, HAButtonTriplePressType);
+        } else if (button.pressesNb == 4) {
+            fire(index, HAButtonQuadruplePressType);
+        } else {
+            fire(index, HAButtonQuintuplePressType);
+        }
+
+        button.pressesNb = 0;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void HABaseGestureRecognizer::fire(const uint8_t index, const char* typeP)
+{
+    for (uint8_t i = 0; i < _bindingsNb; i++) {
+        const Binding& binding = _bindings[i];
+        if (
+            binding.button == index &&
+            binding.trigger->isProgmemType() &&
+            binding.trigger->getType() == typeP
+        ) {
+            binding.trigger->trigger();
+        }
+    }
+}
+
+#endif
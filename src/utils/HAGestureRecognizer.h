@@ -0,0 +1,172 @@
+#ifndef AHA_HAGESTURERECOGNIZER_H
+#define AHA_HAGESTURERECOGNIZER_H
+
+#include <stdint.h>
+
+#include "../ArduinoHADefines.h"
+
+#ifndef EX_ARDUINOHA_DEVICE_TRIGGER
+
+#define HAGESTURE_READ_CALLBACK(name) bool (*name)(uint8_t button)
+
+class HADeviceTrigger;
+
+/**
+ * Debounced detection of the button gestures (short press, long press, double press, etc.).
+ * All buttons are processed in a single tick using the table-driven state machine.
+ * Recognized gestures fire the bound HADeviceTrigger instances with the matching built-in type
+ * (e.g. the trigger created with HADeviceTrigger::ButtonDoublePressType fires on double press).
+ * The buttons and bindings are stored by the HAGestureRecognizer template, so nothing is allocated on the heap.
+ */
+class HABaseGestureRecognizer
+{
+public:
+    static const uint16_t DefaultDebounceTime = 30; // ms
+    static const uint16_t DefaultMultiPressTime = 400; // ms
+    static const uint16_t DefaultLongPressTime = 1000; // ms
+
+    /**
+     * Sets callback that returns raw level of the button (true means pressed).
+     *
+     * @param callback
+     */
+    inline void onRead(HAGESTURE_READ_CALLBACK(callback))
+        { _readCallback = callback; }
+
+    /**
+     * Sets time that the raw level needs to be stable before it's accepted.
+     */
+    inline void setDebounceTime(const uint16_t time)
+        { _debounceTime = time; }
+
+    /**
+     * Sets maximum time between release and the next press of the multi-press gesture.
+     */
+    inline void setMultiPressTime(const uint16_t time)
+        { _multiPressTime = time; }
+
+    /**
+     * Sets minimum time that the button needs to be held to trigger the long press.
+     */
+    inline void setLongPressTime(const uint16_t time)
+        { _longPressTime = time; }
+
+    /**
+     * Binds the trigger to the button.
+     * Only triggers with the built-in button types are fired.
+     *
+     * @param button Index of the button.
+     * @param trigger Trigger to fire.
+     * @returns Returns false if the limit of bindings was reached.
+     */
+    bool bind(const uint8_t button, HADeviceTrigger* trigger);
+
+    /**
+     * Reads levels of all buttons and fires recognized gestures.
+     * It needs to be called frequently (at least once per debounce time).
+     *
+     * @param now Current time in milliseconds.
+     */
+    void tick(const uint32_t now);
+
+protected:
+    struct Button {
+        uint32_t rawChangedAt;
+        uint32_t timerAt;
+        uint8_t state;
+        uint8_t pressesNb;
+        bool rawLevel;
+        bool stableLevel;
+    };
+
+    struct Binding {
+        uint8_t button;
+        HADeviceTrigger* trigger;
+    };
+
+    /**
+     * @param buttons Storage of the buttons' state (it needs to be zeroed).
+     * @param buttonsNb Number of the buttons.
+     * @param bindings Storage of the bindings.
+     * @param maxBindingsNb Maximum number of the triggers that can be bound.
+     */
+    HABaseGestureRecognizer(
+        Button* buttons,
+        const uint8_t buttonsNb,
+        Binding* bindings,
+        const uint8_t maxBindingsNb
+    );
+
+private:
+    enum State {
+        StateIdle = 0,
+        StatePressed,
+        StateReleased,
+        StateLongPressed,
+        StatesNb
+    };
+
+    enum Event {
+        EventPress = 0,
+        EventRelease,
+        EventMultiPressTimeout,
+        EventLongPressTimeout,
+        EventsNb
+    };
+
+    enum Action {
+        ActionNone = 0,
+        ActionCountPress,
+        ActionRestartTimer,
+        ActionFireLongPress,
+        ActionFireLongRelease,
+        ActionFireMultiPress
+    };
+
+    struct Transition {
+        uint8_t nextState;
+        uint8_t action;
+    };
+
+    static const Transition Transitions[StatesNb][EventsNb];
+
+    void processEvent(const uint8_t index, const Event event, const uint32_t now);
+    void fire(const uint8_t index, const char* typeP);
+
+    const uint8_t _buttonsNb;
+    const uint8_t _maxBindingsNb;
+    uint8_t _bindingsNb;
+    Button* const _buttons;
+    Binding* const _bindings;
+    HAGESTURE_READ_CALLBACK(_readCallback);
+    uint16_t _debounceTime;
+    uint16_t _multiPressTime;
+    uint16_t _longPressTime;
+};
+
+/**
+ * Gesture recognizer with the fixed number of buttons and bindings.
+ * For example, `HAGestureRecognizer<2, 10> recognizer;` handles two buttons and up to ten triggers.
+ *
+ * @tparam ButtonsNb Number of the buttons.
+ * @tparam MaxBindingsNb Maximum number of the triggers that can be bound.
+ */
+template <uint8_t ButtonsNb, uint8_t MaxBindingsNb>
+class HAGestureRecognizer : public HABaseGestureRecognizer
+{
+public:
+    HAGestureRecognizer() :
+        HABaseGestureRecognizer(_buttonsStorage, ButtonsNb, _bindingsStorage, MaxBindingsNb),
+        _buttonsStorage(),
+        _bindingsStorage()
+    {
+
+    }
+
+private:
+    Button _buttonsStorage[ButtonsNb];
+    Binding _bindingsStorage[MaxBindingsNb];
+};
+
+#endif
+#endif
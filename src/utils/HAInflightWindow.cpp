@@ -0,0 +1,111 @@
+#include <Arduino.h>
+
+#include "HAInflightWindow.h"
+
+HAInflightWindow::HAInflightWindow(const uint8_t size) :
+    _size(size),
+    _messagesNb(0),
+    _nextSequence(0),
+    _messages(new HAInflightMessage[size])
+{
+    clear();
+}
+
+HAInflightWindow::~HAInflightWindow()
+{
+    delete[] _messages;
+}
+
+HAInflightMessage* HAInflightWindow::next(const HAInflightMessage* previous) const
+{
+    // the age is relative to the next sequence, so the wrap-around doesn't break the order
+    const uint16_t maxAge = previous
+        ? (uint16_t)(_nextSequence - previous->sequence)
+        : 0;
+    HAInflightMessage* result = nullptr;
+    uint16_t resultAge = 0;
+
+    for (uint8_t i = 0; i < _size; i++) {
+        if (_messages[i].packetId == 0) {
+            continue;
+        }
+
+        const uint16_t age = _nextSequence - _messages[i].sequence;
+        if ((previous && age >= maxAge) || (result && age <= resultAge)) {
+            continue;
+        }
+
+        result = &_messages[i];
+        resultAge = age;
+    }
+
+    return result;
+}
+
+bool HAInflightWindow::contains(const uint16_t packetId) const
+{
+    if (packetId == 0) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _size; i++) {
+        if (_messages[i].packetId == packetId) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+HAInflightMessage* HAInflightWindow::acquire(const uint16_t packetId)
+{
+    if (packetId == 0) {
+        return nullptr;
+    }
+
+    for (uint8_t i = 0; i < _size; i++) {
+        if (_messages[i].packetId == 0) {
+            _messages[i].packetId = packetId;
+            _messages[i].sequence = _nextSequence++;
+            _messagesNb++;
+
+            return &_messages[i];
+        }
+    }
+
+    return nullptr;
+}
+
+bool HAInflightWindow::release(const uint16_t packetId)
+{
+    if (packetId == 0) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _size; i++) {
+        if (_messages[i].packetId == packetId) {
+            _messages[i].packetId = 0;
+            _messagesNb--;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void HAInflightWindow::releaseAll(const HABaseDeviceType* deviceType)
+{
+    for (uint8_t i = 0; i < _size; i++) {
+        if (_messages[i].packetId != 0 && _messages[i].deviceType == deviceType) {
+            _messages[i].packetId = 0;
+            _messagesNb--;
+        }
+    }
+}
+
+void HAInflightWindow::clear()
+{
+    memset(_messages, 0, sizeof(HAInflightMessage) * _size);
+    _messagesNb = 0;
+}
@@ -0,0 +1,99 @@
+#ifndef AHA_HAINFLIGHTWINDOW_H
+#define AHA_HAINFLIGHTWINDOW_H
+
+#include <stdint.h>
+
+class HABaseDeviceType;
+
+/**
+ * QoS 1 message that has been sent to the broker but not acknowledged yet.
+ * The topic is not stored in the slot. It's regenerated from the entity, the index
+ * of the served entity (see HABaseDeviceType::getSelectedIndex) and the topic's suffix
+ * when the message needs to be retransmitted.
+ */
+struct HAInflightMessage
+{
+    static const uint8_t MaxPayloadSize = 12;
+
+    uint16_t packetId; // 0 means that the slot is free
+    uint16_t sequence; // order in which the messages were sent
+    HABaseDeviceType* deviceType;
+    uint8_t index;
+    const char* topicP;
+    char payload[MaxPayloadSize];
+    uint8_t length;
+    bool retained;
+};
+
+/**
+ * Fixed-size table of the in-flight QoS 1 messages.
+ * The memory is allocated once in the constructor, so RAM usage is predictable.
+ */
+class HAInflightWindow
+{
+public:
+    HAInflightWindow(const uint8_t size);
+    ~HAInflightWindow();
+
+    inline uint8_t getSize() const
+        { return _size; }
+
+    inline uint8_t getMessagesNb() const
+        { return _messagesNb; }
+
+    inline bool isFull() const
+        { return (_messagesNb >= _size); }
+
+    /**
+     * Returns message stored in the given slot.
+     * The slot is free if packet ID of the message is 0.
+     */
+    inline HAInflightMessage* getSlot(const uint8_t index) const
+        { return (index < _size ? &_messages[index] : nullptr); }
+
+    /**
+     * Returns the in-flight message that was sent right after the given one.
+     * Slots are reused, so this method allows to retransmit messages in the order they were sent.
+     *
+     * @param previous The previous message or nullptr to get the oldest one.
+     * @returns Pointer to the message or nullptr if there are no more messages.
+     */
+    HAInflightMessage* next(const HAInflightMessage* previous) const;
+
+    /**
+     * Returns true if the given packet ID is used by one of the in-flight messages.
+     */
+    bool contains(const uint16_t packetId) const;
+
+    /**
+     * Reserves a free slot for the given packet ID.
+     *
+     * @returns Pointer to the slot or nullptr if the window is full.
+     */
+    HAInflightMessage* acquire(const uint16_t packetId);
+
+    /**
+     * Releases slot of the acknowledged message.
+     *
+     * @returns Returns true if the packet ID was in-flight.
+     */
+    bool release(const uint16_t packetId);
+
+    /**
+     * Releases all slots that belong to the given entity.
+     */
+    void releaseAll(const HABaseDeviceType* deviceType);
+
+    /**
+     * Releases all slots.
+     */
+    void clear();
+
+private:
+    uint8_t _size;
+    uint8_t _messagesNb;
+    uint16_t _nextSequence;
+    HAInflightMessage* _messages;
+};
+
+#endif
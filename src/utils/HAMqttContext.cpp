@@ -0,0 +1,200 @@
+#include <Arduino.h>
+
+#include "HAMqttContext.h"
+#include "HADictionary.h"
+#include "../HADevice.h"
+
+// copies the string followed by the slash and returns pointer to the end of the output
+static char* appendSegment(char* output, const char* str, const uint16_t length)
+{
+    memcpy(output, str, length);
+    output += length;
+    *output++ = '/';
+
+    return output;
+}
+
+HAMqttContext::HAMqttContext(
+    HAMqtt* mqtt,
+    const HADevice* device,
+    const char* discoveryPrefix,
+    const char* dataPrefix
+) :
+    _mqtt(mqtt),
+    _device(device),
+    _discoveryPrefix(nullptr),
+    _discoveryPrefixLength(0),
+    _dataPrefix(nullptr),
+    _dataPrefixLength(0)
+{
+    setDiscoveryPrefix(discoveryPrefix);
+    setDataPrefix(dataPrefix);
+}
+
+void HAMqttContext::setDiscoveryPrefix(const char* prefix)
+{
+    _discoveryPrefix = prefix;
+    _discoveryPrefixLength = prefix ? strlen(prefix) : 0;
+}
+
+void HAMqttContext::setDataPrefix(const char* prefix)
+{
+    _dataPrefix = prefix;
+    _dataPrefixLength = prefix ? strlen(prefix) : 0;
+}
+
+uint16_t HAMqttContext::calculateConfigTopicLength(
+    const char* componentName,
+    const char* objectId,
+    const HADevice* device
+) const
+{
+    device = resolveDevice(device);
+    if (
+        !componentName ||
+        !objectId ||
+        !_discoveryPrefix ||
+        !device ||
+        !device->getUniqueId()
+    ) {
+        return 0;
+    }
+
+    return
+        _discoveryPrefixLength + 1 + // prefix with slash
+        strlen(componentName) + 1 + // component name with slash
+        device->getUniqueIdLength() + 1 + // device ID with slash
+        strlen(objectId) + 1 + // object ID with slash
+        HADictionaryLength(HAConfigTopic) + 1; // including null terminator
+}
+
+bool HAMqttContext::generateConfigTopic(
+    char* output,
+    const char* componentName,
+    const char* objectId,
+    const HADevice* device
+) const
+{
+    device = resolveDevice(device);
+    if (
+        !output ||
+        !componentName ||
+        !objectId ||
+        !_discoveryPrefix ||
+        !device ||
+        !device->getUniqueId()
+    ) {
+        return false;
+    }
+
+    output = appendSegment(output, _discoveryPrefix, _discoveryPrefixLength);
+    output = appendSegment(output, componentName, strlen(componentName));
+    output = appendSegment(
+        output,
+        device->getUniqueId(),
+        device->getUniqueIdLength()
+    );
+    output = appendSegment(output, objectId, strlen(objectId));
+    strcpy_P(output, HAConfigTopic);
+
+    return true;
+}
+
+uint16_t HAMqttContext::calculateDataTopicLength(
+    const char* objectId,
+    const char* topicP,
+    const HADevice* device
+) const
+{
+    if (!topicP) {
+        return 0;
+    }
+
+    return calculateDataTopicLength(objectId, topicP, strlen_P(topicP), device);
+}
+
+uint16_t HAMqttContext::calculateDataTopicLength(
+    const char* objectId,
+    const char* topicP,
+    const uint16_t topicLength,
+    const HADevice* device
+) const
+{
+    device = resolveDevice(device);
+    if (
+        !topicP ||
+        !_dataPrefix ||
+        !device ||
+        !device->getUniqueId()
+    ) {
+        return 0;
+    }
+
+    uint16_t size =
+        _dataPrefixLength + 1 + // prefix with slash
+        device->getUniqueIdLength() + 1 + // device ID with slash
+        topicLength;
+
+    if (objectId) {
+        size += strlen(objectId) + 1; // object ID with slash;
+    }
+
+    return size + 1; // including null terminator
+}
+
+bool HAMqttContext::generateDataTopic(
+    char* output,
+    const char* objectId,
+    const char* topicP,
+    const HADevice* device
+) const
+{
+    device = resolveDevice(device);
+    if (
+        !output ||
+        !topicP ||
+        !_dataPrefix ||
+        !device ||
+        !device->getUniqueId()
+    ) {
+        return false;
+    }
+
+    output = appendSegment(output, _dataPrefix, _dataPrefixLength);
+    output = appendSegment(
+        output,
+        device->getUniqueId(),
+        device->getUniqueIdLength()
+    );
+
+    if (objectId) {
+        output = appendSegment(output, objectId, strlen(objectId));
+    }
+
+    strcpy_P(output, topicP);
+    return true;
+}
+
+bool HAMqttContext::compareDataTopics(
+    const char* topic,
+    const char* objectId,
+    const char* topicP,
+    const HADevice* device
+) const
+{
+    if (!topic) {
+        return false;
+    }
+
+    const uint16_t topicLength = calculateDataTopicLength(objectId, topicP, device);
+    if (topicLength == 0) {
+        return false;
+    }
+
+    char expectedTopic[topicLength];
+    if (!generateDataTopic(expectedTopic, objectId, topicP, device)) {
+        return false;
+    }
+
+    return strcmp(topic, expectedTopic) == 0;
+}
@@ -0,0 +1,111 @@
+#ifndef AHA_HAMQTTCONTEXT_H
+#define AHA_HAMQTTCONTEXT_H
+
+#include <stdint.h>
+
+class HAMqtt;
+class HADevice;
+
+/**
+ * This class holds the state shared by all device types bound to a single HAMqtt instance:
+ * prefixes (with precomputed lengths) and the device passed to the HAMqtt.
+ * Device types and serializers bind to the context at construction,
+ * so the topics can be generated without looking up the HAMqtt singleton
+ * and multiple HAMqtt instances can coexist.
+ */
+class HAMqttContext
+{
+public:
+    HAMqttContext(
+        HAMqtt* mqtt,
+        const HADevice* device,
+        const char* discoveryPrefix,
+        const char* dataPrefix
+    );
+
+    /**
+     * Returns the HAMqtt instance that owns the context.
+     */
+    inline HAMqtt* mqtt() const
+        { return _mqtt; }
+
+    /**
+     * Returns the device passed to the HAMqtt.
+     */
+    inline const HADevice* device() const
+        { return _device; }
+
+    void setDiscoveryPrefix(const char* prefix);
+
+    inline const char* getDiscoveryPrefix() const
+        { return _discoveryPrefix; }
+
+    inline uint16_t getDiscoveryPrefixLength() const
+        { return _discoveryPrefixLength; }
+
+    void setDataPrefix(const char* prefix);
+
+    inline const char* getDataPrefix() const
+        { return _dataPrefix; }
+
+    inline uint16_t getDataPrefixLength() const
+        { return _dataPrefixLength; }
+
+    /**
+     * The methods below generate topics of the given device.
+     * If the device is nullptr then the device passed to the HAMqtt is used.
+     * They work in the same way as the static methods of the HASerializer.
+     */
+    uint16_t calculateConfigTopicLength(
+        const char* component,
+        const char* objectId,
+        const HADevice* device = nullptr
+    ) const;
+
+    bool generateConfigTopic(
+        char* output,
+        const char* component,
+        const char* objectId,
+        const HADevice* device = nullptr
+    ) const;
+
+    uint16_t calculateDataTopicLength(
+        const char* objectId,
+        const char* topicP,
+        const HADevice* device = nullptr
+    ) const;
+
+    uint16_t calculateDataTopicLength(
+        const char* objectId,
+        const char* topicP,
+        const uint16_t topicLength,
+        const HADevice* device = nullptr
+    ) const;
+
+    bool generateDataTopic(
+        char* output,
+        const char* objectId,
+        const char* topicP,
+        const HADevice* device = nullptr
+    ) const;
+
+    bool compareDataTopics(
+        const char* topic,
+        const char* objectId,
+        const char* topicP,
+        const HADevice* device = nullptr
+    ) const;
+
+private:
+    HAMqtt* _mqtt;
+    const HADevice* _device;
+    const char* _discoveryPrefix;
+    uint16_t _discoveryPrefixLength;
+    const char* _dataPrefix;
+    uint16_t _dataPrefixLength;
+
+    inline const HADevice* resolveDevice(const HADevice* device) const
+        { return device ? device : _device; }
+};
+
+#endif
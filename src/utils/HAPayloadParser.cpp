@@ -0,0 +1,112 @@
+#include <Arduino.h>
+
+#include "HAPayloadParser.h"
+#include "HADictionary.h"
+
+bool HAPayloadParser::parseInteger(
+    const uint8_t* payload,
+    const uint16_t length,
+    int32_t& value,
+    const int32_t min,
+    const int32_t max
+)
+{
+    if (!payload || length == 0) {
+        return false;
+    }
+
+    const bool negative = (payload[0] == '-');
+    uint16_t i = negative ? 1 : 0;
+    if (i == length) {
+        return false;
+    }
+
+    // the magnitude of INT32_MIN doesn't fit int32_t
+    const uint32_t limit = negative ? (uint32_t)INT32_MAX + 1 : (uint32_t)INT32_MAX;
+    uint32_t magnitude = 0;
+
+    for (; i < length; i++) {
+        if (payload[i] < '0' || payload[i] > '9') {
+            return false;
+        }
+
+        const uint8_t digit = payload[i] - '0';
+        if (magnitude > (limit - digit) / 10) {
+            return false;
+        }
+
+        magnitude = magnitude * 10 + digit;
+    }
+
+    const int32_t result = negative
+        ? (int32_t)(0 - magnitude)
+        : (int32_t)magnitude;
+    if (result < min || result > max) {
+        return false;
+    }
+
+    value = result;
+    return true;
+}
+
+bool HAPayloadParser::parseBool(
+    const uint8_t* payload,
+    const uint16_t length,
+    bool& value
+)
+{
+    if (equals(payload, length, HAStateOn, true)) {
+        value = true;
+        return true;
+    }
+
+    if (equals(payload, length, HAStateOff, true)) {
+        value = false;
+        return true;
+    }
+
+    return false;
+}
+
+uint8_t HAPayloadParser::parseEnum(
+    const uint8_t* payload,
+    const uint16_t length,
+    const char* const* stringsP,
+    const uint8_t stringsNb
+)
+{
+    for (uint8_t i = 0; i < stringsNb && i != NoMatch; i++) {
+        if (equals(payload, length, stringsP[i])) {
+            return i;
+        }
+    }
+
+    return NoMatch;
+}
+
+bool HAPayloadParser::equals(
+    const uint8_t* payload,
+    const uint16_t length,
+    const char* stringP,
+    const bool ignoreCase
+)
+{
+    if (!payload || !stringP) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < length; i++) {
+        const char c = pgm_read_byte(stringP + i);
+        if (c == 0) {
+            return false; // the payload is longer
+        }
+
+        if (ignoreCase
+            ? tolower(payload[i]) != tolower(c)
+            : payload[i] != (uint8_t)c) {
+            return false;
+        }
+    }
+
+    return (pgm_read_byte(stringP + length) == 0);
+}
@@ -0,0 +1,80 @@
+#ifndef AHA_HAPAYLOADPARSER_H
+#define AHA_HAPAYLOADPARSER_H
+
+#include <stdint.h>
+
+/**
+ * Parsers of the MQTT payloads received from Home Assistant.
+ * The payload is not null-terminated and its length is controlled by the sender,
+ * so the parsers never copy it and they reject anything that isn't an exact match.
+ */
+class HAPayloadParser
+{
+public:
+    /**
+     * Returned by HAPayloadParser::parseEnum if the payload doesn't match any of the strings.
+     */
+    static const uint8_t NoMatch = 0xFF;
+
+    /**
+     * Parses the decimal integer with an optional minus sign, for example "-45".
+     *
+     * @param payload Payload of the message.
+     * @param length Length of the payload.
+     * @param value Parsed value (it's not modified if the payload is invalid).
+     * @param min Minimum accepted value.
+     * @param max Maximum accepted value.
+     * @returns Returns false if the payload is not a number or it's out of the range.
+     */
+    static bool parseInteger(
+        const uint8_t* payload,
+        const uint16_t length,
+        int32_t& value,
+        const int32_t min = INT32_MIN,
+        const int32_t max = INT32_MAX
+    );
+
+    /**
+     * Parses the "on" or "off" payload. The case of the letters is ignored,
+     * because Home Assistant sends commands in the upper case.
+     *
+     * @param payload Payload of the message.
+     * @param length Length of the payload.
+     * @param value Parsed value (it's not modified if the payload is invalid).
+     * @returns Returns false if the payload is neither "on" nor "off".
+     */
+    static bool parseBool(const uint8_t* payload, const uint16_t length, bool& value);
+
+    /**
+     * Finds the string that's equal to the payload.
+     *
+     * @param payload Payload of the message.
+     * @param length Length of the payload.
+     * @param stringsP Array of pointers to the strings stored in the flash memory.
+     * @param stringsNb Number of the strings in the array.
+     * @returns Returns index of the matched string or HAPayloadParser::NoMatch.
+     */
+    static uint8_t parseEnum(
+        const uint8_t* payload,
+        const uint16_t length,
+        const char* const* stringsP,
+        const uint8_t stringsNb
+    );
+
+    /**
+     * Returns true if the payload is equal to the string stored in the flash memory.
+     *
+     * @param payload Payload of the message.
+     * @param length Length of the payload.
+     * @param stringP String stored in the flash memory.
+     * @param ignoreCase Compares letters regardless of their case.
+     */
+    static bool equals(
+        const uint8_t* payload,
+        const uint16_t length,
+        const char* stringP,
+        const bool ignoreCase = false
+    );
+};
+
+#endif
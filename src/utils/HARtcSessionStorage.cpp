@@ -0,0 +1,72 @@
+#include "HARtcSessionStorage.h"
+#if defined(ESP8266) || defined(ESP32)
+
+#include <Arduino.h>
+
+#if defined(ESP8266)
+
+// the RTC user memory is accessed in 4-byte blocks
+bool HARtcSessionStorage::read(uint8_t* data, const uint16_t length)
+{
+    if (length > HARTC_SESSION_STORAGE_SIZE) {
+        return false;
+    }
+
+    for (uint16_t offset = 0; offset < length; offset += 4) {
+        uint32_t block;
+        if (!ESP.rtcUserMemoryRead(offset / 4, &block, sizeof(block))) {
+            return false;
+        }
+
+        const uint16_t size = length - offset < 4 ? length - offset : 4;
+        memcpy(&data[offset], &block, size);
+    }
+
+    return true;
+}
+
+bool HARtcSessionStorage::write(const uint8_t* data, const uint16_t length)
+{
+    if (length > HARTC_SESSION_STORAGE_SIZE) {
+        return false;
+    }
+
+    for (uint16_t offset = 0; offset < length; offset += 4) {
+        uint32_t block = 0;
+        const uint16_t size = length - offset < 4 ? length - offset : 4;
+        memcpy(&block, &data[offset], size);
+
+        if (!ESP.rtcUserMemoryWrite(offset / 4, &block, sizeof(block))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#else
+
+RTC_DATA_ATTR static uint8_t RtcSession[HARTC_SESSION_STORAGE_SIZE];
+
+bool HARtcSessionStorage::read(uint8_t* data, const uint16_t length)
+{
+    if (length > HARTC_SESSION_STORAGE_SIZE) {
+        return false;
+    }
+
+    memcpy(data, RtcSession, length);
+    return true;
+}
+
+bool HARtcSessionStorage::write(const uint8_t* data, const uint16_t length)
+{
+    if (length > HARTC_SESSION_STORAGE_SIZE) {
+        return false;
+    }
+
+    memcpy(RtcSession, data, length);
+    return true;
+}
+
+#endif
+#endif
@@ -0,0 +1,29 @@
+#ifndef AHA_HARTCSESSIONSTORAGE_H
+#define AHA_HARTCSESSIONSTORAGE_H
+
+#if defined(ESP8266) || defined(ESP32)
+
+#include "HASessionStorage.h"
+
+#ifndef HARTC_SESSION_STORAGE_SIZE
+#define HARTC_SESSION_STORAGE_SIZE 256 // bytes
+#endif
+
+/**
+ * Session storage in the RTC memory that's retained during the deep sleep.
+ * On ESP8266 the session occupies the beginning of the RTC user memory (512 bytes in total),
+ * on ESP32 it's a static buffer placed in the RTC slow memory.
+ * The memory is lost on power loss, so the first wake up after that publishes everything.
+ */
+class HARtcSessionStorage : public HASessionStorage
+{
+public:
+    virtual uint16_t getSize() const override
+        { return HARTC_SESSION_STORAGE_SIZE; }
+
+    virtual bool read(uint8_t* data, const uint16_t length) override;
+    virtual bool write(const uint8_t* data, const uint16_t length) override;
+};
+
+#endif
+#endif
@@ -13,143 +13,105 @@
 #include "../device-types/HABaseDeviceType.h"
 
 uint16_t HASerializer::calculateConfigTopicLength(
+    const HAMqttContext* context,
     const char* componentName,
-    const char* objectId
+    const char* objectId,
+    const HADevice* device
 )
 {
-    const HAMqtt* mqtt = HAMqtt::instance();
-    if (
-        !componentName ||
-        !objectId ||
-        !mqtt ||
-        !mqtt->getDiscoveryPrefix() ||
-        !mqtt->getDevice()
-    ) {
+    if (!context) {
         return 0;
     }
 
-    return
-        strlen(mqtt->getDiscoveryPrefix()) + 1 + // prefix with slash
-        strlen(componentName) + 1 + // component name with slash
-        strlen(mqtt->getDevice()->getUniqueId()) + 1 + // device ID with slash
-        strlen(objectId) + 1 + // object ID with slash
-        strlen_P(HAConfigTopic) + 1; // including null terminator
+    return context->calculateConfigTopicLength(
+        componentName,
+        objectId,
+        device
+    );
 }
 
 bool HASerializer::generateConfigTopic(
+    const HAMqttContext* context,
     char* output,
     const char* componentName,
-    const char* objectId
+    const char* objectId,
+    const HADevice* device
 )
 {
-    const HAMqtt* mqtt = HAMqtt::instance();
-    if (
-        !output ||
-        !componentName ||
-        !objectId ||
-        !mqtt ||
-        !mqtt->getDiscoveryPrefix() ||
-        !mqtt->getDevice()
-    ) {
+    if (!context) {
         return false;
     }
 
-    strcpy(output, mqtt->getDiscoveryPrefix());
-    strcat_P(output, HASerializerSlash);
-
-    strcat(output, componentName);
-    strcat_P(output, HASerializerSlash);
-
-    strcat(output, mqtt->getDevice()->getUniqueId());
-    strcat_P(output, HASerializerSlash);
-
-    strcat(output, objectId);
-    strcat_P(output, HASerializerSlash);
-
-    strcat_P(output, HAConfigTopic);
-    return true;
+    return context->generateConfigTopic(
+        output,
+        componentName,
+        objectId,
+        device
+    );
 }
 
 uint16_t HASerializer::calculateDataTopicLength(
+    const HAMqttContext* context,
     const char* objectId,
-    const char* topicP
+    const char* topicP,
+    const HADevice* device
 )
 {
-    const HAMqtt* mqtt = HAMqtt::instance();
-    if (
-        !topicP ||
-        !mqtt ||
-        !mqtt->getDataPrefix() ||
-        !mqtt->getDevice()
-    ) {
+    if (!context) {
         return 0;
     }
 
-    uint16_t size =
-        strlen(mqtt->getDataPrefix()) + 1 + // prefix with slash
-        strlen(mqtt->getDevice()->getUniqueId()) + 1 + // device ID with slash
-        strlen_P(topicP);
+    return context->calculateDataTopicLength(objectId, topicP, device);
+}
 
-    if (objectId) {
-        size += strlen(objectId) + 1; // object ID with slash;
+uint16_t HASerializer::calculateDataTopicLength(
+    const HAMqttContext* context,
+    const char* objectId,
+    const char* topicP,
+    const uint16_t topicLength,
+    const HADevice* device
+)
+{
+    if (!context) {
+        return 0;
     }
 
-    return size + 1; // including null terminator
+    return context->calculateDataTopicLength(
+        objectId,
+        topicP,
+        topicLength,
+        device
+    );
 }
 
 bool HASerializer::generateDataTopic(
+    const HAMqttContext* context,
     char* output,
     const char* objectId,
-    const char* topicP
+    const char* topicP,
+    const HADevice* device
 )
 {
-    const HAMqtt* mqtt = HAMqtt::instance();
-    if (
-        !output ||
-        !topicP ||
-        !mqtt ||
-        !mqtt->getDataPrefix() ||
-        !mqtt->getDevice()
-    ) {
+    if (!context) {
         return false;
     }
 
-    strcpy(output, mqtt->getDataPrefix());
-    strcat_P(output, HASerializerSlash);
-
-    strcat(output, mqtt->getDevice()->getUniqueId());
-    strcat_P(output, HASerializerSlash);
-
-    if (objectId) {
-        strcat(output, objectId);
-        strcat_P(output, HASerializerSlash);
-    }
-
-    strcat_P(output, topicP);
-    return true;
+    return context->generateDataTopic(output, objectId, topicP, device);
 }
 
 bool HASerializer::compareDataTopics(
+    const HAMqttContext* context,
     const char* topic,
     const char* objectId,
-    const char* topicP
+    const char* topicP,
+    const HADevice* device
 )
 {
-    if (!topic) {
+    if (!context) {
         return false;
     }
 
-    const uint16_t topicLength = calculateDataTopicLength(objectId, topicP);
-    if (topicLength == 0) {
-        return false;
-    }
-
-    char expectedTopic[topicLength];
-    if (!generateDataTopic(expectedTopic, objectId, topicP)) {
-        return false;
-    }
-
-    return strcmp(topic, expectedTopic) == 0;
+    return context->compareDataTopics(topic, objectId, topicP, device);
 }
 
 HASerializer::HASerializer(
@@ -159,7 +121,8 @@ HASerializer::HASerializer(
     _deviceType(deviceType),
     _entriesNb(0),
     _maxEntriesNb(maxEntriesNb),
-    _entries(new SerializerEntry[maxEntriesNb])
+    _entries(new SerializerEntry[maxEntriesNb]),
+    _baseTopicForced(false)
 {
 
 }
@@ -171,6 +134,7 @@ HASerializer::~HASerializer()
 
 void HASerializer::set(
     const char* propertyP,
+    const uint8_t propertyLength,
     const void* value,
     PropertyValueType valueType
 )
@@ -187,6 +151,7 @@ void HASerializer::set(
     entry->type = PropertyEntryType;
     entry->subtype = static_cast<uint8_t>(valueType);
     entry->property = propertyP;
+    entry->propertyLength = propertyLength;
     entry->value = value;
 }
 
@@ -203,8 +168,8 @@ void HASerializer::set(const FlagType flag)
         entry->property = nullptr;
         entry->value = nullptr;
     } else if (flag == WithAvailability) {
-        HAMqtt* mqtt = HAMqtt::instance();
-        const bool isSharedAvailability = mqtt->getDevice()->isSharedAvailabilityEnabled();
+        const HADevice* device = getDevice();
+        const bool isSharedAvailability = device->isSharedAvailabilityEnabled();
         const bool isAvailabilityConfigured = _deviceType->isAvailabilityConfigured();
 
         if (!isSharedAvailability && !isAvailabilityConfigured) {
@@ -218,13 +183,14 @@ void HASerializer::set(const FlagType flag)
 
         entry->type = TopicEntryType;
         entry->property = HAAvailabilityTopic;
+        entry->propertyLength = HADictionaryLength(HAAvailabilityTopic);
         entry->value = isSharedAvailability
-            ? mqtt->getDevice()->getAvailabilityTopic()
+            ? device->getAvailabilityTopic()
             : nullptr;
     }
 }
 
-void HASerializer::topic(const char* topicP)
+void HASerializer::topic(const char* topicP, const uint8_t topicLength)
 {
     if (!_deviceType || !topicP) {
         return;
@@ -237,18 +203,61 @@ void HASerializer::topic(const char* topicP)
 
     entry->type = TopicEntryType;
     entry->property = topicP;
+    entry->propertyLength = topicLength;
 }
 
 HASerializer::SerializerEntry* HASerializer::addEntry()
 {
-    return &_entries[_entriesNb++]; // intentional lack of protection against overflow
+    if (_entriesNb >= _maxEntriesNb) {
+        return nullptr; // the entry is skipped, so the device type needs a bigger serializer
+    }
+
+    return &_entries[_entriesNb++];
+}
+
+HAMqtt* HASerializer::mqtt() const
+{
+    return _deviceType ? _deviceType->mqtt() : nullptr;
+}
+
+const HADevice* HASerializer::getDevice() const
+{
+    return _deviceType ? _deviceType->getDevice() : nullptr;
+}
+
+bool HASerializer::remove(const char* propertyP)
+{
+    for (uint8_t i = 0; i < _entriesNb; i++) {
+        if (
+            _entries[i].type != PropertyEntryType ||
+            _entries[i].property != propertyP
+        ) {
+            continue;
+        }
+
+        for (uint8_t j = i + 1; j < _entriesNb; j++) {
+            _entries[j - 1] = _entries[j];
+        }
+
+        _entriesNb--;
+        _entries[_entriesNb] = SerializerEntry();
+        return true;
+    }
+
+    return false;
 }
 
 uint16_t HASerializer::calculateSize() const
 {
     uint16_t size =
-        strlen_P(HASerializerJsonDataPrefix) +
-        strlen_P(HASerializerJsonDataSuffix);
+        HADictionaryLength(HASerializerJsonDataPrefix) +
+        HADictionaryLength(HASerializerJsonDataSuffix);
+
+    if (isBaseTopicUsed()) {
+        size +=
+            calculateBaseTopicSize() +
+            HADictionaryLength(HASerializerJsonPropertiesSeparator);
+    }
 
     for (uint8_t i = 0; i < _entriesNb; i++) {
         const uint16_t entrySize = calculateEntrySize(&_entries[i]);
@@ -260,7 +269,7 @@ uint16_t HASerializer::calculateSize() const
 
         // items separator
         if (i > 0) {
-            size += strlen_P(HASerializerJsonPropertiesSeparator);
+            size += HADictionaryLength(HASerializerJsonPropertiesSeparator);
         }
     }
 
@@ -269,19 +278,31 @@ uint16_t HASerializer::calculateSize() const
 
 bool HASerializer::flush() const
 {
-    HAMqtt* mqtt = HAMqtt::instance();
-    if (!mqtt || (_deviceType && !mqtt->getDevice())) {
+    return flush(mqtt());
+}
+
+bool HASerializer::flush(HAMqtt* mqtt) const
+{
+    if (!mqtt || (_deviceType && !getDevice())) {
         return false;
     }
 
     mqtt->writePayload_P(HASerializerJsonDataPrefix);
 
+    if (isBaseTopicUsed()) {
+        if (!flushBaseTopic(mqtt)) {
+            return false;
+        }
+
+        mqtt->writePayload_P(HASerializerJsonPropertiesSeparator);
+    }
+
     for (uint8_t i = 0; i < _entriesNb; i++) {
         if (i > 0) {
             mqtt->writePayload_P(HASerializerJsonPropertiesSeparator);
         }
 
-        if (!flushEntry(&_entries[i])) {
+        if (!flushEntry(mqtt, &_entries[i])) {
             return false;
         }
     }
@@ -290,15 +311,82 @@ bool HASerializer::flush() const
     return true;
 }
 
+bool HASerializer::isBaseTopicUsed() const
+{
+    const HAMqtt* mqtt = this->mqtt();
+    if (
+        !mqtt ||
+        (!_baseTopicForced && !mqtt->isBaseTopicEnabled()) ||
+        !_deviceType ||
+        !_deviceType->uniqueId()
+    ) {
+        return false;
+    }
+
+    uint8_t dataTopicsNb = 0;
+    for (uint8_t i = 0; i < _entriesNb; i++) {
+        if (_entries[i].type == TopicEntryType && !_entries[i].value) {
+            dataTopicsNb++;
+        }
+    }
+
+    // the base topic property is longer than a single full topic
+    return dataTopicsNb >= 2;
+}
+
+uint16_t HASerializer::calculateBaseTopicSize() const
+{
+    // "<data prefix>/<device ID>/<object ID>/" with null terminator
+    const uint16_t topicLength = mqtt()->getContext().calculateDataTopicLength(
+        _deviceType->uniqueId(),
+        HABaseTopicProperty,
+        static_cast<uint16_t>(0),
+        _deviceType->getDevice()
+    );
+    if (topicLength == 0) {
+        return 0;
+    }
+
+    return
+        HADictionaryLength(HASerializerJsonPropertyPrefix) +
+        HADictionaryLength(HABaseTopicProperty) +
+        HADictionaryLength(HASerializerJsonPropertySuffix) +
+        2 * HADictionaryLength(HASerializerJsonEscapeChar) +
+        topicLength - 2; // exclude trailing slash and null terminator
+}
+
+bool HASerializer::flushBaseTopic(HAMqtt* mqtt) const
+{
+    const char* objectId = _deviceType->uniqueId();
+
+    mqtt->writePayload_P(HASerializerJsonPropertyPrefix);
+    mqtt->writePayload_P(HABaseTopicProperty);
+    mqtt->writePayload_P(HASerializerJsonPropertySuffix);
+
+    mqtt->writePayload_P(HASerializerJsonEscapeChar);
+    mqtt->writePayload(
+        mqtt->getDataPrefix(),
+        mqtt->getContext().getDataPrefixLength()
+    );
+    mqtt->writePayload_P(HASerializerSlash);
+    const HADevice* device = _deviceType->getDevice();
+    mqtt->writePayload(device->getUniqueId(), device->getUniqueIdLength());
+    mqtt->writePayload_P(HASerializerSlash);
+    mqtt->writePayload(objectId, strlen(objectId));
+    mqtt->writePayload_P(HASerializerJsonEscapeChar);
+
+    return true;
+}
+
 uint16_t HASerializer::calculateEntrySize(const SerializerEntry* entry) const
 {
     switch (entry->type) {
     case PropertyEntryType:
         return
             // property name
-            strlen_P(HASerializerJsonPropertyPrefix) +
-            strlen_P(entry->property) +
-            strlen_P(HASerializerJsonPropertySuffix) +
+            HADictionaryLength(HASerializerJsonPropertyPrefix) +
+            entry->propertyLength +
+            HADictionaryLength(HASerializerJsonPropertySuffix) +
             // property value
             calculatePropertyValueSize(entry);
 
@@ -323,24 +411,31 @@ uint16_t HASerializer::calculateTopicEntrySize(
 
     // property name
     size +=
-        strlen_P(HASerializerJsonPropertyPrefix) +
-        strlen_P(entry->property) +
-        strlen_P(HASerializerJsonPropertySuffix);
+        HADictionaryLength(HASerializerJsonPropertyPrefix) +
+        entry->propertyLength +
+        HADictionaryLength(HASerializerJsonPropertySuffix);
 
     // topic escape
-    size += 2 * strlen_P(HASerializerJsonEscapeChar);
+    size += 2 * HADictionaryLength(HASerializerJsonEscapeChar);
 
     // topic
     if (entry->value) {
         size += strlen(static_cast<const char*>(entry->value));
+    } else if (isBaseTopicUsed()) {
+        size +=
+            HADictionaryLength(HABaseTopicProperty) +
+            HADictionaryLength(HASerializerSlash) +
+            entry->propertyLength;
     } else {
-        if (!_deviceType) {
+        if (!_deviceType || !mqtt()) {
             return 0;
         }
 
-        size += calculateDataTopicLength(
+        size += mqtt()->getContext().calculateDataTopicLength(
             _deviceType->uniqueId(),
-            entry->property
+            entry->property,
+            entry->propertyLength,
+            _deviceType->getDevice()
         ) - 1; // exclude null terminator
     }
 
@@ -349,8 +444,7 @@ uint16_t HASerializer::calculateTopicEntrySize(
 
 uint16_t HASerializer::calculateFlagSize(const FlagInternalType flag) const
 {
-    const HAMqtt* mqtt = HAMqtt::instance();
-    const HADevice* device = mqtt->getDevice();
+    const HADevice* device = getDevice();
 
     if (flag == InternalWithDevice && device->getSerializer()) {
         const uint16_t deviceLength = device->getSerializer()->calculateSize();
@@ -359,9 +453,9 @@ uint16_t HASerializer::calculateFlagSize(const FlagInternalType flag) const
         }
 
         return
-            strlen_P(HASerializerJsonPropertyPrefix) +
-            strlen_P(HADeviceProperty) +
-            strlen_P(HASerializerJsonPropertySuffix) +
+            HADictionaryLength(HASerializerJsonPropertyPrefix) +
+            HADictionaryLength(HADeviceProperty) +
+            HADictionaryLength(HASerializerJsonPropertySuffix) +
             deviceLength;
     }
 
@@ -376,14 +470,14 @@ uint16_t HASerializer::calculatePropertyValueSize(
     case ConstCharPropertyValue: {
         const char* value = static_cast<const char*>(entry->value);
         return 
-            2 * strlen_P(HASerializerJsonEscapeChar) +
+            2 * HADictionaryLength(HASerializerJsonEscapeChar) +
             strlen(value);
     }
 
     case ProgmemPropertyValue: {
         const char* value = static_cast<const char*>(entry->value);
         return 
-            2 * strlen_P(HASerializerJsonEscapeChar) +
+            2 * HADictionaryLength(HASerializerJsonEscapeChar) +
             strlen_P(value);
     }
 
@@ -409,34 +503,36 @@ uint16_t HASerializer::calculatePropertyValueSize(
     }
 }
 
-bool HASerializer::flushEntry(const SerializerEntry* entry) const
+bool HASerializer::flushEntry(
+    HAMqtt* mqtt,
+    const SerializerEntry* entry
+) const
 {
-    HAMqtt* mqtt = HAMqtt::instance();
-
     switch (entry->type) {
     case PropertyEntryType: {
         mqtt->writePayload_P(HASerializerJsonPropertyPrefix);
         mqtt->writePayload_P(entry->property);
         mqtt->writePayload_P(HASerializerJsonPropertySuffix);
 
-        return flushEntryValue(entry);
+        return flushEntryValue(mqtt, entry);
     }
 
     case TopicEntryType:
-        return flushTopic(entry);
+        return flushTopic(mqtt, entry);
 
     case FlagEntryType:
-        return flushFlag(entry);
+        return flushFlag(mqtt, entry);
 
     default:
         return true;
     }
 }
 
-bool HASerializer::flushEntryValue(const SerializerEntry* entry) const
+bool HASerializer::flushEntryValue(
+    HAMqtt* mqtt,
+    const SerializerEntry* entry
+) const
 {
-    HAMqtt* mqtt = HAMqtt::instance();
-
     switch (entry->subtype) {
     case ConstCharPropertyValue:
     case ProgmemPropertyValue: {
@@ -475,7 +571,7 @@ bool HASerializer::flushEntryValue(const SerializerEntry* entry) const
             entry->value
         );
         const uint16_t size = array->calculateSize();
-        char tmp[size];
+        char tmp[size + 1]; // with null terminator
         tmp[0] = 0;
         array->serialize(tmp);
         mqtt->writePayload(tmp, size);
@@ -488,10 +584,11 @@ bool HASerializer::flushEntryValue(const SerializerEntry* entry) const
     }
 }
 
-bool HASerializer::flushTopic(const SerializerEntry* entry) const
+bool HASerializer::flushTopic(
+    HAMqtt* mqtt,
+    const SerializerEntry* entry
+) const
 {
-    HAMqtt* mqtt = HAMqtt::instance();
-
     // property name
     mqtt->writePayload_P(HASerializerJsonPropertyPrefix);
     mqtt->writePayload_P(entry->property);
@@ -503,20 +600,28 @@ bool HASerializer::flushTopic(const SerializerEntry* entry) const
     if (entry->value) {
         const char* topic = static_cast<const char*>(entry->value);
         mqtt->writePayload(topic, strlen(topic));
+    } else if (isBaseTopicUsed()) {
+        mqtt->writePayload_P(HABaseTopicProperty);
+        mqtt->writePayload_P(HASerializerSlash);
+        mqtt->writePayload_P(entry->property);
     } else {
-        const uint16_t length = calculateDataTopicLength(
+        const HAMqttContext& context = mqtt->getContext();
+        const uint16_t length = context.calculateDataTopicLength(
             _deviceType->uniqueId(),
-            entry->property
+            entry->property,
+            entry->propertyLength,
+            _deviceType->getDevice()
         );
         if (length == 0) {
             return false;
         }
 
         char topic[length];
-        generateDataTopic(
+        context.generateDataTopic(
             topic,
             _deviceType->uniqueId(),
-            entry->property
+            entry->property,
+            _deviceType->getDevice()
         );
 
         mqtt->writePayload(topic, length - 1);
@@ -526,10 +631,12 @@ bool HASerializer::flushTopic(const SerializerEntry* entry) const
     return true;
 }
 
-bool HASerializer::flushFlag(const SerializerEntry* entry) const
+bool HASerializer::flushFlag(
+    HAMqtt* mqtt,
+    const SerializerEntry* entry
+) const
 {
-    HAMqtt* mqtt = HAMqtt::instance();
-    const HADevice* device = mqtt->getDevice();
+    const HADevice* device = getDevice();
     const FlagInternalType flag = static_cast<FlagInternalType>(
         entry->subtype
     );
@@ -539,7 +646,7 @@ bool HASerializer::flushFlag(const SerializerEntry* entry) const
         mqtt->writePayload_P(HADeviceProperty);
         mqtt->writePayload_P(HASerializerJsonPropertySuffix);
 
-        return device->getSerializer()->flush();
+        return device->getSerializer()->flush(mqtt);
     }
 
     return false;
@@ -8,6 +8,8 @@
 #include "HASerializerArray.h"
 
 class HAMqtt;
+class HAMqttContext;
+class HADevice;
 class HABaseDeviceType;
 
 class HASerializer
@@ -37,42 +39,70 @@ public:
         EntryType type;
         uint8_t subtype; // FlagInternalType, PropertyValueType or TopicType
         const char* property;
+        uint8_t propertyLength;
         const void* value;
 
         SerializerEntry():
             type(UnknownEntryType),
             subtype(0),
             property(nullptr),
+            propertyLength(0),
             value(nullptr)
         { }
     };
 
+    /**
+     * The static methods below generate topics of the given device using the given context
+     * (see HAMqtt::getContext). They fail if the context is nullptr.
+     * If the device is nullptr then the device passed to the HAMqtt is used.
+     */
     static uint16_t calculateConfigTopicLength(
+        const HAMqttContext* context,
         const char* component,
-        const char* objectId
+        const char* objectId,
+        const HADevice* device = nullptr
     );
 
     static bool generateConfigTopic(
+        const HAMqttContext* context,
         char* output,
         const char* component,
-        const char* objectId
+        const char* objectId,
+        const HADevice* device = nullptr
+    );
+
+    static uint16_t calculateDataTopicLength(
+        const HAMqttContext* context,
+        const char* objectId,
+        const char* topicP,
+        const HADevice* device = nullptr
     );
 
+    /**
+     * Calculates length of the data topic using the known length of the topic's suffix.
+     */
     static uint16_t calculateDataTopicLength(
+        const HAMqttContext* context,
         const char* objectId,
-        const char* topicP
+        const char* topicP,
+        const uint16_t topicLength,
+        const HADevice* device = nullptr
     );
 
     static bool generateDataTopic(
+        const HAMqttContext* context,
         char* output,
         const char* objectId,
-        const char* topicP
+        const char* topicP,
+        const HADevice* device = nullptr
     );
 
     static bool compareDataTopics(
+        const HAMqttContext* context,
         const char* topic,
         const char* objectId,
-        const char* topicP
+        const char* topicP,
+        const HADevice* device = nullptr
     );
 
     HASerializer(HABaseDeviceType* deviceType, const uint8_t maxEntriesNb);
@@ -84,17 +114,64 @@ public:
     inline SerializerEntry* getEntries() const
         { return _entries; }
 
+    /**
+     * Adds property to the serializer.
+     * Only dictionary strings are accepted, so the length of the property is known at compile time.
+     */
+    template <size_t N>
+    inline void set(
+        const char (&propertyP)[N],
+        const void* value,
+        PropertyValueType valueType = ConstCharPropertyValue
+    ) { set(propertyP, N - 1, value, valueType); }
+
     void set(
         const char* propertyP,
+        const uint8_t propertyLength,
         const void* value,
         PropertyValueType valueType = ConstCharPropertyValue
     );
     void set(const FlagType flag);
-    void topic(const char* topicP);
+
+    /**
+     * Adds data topic to the serializer.
+     * Only dictionary strings are accepted, so the length of the topic is known at compile time.
+     */
+    template <size_t N>
+    inline void topic(const char (&topicP)[N])
+        { topic(topicP, N - 1); }
+
+    void topic(const char* topicP, const uint8_t topicLength);
+
+    /**
+     * Removes the property from the serializer.
+     * Returns true if the property was found.
+     *
+     * @param propertyP Dictionary string of the property.
+     */
+    bool remove(const char* propertyP);
 
     uint16_t calculateSize() const;
     bool flush() const;
 
+    /**
+     * Writes the serialized JSON using the given HAMqtt instance.
+     * It's used to write the device's representation as a part of the entity's config.
+     */
+    bool flush(HAMqtt* mqtt) const;
+
+    /**
+     * Forces the base topic ("~") abbreviation even if it's disabled in the HAMqtt.
+     * It's used when the config doesn't fit the max packet size of the transport.
+     */
+    inline void setBaseTopicForced(bool forced)
+        { _baseTopicForced = forced; }
+
+    /**
+     * Returns true if the data topics are abbreviated using the base topic ("~").
+     */
+    bool isBaseTopicUsed() const;
+
 private:
     enum FlagInternalType {
         InternalWithDevice = 1,
@@ -106,17 +183,22 @@ private:
     uint8_t _entriesNb;
     uint8_t _maxEntriesNb;
     SerializerEntry* _entries;
+    bool _baseTopicForced;
 
     SerializerEntry* addEntry();
+    HAMqtt* mqtt() const;
+    const HADevice* getDevice() const;
+    uint16_t calculateBaseTopicSize() const;
+    bool flushBaseTopic(HAMqtt* mqtt) const;
     uint16_t calculateEntrySize(const SerializerEntry* entry) const;
     uint16_t calculateTopicEntrySize(const SerializerEntry* entry) const;
     uint16_t calculateFlagSize(const FlagInternalType flag) const;
     uint16_t calculatePropertyValueSize(const SerializerEntry* entry) const;
     uint16_t calculateArraySize(const HASerializerArray* array) const;
-    bool flushEntry(const SerializerEntry* entry) const;
-    bool flushEntryValue(const SerializerEntry* entry) const;
-    bool flushTopic(const SerializerEntry* entry) const;
-    bool flushFlag(const SerializerEntry* entry) const;
+    bool flushEntry(HAMqtt* mqtt, const SerializerEntry* entry) const;
+    bool flushEntryValue(HAMqtt* mqtt, const SerializerEntry* entry) const;
+    bool flushTopic(HAMqtt* mqtt, const SerializerEntry* entry) const;
+    bool flushFlag(HAMqtt* mqtt, const SerializerEntry* entry) const;
 };
 
 #endif
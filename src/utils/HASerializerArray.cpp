@@ -30,18 +30,18 @@ bool HASerializerArray::add(const char* itemP)
 uint16_t HASerializerArray::calculateSize() const
 {
     uint16_t size =
-        strlen_P(HASerializerJsonArrayPrefix) +
-        strlen_P(HASerializerJsonArraySuffix);
+        HADictionaryLength(HASerializerJsonArrayPrefix) +
+        HADictionaryLength(HASerializerJsonArraySuffix);
 
     if (_itemsNb == 0) {
         return size;
     }
 
     // separators between elements
-    size += (_itemsNb - 1) * strlen_P(HASerializerJsonPropertiesSeparator);
+    size += (_itemsNb - 1) * HADictionaryLength(HASerializerJsonPropertiesSeparator);
 
     for (uint8_t i = 0; i < _itemsNb; i++) {
-        size += 2 * strlen_P(HASerializerJsonEscapeChar) + strlen_P(_items[i]);
+        size += 2 * HADictionaryLength(HASerializerJsonEscapeChar) + strlen_P(_items[i]);
     }
 
     return size;
@@ -0,0 +1,181 @@
+#include <Arduino.h>
+
+#include "HASessionState.h"
+#include "HASessionStorage.h"
+
+static const uint16_t SessionMagic = 0x4841; // "HA"
+static const uint32_t HashPrime = 16777619UL;
+
+static void writeNumber(uint8_t* dst, const uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; i++) {
+        dst[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+static uint32_t readNumber(const uint8_t* src)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        value |= static_cast<uint32_t>(src[i]) << (i * 8);
+    }
+
+    return value;
+}
+
+HASessionState::HASessionState(const uint8_t maxValuesNb) :
+    _maxValuesNb(maxValuesNb),
+    _valuesNb(0),
+    _fingerprint(0),
+    _values(new HASessionValue[maxValuesNb])
+{
+
+}
+
+HASessionState::~HASessionState()
+{
+    delete[] _values;
+}
+
+bool HASessionState::load(HASessionStorage& storage)
+{
+    clear();
+
+    uint16_t size = OverheadSize + _maxValuesNb * sizeof(HASessionValue);
+    if (size > storage.getSize()) {
+        size = storage.getSize();
+    }
+
+    if (size < OverheadSize) {
+        return false;
+    }
+
+    uint8_t* data = new uint8_t[size];
+    if (!storage.read(data, size)) {
+        delete[] data;
+        return false;
+    }
+
+    // layout: magic (2), values number (1), fingerprint (4), values (8 each), checksum (4)
+    const uint8_t valuesNb = data[2];
+    const uint16_t checksumOffset = 7 + valuesNb * sizeof(HASessionValue);
+    const bool valid = (
+        (data[0] | (data[1] << 8)) == SessionMagic &&
+        valuesNb <= _maxValuesNb &&
+        checksumOffset + 4 <= size &&
+        readNumber(&data[checksumOffset]) == hash(
+            HashSeed,
+            reinterpret_cast<const char*>(data),
+            checksumOffset
+        )
+    );
+
+    if (valid) {
+        _fingerprint = readNumber(&data[3]);
+        _valuesNb = valuesNb;
+
+        for (uint8_t i = 0; i < valuesNb; i++) {
+            const uint8_t* value = &data[7 + i * sizeof(HASessionValue)];
+            _values[i].topicHash = readNumber(value);
+            _values[i].valueHash = readNumber(&value[4]);
+        }
+    }
+
+    delete[] data;
+    return valid;
+}
+
+bool HASessionState::save(HASessionStorage& storage) const
+{
+    const uint16_t size = calculateSize();
+    if (size > storage.getSize()) {
+        return false;
+    }
+
+    uint8_t* data = new uint8_t[size];
+    data[0] = SessionMagic & 0xFF;
+    data[1] = SessionMagic >> 8;
+    data[2] = _valuesNb;
+    writeNumber(&data[3], _fingerprint);
+
+    for (uint8_t i = 0; i < _valuesNb; i++) {
+        uint8_t* value = &data[7 + i * sizeof(HASessionValue)];
+        writeNumber(value, _values[i].topicHash);
+        writeNumber(&value[4], _values[i].valueHash);
+    }
+
+    const uint16_t checksumOffset = size - 4;
+    writeNumber(
+        &data[checksumOffset],
+        hash(HashSeed, reinterpret_cast<const char*>(data), checksumOffset)
+    );
+
+    const bool result = storage.write(data, size);
+    delete[] data;
+
+    return result;
+}
+
+void HASessionState::clear()
+{
+    _valuesNb = 0;
+    _fingerprint = 0;
+}
+
+bool HASessionState::isUnchanged(const uint32_t topicHash, const uint32_t valueHash) const
+{
+    for (uint8_t i = 0; i < _valuesNb; i++) {
+        if (_values[i].topicHash == topicHash) {
+            return _values[i].valueHash == valueHash;
+        }
+    }
+
+    return false;
+}
+
+bool HASessionState::set(const uint32_t topicHash, const uint32_t valueHash)
+{
+    for (uint8_t i = 0; i < _valuesNb; i++) {
+        if (_values[i].topicHash == topicHash) {
+            _values[i].valueHash = valueHash;
+            return true;
+        }
+    }
+
+    if (_valuesNb >= _maxValuesNb) {
+        return false;
+    }
+
+    _values[_valuesNb].topicHash = topicHash;
+    _values[_valuesNb].valueHash = valueHash;
+    _valuesNb++;
+
+    return true;
+}
+
+uint32_t HASessionState::hash(
+    uint32_t hash,
+    const char* data,
+    const uint16_t length,
+    const bool isProgmem
+)
+{
+    for (uint16_t i = 0; i < length; i++) {
+        const uint8_t byte = isProgmem
+            ? pgm_read_byte(&data[i])
+            : static_cast<uint8_t>(data[i]);
+
+        hash ^= byte;
+        hash *= HashPrime;
+    }
+
+    return hash;
+}
+
+uint32_t HASessionState::hash(uint32_t hash, const uint32_t value)
+{
+    uint8_t data[4];
+    writeNumber(data, value);
+
+    return HASessionState::hash(hash, reinterpret_cast<const char*>(data), 4);
+}
@@ -0,0 +1,110 @@
+#ifndef AHA_HASESSIONSTATE_H
+#define AHA_HASESSIONSTATE_H
+
+#include <stdint.h>
+
+class HASessionStorage;
+
+/**
+ * Hashes of the value published on the topic.
+ */
+struct HASessionValue
+{
+    uint32_t topicHash;
+    uint32_t valueHash;
+};
+
+/**
+ * State of the MQTT session that's persisted between deep sleep cycles (see HAMqtt::enableFastResume).
+ * It consists of the discovery fingerprint and the hashes of the last published values.
+ * The values are stored as 32-bit FNV-1a hashes, so the size of the state doesn't depend on the payloads.
+ */
+class HASessionState
+{
+public:
+    static const uint32_t HashSeed = 2166136261UL;
+
+    /// Size of the header (magic, values number and fingerprint) and checksum.
+    static const uint8_t OverheadSize = 11;
+
+    /**
+     * @param maxValuesNb Maximum number of the values that can be persisted.
+     */
+    HASessionState(const uint8_t maxValuesNb);
+    ~HASessionState();
+
+    /**
+     * Restores the state from the storage.
+     *
+     * @returns Returns false if the storage doesn't contain a valid state.
+     *          In this case the state is cleared.
+     */
+    bool load(HASessionStorage& storage);
+
+    /**
+     * Writes the state to the storage.
+     *
+     * @returns Returns false if the state doesn't fit the storage or the write failed.
+     */
+    bool save(HASessionStorage& storage) const;
+
+    /**
+     * Removes all values and the fingerprint.
+     */
+    void clear();
+
+    /**
+     * Returns true if the given value was the last one published on the topic.
+     */
+    bool isUnchanged(const uint32_t topicHash, const uint32_t valueHash) const;
+
+    /**
+     * Stores the value published on the topic.
+     *
+     * @returns Returns false if the limit of values was reached.
+     */
+    bool set(const uint32_t topicHash, const uint32_t valueHash);
+
+    inline uint32_t getFingerprint() const
+        { return _fingerprint; }
+
+    inline void setFingerprint(const uint32_t fingerprint)
+        { _fingerprint = fingerprint; }
+
+    inline uint8_t getValuesNb() const
+        { return _valuesNb; }
+
+    /**
+     * Returns number of bytes needed to persist the current state.
+     */
+    inline uint16_t calculateSize() const
+        { return OverheadSize + _valuesNb * sizeof(HASessionValue); }
+
+    /**
+     * Extends the FNV-1a hash with the given data.
+     *
+     * @param hash Current hash (HASessionState::HashSeed for the new one).
+     * @param data Data to hash.
+     * @param length Length of the data.
+     * @param isProgmem Set to true if the data is stored in the flash memory.
+     */
+    static uint32_t hash(
+        uint32_t hash,
+        const char* data,
+        const uint16_t length,
+        const bool isProgmem = false
+    );
+
+    /**
+     * Extends the FNV-1a hash with the given number (little endian).
+     */
+    static uint32_t hash(uint32_t hash, const uint32_t value);
+
+private:
+    const uint8_t _maxValuesNb;
+    uint8_t _valuesNb;
+    uint32_t _fingerprint;
+    HASessionValue* _values;
+};
+
+#endif
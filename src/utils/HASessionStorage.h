@@ -0,0 +1,36 @@
+#ifndef AHA_HASESSIONSTORAGE_H
+#define AHA_HASESSIONSTORAGE_H
+
+#include <stdint.h>
+
+/**
+ * Memory that survives the deep sleep (e.g. RTC memory or flash).
+ * It's used by the fast resume to persist the session (see HAMqtt::enableFastResume).
+ * The whole session is always read and written at once, starting at the beginning of the memory.
+ */
+class HASessionStorage
+{
+public:
+    virtual ~HASessionStorage() { }
+
+    /**
+     * Returns capacity of the storage in bytes.
+     */
+    virtual uint16_t getSize() const = 0;
+
+    /**
+     * Reads the given number of bytes from the beginning of the storage.
+     *
+     * @returns Returns false if the data couldn't be read.
+     */
+    virtual bool read(uint8_t* data, const uint16_t length) = 0;
+
+    /**
+     * Writes the given number of bytes at the beginning of the storage.
+     *
+     * @returns Returns false if the data couldn't be written.
+     */
+    virtual bool write(const uint8_t* data, const uint16_t length) = 0;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include <Arduino.h>
+
+#include "HATopicAliases.h"
+
+HATopicAliases::HATopicAliases(const uint16_t maxAliasesNb) :
+    _maxAliasesNb(maxAliasesNb),
+    _aliasesNb(0),
+    _topics(new char*[maxAliasesNb])
+{
+
+}
+
+HATopicAliases::~HATopicAliases()
+{
+    clear();
+    delete[] _topics;
+}
+
+uint16_t HATopicAliases::find(const char* topic) const
+{
+    if (!topic) {
+        return 0;
+    }
+
+    for (uint16_t i = 0; i < _aliasesNb; i++) {
+        if (strcmp(_topics[i], topic) == 0) {
+            return i + 1; // alias 0 is not allowed by the spec
+        }
+    }
+
+    return 0;
+}
+
+uint16_t HATopicAliases::assign(const char* topic)
+{
+    if (!topic || _aliasesNb >= _maxAliasesNb) {
+        return 0;
+    }
+
+    const uint16_t size = strlen(topic) + 1;
+    char* copy = new char[size];
+    memcpy(copy, topic, size);
+
+    _topics[_aliasesNb++] = copy;
+    return _aliasesNb;
+}
+
+bool HATopicAliases::release(const uint16_t alias)
+{
+    // aliases are assigned incrementally, so only the last one can be reused
+    if (alias == 0 || alias != _aliasesNb) {
+        return false;
+    }
+
+    delete[] _topics[--_aliasesNb];
+    return true;
+}
+
+void HATopicAliases::clear()
+{
+    for (uint16_t i = 0; i < _aliasesNb; i++) {
+        delete[] _topics[i];
+    }
+
+    _aliasesNb = 0;
+}
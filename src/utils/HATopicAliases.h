@@ -0,0 +1,63 @@
+#ifndef AHA_HATOPICALIASES_H
+#define AHA_HATOPICALIASES_H
+
+#include <stdint.h>
+
+/**
+ * This class keeps the mapping between MQTT topics and MQTT 5 topic aliases.
+ * Aliases are assigned in the order of the first publish and they are valid
+ * only within a single connection, so the table needs to be cleared
+ * each time the connection with the broker is acquired.
+ */
+class HATopicAliases
+{
+public:
+    /**
+     * @param maxAliasesNb Maximum number of aliases (the "Topic Alias Maximum" announced by the broker).
+     */
+    HATopicAliases(const uint16_t maxAliasesNb);
+    ~HATopicAliases();
+
+    inline uint16_t getAliasesNb() const
+        { return _aliasesNb; }
+
+    inline uint16_t getMaxAliasesNb() const
+        { return _maxAliasesNb; }
+
+    /**
+     * Returns alias assigned to the given topic or 0 if there is no alias yet.
+     *
+     * @param topic Topic to find.
+     */
+    uint16_t find(const char* topic) const;
+
+    /**
+     * Assigns a new alias to the given topic.
+     * The topic is copied, so the given pointer doesn't need to outlive the call.
+     *
+     * @param topic Topic to assign.
+     * @returns Alias (1..maxAliasesNb) or 0 if the table is full.
+     */
+    uint16_t assign(const char* topic);
+
+    /**
+     * Releases the alias if it's the most recently assigned one.
+     * It's used to roll back the assignment when the publish fails.
+     *
+     * @param alias Alias to release.
+     * @returns Returns true if the alias has been released.
+     */
+    bool release(const uint16_t alias);
+
+    /**
+     * Removes all aliases. It needs to be called each time a new connection is established.
+     */
+    void clear();
+
+private:
+    uint16_t _maxAliasesNb;
+    uint16_t _aliasesNb;
+    char** _topics;
+};
+
+#endif
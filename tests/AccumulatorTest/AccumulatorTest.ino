@@ -0,0 +1,142 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* meanTopic = "testData/testDevice/mean/stat_t";
+static const char* maxTopic = "testData/testDevice/max/stat_t";
+
+test(AccumulatorTest, empty) {
+    HAAccumulator accumulator;
+
+    assertEqual((uint16_t)0, accumulator.getCount());
+    assertTrue(accumulator.getVariance() == 0);
+}
+
+test(AccumulatorTest, statistics) {
+    HAAccumulator accumulator;
+    const float samples[] = {2, 4, 4, 4, 5, 5, 7, 9};
+
+    for (uint8_t i = 0; i < 8; i++) {
+        assertFalse(accumulator.add(samples[i]));
+    }
+
+    assertEqual((uint16_t)8, accumulator.getCount());
+    assertTrue(accumulator.getSum() == 40);
+    assertTrue(accumulator.getMin() == 2);
+    assertTrue(accumulator.getMax() == 9);
+    assertTrue(accumulator.getMean() == 5);
+    assertTrue(fabs(accumulator.getVariance() - 32.0 / 7) < 0.0001);
+}
+
+test(AccumulatorTest, negative_samples) {
+    HAAccumulator accumulator;
+
+    accumulator.add(-3);
+    accumulator.add(-1);
+
+    assertTrue(accumulator.getMin() == -3);
+    assertTrue(accumulator.getMax() == -1);
+    assertTrue(accumulator.getMean() == -2);
+}
+
+test(AccumulatorTest, window_completion_resets) {
+    HAAccumulator accumulator(3);
+
+    assertFalse(accumulator.add(1));
+    assertFalse(accumulator.add(2));
+    assertTrue(accumulator.add(3));
+    assertEqual((uint16_t)0, accumulator.getCount());
+}
+
+test(AccumulatorTest, counter_saturation_flushes) {
+    HAAccumulator accumulator;
+
+    uint16_t completedNb = 0;
+    for (uint16_t i = 1; i < UINT16_MAX; i++) {
+        completedNb += accumulator.add(1);
+    }
+
+    assertEqual((uint16_t)0, completedNb);
+    assertTrue(accumulator.add(1));
+    assertEqual((uint16_t)0, accumulator.getCount());
+    assertFalse(accumulator.add(2));
+    assertEqual((uint16_t)1, accumulator.getCount());
+}
+
+test(AccumulatorTest, aggregate_publishes_on_window) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HAAccumulator accumulator(4);
+    HASensorAggregate sensor("mean", accumulator, HASensorAggregate::StatisticMean);
+
+    accumulator.add(1.5);
+    accumulator.add(2.5);
+    accumulator.add(3.5);
+    assertNoMqttMessage()
+
+    accumulator.add(4.5);
+    assertSingleMqttMessage(meanTopic, "300", true)
+}
+
+test(AccumulatorTest, aggregate_shared_accumulator) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HAAccumulator accumulator(2);
+    HASensorAggregate mean("mean", accumulator, HASensorAggregate::StatisticMean);
+    HASensorAggregate max("max", accumulator, HASensorAggregate::StatisticMax, HASensorFloat::PrecisionP0);
+
+    accumulator.add(10);
+    accumulator.add(20);
+
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, meanTopic, "1500", true)
+    assertMqttMessage(1, maxTopic, "20", true)
+}
+
+test(AccumulatorTest, aggregate_manual_flush) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HAAccumulator accumulator;
+    HASensorAggregate sensor("max", accumulator, HASensorAggregate::StatisticCount, HASensorFloat::PrecisionP0);
+
+    accumulator.flush(); // empty window
+    assertNoMqttMessage()
+
+    for (uint8_t i = 0; i < 7; i++) {
+        accumulator.add(i);
+    }
+
+    accumulator.flush();
+    assertSingleMqttMessage(maxTopic, "7", true)
+}
+
+test(AccumulatorTest, aggregate_destruction_unregisters) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HAAccumulator accumulator(1);
+
+    {
+        HASensorAggregate sensor("mean", accumulator);
+    }
+
+    accumulator.add(1);
+    assertNoMqttMessage()
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
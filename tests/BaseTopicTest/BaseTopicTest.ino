@@ -0,0 +1,138 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define assertConfigLength(message) \
+    assertEqual(strlen(message.buffer) + 1, (size_t)message.bufferSize);
+
+#define measureConfig(EntityType, uniqueId, baseTopicEnabled, result) \
+{ \
+    PubSubClientMock* mock = new PubSubClientMock(); \
+    HADevice device(longDeviceId); \
+    HAMqtt mqtt(mock, device); \
+    mqtt.setBaseTopicEnabled(baseTopicEnabled); \
+    mqtt.begin("testHost"); \
+    EntityType entity(uniqueId); \
+    mqtt.loop(); \
+    assertConfigLength(mock->getFlushedMessages()[0]) \
+    result = strlen(mock->getFlushedMessages()[0].buffer); \
+}
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* longDeviceId = "0123456789abcdef0123456789abcdef";
+
+test(BaseTopicTest, disabled_by_default) {
+    initMqttTest(testDeviceId)
+
+    assertFalse(mqtt.isBaseTopicEnabled());
+}
+
+test(BaseTopicTest, cover_config) {
+    static const char* configTopic = "homeassistant/cover/testDevice/uniqueCover/config";
+    initMqttTest(testDeviceId)
+    mqtt.setBaseTopicEnabled(true);
+
+    HACover cover("uniqueCover");
+    assertEntityConfig(
+        mock,
+        cover,
+        "{\"~\":\"testData/testDevice/uniqueCover\",\"uniq_id\":\"uniqueCover\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"~/stat_t\",\"cmd_t\":\"~/cmd_t\",\"pos_t\":\"~/pos_t\"}"
+    )
+    assertConfigLength(mock->getFlushedMessages()[0])
+}
+
+test(BaseTopicTest, switch_config) {
+    static const char* configTopic = "homeassistant/switch/testDevice/uniqueSwitch/config";
+    initMqttTest(testDeviceId)
+    mqtt.setBaseTopicEnabled(true);
+
+    HASwitch sw("uniqueSwitch");
+    assertEntityConfig(
+        mock,
+        sw,
+        "{\"~\":\"testData/testDevice/uniqueSwitch\",\"uniq_id\":\"uniqueSwitch\",\"opt\":false,\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"~/stat_t\",\"cmd_t\":\"~/cmd_t\"}"
+    )
+    assertConfigLength(mock->getFlushedMessages()[0])
+}
+
+test(BaseTopicTest, lock_config_with_availability) {
+    static const char* configTopic = "homeassistant/lock/testDevice/uniqueLock/config";
+    initMqttTest(testDeviceId)
+    mqtt.setBaseTopicEnabled(true);
+
+    HALock lock("uniqueLock");
+    lock.setAvailability(true);
+    assertEntityConfig(
+        mock,
+        lock,
+        "{\"~\":\"testData/testDevice/uniqueLock\",\"uniq_id\":\"uniqueLock\",\"dev\":{\"ids\":\"testDevice\"},\"avty_t\":\"~/avty_t\",\"stat_t\":\"~/stat_t\",\"cmd_t\":\"~/cmd_t\"}"
+    )
+    assertConfigLength(mock->getFlushedMessages()[0])
+}
+
+test(BaseTopicTest, shared_availability_is_not_abbreviated) {
+    static const char* configTopic = "homeassistant/switch/testDevice/uniqueSwitch/config";
+    initMqttTest(testDeviceId)
+    mqtt.setBaseTopicEnabled(true);
+    device.enableSharedAvailability();
+
+    HASwitch sw("uniqueSwitch");
+    mqtt.loop();
+
+    // device's availability is published first
+    assertMqttMessage(
+        1,
+        configTopic,
+        "{\"~\":\"testData/testDevice/uniqueSwitch\",\"uniq_id\":\"uniqueSwitch\",\"opt\":false,\"dev\":{\"ids\":\"testDevice\"},\"avty_t\":\"testData/testDevice/avty_t\",\"stat_t\":\"~/stat_t\",\"cmd_t\":\"~/cmd_t\"}",
+        true
+    )
+}
+
+test(BaseTopicTest, single_topic_is_not_abbreviated) {
+    static const char* configTopic = "homeassistant/sensor/testDevice/uniqueSensor/config";
+    initMqttTest(testDeviceId)
+    mqtt.setBaseTopicEnabled(true);
+
+    HASensor sensor("uniqueSensor");
+    assertEntityConfig(
+        mock,
+        sensor,
+        "{\"uniq_id\":\"uniqueSensor\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/uniqueSensor/stat_t\"}"
+    )
+}
+
+test(BaseTopicTest, savings_per_device_type) {
+    // each data topic saves the "aha/<32 chars device ID>/<object ID>" prefix minus 1 byte
+    // and the base topic property costs the prefix plus 7 bytes
+    size_t full = 0;
+    size_t abbreviated = 0;
+
+    measureConfig(HACover, "cover", false, full)
+    measureConfig(HACover, "cover", true, abbreviated)
+    assertEqual((size_t)74, full - abbreviated);
+
+    measureConfig(HASwitch, "switch", false, full)
+    measureConfig(HASwitch, "switch", true, abbreviated)
+    assertEqual((size_t)34, full - abbreviated);
+
+    measureConfig(HALock, "lock", false, full)
+    measureConfig(HALock, "lock", true, abbreviated)
+    assertEqual((size_t)32, full - abbreviated);
+
+    measureConfig(HASensor, "sensor", false, full)
+    measureConfig(HASensor, "sensor", true, abbreviated)
+    assertEqual((size_t)0, full - abbreviated);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
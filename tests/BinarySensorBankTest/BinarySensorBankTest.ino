@@ -0,0 +1,195 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* testBankId = "bank";
+static const char* configTopic = "homeassistant/binary_sensor/testDevice/bank_0/config";
+
+test(BinarySensorBankTest, invalid_bank_id) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(nullptr, 4);
+    mqtt.loop();
+
+    assertNoMqttMessage()
+    assertFalse(bank.setState(0, true));
+}
+
+test(BinarySensorBankTest, default_params) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 2);
+    assertEntityConfig(
+        mock,
+        bank,
+        "{\"uniq_id\":\"bank_0\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/bank_0/stat_t\"}"
+    )
+}
+
+test(BinarySensorBankTest, shared_params) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 2);
+    bank.setDeviceClass("door");
+    bank.setIcon("mdi:door");
+    mqtt.loop();
+
+    assertMqttMessage(
+        2,
+        "homeassistant/binary_sensor/testDevice/bank_1/config",
+        "{\"uniq_id\":\"bank_1\",\"dev_cla\":\"door\",\"ic\":\"mdi:door\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/bank_1/stat_t\"}",
+        true
+    )
+}
+
+test(BinarySensorBankTest, input_names) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 2);
+    bank.setName("Door");
+    mqtt.loop();
+
+    assertMqttMessage(
+        0,
+        "homeassistant/binary_sensor/testDevice/bank_0/config",
+        "{\"name\":\"Door 0\",\"uniq_id\":\"bank_0\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/bank_0/stat_t\"}",
+        true
+    )
+    assertMqttMessage(
+        2,
+        "homeassistant/binary_sensor/testDevice/bank_1/config",
+        "{\"name\":\"Door 1\",\"uniq_id\":\"bank_1\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/bank_1/stat_t\"}",
+        true
+    )
+}
+
+test(BinarySensorBankTest, publish_initial_states) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 12);
+    bank.setCurrentState(11, true);
+    mqtt.loop();
+
+    // config + state for each input
+    assertEqual(24, mock->getFlushedMessagesNb());
+    assertMqttMessage(1, "testData/testDevice/bank_0/stat_t", "OFF", true)
+    assertMqttMessage(23, "testData/testDevice/bank_11/stat_t", "ON", true)
+}
+
+test(BinarySensorBankTest, availability) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 2);
+    mock->connectDummy();
+    bank.setAvailability(false);
+
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, "testData/testDevice/bank_0/avty_t", "offline", true)
+    assertMqttMessage(1, "testData/testDevice/bank_1/avty_t", "offline", true)
+}
+
+test(BinarySensorBankTest, set_state) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 40);
+    mock->connectDummy();
+
+    assertTrue(bank.setState(35, true));
+    assertSingleMqttMessage("testData/testDevice/bank_35/stat_t", "ON", true)
+    assertTrue(bank.getCurrentState(35));
+    assertEqual((uint32_t)8, bank.getCurrentStates(1));
+}
+
+test(BinarySensorBankTest, retransmit_to_input) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(4);
+    HABinarySensorBank bank(testBankId, 4);
+    bank.setQos(1);
+    mock->connectDummy();
+
+    assertTrue(bank.setState(0, true));
+    assertTrue(bank.setState(2, true));
+
+    mock->disconnect();
+    mock->clearFlushedMessages();
+    mqtt.loop();
+
+    // each retransmitted message goes to its own input
+    assertMqttMessage(0, "testData/testDevice/bank_0/stat_t", "ON", true)
+    assertMqttMessage(1, "testData/testDevice/bank_2/stat_t", "ON", true)
+    assertTrue(mock->getFlushedMessages()[0].duplicate);
+    assertTrue(mock->getFlushedMessages()[1].duplicate);
+}
+
+test(BinarySensorBankTest, set_state_debounce) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 4);
+    mock->connectDummy();
+
+    assertTrue(bank.setState(2, false));
+    assertNoMqttMessage()
+}
+
+test(BinarySensorBankTest, set_state_out_of_range) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 4);
+    mock->connectDummy();
+
+    assertFalse(bank.setState(4, true));
+    assertFalse(bank.getCurrentState(4));
+}
+
+test(BinarySensorBankTest, set_states_publishes_changes_only) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 32);
+    bank.setCurrentState(0, true);
+    bank.setCurrentState(5, true);
+    mock->connectDummy();
+
+    // input 0 is unchanged, 5 goes off and 31 goes on
+    assertTrue(bank.setStates(0, 0x80000001));
+
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, "testData/testDevice/bank_5/stat_t", "OFF", true)
+    assertMqttMessage(1, "testData/testDevice/bank_31/stat_t", "ON", true)
+    assertEqual((uint32_t)0x80000001, bank.getCurrentStates(0));
+}
+
+test(BinarySensorBankTest, set_states_ignores_unused_bits) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 34);
+    mock->connectDummy();
+
+    assertTrue(bank.setStates(1, 0xFFFFFFFF));
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertFalse(bank.setStates(2, 1));
+}
+
+test(BinarySensorBankTest, set_states_disconnected) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensorBank bank(testBankId, 8);
+
+    // failed inputs are kept unchanged so they can be retried
+    assertFalse(bank.setStates(0, 0x03));
+    assertEqual((uint32_t)0, bank.getCurrentStates(0));
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
@@ -0,0 +1,428 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define prepareTest \
+    BrokerMock broker; \
+    BrokerClientMock subscriber(broker); \
+    BrokerClientMock publisher(broker); \
+    subscriber.setCallback(onBrokerMessage); \
+    subscriber.connectDummy("subscriber"); \
+    publisher.connectDummy("publisher"); \
+    receivedNb = 0; \
+    memset(lastTopic, 0, sizeof(lastTopic)); \
+    memset(lastPayload, 0, sizeof(lastPayload));
+
+#define assertLastMessage(eTopic, ePayload) \
+    assertStringCaseEqual(eTopic, lastTopic); \
+    assertStringCaseEqual(ePayload, lastPayload);
+
+// the burst is serialized on the broker's egress link, so the last message
+// waits for all previous ones (the delivery time is rounded up to the whole millisecond)
+#define assertFleetLatency(stats) \
+    assertMoreOrEqual( \
+        stats.latencySum / stats.deliveredNb, \
+        fleetLatency \
+    ); \
+    assertMoreOrEqual( \
+        stats.maxLatency, \
+        fleetLatency + (uint32_t)((uint64_t)stats.bytesNb * 1000 / fleetBandwidth) \
+    ); \
+    assertLessOrEqual( \
+        stats.maxLatency, \
+        fleetLatency + (uint32_t)((uint64_t)stats.bytesNb * 1000 / fleetBandwidth) + 1 \
+    );
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const uint8_t fleetDevicesNb = 100;
+static const uint8_t fleetEntitiesNb = 50;
+static const uint32_t fleetLatency = 5; // ms
+static const uint32_t fleetBandwidth = 1000000; // B/s
+static uint16_t receivedNb = 0;
+static char lastTopic[128];
+static char lastPayload[128];
+
+void onBrokerMessage(char* topic, uint8_t* payload, unsigned int length)
+{
+    receivedNb++;
+    strncpy(lastTopic, topic, sizeof(lastTopic) - 1);
+    memset(lastPayload, 0, sizeof(lastPayload));
+    memcpy(lastPayload, payload, length < sizeof(lastPayload) ? length : sizeof(lastPayload) - 1);
+}
+
+void onSwitchCommand(bool state, HASwitch* sender)
+{
+    sender->setState(state);
+}
+
+// loops all clients in the round-robin order while the broker's and library's clocks move forward
+// (it stops once there is nothing to deliver, unless the minimum duration is given)
+static void runFleet(
+    BrokerMock& broker,
+    BrokerClientMock& homeAssistant,
+    HAMqtt** mqtts,
+    uint32_t minDuration = 1
+)
+{
+    const uint32_t startedAt = broker.getTime();
+    while (broker.getTime() - startedAt < minDuration || broker.getPendingNb() > 0) {
+        for (uint8_t d = 0; d < fleetDevicesNb; d++) {
+            mqtts[d]->loop();
+        }
+
+        homeAssistant.loop();
+        broker.advance(1);
+        HAUtils::advanceSimulatedTime(1);
+    }
+}
+
+test(BrokerMockTest, match_exact) {
+    assertTrue(BrokerMock::matchTopic("a/b/c", "a/b/c"));
+    assertFalse(BrokerMock::matchTopic("a/b/c", "a/b"));
+    assertFalse(BrokerMock::matchTopic("a/b", "a/b/c"));
+}
+
+test(BrokerMockTest, match_single_level) {
+    assertTrue(BrokerMock::matchTopic("a/+/c", "a/b/c"));
+    assertTrue(BrokerMock::matchTopic("+/+/+", "a/b/c"));
+    assertFalse(BrokerMock::matchTopic("a/+", "a/b/c"));
+    assertFalse(BrokerMock::matchTopic("+/b", "$SYS/b"));
+}
+
+test(BrokerMockTest, match_multi_level) {
+    assertTrue(BrokerMock::matchTopic("#", "a/b/c"));
+    assertTrue(BrokerMock::matchTopic("a/#", "a/b/c"));
+    assertTrue(BrokerMock::matchTopic("a/#", "a"));
+    assertFalse(BrokerMock::matchTopic("b/#", "a/b"));
+}
+
+test(BrokerMockTest, route_exact_subscription) {
+    prepareTest
+
+    subscriber.subscribe("test/topic");
+    publisher.publish("test/topic", "hello");
+    publisher.publish("test/other", "world");
+    subscriber.loop();
+
+    assertEqual(1, receivedNb);
+    assertLastMessage("test/topic", "hello")
+}
+
+test(BrokerMockTest, route_wildcard_subscription) {
+    prepareTest
+
+    subscriber.subscribe("aha/testDevice/+/cmd_t");
+    publisher.publish("aha/testDevice/switch1/cmd_t", "ON");
+    publisher.publish("aha/testDevice/switch1/stat_t", "ON");
+    publisher.publish("aha/otherDevice/switch1/cmd_t", "ON");
+    subscriber.loop();
+
+    assertEqual(1, receivedNb);
+    assertLastMessage("aha/testDevice/switch1/cmd_t", "ON")
+}
+
+test(BrokerMockTest, overlapping_subscriptions_deliver_once) {
+    prepareTest
+
+    subscriber.subscribe("a/#");
+    subscriber.subscribe("a/+");
+    subscriber.subscribe("a/b");
+    publisher.publish("a/b", "x");
+    subscriber.loop();
+
+    assertEqual(1, receivedNb);
+}
+
+test(BrokerMockTest, retained_replay) {
+    prepareTest
+
+    publisher.publish("a/b", "retained", true);
+    publisher.publish("a/c", "not retained", false);
+    subscriber.subscribe("a/#");
+    subscriber.loop();
+
+    assertEqual(1, broker.getRetainedNb());
+    assertEqual(1, receivedNb);
+    assertLastMessage("a/b", "retained")
+}
+
+test(BrokerMockTest, retained_override_and_removal) {
+    prepareTest
+
+    publisher.publish("a/b", "first", true);
+    publisher.publish("a/b", "second", true);
+    assertEqual(1, broker.getRetainedNb());
+    assertEqual((uint16_t)6, broker.getRetained("a/b")->length);
+
+    publisher.publish("a/b", "", true);
+    assertEqual(0, broker.getRetainedNb());
+    assertTrue(broker.getRetained("a/b") == nullptr);
+}
+
+test(BrokerMockTest, latency) {
+    prepareTest
+
+    broker.setLatency(50);
+    subscriber.subscribe("a");
+    publisher.publish("a", "x");
+
+    broker.advance(49);
+    subscriber.loop();
+    assertEqual(0, receivedNb);
+
+    broker.advance(1);
+    subscriber.loop();
+    assertEqual(1, receivedNb);
+    assertEqual((uint32_t)50, broker.getStats().maxLatency);
+}
+
+test(BrokerMockTest, bandwidth) {
+    prepareTest
+
+    broker.setBandwidth(1000); // 1 byte per ms
+    subscriber.subscribe("a");
+
+    // 4 bytes of overhead + 1 byte of topic + 5 bytes of payload = 10ms per message
+    publisher.publish("a", "12345");
+    publisher.publish("a", "12345");
+
+    broker.advance(10);
+    subscriber.loop();
+    assertEqual(1, receivedNb);
+
+    broker.advance(10);
+    subscriber.loop();
+    assertEqual(2, receivedNb);
+    assertEqual((uint32_t)20, broker.getStats().maxLatency);
+}
+
+test(BrokerMockTest, packet_loss_qos0) {
+    prepareTest
+
+    broker.setPacketLoss(50);
+    broker.setSeed(1234);
+    subscriber.subscribe("a");
+
+    for (uint8_t i = 0; i < 100; i++) {
+        publisher.publish("a", "x");
+    }
+
+    subscriber.loop();
+    assertEqual((uint32_t)100, broker.getStats().droppedNb + receivedNb);
+    assertMore(broker.getStats().droppedNb, (uint32_t)25);
+    assertMore(receivedNb, 25);
+}
+
+test(BrokerMockTest, packet_loss_qos1) {
+    prepareTest
+
+    broker.setLatency(10);
+    broker.setPacketLoss(50);
+    broker.setSeed(1234);
+    subscriber.subscribe("a");
+
+    for (uint8_t i = 0; i < 100; i++) {
+        publisher.publish("a", "x", false, 1);
+    }
+
+    broker.advance(10000);
+    subscriber.loop();
+    assertEqual(100, receivedNb);
+    assertEqual((uint32_t)0, broker.getStats().droppedNb);
+    assertMore(broker.getStats().retransmittedNb, (uint32_t)0);
+}
+
+test(BrokerMockTest, last_will) {
+    prepareTest
+
+    BrokerClientMock device(broker);
+    device.connect("device", nullptr, nullptr, "dev/avty", 0, true, "offline", true);
+    subscriber.subscribe("dev/avty");
+
+    device.disconnect(); // graceful
+    subscriber.loop();
+    assertEqual(0, receivedNb);
+
+    device.connect("device", nullptr, nullptr, "dev/avty", 0, true, "offline", true);
+    device.dropConnection();
+    subscriber.loop();
+    assertEqual(1, receivedNb);
+    assertLastMessage("dev/avty", "offline")
+    assertTrue(broker.getRetained("dev/avty") != nullptr);
+}
+
+test(BrokerMockTest, clean_session) {
+    prepareTest
+
+    subscriber.subscribe("a");
+    subscriber.disconnect();
+    subscriber.connectDummy("subscriber");
+    publisher.publish("a", "x");
+    subscriber.loop();
+
+    assertEqual(0, receivedNb);
+}
+
+test(BrokerMockTest, refused_connection) {
+    BrokerMock broker;
+    BrokerClientMock client(broker);
+
+    broker.setAcceptingConnections(false);
+    assertFalse(client.connectDummy());
+    assertFalse(client.connected());
+    assertEqual((uint32_t)1, broker.getStats().refusedConnectionsNb);
+}
+
+test(BrokerMockTest, mqtt_discovery_end_to_end) {
+    prepareTest
+
+    BrokerClientMock transport(broker);
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(transport, device);
+    HASwitch testSwitch("mySwitch");
+    testSwitch.onCommand(onSwitchCommand);
+
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    // config and state are retained
+    assertEqual(2, broker.getRetainedNb());
+    assertTrue(broker.getRetained("homeassistant/switch/testDevice/mySwitch/config") != nullptr);
+
+    // command sent by Home Assistant changes the state
+    subscriber.subscribe("aha/testDevice/mySwitch/stat_t");
+    publisher.publish("aha/testDevice/mySwitch/cmd_t", "ON");
+    mqtt.loop();
+    subscriber.loop();
+
+    assertTrue(testSwitch.getCurrentState());
+    assertLastMessage("aha/testDevice/mySwitch/stat_t", "on")
+}
+
+test(BrokerMockTest, fleet_reconnect_storm) {
+    BrokerMock broker;
+    broker.setLatency(fleetLatency);
+    broker.setBandwidth(fleetBandwidth);
+    HAUtils::setSimulatedTime(1000);
+
+    BrokerClientMock homeAssistant(broker);
+    homeAssistant.setCallback(onBrokerMessage);
+    homeAssistant.connectDummy("homeassistant");
+    homeAssistant.subscribe("homeassistant/#");
+    homeAssistant.subscribe("aha/#");
+    receivedNb = 0;
+
+    char deviceIds[fleetDevicesNb][16];
+    char entityIds[fleetEntitiesNb][16];
+    for (uint8_t i = 0; i < fleetEntitiesNb; i++) {
+        sprintf(entityIds[i], "sensor%d", i);
+    }
+
+    // all devices are alive at the same time and each of them owns its entities
+    BrokerClientMock* transports[fleetDevicesNb];
+    HADevice* devices[fleetDevicesNb];
+    HAMqtt* mqtts[fleetDevicesNb];
+    HABinarySensor* sensors[fleetDevicesNb][fleetEntitiesNb];
+
+    for (uint8_t d = 0; d < fleetDevicesNb; d++) {
+        sprintf(deviceIds[d], "device%d", d);
+        transports[d] = new BrokerClientMock(broker);
+        devices[d] = new HADevice(deviceIds[d]);
+        mqtts[d] = new HAMqtt(*transports[d], *devices[d], fleetEntitiesNb);
+
+        for (uint8_t i = 0; i < fleetEntitiesNb; i++) {
+            sensors[d][i] = new HABinarySensor(entityIds[i]);
+            assertTrue(mqtts[d]->addDeviceType(sensors[d][i]));
+        }
+    }
+
+    for (uint8_t d = 0; d < fleetDevicesNb; d++) {
+        assertEqual((uint16_t)fleetEntitiesNb, mqtts[d]->getDevicesTypesNb());
+        mqtts[d]->begin("testHost");
+    }
+
+    // boot: all devices connect and publish discovery in the same burst
+    broker.resetStats();
+    const uint32_t bootStartedAt = broker.getTime();
+    runFleet(broker, homeAssistant, mqtts);
+    const uint32_t bootTime = broker.getTime() - bootStartedAt;
+    const BrokerStats boot = broker.getStats();
+
+    assertEqual((uint32_t)fleetDevicesNb, boot.connectionsNb);
+    assertEqual((uint32_t)(2 * fleetDevicesNb * fleetEntitiesNb), boot.publishedNb);
+    assertEqual(boot.publishedNb, boot.deliveredNb);
+    assertEqual((uint32_t)0, boot.droppedNb);
+    assertEqual((uint32_t)boot.deliveredNb, (uint32_t)receivedNb);
+    assertFleetLatency(boot);
+
+    // broker's restart: the devices lose the connection and they are refused until it's back
+    broker.resetStats();
+    broker.setAcceptingConnections(false);
+    for (uint8_t d = 0; d < fleetDevicesNb; d++) {
+        transports[d]->dropConnection();
+    }
+
+    runFleet(broker, homeAssistant, mqtts, HAMqtt::ReconnectInterval);
+    assertEqual((uint32_t)fleetDevicesNb, broker.getStats().refusedConnectionsNb);
+    assertEqual((uint32_t)0, broker.getStats().connectionsNb);
+
+    // the reconnect storm: the throttle expires for all devices at the same time
+    receivedNb = 0;
+    broker.setAcceptingConnections(true);
+    runFleet(broker, homeAssistant, mqtts, HAMqtt::ReconnectInterval);
+    const BrokerStats storm = broker.getStats();
+
+    for (uint8_t d = 0; d < fleetDevicesNb; d++) {
+        assertTrue(mqtts[d]->isConnected());
+    }
+
+    assertEqual((uint32_t)fleetDevicesNb, storm.connectionsNb);
+    assertEqual((uint32_t)(2 * fleetDevicesNb * fleetEntitiesNb), storm.publishedNb);
+    assertEqual(storm.publishedNb, storm.deliveredNb);
+    assertEqual((uint32_t)0, storm.droppedNb);
+    assertEqual((uint32_t)storm.deliveredNb, (uint32_t)receivedNb);
+    assertFleetLatency(storm);
+
+    // retained config and state of each entity
+    assertEqual(2 * fleetDevicesNb * fleetEntitiesNb, broker.getRetainedNb());
+
+    Serial.print(F("fleet of "));
+    Serial.print(fleetDevicesNb);
+    Serial.print(F("x"));
+    Serial.print(fleetEntitiesNb);
+    Serial.print(F(", boot [ms]: "));
+    Serial.print(bootTime);
+    Serial.print(F(", broker load [B]: "));
+    Serial.print(storm.bytesNb);
+    Serial.print(F(", max pending: "));
+    Serial.print(storm.maxPendingNb);
+    Serial.print(F(", avg latency [ms]: "));
+    Serial.print(storm.latencySum / storm.deliveredNb);
+    Serial.print(F(", max latency [ms]: "));
+    Serial.println(storm.maxLatency);
+
+    for (uint8_t d = 0; d < fleetDevicesNb; d++) {
+        for (uint8_t i = 0; i < fleetEntitiesNb; i++) {
+            delete sensors[d][i];
+        }
+
+        delete mqtts[d];
+        delete devices[d];
+        delete transports[d];
+    }
+
+    HAUtils::disableSimulatedTime();
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
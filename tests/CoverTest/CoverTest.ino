@@ -5,7 +5,8 @@
     initMqttTest(testDeviceId) \
     commandCallbackCalled = false; \
     commandCallbackCommand = unknownCommand; \
-    commandCallbackCoverPtr = nullptr;
+    commandCallbackCoverPtr = nullptr; \
+    positionCallbackPosition = HACover::DefaultPosition;
 
 #define assertCallback(shouldBeCalled, expectedCommand, callerPtr) \
     assertTrue(commandCallbackCalled == shouldBeCalled); \
@@ -18,11 +19,13 @@ static const char* testDeviceId = "testDevice";
 static const char* testUniqueId = "uniqueCover";
 static const char* configTopic = "homeassistant/cover/testDevice/uniqueCover/config";
 static const char* commandTopic = "testData/testDevice/uniqueCover/cmd_t";
+static const char* setPositionTopic = "testData/testDevice/uniqueCover/set_pos_t";
 static const HACover::CoverCommand unknownCommand = static_cast<HACover::CoverCommand>(0);
 
 static bool commandCallbackCalled = false;
 static HACover::CoverCommand commandCallbackCommand = unknownCommand;
 static HACover* commandCallbackCoverPtr = nullptr;
+static int16_t positionCallbackPosition = HACover::DefaultPosition;
 
 void onCommandReceived(HACover::CoverCommand command, HACover* cover)
 {
@@ -31,6 +34,12 @@ void onCommandReceived(HACover::CoverCommand command, HACover* cover)
     commandCallbackCoverPtr = cover;
 }
 
+void onPositionCommandReceived(int16_t position, HACover* cover)
+{
+    positionCallbackPosition = position;
+    commandCallbackCoverPtr = cover;
+}
+
 test(CoverTest, invalid_unique_id) {
     prepareTest
 
@@ -63,6 +72,29 @@ test(CoverTest, command_subscription) {
     assertStringCaseEqual(commandTopic, mock->getSubscriptions()[0].topic);
 }
 
+test(CoverTest, position_command_config) {
+    prepareTest
+
+    HACover cover(testUniqueId);
+    cover.onPositionCommand(onPositionCommandReceived);
+    assertEntityConfig(
+        mock,
+        cover,
+        "{\"uniq_id\":\"uniqueCover\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/uniqueCover/stat_t\",\"cmd_t\":\"testData/testDevice/uniqueCover/cmd_t\",\"pos_t\":\"testData/testDevice/uniqueCover/pos_t\",\"set_pos_t\":\"testData/testDevice/uniqueCover/set_pos_t\"}"
+    )
+}
+
+test(CoverTest, position_command_subscription) {
+    prepareTest
+
+    HACover cover(testUniqueId);
+    cover.onPositionCommand(onPositionCommandReceived);
+    mqtt.loop();
+
+    assertEqual(2, mock->getSubscriptionsNb());
+    assertStringCaseEqual(setPositionTopic, mock->getSubscriptions()[1].topic);
+}
+
 test(CoverTest, availability) {
     prepareTest
 
@@ -316,6 +348,31 @@ test(ButtonTest, command_invalid) {
     assertCallback(false, unknownCommand, nullptr)
 }
 
+test(CoverTest, position_command) {
+    prepareTest
+
+    HACover cover(testUniqueId);
+    cover.onPositionCommand(onPositionCommandReceived);
+    mock->fakeMessage(setPositionTopic, "42");
+
+    assertEqual((int16_t)42, positionCallbackPosition);
+    assertEqual(&cover, commandCallbackCoverPtr);
+}
+
+test(CoverTest, position_command_invalid) {
+    prepareTest
+
+    HACover cover(testUniqueId);
+    cover.onPositionCommand(onPositionCommandReceived);
+    mock->fakeMessage(setPositionTopic, "101");
+    mock->fakeMessage(setPositionTopic, "-1");
+    mock->fakeMessage(setPositionTopic, "4x");
+    mock->fakeMessage(setPositionTopic, "");
+
+    assertEqual((int16_t)HACover::DefaultPosition, positionCallbackPosition);
+    assertTrue(commandCallbackCoverPtr == nullptr);
+}
+
 test(ButtonTest, different_cover_command) {
     prepareTest
 
@@ -22,7 +22,7 @@ static const char* dummyTopic = "dummyTopic";
 #define flushSerializer(mock, serializer) \
     mock->connectDummy(); \
     mock->beginPublish(dummyTopic, serializer->calculateSize(), false); \
-    serializer->flush(); \
+    serializer->flush(&mqtt); \
     mock->endPublish();
 
 #define assertSerializerMqttMessage(expectedJson) \
@@ -3,6 +3,16 @@
 
 using aunit::TestRunner;
 
+class UncachedDeviceTrigger : public HADeviceTrigger
+{
+public:
+    UncachedDeviceTrigger(const char* type, const char* subtype) :
+        HADeviceTrigger(type, subtype) { }
+
+    bool triggerUncached()
+        { return publishOnDataTopic(HATopic, ""); }
+};
+
 static const char* testDeviceId = "testDevice";
 static const char* triggerType = "myType";
 static const char* triggerSubtype = "mySubtype";
@@ -312,6 +322,100 @@ test(DeviceTriggerTest, subtype_progmem_button_6) {
     assertTrue(trigger.getType() == nullptr);
 }
 
+test(DeviceTriggerTest, trigger_after_prefix_change) {
+    initMqttTest(testDeviceId)
+
+    HADeviceTrigger trigger(triggerType, triggerSubtype);
+    mqtt.loop();
+    mqtt.setDataPrefix("newData");
+    mock->disconnect();
+    mqtt.disconnect();
+    mqtt.begin("testHost", "testUser", "testPass");
+    mqtt.loop(); // topic is regenerated on reconnect
+    mock->clearFlushedMessages();
+
+    assertTrue(trigger.trigger());
+    assertSingleMqttMessage("newData/testDevice/myType_mySubtype/t", "", false)
+}
+
+test(DeviceTriggerTest, trigger_after_device_removal) {
+    initMqttTest(testDeviceId)
+    assertTrue(mqtt.enableGatewayMode(2));
+
+    HADevice child("child");
+    HADeviceTrigger trigger(triggerType, triggerSubtype);
+    assertTrue(trigger.setDevice(child));
+    mqtt.loop();
+    assertTrue(trigger.trigger()); // the topic is cached
+
+    assertTrue(mqtt.removeDevice(child));
+    mock->clearFlushedMessages();
+
+    assertFalse(trigger.trigger());
+    assertNoMqttMessage()
+}
+
+test(DeviceTriggerTest, trigger_after_device_change) {
+    initMqttTest(testDeviceId)
+    assertTrue(mqtt.enableGatewayMode(2));
+
+    HADevice child("child");
+    HADeviceTrigger trigger(triggerType, triggerSubtype);
+    mqtt.loop();
+    assertTrue(trigger.trigger()); // the topic is cached
+
+    assertTrue(trigger.setDevice(child));
+    mock->clearFlushedMessages();
+
+    assertTrue(trigger.trigger());
+    assertSingleMqttMessage("testData/child/myType_mySubtype/t", "", false)
+}
+
+test(DeviceTriggerTest, trigger_burst_benchmark) {
+    static const uint8_t triggersNb = 64;
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device, triggersNb + 1);
+    mqtt.setDataPrefix("testData");
+
+    char subtypes[triggersNb][4];
+    UncachedDeviceTrigger* triggers[triggersNb];
+    for (uint8_t i = 0; i < triggersNb; i++) {
+        memset(subtypes[i], 0, sizeof(subtypes[i]));
+        HAUtils::numberToStr(subtypes[i], i);
+        triggers[i] = new UncachedDeviceTrigger(triggerType, subtypes[i]);
+    }
+
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    uint32_t startedAt = micros();
+    for (uint8_t i = 0; i < triggersNb; i++) {
+        triggers[i]->triggerUncached();
+    }
+    const uint32_t uncachedTime = micros() - startedAt;
+    mock->clearFlushedMessages();
+
+    startedAt = micros();
+    for (uint8_t i = 0; i < triggersNb; i++) {
+        assertTrue(triggers[i]->trigger());
+    }
+    const uint32_t cachedTime = micros() - startedAt;
+
+    assertEqual(triggersNb, mock->getFlushedMessagesNb());
+    assertMqttMessage(63, "testData/testDevice/myType_63/t", "", false)
+
+    Serial.print(F("64 triggers burst [us], uncached: "));
+    Serial.print(uncachedTime);
+    Serial.print(F(", cached: "));
+    Serial.println(cachedTime);
+
+    for (uint8_t i = 0; i < triggersNb; i++) {
+        delete triggers[i];
+    }
+}
+
 void setup()
 {
     Serial.begin(115200);
@@ -0,0 +1,271 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define prepareTest \
+    initMqttTest(testDeviceId) \
+    commandsNb = 0;
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* configWildcard = "homeassistant/+/testDevice/+/config";
+static uint8_t commandsNb = 0;
+
+static const char tableRelayId[] PROGMEM = "tableRelay";
+static const HAEntityDescriptor entities[] PROGMEM = {
+    {tableRelayId, HAEntityTable::Switch, HAEntityTable::EnabledByDefault}
+};
+
+void onSwitchCommand(bool state, HASwitch* sender)
+{
+    (void)state;
+    (void)sender;
+    commandsNb++;
+}
+
+test(EntityRemovalTest, remove_twice) {
+    prepareTest
+
+    HASwitch sw("relay");
+    assertTrue(mqtt.removeDeviceType(&sw));
+    assertFalse(mqtt.removeDeviceType(&sw));
+    assertTrue(sw.mqtt() == nullptr);
+}
+
+test(EntityRemovalTest, set_state_after_remove) {
+    prepareTest
+
+    HASwitch relay("relay");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(mqtt.removeDeviceType(&relay));
+    assertFalse(relay.setState(true));
+    assertNoMqttMessage()
+}
+
+test(EntityRemovalTest, remove_and_add_again) {
+    prepareTest
+
+    HASwitch relay("relay");
+    assertTrue(mqtt.removeDeviceType(&relay));
+    assertTrue(mqtt.addDeviceType(&relay));
+    assertEqual((uint8_t)1, mqtt.getDevicesTypesNb());
+    assertTrue(mqtt.getDevicesTypes()[0] == &relay);
+
+    mqtt.loop();
+    assertMqttMessage(
+        0,
+        "homeassistant/switch/testDevice/relay/config",
+        "{\"uniq_id\":\"relay\",\"opt\":false,\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/relay/stat_t\",\"cmd_t\":\"testData/testDevice/relay/cmd_t\"}",
+        true
+    )
+}
+
+test(EntityRemovalTest, remove_preserves_order) {
+    prepareTest
+
+    HASwitch first("first");
+    HASwitch second("second");
+    HASwitch third("third");
+
+    assertTrue(mqtt.removeDeviceType(&second));
+    assertEqual((uint8_t)2, mqtt.getDevicesTypesNb());
+    assertTrue(mqtt.getDevicesTypes()[0] == &first);
+    assertTrue(mqtt.getDevicesTypes()[1] == &third);
+}
+
+test(EntityRemovalTest, removed_entity_is_not_published) {
+    prepareTest
+
+    HASwitch relay("relay");
+    HASwitch removed("removed");
+    removed.onCommand(onSwitchCommand);
+    mqtt.removeDeviceType(&removed);
+    mqtt.loop();
+
+    for (uint8_t i = 0; i < mock->getFlushedMessagesNb(); i++) {
+        assertTrue(strstr(mock->getFlushedMessages()[i].topic, "removed") == nullptr);
+    }
+
+    mock->fakeMessage("testData/testDevice/removed/cmd_t", "ON");
+    assertEqual((uint8_t)0, commandsNb);
+}
+
+test(EntityRemovalTest, destructor_removes_entity) {
+    prepareTest
+
+    {
+        HASwitch relay("relay");
+        assertEqual((uint8_t)1, mqtt.getDevicesTypesNb());
+    }
+
+    assertEqual((uint8_t)0, mqtt.getDevicesTypesNb());
+    mqtt.loop();
+    mock->fakeMessage("testData/testDevice/relay/cmd_t", "ON");
+}
+
+test(EntityRemovalTest, remove_with_purge) {
+    prepareTest
+
+    HASwitch relay("relay");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(mqtt.removeDeviceType(&relay, true));
+    assertEqual((uint8_t)0, mqtt.getDevicesTypesNb());
+    assertSingleMqttMessage("homeassistant/switch/testDevice/relay/config", "", true)
+}
+
+test(EntityRemovalTest, purge_requires_connection) {
+    prepareTest
+
+    HASwitch relay("relay");
+    assertFalse(mqtt.removeDeviceType(&relay, true));
+    assertEqual((uint8_t)1, mqtt.getDevicesTypesNb());
+    assertNoMqttMessage()
+}
+
+test(EntityRemovalTest, purge_config_by_id) {
+    prepareTest
+
+    mqtt.loop();
+    assertTrue(mqtt.purgeConfig("sensor", "oldSensor"));
+    assertSingleMqttMessage("homeassistant/sensor/testDevice/oldSensor/config", "", true)
+}
+
+test(EntityRemovalTest, purge_bank) {
+    prepareTest
+
+    HABinarySensorBank bank("bank", 2);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(mqtt.removeDeviceType(&bank, true));
+    assertEqual((uint8_t)2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, "homeassistant/binary_sensor/testDevice/bank_0/config", "", true)
+    assertMqttMessage(1, "homeassistant/binary_sensor/testDevice/bank_1/config", "", true)
+}
+
+test(EntityRemovalTest, sweep_requires_connection) {
+    prepareTest
+
+    assertFalse(mqtt.sweepOrphanedConfigs());
+    mqtt.loop();
+    assertTrue(mqtt.sweepOrphanedConfigs());
+    assertFalse(mqtt.sweepOrphanedConfigs());
+    assertTrue(mqtt.isSweeping());
+}
+
+test(EntityRemovalTest, sweep_subscription) {
+    HAUtils::setSimulatedTime(1000);
+    prepareTest
+
+    mqtt.loop();
+    assertTrue(mqtt.sweepOrphanedConfigs(2000));
+    assertEqual(1, mock->getSubscriptionsNb());
+    assertStringCaseEqual(configWildcard, mock->getSubscriptions()[0].topic);
+    assertEqual((uint32_t)2000, mqtt.getIdleTimeout());
+
+    HAUtils::advanceSimulatedTime(2000);
+    mqtt.loop();
+    assertFalse(mqtt.isSweeping());
+    assertEqual(0, mock->getSubscriptionsNb());
+    HAUtils::disableSimulatedTime();
+}
+
+test(EntityRemovalTest, sweep_purges_orphans_only) {
+    prepareTest
+    HASwitch relay("relay");
+    relay.onCommand(onSwitchCommand);
+    HABinarySensorBank bank("bank", 4);
+    HAEntityTable table(entities, 1);
+
+    mqtt.loop();
+    mqtt.sweepOrphanedConfigs();
+    mock->clearFlushedMessages();
+
+    mock->fakeMessage("homeassistant/switch/testDevice/relay/config", "{}");
+    mock->fakeMessage("homeassistant/binary_sensor/testDevice/bank_3/config", "{}");
+    mock->fakeMessage("homeassistant/switch/testDevice/tableRelay/config", "{}");
+    assertNoMqttMessage()
+
+    mock->fakeMessage("homeassistant/sensor/testDevice/relay/config", "{}");
+    mock->fakeMessage("homeassistant/binary_sensor/testDevice/bank_4/config", "{}");
+    mock->fakeMessage("homeassistant/switch/testDevice/oldRelay/config", "{}");
+    mock->fakeMessage("homeassistant/switch/testDevice/oldRelay/config", ""); // echo of the purge
+    assertEqual((uint8_t)3, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, "homeassistant/sensor/testDevice/relay/config", "", true)
+    assertMqttMessage(1, "homeassistant/binary_sensor/testDevice/bank_4/config", "", true)
+    assertMqttMessage(2, "homeassistant/switch/testDevice/oldRelay/config", "", true)
+    assertEqual((uint16_t)3, mqtt.getPurgedConfigsNb());
+
+    // other messages are still passed to the entities
+    mock->fakeMessage("testData/testDevice/relay/cmd_t", "ON");
+    assertEqual((uint8_t)1, commandsNb);
+}
+
+test(EntityRemovalTest, sweep_gateway_devices) {
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HADevice child("childDevice");
+    HAMqtt mqtt(mock, device);
+    mqtt.enableGatewayMode(1);
+    HASwitch relay("relay");
+    relay.setDevice(child);
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    mqtt.sweepOrphanedConfigs();
+
+    // the first subscription is the command topic of the relay
+    assertEqual(3, mock->getSubscriptionsNb());
+    assertStringCaseEqual(configWildcard, mock->getSubscriptions()[1].topic);
+    assertStringCaseEqual(
+        "homeassistant/+/childDevice/+/config",
+        mock->getSubscriptions()[2].topic
+    );
+
+    mock->clearFlushedMessages();
+    mock->fakeMessage("homeassistant/switch/childDevice/relay/config", "{}");
+    mock->fakeMessage("homeassistant/switch/testDevice/relay/config", "{}");
+    assertSingleMqttMessage("homeassistant/switch/testDevice/relay/config", "", true)
+}
+
+test(EntityRemovalTest, sweep_retained_replay) {
+    BrokerMock broker;
+    BrokerClientMock publisher(broker);
+    publisher.connectDummy("publisher");
+    publisher.publish("homeassistant/switch/testDevice/relay/config", "{}", true);
+    publisher.publish("homeassistant/switch/testDevice/oldRelay/config", "{}", true);
+    publisher.publish("homeassistant/sensor/testDevice/oldSensor/config", "{}", true);
+    publisher.publish("homeassistant/switch/otherDevice/relay/config", "{}", true);
+
+    BrokerClientMock transport(broker);
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(transport, device);
+    HASwitch relay("relay");
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    assertTrue(mqtt.sweepOrphanedConfigs());
+    mqtt.loop();
+
+    assertEqual((uint16_t)2, mqtt.getPurgedConfigsNb());
+    assertTrue(broker.getRetained("homeassistant/switch/testDevice/oldRelay/config") == nullptr);
+    assertTrue(broker.getRetained("homeassistant/sensor/testDevice/oldSensor/config") == nullptr);
+    assertTrue(broker.getRetained("homeassistant/switch/testDevice/relay/config") != nullptr);
+    assertTrue(broker.getRetained("homeassistant/switch/otherDevice/relay/config") != nullptr);
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
@@ -0,0 +1,289 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define prepareTest \
+    PubSubClientMock* mock = new PubSubClientMock(); \
+    HADevice device(testDeviceId); \
+    HAMqtt mqtt(mock, device, 4); \
+    mqtt.setDataPrefix("testData"); \
+    commandCallbackCalled = false; \
+    commandCallbackIndex = 0xFF; \
+    commandCallbackState = false; \
+    commandCallbackTablePtr = nullptr;
+
+#define assertCallback(shouldBeCalled, expectedIndex, expectedState, callerPtr) \
+    assertTrue(commandCallbackCalled == shouldBeCalled); \
+    assertEqual((uint8_t)expectedIndex, commandCallbackIndex); \
+    assertEqual(expectedState, commandCallbackState); \
+    assertEqual(callerPtr, commandCallbackTablePtr);
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+
+static const char doorId[] PROGMEM = "door";
+static const char tempId[] PROGMEM = "temp";
+static const char relayId[] PROGMEM = "relay";
+static const char bellId[] PROGMEM = "bell";
+static const char spareId[] PROGMEM = "spare";
+
+static const HAEntityDescriptor entities[] PROGMEM = {
+    {doorId, HAEntityTable::BinarySensor, HAEntityTable::EnabledByDefault},
+    {tempId, HAEntityTable::Sensor, HAEntityTable::EnabledByDefault},
+    {relayId, HAEntityTable::Switch, HAEntityTable::EnabledByDefault | HAEntityTable::RetainState},
+    {bellId, HAEntityTable::Button, HAEntityTable::EnabledByDefault},
+    {spareId, HAEntityTable::Switch, 0}
+};
+static const uint8_t entitiesNb = sizeof(entities) / sizeof(entities[0]);
+
+static bool commandCallbackCalled = false;
+static uint8_t commandCallbackIndex = 0xFF;
+static bool commandCallbackState = false;
+static HAEntityTable* commandCallbackTablePtr = nullptr;
+
+void onCommandReceived(uint8_t index, bool state, HAEntityTable* sender)
+{
+    commandCallbackCalled = true;
+    commandCallbackIndex = index;
+    commandCallbackState = state;
+    commandCallbackTablePtr = sender;
+}
+
+HABaseDeviceType* createSwitch(uint8_t index, const char* uniqueId)
+{
+    (void)index;
+    return new HASwitch(uniqueId);
+}
+
+test(EntityTableTest, enabled_by_default) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    assertEqual((uint8_t)5, table.getDescriptorsNb());
+    assertEqual((uint8_t)4, table.getEnabledNb());
+    assertTrue(table.isEnabled(2));
+    assertFalse(table.isEnabled(4));
+    assertFalse(table.isEnabled(entitiesNb));
+
+    table.setEnabled(4, true);
+    table.setEnabled(0, false);
+    assertTrue(table.isEnabled(4));
+    assertFalse(table.isEnabled(0));
+}
+
+test(EntityTableTest, configs_of_enabled_entities) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    assertEqual((uint8_t)6, mock->getFlushedMessagesNb());
+    assertMqttMessage(
+        0,
+        "homeassistant/binary_sensor/testDevice/door/config",
+        "{\"uniq_id\":\"door\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/door/stat_t\"}",
+        true
+    )
+    assertMqttMessage(1, "testData/testDevice/door/stat_t", "OFF", false)
+    assertMqttMessage(
+        2,
+        "homeassistant/sensor/testDevice/temp/config",
+        "{\"uniq_id\":\"temp\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/temp/stat_t\"}",
+        true
+    )
+    assertMqttMessage(
+        3,
+        "homeassistant/switch/testDevice/relay/config",
+        "{\"uniq_id\":\"relay\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/relay/stat_t\",\"cmd_t\":\"testData/testDevice/relay/cmd_t\"}",
+        true
+    )
+    assertMqttMessage(4, "testData/testDevice/relay/stat_t", "OFF", true)
+    assertMqttMessage(
+        5,
+        "homeassistant/button/testDevice/bell/config",
+        "{\"uniq_id\":\"bell\",\"dev\":{\"ids\":\"testDevice\"},\"cmd_t\":\"testData/testDevice/bell/cmd_t\"}",
+        true
+    )
+}
+
+test(EntityTableTest, command_subscriptions) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    table.setEnabled(4, true);
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    assertEqual(3, mock->getSubscriptionsNb());
+    assertStringCaseEqual(F("testData/testDevice/relay/cmd_t"), mock->getSubscriptions()[0].topic);
+    assertStringCaseEqual(F("testData/testDevice/bell/cmd_t"), mock->getSubscriptions()[1].topic);
+    assertStringCaseEqual(F("testData/testDevice/spare/cmd_t"), mock->getSubscriptions()[2].topic);
+}
+
+test(EntityTableTest, set_state) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(table.setState(2, true));
+    assertTrue(table.getCurrentState(2));
+    assertFalse(table.getCurrentState(0));
+    assertSingleMqttMessage("testData/testDevice/relay/stat_t", "ON", true)
+
+    // the same state is not published again
+    mock->clearFlushedMessages();
+    assertTrue(table.setState(2, true));
+    assertNoMqttMessage()
+}
+
+test(EntityTableTest, retransmit_to_entity) {
+    prepareTest
+
+    mqtt.enableInflightWindow(4);
+    HAEntityTable table(entities, entitiesNb);
+    table.setQos(1);
+    mqtt.begin("testHost");
+    mock->connectDummy();
+
+    assertTrue(table.setState(0, true));
+    assertTrue(table.setState(2, true));
+
+    mock->disconnect();
+    mock->clearFlushedMessages();
+    mqtt.loop();
+
+    // each retransmitted message goes to its own entity
+    assertMqttMessage(0, "testData/testDevice/door/stat_t", "ON", false)
+    assertMqttMessage(1, "testData/testDevice/relay/stat_t", "ON", true)
+    assertTrue(mock->getFlushedMessages()[0].duplicate);
+    assertTrue(mock->getFlushedMessages()[1].duplicate);
+}
+
+test(EntityTableTest, set_state_invalid_entity) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertFalse(table.setState(1, true)); // sensor
+    assertFalse(table.setState(3, true)); // button
+    assertFalse(table.setState(4, true)); // disabled
+    assertFalse(table.setState(entitiesNb, true));
+    assertFalse(table.getCurrentState(4));
+    assertNoMqttMessage()
+}
+
+test(EntityTableTest, set_value) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertFalse(table.setValue(0, "1"));
+    assertTrue(table.setValue(1, "21.5"));
+    assertSingleMqttMessage("testData/testDevice/temp/stat_t", "21.5", false)
+}
+
+test(EntityTableTest, switch_command) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    table.onCommand(onCommandReceived);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mock->fakeMessage("testData/testDevice/relay/cmd_t", "ON");
+
+    assertCallback(true, 2, true, &table)
+    assertFalse(table.getCurrentState(2));
+}
+
+test(EntityTableTest, button_command) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    table.onCommand(onCommandReceived);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mock->fakeMessage("testData/testDevice/bell/cmd_t", "PRESS");
+
+    assertCallback(true, 3, true, &table)
+}
+
+test(EntityTableTest, command_for_disabled_entity) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    table.onCommand(onCommandReceived);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mock->fakeMessage("testData/testDevice/spare/cmd_t", "ON");
+
+    assertFalse(commandCallbackCalled);
+}
+
+test(EntityTableTest, materialize) {
+    prepareTest
+
+    HAEntityTable table(entities, entitiesNb);
+    assertTrue(table.materialize(4, createSwitch) == nullptr); // disabled
+
+    HABaseDeviceType* relay = table.materialize(2, createSwitch);
+    assertTrue(relay != nullptr);
+    assertTrue(table.getMaterialized(2) == relay);
+    assertTrue(table.materialize(2, createSwitch) == nullptr);
+    assertStringCaseEqual("relay", relay->uniqueId());
+
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    // the relay is published once by the HASwitch
+    uint8_t relayConfigsNb = 0;
+    for (uint8_t i = 0; i < mock->getFlushedMessagesNb(); i++) {
+        if (strcmp(mock->getFlushedMessages()[i].topic, "homeassistant/switch/testDevice/relay/config") == 0) {
+            relayConfigsNb++;
+        }
+    }
+
+    assertEqual((uint8_t)1, relayConfigsNb);
+    assertFalse(table.setState(2, true));
+    assertTrue(static_cast<HASwitch*>(relay)->setState(true));
+}
+
+test(EntityTableTest, memory_usage) {
+    static const uint8_t entitiesNb = 64;
+
+    static const uint8_t maxIdLength = 16;
+
+    // the table needs two bits per entity, the object ID buffer and one slot in the HAMqtt
+    const size_t objectsSize = entitiesNb * (sizeof(HASwitch) + sizeof(HABaseDeviceType*));
+    const size_t tableSize = sizeof(HAEntityTable) + sizeof(HABaseDeviceType*) +
+        2 * ((entitiesNb + 7) / 8) + maxIdLength + 1;
+
+    Serial.print(F("RAM of 64 switches: "));
+    Serial.print(objectsSize);
+    Serial.print(F(" B as objects, "));
+    Serial.print(tableSize);
+    Serial.println(F(" B as table"));
+
+    assertTrue(tableSize * 10 < objectsSize);
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
@@ -0,0 +1,174 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* testUniqueId = "uniqueSensor";
+static const char* stateTopic = "testData/testDevice/uniqueSensor/stat_t";
+static const char* triggerTopic = "testData/testDevice/myType_mySubtype/t";
+
+test(EventQueueTest, push_pop) {
+    HAEventQueue queue(2);
+    HABaseDeviceType* deviceType = reinterpret_cast<HABaseDeviceType*>(0x10);
+    HAQueuedEvent event;
+
+    assertTrue(queue.isEmpty());
+    assertFalse(queue.pop(event));
+
+    assertTrue(queue.push(deviceType, 1));
+    assertTrue(queue.push(deviceType, 2));
+    assertFalse(queue.isEmpty());
+
+    assertTrue(queue.pop(event));
+    assertTrue(event.deviceType == deviceType);
+    assertEqual((uint8_t)1, event.value);
+    assertTrue(queue.pop(event));
+    assertEqual((uint8_t)2, event.value);
+    assertTrue(queue.isEmpty());
+}
+
+test(EventQueueTest, overflow) {
+    HAEventQueue queue(2);
+    HABaseDeviceType* deviceType = reinterpret_cast<HABaseDeviceType*>(0x10);
+
+    assertTrue(queue.push(deviceType, 1));
+    assertTrue(queue.push(deviceType, 2));
+    assertFalse(queue.push(deviceType, 3));
+    assertEqual((uint8_t)1, queue.getDroppedNb());
+}
+
+test(EventQueueTest, wrap_around) {
+    HAEventQueue queue(3);
+    HABaseDeviceType* deviceType = reinterpret_cast<HABaseDeviceType*>(0x10);
+    HAQueuedEvent event;
+
+    for (uint8_t i = 0; i < 20; i++) {
+        assertTrue(queue.push(deviceType, i));
+        assertTrue(queue.pop(event));
+        assertEqual(i, event.value);
+    }
+
+    assertTrue(queue.isEmpty());
+}
+
+test(EventQueueTest, invalidate) {
+    HAEventQueue queue(3);
+    HABaseDeviceType* deviceTypeA = reinterpret_cast<HABaseDeviceType*>(0x10);
+    HABaseDeviceType* deviceTypeB = reinterpret_cast<HABaseDeviceType*>(0x20);
+    HAQueuedEvent event;
+
+    queue.push(deviceTypeA, 1);
+    queue.push(deviceTypeB, 2);
+    queue.invalidate(deviceTypeA);
+
+    assertTrue(queue.pop(event));
+    assertTrue(event.deviceType == nullptr);
+    assertTrue(queue.pop(event));
+    assertTrue(event.deviceType == deviceTypeB);
+}
+
+test(EventQueueTest, mqtt_disabled_by_default) {
+    initMqttTest(testDeviceId)
+
+    HABinarySensor sensor(testUniqueId);
+
+    assertTrue(mqtt.getEventQueue() == nullptr);
+    assertFalse(sensor.setStateFromISR(true));
+    assertFalse(mqtt.enableEventQueue(0));
+    assertTrue(mqtt.enableEventQueue(4));
+    assertFalse(mqtt.enableEventQueue(4)); // already enabled
+}
+
+test(EventQueueTest, binary_sensor_published_in_loop) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableEventQueue(4);
+    HABinarySensor sensor(testUniqueId);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(sensor.setStateFromISR(true));
+    assertNoMqttMessage()
+    assertFalse(sensor.getCurrentState());
+
+    mqtt.loop();
+    assertSingleMqttMessage(stateTopic, "ON", true)
+    assertTrue(sensor.getCurrentState());
+}
+
+test(EventQueueTest, binary_sensor_edges_between_loops) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableEventQueue(4);
+    HABinarySensor sensor(testUniqueId);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    // short pulse that would be missed by polling
+    sensor.setStateFromISR(true);
+    sensor.setStateFromISR(false);
+    mqtt.loop();
+
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, stateTopic, "ON", true)
+    assertMqttMessage(1, stateTopic, "OFF", true)
+}
+
+test(EventQueueTest, binary_sensor_disconnected) {
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+
+    mqtt.enableEventQueue(4);
+    HABinarySensor sensor(testUniqueId);
+    sensor.setStateFromISR(true);
+    mqtt.loop();
+
+    // state is kept until the connection is acquired
+    assertNoMqttMessage()
+    assertTrue(sensor.getCurrentState());
+}
+
+test(EventQueueTest, device_trigger_published_in_loop) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableEventQueue(4);
+    HADeviceTrigger trigger("myType", "mySubtype");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(trigger.triggerFromISR());
+    assertNoMqttMessage()
+
+    mqtt.loop();
+    assertSingleMqttMessage(triggerTopic, "", false)
+}
+
+test(EventQueueTest, destroyed_entity_is_skipped) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableEventQueue(4);
+    mqtt.loop();
+
+    {
+        HABinarySensor sensor(testUniqueId);
+        sensor.setStateFromISR(true);
+    }
+
+    mock->clearFlushedMessages();
+    mqtt.loop();
+    assertNoMqttMessage()
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
@@ -0,0 +1,201 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define initFailoverTest(maxBrokersNb, maxFailedAttemptsNb) \
+    PubSubClientMock* mock = new PubSubClientMock(); \
+    HADevice device(testDeviceId); \
+    HAMqtt mqtt(mock, device, 2); \
+    mqtt.setDataPrefix("testData"); \
+    mqtt.onBrokerSwitched(onBrokerSwitched); \
+    switchesNb = 0; \
+    assertTrue(mqtt.enableFailover(maxBrokersNb, maxFailedAttemptsNb));
+
+#define retryConnection() \
+    mqtt.disconnect(); \
+    mqtt.begin("primary"); \
+    mqtt.loop();
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* configTopic = "homeassistant/switch/testDevice/relay/config";
+static uint8_t switchesNb = 0;
+
+void onBrokerSwitched()
+{
+    switchesNb++;
+}
+
+test(FailoverTest, disabled_by_default) {
+    initMqttTest(testDeviceId)
+
+    assertEqual((uint8_t)0, mqtt.getBrokersNb());
+    assertFalse(mqtt.addBroker("backup"));
+    assertFalse(mqtt.enableFailover(2)); // already initialized
+}
+
+test(FailoverTest, brokers_limit) {
+    initFailoverTest(2, 1)
+
+    assertFalse(mqtt.enableFailover(3));
+    assertTrue(mqtt.addBroker("backup"));
+    assertFalse(mqtt.addBroker("backup2"));
+    assertEqual((uint8_t)2, mqtt.getBrokersNb());
+}
+
+test(FailoverTest, invalid_params) {
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+
+    assertFalse(mqtt.enableFailover(1));
+    assertFalse(mqtt.enableFailover(2, 0));
+    assertFalse(mqtt.addBroker(nullptr));
+}
+
+test(FailoverTest, switch_after_failed_attempts) {
+    initFailoverTest(2, 2)
+    mqtt.addBroker("backup", 1884);
+    mock->setUnreachableHost("primary");
+
+    mqtt.begin("primary");
+    mqtt.loop();
+    assertFalse(mqtt.isConnected());
+    assertEqual((uint8_t)0, mqtt.getActiveBroker());
+    assertEqual((uint8_t)0, switchesNb);
+
+    retryConnection()
+    assertFalse(mqtt.isConnected());
+    assertEqual((uint8_t)1, mqtt.getActiveBroker());
+    assertEqual((uint8_t)1, switchesNb);
+
+    // the new broker is tried immediately
+    mqtt.loop();
+    assertTrue(mqtt.isConnected());
+    assertStringCaseEqual("backup", mock->getConnection().domain);
+    assertEqual((uint16_t)1884, mock->getConnection().port);
+    assertEqual((uint16_t)3, mock->getConnectAttemptsNb());
+}
+
+test(FailoverTest, republish_to_new_broker) {
+    initFailoverTest(2, 1)
+    mqtt.addBroker("backup");
+    mock->setUnreachableHost("primary");
+    HASwitch sw("relay");
+
+    mqtt.begin("primary");
+    mqtt.loop();
+    assertNoMqttMessage()
+
+    mqtt.loop();
+    assertTrue(mqtt.isConnected());
+    assertTrue(mock->getFlushedMessagesNb() > 0);
+    assertStringCaseEqual(configTopic, mock->getFlushedMessages()[0].topic);
+}
+
+test(FailoverTest, wrap_around_to_ip_broker) {
+    initFailoverTest(3, 1)
+    mqtt.addBroker("backup");
+    mqtt.addBroker(IPAddress(192, 168, 1, 2), 1885);
+    mock->setUnreachableHost("backup");
+    mqtt.begin("primary");
+    mqtt.loop();
+    assertTrue(mqtt.isConnected());
+
+    // primary goes down
+    mock->setUnreachableHost("primary");
+    mock->disconnect();
+    retryConnection()
+    assertEqual((uint8_t)1, mqtt.getActiveBroker());
+
+    // backup is unreachable too
+    mock->setUnreachableHost("backup");
+    mqtt.loop();
+    assertEqual((uint8_t)2, mqtt.getActiveBroker());
+
+    mqtt.loop();
+    assertTrue(mqtt.isConnected());
+    assertTrue(mock->getConnection().domain == nullptr);
+    assertTrue(mock->getConnection().ip == IPAddress(192, 168, 1, 2));
+    assertEqual((uint16_t)1885, mock->getConnection().port);
+    assertEqual((uint8_t)2, switchesNb);
+}
+
+test(FailoverTest, success_resets_attempts) {
+    initFailoverTest(2, 2)
+    mqtt.addBroker("backup");
+    mock->setUnreachableHost("primary");
+
+    mqtt.begin("primary");
+    mqtt.loop();
+
+    mock->setUnreachableHost(nullptr);
+    retryConnection()
+    assertTrue(mqtt.isConnected());
+
+    mock->setUnreachableHost("primary");
+    mock->disconnect();
+    retryConnection()
+    assertEqual((uint8_t)0, mqtt.getActiveBroker());
+    assertEqual((uint8_t)0, switchesNb);
+}
+
+test(FailoverTest, standby_connects_to_next_broker) {
+    PubSubClientMock standby;
+    initFailoverTest(2, 3)
+    mqtt.addBroker("backup");
+    assertTrue(mqtt.setStandbyTransport(standby));
+    assertFalse(mqtt.setStandbyTransport(standby));
+    HASwitch sw("relay");
+
+    mqtt.begin("primary");
+    mqtt.loop();
+
+    assertTrue(mock->connected());
+    assertStringCaseEqual("primary", mock->getConnection().domain);
+    assertTrue(standby.connected());
+    assertStringCaseEqual("backup", standby.getConnection().domain);
+    assertEqual((uint8_t)0, standby.getFlushedMessagesNb());
+    assertEqual((uint8_t)0, standby.getSubscriptionsNb());
+}
+
+test(FailoverTest, standby_promotion) {
+    PubSubClientMock standby;
+    initFailoverTest(2, 3)
+    mqtt.addBroker("backup");
+    mqtt.setStandbyTransport(standby);
+    HASwitch sw("relay");
+
+    mqtt.begin("primary");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    // the primary connection is lost, the standby takes over without waiting
+    mock->disconnect();
+    mqtt.loop();
+
+    assertTrue(mqtt.isConnected());
+    assertEqual((uint8_t)1, mqtt.getActiveBroker());
+    assertEqual((uint8_t)1, switchesNb);
+    assertTrue(mqtt.getStandbyTransport() == mock);
+    assertTrue(standby.getFlushedMessagesNb() > 0);
+    assertStringCaseEqual(configTopic, standby.getFlushedMessages()[0].topic);
+    assertTrue(standby.getSubscriptionsNb() > 0);
+    assertNoMqttMessage()
+
+    // the previous transport becomes the standby of the primary broker
+    assertTrue(mock->connected());
+    assertStringCaseEqual("primary", mock->getConnection().domain);
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
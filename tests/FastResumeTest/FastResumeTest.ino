@@ -0,0 +1,404 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* sessionPath = "fast_resume.session";
+
+struct WakeResult
+{
+    uint8_t messagesNb;
+    uint32_t publishedBytesNb;
+    bool resumed;
+    bool cleanSession;
+};
+
+static const char* availabilityTopic = "testData/testDevice/avty_t";
+static HASensorInteger* wakeSensor = nullptr;
+static int32_t wakeValue = 0;
+
+static void onWakeConnected()
+{
+    // values set while the connection is being resumed are compared with the session
+    wakeSensor->setValue(wakeValue);
+}
+
+/**
+ * Simulates a single wake up: boot, connect, publish the sensor's value and save the session.
+ */
+static WakeResult wakeUp(
+    HASessionStorage& storage,
+    const int32_t value,
+    const uint32_t configVersion = 0,
+    const char* sensorName = nullptr
+)
+{
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+    mqtt.setDataPrefix("testData");
+    device.enableSharedAvailability();
+
+    HASensorInteger sensor("temp");
+    HASwitch relay("relay");
+    sensor.setName(sensorName);
+    wakeSensor = &sensor;
+    wakeValue = value;
+    mqtt.onConnected(onWakeConnected);
+    mqtt.enableFastResume(storage, 8, configVersion);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mqtt.saveSession();
+
+    WakeResult result;
+    result.messagesNb = mock->getFlushedMessagesNb();
+    result.publishedBytesNb = mock->getPublishedBytesNb();
+    result.resumed = mqtt.isResumed();
+    result.cleanSession = mock->getConnection().cleanSession;
+
+    return result;
+}
+
+static const char tableDoorId[] PROGMEM = "door";
+static const char tableSpareId[] PROGMEM = "spare";
+static const HAEntityDescriptor tableEntities[] PROGMEM = {
+    {tableDoorId, HAEntityTable::BinarySensor, HAEntityTable::EnabledByDefault},
+    {tableSpareId, HAEntityTable::Switch, 0}
+};
+
+/**
+ * Simulates a single wake up of the device with the entity table.
+ */
+static WakeResult wakeUpTable(HASessionStorage& storage, const bool spareEnabled)
+{
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+    mqtt.setDataPrefix("testData");
+
+    HAEntityTable table(tableEntities, 2);
+    table.setEnabled(1, spareEnabled);
+    mqtt.enableFastResume(storage, 8);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mqtt.saveSession();
+
+    WakeResult result;
+    result.messagesNb = mock->getFlushedMessagesNb();
+    result.publishedBytesNb = mock->getPublishedBytesNb();
+    result.resumed = mqtt.isResumed();
+    result.cleanSession = mock->getConnection().cleanSession;
+
+    return result;
+}
+
+test(FastResumeTest, disabled_by_default) {
+    initMqttTest(testDeviceId)
+
+    mqtt.loop();
+    assertTrue(mqtt.getSessionState() == nullptr);
+    assertTrue(mock->getConnection().cleanSession);
+    assertFalse(mqtt.isResumed());
+    assertFalse(mqtt.saveSession());
+}
+
+test(FastResumeTest, enable_before_begin) {
+    FileSessionStorageMock storage(sessionPath);
+    initMqttTest(testDeviceId)
+
+    assertFalse(mqtt.enableFastResume(storage, 4));
+}
+
+test(FastResumeTest, first_wake_publishes_everything) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    const WakeResult result = wakeUp(storage, 21);
+    storage.erase();
+
+    // availability, two configs, initial states and the new value of the sensor
+    assertEqual((uint8_t)6, result.messagesNb);
+    assertFalse(result.resumed);
+    assertFalse(result.cleanSession);
+}
+
+test(FastResumeTest, resume_publishes_changed_values_only) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    wakeUp(storage, 21);
+    const WakeResult changed = wakeUp(storage, 22);
+    const WakeResult unchanged = wakeUp(storage, 22);
+    storage.erase();
+
+    // the availability is always published
+    assertTrue(changed.resumed);
+    assertEqual((uint8_t)2, changed.messagesNb);
+    assertTrue(unchanged.resumed);
+    assertEqual((uint8_t)1, unchanged.messagesNb);
+    assertEqual((uint16_t)3, storage.getWritesNb());
+}
+
+test(FastResumeTest, resumed_value_message) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+    wakeUp(storage, 21);
+
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+    mqtt.setDataPrefix("testData");
+    HASensorInteger sensor("temp");
+    HASwitch relay("relay");
+    device.enableSharedAvailability();
+    wakeSensor = &sensor;
+    wakeValue = 25;
+    mqtt.onConnected(onWakeConnected);
+    mqtt.enableFastResume(storage, 8);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    storage.erase();
+
+    assertTrue(mqtt.isResumed());
+    assertEqual((uint8_t)2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, "testData/testDevice/temp/stat_t", "25", true)
+    assertMqttMessage(1, availabilityTopic, "online", true)
+}
+
+test(FastResumeTest, availability_after_last_will) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+    wakeUp(storage, 21);
+
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+    mqtt.setDataPrefix("testData");
+    HASensorInteger sensor("temp");
+    HASwitch relay("relay");
+    device.enableSharedAvailability();
+    device.enableLastWill();
+    wakeSensor = &sensor;
+    wakeValue = 21;
+    mqtt.onConnected(onWakeConnected);
+    mqtt.enableFastResume(storage, 8);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    storage.erase();
+
+    // the broker published "offline" while the device was sleeping
+    assertTrue(mqtt.isResumed());
+    assertEqual(availabilityTopic, mock->getLastWill().topic);
+    assertSingleMqttMessage(availabilityTopic, "online", true)
+}
+
+test(FastResumeTest, repeated_values_after_resume) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    for (uint8_t i = 0; i < 2; i++) {
+        PubSubClientMock* mock = new PubSubClientMock();
+        HADevice device(testDeviceId);
+        HAMqtt mqtt(mock, device);
+        mqtt.setDataPrefix("testData");
+        HASensorInteger sensor("temp");
+        HATagScanner scanner("scanner");
+        mqtt.enableFastResume(storage, 8);
+        mqtt.begin("testHost");
+        mqtt.loop();
+        mock->clearFlushedMessages();
+
+        assertTrue(scanner.tagScanned("abc"));
+        assertTrue(scanner.tagScanned("abc"));
+        assertTrue(sensor.setValue(0, true));
+        mqtt.saveSession();
+
+        // the values set after the connection are never suppressed
+        assertEqual(i == 1, mqtt.isResumed());
+        assertEqual((uint8_t)3, mock->getFlushedMessagesNb());
+        assertMqttMessage(0, "testData/testDevice/scanner/t", "abc", false)
+        assertMqttMessage(1, "testData/testDevice/scanner/t", "abc", false)
+        assertMqttMessage(2, "testData/testDevice/temp/stat_t", "0", true)
+    }
+
+    storage.erase();
+}
+
+test(FastResumeTest, config_version_change) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    wakeUp(storage, 21, 1);
+    const WakeResult result = wakeUp(storage, 21, 2);
+    storage.erase();
+
+    assertFalse(result.resumed);
+    assertEqual((uint8_t)6, result.messagesNb);
+}
+
+test(FastResumeTest, table_entity_enabled) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    wakeUpTable(storage, false);
+    const WakeResult unchanged = wakeUpTable(storage, false);
+    const WakeResult enabled = wakeUpTable(storage, true);
+    storage.erase();
+
+    // the enabled entity needs its config, so the discovery is published again
+    assertTrue(unchanged.resumed);
+    assertFalse(enabled.resumed);
+    assertEqual((uint8_t)4, enabled.messagesNb);
+}
+
+test(FastResumeTest, config_change_of_the_same_size) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    wakeUp(storage, 21, 0, "Kitchen");
+    const WakeResult result = wakeUp(storage, 21, 0, "Bedroom");
+    storage.erase();
+
+    assertFalse(result.resumed);
+    assertEqual((uint8_t)6, result.messagesNb);
+}
+
+test(FastResumeTest, corrupted_storage) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+    wakeUp(storage, 21);
+
+    uint8_t data[32];
+    assertTrue(storage.read(data, sizeof(data)));
+    data[8] ^= 0xFF;
+    assertTrue(storage.write(data, sizeof(data)));
+
+    const WakeResult result = wakeUp(storage, 21);
+    storage.erase();
+
+    assertFalse(result.resumed);
+    assertEqual((uint8_t)6, result.messagesNb);
+}
+
+test(FastResumeTest, power_loss) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+    wakeUp(storage, 21);
+
+    storage.erase();
+    const WakeResult result = wakeUp(storage, 21);
+    storage.erase();
+
+    assertFalse(result.resumed);
+    assertEqual((uint8_t)6, result.messagesNb);
+}
+
+test(FastResumeTest, reconnect_publishes_everything) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+    wakeUp(storage, 21);
+
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+    mqtt.setDataPrefix("testData");
+    HASensorInteger sensor("temp");
+    HASwitch relay("relay");
+    device.enableSharedAvailability();
+    wakeSensor = &sensor;
+    wakeValue = 21;
+    mqtt.onConnected(onWakeConnected);
+    mqtt.enableFastResume(storage, 8);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    assertTrue(mqtt.isResumed());
+    assertSingleMqttMessage(availabilityTopic, "online", true)
+
+    mock->clearFlushedMessages();
+    mock->disconnect();
+    mqtt.disconnect();
+    mqtt.begin("testHost");
+    mqtt.loop();
+    storage.erase();
+
+    assertFalse(mqtt.isResumed());
+    assertEqual((uint8_t)5, mock->getFlushedMessagesNb());
+}
+
+test(FastResumeTest, session_state_limit) {
+    FileSessionStorageMock storage(sessionPath, 32);
+    storage.erase();
+    HASessionState state(3);
+
+    state.setFingerprint(123);
+    assertTrue(state.set(1, 10));
+    assertTrue(state.set(2, 20));
+    assertTrue(state.set(1, 11));
+    assertTrue(state.set(3, 30));
+    assertFalse(state.set(4, 40));
+    assertEqual((uint16_t)35, state.calculateSize());
+
+    // 35 bytes don't fit the storage
+    assertFalse(state.save(storage));
+    assertFalse(state.load(storage));
+    storage.erase();
+}
+
+test(FastResumeTest, session_state_roundtrip) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    HASessionState state(4);
+    state.setFingerprint(123);
+    state.set(1, 10);
+    state.set(2, 20);
+    assertTrue(state.save(storage));
+
+    HASessionState restored(4);
+    assertTrue(restored.load(storage));
+    storage.erase();
+
+    assertEqual((uint32_t)123, restored.getFingerprint());
+    assertEqual((uint8_t)2, restored.getValuesNb());
+    assertTrue(restored.isUnchanged(1, 10));
+    assertTrue(restored.isUnchanged(2, 20));
+    assertFalse(restored.isUnchanged(2, 21));
+    assertFalse(restored.isUnchanged(3, 30));
+}
+
+test(FastResumeTest, wake_benchmark) {
+    FileSessionStorageMock storage(sessionPath);
+    storage.erase();
+
+    // the air time dominates the wake up, so the bytes are compared instead of the host's time
+    const WakeResult cold = wakeUp(storage, 21);
+    const WakeResult resumed = wakeUp(storage, 22);
+    storage.erase();
+
+    Serial.print(F("cold wake: "));
+    Serial.print(cold.messagesNb);
+    Serial.print(F(" messages, "));
+    Serial.print(cold.publishedBytesNb);
+    Serial.println(F(" B"));
+    Serial.print(F("resumed wake: "));
+    Serial.print(resumed.messagesNb);
+    Serial.print(F(" messages, "));
+    Serial.print(resumed.publishedBytesNb);
+    Serial.println(F(" B"));
+
+    // the availability is published on each wake up, so it's the floor of the resumed wake
+    assertTrue(resumed.publishedBytesNb * 5 < cold.publishedBytesNb);
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
@@ -0,0 +1,316 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define initGatewayTest(maxDevicesNb) \
+    initMqttTest(testDeviceId) \
+    initGatewayNodes(maxDevicesNb)
+
+#define initGatewayNodes(maxDevicesNb) \
+    assertTrue(mqtt.enableGatewayMode(maxDevicesNb)); \
+    HADevice node1("node1"); \
+    HADevice node2("node2");
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static HASwitch* lastSwitch = nullptr;
+
+void onSwitchCommand(bool state, HASwitch* sender)
+{
+    (void)state;
+    lastSwitch = sender;
+}
+
+test(GatewayTest, disabled_by_default) {
+    initMqttTest(testDeviceId)
+    HADevice node1("node1");
+    HASwitch sw("relay1");
+
+    assertFalse(mqtt.isGatewayModeEnabled());
+    assertFalse(sw.setDevice(node1));
+    assertTrue(sw.setDevice(device));
+    assertTrue(sw.getDevice() == &device);
+}
+
+test(GatewayTest, devices_limit) {
+    initGatewayTest(1)
+    HASwitch sw1("relay1");
+    HASwitch sw2("relay2");
+    HASwitch sw3("relay3");
+
+    assertFalse(mqtt.enableGatewayMode(2));
+    assertTrue(sw1.setDevice(node1));
+    assertTrue(sw2.setDevice(node1));
+    assertFalse(sw3.setDevice(node2));
+    assertEqual((uint16_t)1, mqtt.getDevicesNb());
+    assertTrue(sw1.getDevice() == &node1);
+    assertTrue(sw3.getDevice() == &device);
+}
+
+test(GatewayTest, config_uses_own_device) {
+    static const char* configTopic = "homeassistant/switch/node1/relay1/config";
+    initGatewayTest(2)
+
+    HASwitch sw("relay1");
+    assertTrue(sw.setDevice(node1));
+    assertEntityConfig(
+        mock,
+        sw,
+        "{\"uniq_id\":\"relay1\",\"opt\":false,\"dev\":{\"ids\":\"node1\"},\"stat_t\":\"testData/node1/relay1/stat_t\",\"cmd_t\":\"testData/node1/relay1/cmd_t\"}"
+    )
+}
+
+test(GatewayTest, state_uses_own_device) {
+    initGatewayTest(2)
+
+    HASwitch sw1("relay1");
+    HASwitch sw2("relay2");
+    sw1.setDevice(node1);
+    sw2.setDevice(node2);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(sw2.setState(true));
+    assertSingleMqttMessage("testData/node2/relay2/stat_t", "ON", true)
+}
+
+test(GatewayTest, command_routing) {
+    initGatewayTest(2)
+
+    lastSwitch = nullptr;
+    HASwitch sw1("relay");
+    HASwitch sw2("relay2");
+    sw1.setDevice(node1);
+    sw2.setDevice(node2);
+    sw1.onCommand(onSwitchCommand);
+    sw2.onCommand(onSwitchCommand);
+    mqtt.loop();
+
+    assertEqual(2, mock->getSubscriptionsNb());
+    assertStringCaseEqual(
+        "testData/node1/relay/cmd_t",
+        mock->getSubscriptions()[0].topic
+    );
+
+    mock->fakeMessage("testData/testDevice/relay/cmd_t", "ON");
+    assertTrue(lastSwitch == nullptr);
+
+    mock->fakeMessage("testData/node2/relay2/cmd_t", "ON");
+    assertTrue(lastSwitch == &sw2);
+}
+
+test(GatewayTest, command_wildcard_per_device) {
+    initMqttTestWithoutBegin(testDeviceId)
+    assertTrue(mqtt.setCommandWildcard(true));
+    mqtt.begin("testHost", "testUser", "testPass");
+    initGatewayNodes(2)
+
+    lastSwitch = nullptr;
+    HASwitch sw0("relay0");
+    HASwitch sw1("relay1");
+    HASwitch sw2("relay2");
+    sw1.setDevice(node1);
+    sw2.setDevice(node2);
+    sw1.onCommand(onSwitchCommand);
+    mqtt.loop();
+
+    assertEqual(3, mock->getSubscriptionsNb());
+    assertStringCaseEqual(
+        "testData/testDevice/+/cmd_t",
+        mock->getSubscriptions()[0].topic
+    );
+    assertStringCaseEqual(
+        "testData/node1/+/cmd_t",
+        mock->getSubscriptions()[1].topic
+    );
+    assertStringCaseEqual(
+        "testData/node2/+/cmd_t",
+        mock->getSubscriptions()[2].topic
+    );
+
+    mock->fakeMessage("testData/node1/relay1/cmd_t", "OFF");
+    assertTrue(lastSwitch == &sw1);
+}
+
+test(GatewayTest, shared_availability_per_device) {
+    initGatewayTest(2)
+    assertTrue(node1.enableSharedAvailability());
+    node1.setAvailability(false);
+
+    HASwitch sw("relay1");
+    sw.setDevice(node1);
+    mqtt.loop();
+
+    assertStringCaseEqual("testData/node1/avty_t", node1.getAvailabilityTopic());
+    assertMqttMessage(0, "testData/node1/avty_t", "offline", true)
+    assertMqttMessage(
+        1,
+        "homeassistant/switch/node1/relay1/config",
+        "{\"uniq_id\":\"relay1\",\"opt\":false,\"dev\":{\"ids\":\"node1\"},\"avty_t\":\"testData/node1/avty_t\",\"stat_t\":\"testData/node1/relay1/stat_t\",\"cmd_t\":\"testData/node1/relay1/cmd_t\"}",
+        true
+    )
+}
+
+test(GatewayTest, remove_device) {
+    initGatewayTest(2)
+
+    HASwitch sw1("relay1");
+    HASwitch sw2("relay2");
+    sw1.setDevice(node1);
+    sw2.setDevice(node2);
+
+    assertTrue(mqtt.removeDevice(node1));
+    assertFalse(mqtt.removeDevice(node1));
+    assertFalse(mqtt.removeDevice(device));
+    assertEqual((uint16_t)1, mqtt.getDevicesNb());
+    assertTrue(node1.mqtt() == nullptr);
+    assertTrue(sw1.mqtt() == nullptr);
+    assertTrue(sw2.mqtt() == &mqtt);
+
+    // the entities of the removed device are not published anymore
+    mqtt.loop();
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertStringCaseEqual(
+        "homeassistant/switch/node2/relay2/config",
+        mock->getFlushedMessages()[0].topic
+    );
+}
+
+test(GatewayTest, destroyed_device_unregistered) {
+    initGatewayTest(2)
+
+    HASwitch sw("relay1");
+    HADevice* node = new HADevice("node3");
+    assertTrue(sw.setDevice(*node));
+    assertEqual((uint16_t)1, mqtt.getDevicesNb());
+
+    delete node;
+    assertEqual((uint16_t)0, mqtt.getDevicesNb());
+    assertTrue(sw.mqtt() == nullptr);
+
+    mqtt.loop();
+    assertNoMqttMessage()
+}
+
+test(GatewayTest, device_types_limit) {
+    static const uint16_t maxDevicesTypesNb = 300;
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device, maxDevicesTypesNb);
+
+    HABinarySensor* sensors[maxDevicesTypesNb + 1];
+    for (uint16_t i = 0; i <= maxDevicesTypesNb; i++) {
+        sensors[i] = new HABinarySensor("sensor");
+    }
+
+    // the limit is not truncated to 8 bits and the overflow is reported
+    assertEqual(maxDevicesTypesNb, mqtt.getDevicesTypesNb());
+    assertTrue(sensors[maxDevicesTypesNb - 1]->mqtt() == &mqtt);
+    assertTrue(sensors[maxDevicesTypesNb]->mqtt() == nullptr);
+    assertFalse(mqtt.addDeviceType(sensors[maxDevicesTypesNb]));
+
+    delete sensors[0];
+    assertTrue(mqtt.addDeviceType(sensors[maxDevicesTypesNb]));
+
+    for (uint16_t i = 1; i <= maxDevicesTypesNb; i++) {
+        delete sensors[i];
+    }
+
+    assertEqual((uint16_t)0, mqtt.getDevicesTypesNb());
+}
+
+test(GatewayTest, set_device_with_full_owner) {
+    initGatewayTest(2)
+
+    // the other gateway owns the node and it can't take more device types
+    PubSubClientMock* otherMock = new PubSubClientMock();
+    HADevice otherDevice("otherDevice");
+    HAMqtt other(otherMock, otherDevice, 1);
+    assertTrue(other.enableGatewayMode(2));
+    HASwitch otherSwitch("otherRelay");
+    assertTrue(other.addDevice(node1));
+
+    HASwitch sw("relay1");
+    assertTrue(mqtt.addDeviceType(&sw));
+    assertFalse(sw.setDevice(node1));
+
+    assertTrue(sw.mqtt() == &mqtt);
+    assertEqual((uint16_t)1, other.getDevicesNb());
+    assertEqual((uint16_t)0, mqtt.getDevicesNb());
+}
+
+test(GatewayTest, scaling_benchmark) {
+    static const uint16_t steps[] = {1, 32, 200, 250};
+    static const uint16_t maxNodesNb = 250;
+    char ids[maxNodesNb][8];
+
+    for (uint8_t step = 0; step < sizeof(steps) / sizeof(steps[0]); step++) {
+        const uint16_t nodesNb = steps[step];
+        PubSubClientMock* mock = new PubSubClientMock();
+        HADevice device(testDeviceId);
+        HAMqtt mqtt(mock, device, nodesNb);
+        mqtt.setDataPrefix("testData");
+        mqtt.enableGatewayMode(nodesNb);
+        mqtt.begin("testHost");
+
+        HADevice* nodes[maxNodesNb];
+        HASwitch* switches[maxNodesNb];
+        for (uint16_t i = 0; i < nodesNb; i++) {
+            memset(ids[i], 0, sizeof(ids[i]));
+            ids[i][0] = 'n';
+            HAUtils::numberToStr(&ids[i][1], i);
+
+            nodes[i] = new HADevice(ids[i]);
+            nodes[i]->enableSharedAvailability();
+            switches[i] = new HASwitch(ids[i]);
+            assertTrue(switches[i]->setDevice(*nodes[i]));
+        }
+
+        uint32_t startedAt = micros();
+        mqtt.loop();
+        const uint32_t connectTime = micros() - startedAt;
+
+        // availability, config and state of each node
+        assertEqual(nodesNb * 3, (int)mock->getFlushedMessagesNb());
+        const uint32_t connectBytes = mock->getPublishedBytesNb();
+        mock->clearFlushedMessages();
+
+        startedAt = micros();
+        for (uint16_t i = 0; i < nodesNb; i++) {
+            switches[i]->setState(true);
+        }
+        const uint32_t publishTime = micros() - startedAt;
+        assertEqual(nodesNb, mock->getFlushedMessagesNb());
+
+        Serial.print(F("gateway with "));
+        Serial.print(nodesNb);
+        Serial.print(F(" nodes, connect [us]: "));
+        Serial.print(connectTime);
+        Serial.print(F(", connect [B]: "));
+        Serial.print(connectBytes);
+        Serial.print(F(", states burst [us]: "));
+        Serial.print(publishTime);
+        Serial.print(F(", RAM per node [B]: "));
+        Serial.println(
+            sizeof(HADevice) + sizeof(HASwitch) + sizeof(HADevice*) +
+            sizeof(HABaseDeviceType*) + strlen(nodes[0]->getAvailabilityTopic()) + 1
+        );
+
+        for (uint16_t i = 0; i < nodesNb; i++) {
+            delete switches[i];
+            delete nodes[i];
+        }
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
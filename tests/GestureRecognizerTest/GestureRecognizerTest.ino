@@ -0,0 +1,153 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define initGestureTest() \
+    initMqttTest(testDeviceId) \
+    mock->connectDummy(); \
+    memset(levels, 0, sizeof(levels)); \
+    now = 0; \
+    HAGestureRecognizer<2, 10> recognizer; \
+    recognizer.onRead(readLevel);
+
+#define bindTrigger(name, button, type, subtype) \
+    HADeviceTrigger name(HADeviceTrigger::type, HADeviceTrigger::subtype); \
+    recognizer.bind(button, &name);
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static bool levels[2];
+static uint32_t now;
+
+bool readLevel(uint8_t button)
+{
+    return levels[button];
+}
+
+void hold(HABaseGestureRecognizer& recognizer, uint8_t button, bool level, uint32_t duration)
+{
+    levels[button] = level;
+
+    const uint32_t end = now + duration;
+    while (now < end) {
+        recognizer.tick(now);
+        now += 5;
+    }
+}
+
+void click(HABaseGestureRecognizer& recognizer, uint8_t button)
+{
+    hold(recognizer, button, true, 100);
+    hold(recognizer, button, false, 100);
+}
+
+test(GestureRecognizerTest, bind_limits) {
+    initGestureTest()
+
+    HADeviceTrigger trigger(HADeviceTrigger::ButtonShortPressType, HADeviceTrigger::Button1Subtype);
+    assertFalse(recognizer.bind(2, &trigger));
+    assertFalse(recognizer.bind(0, nullptr));
+    assertTrue(recognizer.bind(0, &trigger));
+}
+
+test(GestureRecognizerTest, bounce_is_ignored) {
+    initGestureTest()
+    bindTrigger(shortPress, 0, ButtonShortPressType, Button1Subtype)
+
+    for (uint8_t i = 0; i < 10; i++) {
+        hold(recognizer, 0, i % 2 == 0, 10);
+    }
+
+    hold(recognizer, 0, false, 1000);
+    assertNoMqttMessage()
+}
+
+test(GestureRecognizerTest, short_press) {
+    initGestureTest()
+    bindTrigger(shortPress, 0, ButtonShortPressType, Button1Subtype)
+    bindTrigger(shortRelease, 0, ButtonShortReleaseType, Button1Subtype)
+
+    click(recognizer, 0);
+    assertNoMqttMessage() // waiting for the next press
+
+    hold(recognizer, 0, false, 500);
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, "testData/testDevice/button_short_press_button_1/t", "", false)
+    assertMqttMessage(1, "testData/testDevice/button_short_release_button_1/t", "", false)
+}
+
+test(GestureRecognizerTest, double_press) {
+    initGestureTest()
+    bindTrigger(shortPress, 0, ButtonShortPressType, Button1Subtype)
+    bindTrigger(doublePress, 0, ButtonDoublePressType, Button1Subtype)
+
+    click(recognizer, 0);
+    click(recognizer, 0);
+    hold(recognizer, 0, false, 500);
+
+    assertSingleMqttMessage("testData/testDevice/button_double_press_button_1/t", "", false)
+}
+
+test(GestureRecognizerTest, quintuple_press) {
+    initGestureTest()
+    bindTrigger(quintuplePress, 0, ButtonQuintuplePressType, Button1Subtype)
+
+    for (uint8_t i = 0; i < 6; i++) {
+        click(recognizer, 0);
+    }
+
+    hold(recognizer, 0, false, 500);
+    assertSingleMqttMessage("testData/testDevice/button_quintuple_press_button_1/t", "", false)
+}
+
+test(GestureRecognizerTest, long_press_and_release) {
+    initGestureTest()
+    bindTrigger(shortPress, 0, ButtonShortPressType, Button1Subtype)
+    bindTrigger(longPress, 0, ButtonLongPressType, Button1Subtype)
+    bindTrigger(longRelease, 0, ButtonLongReleaseType, Button1Subtype)
+
+    hold(recognizer, 0, true, 1100);
+    assertSingleMqttMessage("testData/testDevice/button_long_press_button_1/t", "", false)
+
+    hold(recognizer, 0, false, 1000);
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(1, "testData/testDevice/button_long_release_button_1/t", "", false)
+}
+
+test(GestureRecognizerTest, custom_timings) {
+    initGestureTest()
+    recognizer.setMultiPressTime(150);
+    bindTrigger(shortPress, 0, ButtonShortPressType, Button1Subtype)
+
+    click(recognizer, 0);
+    hold(recognizer, 0, false, 100);
+    assertSingleMqttMessage("testData/testDevice/button_short_press_button_1/t", "", false)
+}
+
+test(GestureRecognizerTest, independent_buttons) {
+    initGestureTest()
+    bindTrigger(firstDouble, 0, ButtonDoublePressType, Button1Subtype)
+    bindTrigger(secondShort, 1, ButtonShortPressType, Button2Subtype)
+
+    levels[1] = true;
+    click(recognizer, 0);
+    levels[1] = false;
+    click(recognizer, 0);
+    hold(recognizer, 0, false, 500);
+
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(0, "testData/testDevice/button_short_press_button_2/t", "", false)
+    assertMqttMessage(1, "testData/testDevice/button_double_press_button_1/t", "", false)
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
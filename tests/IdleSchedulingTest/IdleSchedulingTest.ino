@@ -0,0 +1,212 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define initIdleTest() \
+    HAUtils::setSimulatedTime(startTime); \
+    initMqttTest(testDeviceId)
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const uint32_t startTime = 1000;
+static const uint32_t hour = 3600000;
+
+struct WakeStats
+{
+    uint32_t wakesNb;
+    uint32_t publishedNb;
+};
+
+/**
+ * Simulates one hour of the node that sleeps between deadlines of the HAMqtt
+ * and samples the sensor every `sampleInterval` ms (zero means no sensor).
+ */
+static WakeStats simulateHour(const uint16_t keepAlive, const uint32_t sampleInterval)
+{
+    HAUtils::setSimulatedTime(startTime);
+
+    PubSubClientMock* mock = new PubSubClientMock();
+    mock->setKeepAlive(keepAlive);
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+    HASensorInteger sensor("temp");
+    mqtt.begin("testHost");
+
+    WakeStats stats = {0, 0};
+    uint32_t nextSampleAt = startTime;
+    int32_t value = 0;
+
+    while (HAUtils::now() < startTime + hour) {
+        stats.wakesNb++;
+        mqtt.loop();
+
+        const uint32_t now = HAUtils::now();
+        if (sampleInterval > 0 && now >= nextSampleAt) {
+            sensor.setValue(value++);
+            nextSampleAt += sampleInterval;
+        }
+
+        stats.publishedNb += mock->getFlushedMessagesNb();
+        mock->clearFlushedMessages();
+
+        uint32_t sleep = mqtt.getIdleTimeout();
+        if (sampleInterval > 0 && nextSampleAt - now < sleep) {
+            sleep = nextSampleAt - now;
+        }
+
+        HAUtils::advanceSimulatedTime(sleep > 0 ? sleep : 1);
+    }
+
+    HAUtils::disableSimulatedTime();
+    return stats;
+}
+
+test(IdleSchedulingTest, not_initialized) {
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(mock, device);
+
+    assertEqual((uint32_t)HAMqtt::NoIdleTimeout, mqtt.getIdleTimeout());
+}
+
+test(IdleSchedulingTest, connect_immediately) {
+    initIdleTest()
+
+    assertEqual((uint32_t)0, mqtt.getIdleTimeout());
+    HAUtils::disableSimulatedTime();
+}
+
+test(IdleSchedulingTest, reconnect_interval) {
+    initIdleTest()
+    mock->setUnreachableHost("testHost");
+
+    mqtt.loop();
+    assertEqual((uint32_t)HAMqtt::ReconnectInterval, mqtt.getIdleTimeout());
+
+    HAUtils::advanceSimulatedTime(2000);
+    assertEqual((uint32_t)3000, mqtt.getIdleTimeout());
+
+    HAUtils::advanceSimulatedTime(3000);
+    assertEqual((uint32_t)0, mqtt.getIdleTimeout());
+
+    mqtt.loop();
+    assertEqual((uint16_t)2, mock->getConnectAttemptsNb());
+    HAUtils::disableSimulatedTime();
+}
+
+test(IdleSchedulingTest, keepalive_ping_and_response) {
+    initIdleTest()
+
+    mqtt.loop();
+    assertTrue(mqtt.isConnected());
+    assertEqual((uint32_t)15001, mqtt.getIdleTimeout());
+
+    // the transport sends the ping
+    HAUtils::advanceSimulatedTime(15001);
+    mqtt.loop();
+    assertEqual((uint32_t)7500, mqtt.getIdleTimeout());
+
+    // the response is read
+    HAUtils::advanceSimulatedTime(7500);
+    mqtt.loop();
+    assertEqual((uint32_t)7501, mqtt.getIdleTimeout());
+    HAUtils::disableSimulatedTime();
+}
+
+test(IdleSchedulingTest, publish_does_not_postpone_ping) {
+    initIdleTest()
+    HASensorInteger sensor("temp");
+
+    mqtt.loop();
+    HAUtils::advanceSimulatedTime(10000);
+    sensor.setValue(10);
+
+    // there was no incoming packet, so the transport pings anyway
+    assertEqual((uint32_t)5001, mqtt.getIdleTimeout());
+    HAUtils::disableSimulatedTime();
+}
+
+test(IdleSchedulingTest, traffic_postpones_ping) {
+    initIdleTest()
+    HASensorInteger sensor("temp");
+
+    mqtt.loop();
+    HAUtils::advanceSimulatedTime(10000);
+    sensor.setValue(10);
+    mock->fakeMessage("testData/testDevice/other/cmd_t", "ON");
+
+    assertEqual((uint32_t)15001, mqtt.getIdleTimeout());
+    HAUtils::disableSimulatedTime();
+}
+
+test(IdleSchedulingTest, keepalive_disabled) {
+    initIdleTest()
+    mock->setKeepAlive(0);
+
+    mqtt.loop();
+    assertEqual((uint32_t)HAMqtt::NoIdleTimeout, mqtt.getIdleTimeout());
+    HAUtils::disableSimulatedTime();
+}
+
+test(IdleSchedulingTest, pending_events) {
+    initIdleTest()
+    HABinarySensor sensor("motion");
+    mqtt.enableEventQueue(2);
+
+    mqtt.loop();
+    assertTrue(sensor.setStateFromISR(true));
+    assertEqual((uint32_t)0, mqtt.getIdleTimeout());
+
+    mqtt.loop();
+    assertEqual((uint32_t)15001, mqtt.getIdleTimeout());
+    HAUtils::disableSimulatedTime();
+}
+
+test(IdleSchedulingTest, wakes_per_hour) {
+    static const struct {
+        uint16_t keepAlive;
+        uint32_t sampleInterval;
+        uint32_t maxWakesNb;
+    } configs[] = {
+        {15, 0, 480},
+        {60, 0, 120},
+        {15, 10000, 601},
+        {60, 60000, 121},
+        {300, 300000, 25}
+    };
+
+    for (uint8_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        const WakeStats stats = simulateHour(
+            configs[i].keepAlive,
+            configs[i].sampleInterval
+        );
+
+        Serial.print(F("keep alive [s]: "));
+        Serial.print(configs[i].keepAlive);
+        Serial.print(F(", sample interval [s]: "));
+        Serial.print(configs[i].sampleInterval / 1000);
+        Serial.print(F(", wakes per hour: "));
+        Serial.print(stats.wakesNb);
+        Serial.print(F(", messages per hour: "));
+        Serial.println(stats.publishedNb);
+
+        assertTrue(stats.wakesNb <= configs[i].maxWakesNb);
+
+        if (configs[i].sampleInterval > 0) {
+            // each sample is published
+            assertTrue(stats.publishedNb >= hour / configs[i].sampleInterval);
+        }
+    }
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
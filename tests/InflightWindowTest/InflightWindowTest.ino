@@ -0,0 +1,227 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* testUniqueId = "uniqueSensor";
+static const char* stateTopic = "testData/testDevice/uniqueSensor/stat_t";
+
+test(InflightWindowTest, acquire_release) {
+    HAInflightWindow window(2);
+
+    assertTrue(window.acquire(1) != nullptr);
+    assertTrue(window.acquire(2) != nullptr);
+    assertTrue(window.isFull());
+    assertTrue(window.acquire(3) == nullptr);
+    assertTrue(window.contains(2));
+
+    assertTrue(window.release(1));
+    assertFalse(window.release(1));
+    assertFalse(window.contains(1));
+    assertEqual((uint8_t)1, window.getMessagesNb());
+}
+
+test(InflightWindowTest, invalid_packet_id) {
+    HAInflightWindow window(2);
+
+    assertTrue(window.acquire(0) == nullptr);
+    assertFalse(window.release(0));
+    assertFalse(window.contains(0));
+}
+
+test(InflightWindowTest, send_order) {
+    HAInflightWindow window(3);
+
+    HAInflightMessage* first = window.acquire(1);
+    HAInflightMessage* second = window.acquire(2);
+    window.release(1);
+    HAInflightMessage* third = window.acquire(3); // reuses the first slot
+
+    assertTrue(third == first);
+    assertTrue(window.next(nullptr) == second);
+    assertTrue(window.next(second) == third);
+    assertTrue(window.next(third) == nullptr);
+}
+
+test(InflightWindowTest, mqtt_disabled_by_default) {
+    initMqttTest(testDeviceId)
+
+    assertTrue(mqtt.getInflightWindow() == nullptr);
+    assertFalse(mqtt.enableInflightWindow(0));
+    assertTrue(mqtt.enableInflightWindow(4));
+    assertFalse(mqtt.enableInflightWindow(4)); // already enabled
+    assertEqual((uint8_t)4, mqtt.getInflightWindow()->getSize());
+}
+
+test(InflightWindowTest, qos0_without_window) {
+    initMqttTest(testDeviceId)
+
+    HASensorInteger sensor(testUniqueId);
+    sensor.setQos(1);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(sensor.setValue(10));
+    assertSingleMqttMessage(stateTopic, "10", true)
+    assertEqual((uint8_t)0, mock->getFlushedMessages()[0].qos);
+}
+
+test(InflightWindowTest, qos1_publish) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(2);
+    HASensorInteger sensor(testUniqueId);
+    sensor.setQos(1);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(sensor.setValue(10));
+    assertSingleMqttMessage(stateTopic, "10", true)
+
+    const MqttMessage& message = mock->getFlushedMessages()[0];
+    assertEqual((uint8_t)1, message.qos);
+    assertTrue(message.packetId != 0);
+    assertFalse(message.duplicate);
+    assertTrue(mqtt.getInflightWindow()->contains(message.packetId));
+}
+
+test(InflightWindowTest, ack_releases_slot) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(2);
+    HASensorInteger sensor(testUniqueId);
+    sensor.setQos(1);
+    mqtt.loop();
+
+    const uint8_t messagesNb = mqtt.getInflightWindow()->getMessagesNb();
+    mock->clearFlushedMessages();
+    sensor.setValue(10);
+
+    const uint16_t packetId = mock->getFlushedMessages()[0].packetId;
+    assertEqual((uint8_t)(messagesNb + 1), mqtt.getInflightWindow()->getMessagesNb());
+
+    mock->fakeAck(packetId);
+    assertEqual(messagesNb, mqtt.getInflightWindow()->getMessagesNb());
+    assertFalse(mqtt.getInflightWindow()->contains(packetId));
+}
+
+test(InflightWindowTest, full_window_rejects_publish) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(1);
+    HASensorInteger sensor(testUniqueId);
+    sensor.setQos(1);
+    mqtt.loop(); // initial state occupies the only slot
+    mock->clearFlushedMessages();
+
+    assertFalse(sensor.setValue(10));
+    assertNoMqttMessage()
+}
+
+test(InflightWindowTest, unique_packet_ids) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(3);
+    HASensorInteger sensor(testUniqueId);
+    sensor.setQos(1);
+    mock->connectDummy();
+
+    assertTrue(sensor.setValue(1));
+    assertTrue(sensor.setValue(2));
+    assertTrue(sensor.setValue(3));
+
+    const MqttMessage* messages = mock->getFlushedMessages();
+    assertTrue(messages[0].packetId != messages[1].packetId);
+    assertTrue(messages[1].packetId != messages[2].packetId);
+    assertTrue(messages[0].packetId != messages[2].packetId);
+}
+
+test(InflightWindowTest, long_payload_fallback_to_qos0) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(1);
+    HASensor sensor(testUniqueId);
+    sensor.setQos(1);
+    mock->connectDummy();
+
+    assertTrue(sensor.setValue("payloadLongerThanSlot"));
+    assertEqual((uint8_t)0, mock->getFlushedMessages()[0].qos);
+    assertEqual((uint8_t)0, mqtt.getInflightWindow()->getMessagesNb());
+}
+
+test(InflightWindowTest, retransmit_on_reconnect) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(2);
+    HASensorInteger sensor(testUniqueId);
+    sensor.setQos(1);
+    mock->connectDummy();
+    sensor.setValue(10);
+
+    const uint16_t packetId = mock->getFlushedMessages()[0].packetId;
+
+    mock->disconnect();
+    mock->clearFlushedMessages();
+    mqtt.loop();
+
+    // retransmitted state, config and the current state
+    assertEqual(3, mock->getFlushedMessagesNb());
+    const MqttMessage& message = mock->getFlushedMessages()[0];
+    assertStringCaseEqual(stateTopic, message.topic);
+    assertStringCaseEqual("10", message.buffer);
+    assertEqual(packetId, message.packetId);
+    assertTrue(message.duplicate);
+}
+
+test(InflightWindowTest, retransmit_in_send_order) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(2);
+    HASensorInteger sensor(testUniqueId);
+    sensor.setQos(1);
+    mock->connectDummy();
+
+    sensor.setValue(1);
+    sensor.setValue(2);
+    mock->fakeAck(mock->getFlushedMessages()[0].packetId);
+    sensor.setValue(3); // reuses the slot of the first value
+
+    mock->disconnect();
+    mock->clearFlushedMessages();
+    mqtt.loop();
+
+    // the latest value is retained by the broker
+    assertMqttMessage(0, stateTopic, "2", true)
+    assertMqttMessage(1, stateTopic, "3", true)
+    assertTrue(mock->getFlushedMessages()[0].duplicate);
+    assertTrue(mock->getFlushedMessages()[1].duplicate);
+}
+
+test(InflightWindowTest, entity_destruction_releases_slots) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableInflightWindow(2);
+    mock->connectDummy();
+
+    {
+        HASensorInteger sensor(testUniqueId);
+        sensor.setQos(1);
+        sensor.setValue(10);
+        assertEqual((uint8_t)1, mqtt.getInflightWindow()->getMessagesNb());
+    }
+
+    assertEqual((uint8_t)0, mqtt.getInflightWindow()->getMessagesNb());
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
@@ -0,0 +1,425 @@
+#include <ArduinoHA.h>
+
+/**
+ * Fuzzing harness of the inbound message path (HAMqtt::processMessage) and the HASerializer.
+ * The target has the libFuzzer's signature, so it can be linked with -fsanitize=fuzzer
+ * (see `make libfuzzer`). The default EpoxyDuino build drives the target with
+ * deterministic random inputs and reports the throughput.
+ *
+ * Layout of the input (the first byte selects the target):
+ * - message: [0][selector][topic length][topic...][payload length][payload...] repeated,
+ *   selectors below RawTopicSelector pick one of the known topics (without the raw topic).
+ * - serializer: [1][max entries nb][flags][operation][argument]...
+ */
+
+#ifndef FUZZ_ITERATIONS
+#define FUZZ_ITERATIONS 200000
+#endif
+
+#define fuzzAssert(condition) \
+    if (!(condition)) { \
+        Serial.print(F("invariant failed: ")); \
+        Serial.println(F(#condition)); \
+        abort(); \
+    }
+
+static const char* fuzzDeviceId = "fuzzDevice";
+static const uint8_t MessageTarget = 0;
+static const uint8_t SerializerTarget = 1;
+static const uint8_t RawTopicSelector = 0xC0;
+static const uint8_t MaxMessagesNb = 8;
+static const uint8_t MaxOperationsNb = 24;
+
+static const char* knownTopics[] = {
+    "aha/fuzzDevice/relay/cmd_t",
+    "aha/fuzzDevice/relay/stat_t",
+    "aha/fuzzDevice/door/cmd_t",
+    "aha/fuzzDevice/door/stat_t",
+    "aha/fuzzDevice/blind/cmd_t",
+    "aha/fuzzDevice/blind/stat_t",
+    "aha/fuzzDevice/blind/pos_t",
+    "aha/fuzzDevice/blind/set_pos_t",
+    "aha/fuzzDevice/bell/cmd_t",
+    "aha/fuzzDevice/fan/cmd_t",
+    "aha/fuzzDevice/chime/cmd_t",
+    "aha/fuzzDevice/unknown/cmd_t",
+    "aha/otherDevice/relay/cmd_t",
+    "aha/fuzzDevice/relay",
+    "aha/",
+    "",
+    "homeassistant/switch/fuzzDevice/relay/config",
+    "homeassistant/sensor/fuzzDevice/orphan/config",
+    "homeassistant/switch/otherDevice/relay/config",
+    "homeassistant/switch/fuzzDevice/config",
+    "homeassistant/switch/fuzzDevice/relay/config/extra",
+    "homeassistant//fuzzDevice//config",
+    "homeassistant/"
+};
+
+static const char* const properties[] = {
+    HANameProperty,
+    HAUniqueIdProperty,
+    HADeviceClassProperty,
+    HAIconProperty,
+    HARetainProperty,
+    HAOptimisticProperty,
+    HAUnitOfMeasurementProperty,
+    HAValueTemplateProperty
+};
+
+static const char* const topics[] = {
+    HAStateTopic,
+    HACommandTopic,
+    HAPositionTopic,
+    HASetPositionTopic
+};
+
+static const char relayId[] PROGMEM = "fan";
+static const char bellId[] PROGMEM = "chime";
+
+static const HAEntityDescriptor entities[] PROGMEM = {
+    {relayId, HAEntityTable::Switch, HAEntityTable::EnabledByDefault},
+    {bellId, HAEntityTable::Button, HAEntityTable::EnabledByDefault}
+};
+
+class FuzzDeviceType : public HABaseDeviceType
+{
+public:
+    FuzzDeviceType(): HABaseDeviceType("fuzz", "fuzzEntity") { }
+
+protected:
+    virtual void onMqttConnected() override { }
+};
+
+/**
+ * Reads the input byte by byte. Reads past the end return zeros.
+ */
+class FuzzInput
+{
+public:
+    FuzzInput(const uint8_t* data, const size_t size) :
+        _data(data),
+        _size(size),
+        _position(0)
+    { }
+
+    inline bool isEmpty() const
+        { return _position >= _size; }
+
+    uint8_t readByte()
+    {
+        return isEmpty() ? 0 : _data[_position++];
+    }
+
+    /**
+     * Copies up to `length` bytes to the exactly sized buffer, so the sanitizer
+     * catches reads past the end. Returns the number of copied bytes.
+     */
+    uint16_t readBytes(uint8_t*& output, uint16_t length, const bool nullTerminated)
+    {
+        if (length > _size - _position) {
+            length = _size - _position;
+        }
+
+        output = new uint8_t[length + (nullTerminated ? 1 : 0)];
+        memcpy(output, &_data[_position], length);
+        _position += length;
+
+        if (nullTerminated) {
+            output[length] = 0;
+        }
+
+        return length;
+    }
+
+private:
+    const uint8_t* _data;
+    const size_t _size;
+    size_t _position;
+};
+
+static void onSwitchCommand(bool state, HASwitch* sender)
+{
+    sender->setState(state);
+}
+
+static void onLockCommand(HALock::LockCommand command, HALock* sender)
+{
+    fuzzAssert(command >= HALock::CommandLock && command <= HALock::CommandOpen)
+    sender->setState(
+        command == HALock::CommandLock ? HALock::StateLocked : HALock::StateUnlocked
+    );
+}
+
+static void onCoverCommand(HACover::CoverCommand command, HACover* sender)
+{
+    fuzzAssert(command >= HACover::CommandOpen && command <= HACover::CommandStop)
+    sender->setState(HACover::StateStopped);
+}
+
+static void onPositionCommand(int16_t position, HACover* sender)
+{
+    fuzzAssert(
+        position >= HACover::ClosedPosition &&
+        position <= HACover::OpenPosition
+    )
+    sender->setPosition(position);
+}
+
+static void onButtonPress(HAButton* sender)
+{
+    (void)sender;
+}
+
+static void onTableCommand(uint8_t index, bool state, HAEntityTable* sender)
+{
+    fuzzAssert(index < sender->getDescriptorsNb())
+    sender->setState(index, state);
+}
+
+static void fuzzMessages(FuzzInput& input)
+{
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(fuzzDeviceId);
+    HAMqtt mqtt(mock, device);
+    mqtt.setDataPrefix("aha");
+
+    HASwitch relay("relay");
+    HALock door("door");
+    HACover blind("blind");
+    HAButton bell("bell");
+    HAEntityTable table(entities, sizeof(entities) / sizeof(entities[0]));
+
+    relay.onCommand(onSwitchCommand);
+    relay.setStateRestore(true);
+    door.onCommand(onLockCommand);
+    door.setStateRestore(true);
+    blind.onCommand(onCoverCommand);
+    blind.onPositionCommand(onPositionCommand);
+    blind.setStateRestore(true);
+    bell.onPress(onButtonPress);
+    table.onCommand(onTableCommand);
+
+    mqtt.begin("fuzzHost");
+    mqtt.loop();
+    mqtt.sweepOrphanedConfigs();
+
+    for (uint8_t i = 0; i < MaxMessagesNb && !input.isEmpty(); i++) {
+        const uint8_t selector = input.readByte();
+        uint8_t* topic = nullptr;
+        uint8_t* payload = nullptr;
+
+        if (selector < RawTopicSelector) {
+            const char* knownTopic = knownTopics[selector % (sizeof(knownTopics) / sizeof(knownTopics[0]))];
+            topic = new uint8_t[strlen(knownTopic) + 1];
+            strcpy(reinterpret_cast<char*>(topic), knownTopic);
+        } else {
+            input.readBytes(topic, input.readByte(), true);
+        }
+
+        const uint16_t length = input.readBytes(payload, input.readByte(), false);
+        mqtt.processMessage(reinterpret_cast<const char*>(topic), payload, length);
+
+        delete[] topic;
+        delete[] payload;
+    }
+
+    mqtt.loop();
+}
+
+static void fuzzSerializer(FuzzInput& input)
+{
+    PubSubClientMock* mock = new PubSubClientMock();
+    HADevice device(fuzzDeviceId);
+    HAMqtt mqtt(mock, device);
+    mqtt.setDataPrefix("aha");
+
+    const uint8_t maxEntriesNb = input.readByte() % 16;
+    const uint8_t flags = input.readByte();
+    if (flags & 1) {
+        device.enableSharedAvailability();
+    }
+
+    FuzzDeviceType deviceType;
+    if (flags & 2) {
+        deviceType.setAvailability(flags & 4);
+    }
+
+    HASerializer serializer(&deviceType, maxEntriesNb);
+    serializer.setBaseTopicForced(flags & 8);
+    HASerializerArray array(4);
+
+    // values need to outlive the serializer
+    uint8_t* strings[MaxOperationsNb] = {};
+    int32_t numbers[MaxOperationsNb];
+    bool bools[MaxOperationsNb];
+
+    for (uint8_t i = 0; i < MaxOperationsNb && !input.isEmpty(); i++) {
+        const uint8_t operation = input.readByte();
+        const uint8_t argument = input.readByte();
+        const char* propertyP = properties[argument % (sizeof(properties) / sizeof(properties[0]))];
+        const uint8_t propertyLength = strlen_P(propertyP);
+
+        switch (operation % 8) {
+        case 0:
+            input.readBytes(strings[i], input.readByte() % 64, true);
+            serializer.set(propertyP, propertyLength, strings[i]);
+            break;
+
+        case 1:
+            bools[i] = argument & 0x80;
+            serializer.set(propertyP, propertyLength, &bools[i], HASerializer::BoolPropertyType);
+            break;
+
+        case 2:
+            numbers[i] = 0;
+            for (uint8_t j = 0; j < 4; j++) {
+                numbers[i] = (numbers[i] << 8) | input.readByte();
+            }
+
+            serializer.set(propertyP, propertyLength, &numbers[i], HASerializer::Int32PropertyType);
+            break;
+
+        case 3:
+            serializer.set(propertyP, propertyLength, HAOnline, HASerializer::ProgmemPropertyValue);
+            break;
+
+        case 4:
+            array.add(argument & 1 ? HAStateOn : HAOffline);
+            serializer.set(propertyP, propertyLength, &array, HASerializer::ArrayPropertyType);
+            break;
+
+        case 5:
+            serializer.set(argument & 1 ? HASerializer::WithDevice : HASerializer::WithAvailability);
+            break;
+
+        case 6: {
+            const char* topicP = topics[argument % (sizeof(topics) / sizeof(topics[0]))];
+            serializer.topic(topicP, strlen_P(topicP));
+            break;
+        }
+
+        default:
+            serializer.remove(propertyP);
+            break;
+        }
+
+        fuzzAssert(serializer.getEntriesNb() <= maxEntriesNb)
+    }
+
+    const uint16_t size = serializer.calculateSize();
+    mock->connectDummy();
+    mock->beginPublish("fuzzTopic", size, false);
+    serializer.flush();
+    mock->endPublish();
+
+    const MqttMessage& message = mock->getFlushedMessages()[0];
+    fuzzAssert(strlen(message.buffer) == size)
+
+    for (uint8_t i = 0; i < MaxOperationsNb; i++) {
+        delete[] strings[i];
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzInput input(data, size);
+    const uint8_t target = input.readByte();
+
+    if (target % 2 == MessageTarget) {
+        fuzzMessages(input);
+    } else {
+        fuzzSerializer(input);
+    }
+
+    return 0;
+}
+
+#ifndef ARDUINOHA_LIBFUZZER
+
+static const char* payloadTokens[] = {
+    "ON", "OFF", "on", "off", "LOCK", "UNLOCK", "OPEN", "CLOSE", "STOP", "PRESS",
+    "locked", "unlocked", "open", "opening", "closed", "closing", "stopped",
+    "0", "-0", "100", "101", "-1", "32767", "-32768", "-32769", "2147483648", "{}"
+};
+
+static uint32_t randomState = 0x2545F491;
+
+/**
+ * Deterministic xorshift generator, so the failed run can be repeated.
+ */
+static uint32_t nextRandom()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+/**
+ * Generates random input. Half of the payloads are the known tokens (optionally mutated),
+ * so the generator reaches the valid commands and states without the coverage feedback.
+ */
+static size_t generateInput(uint8_t* data, const size_t maxSize)
+{
+    size_t size = 0;
+    data[size++] = nextRandom() & 0xFF;
+
+    while (size < maxSize - 2) {
+        data[size++] = nextRandom() & 0xFF;
+
+        if (data[0] % 2 == SerializerTarget || nextRandom() % 2 == 0) {
+            continue;
+        }
+
+        const char* token = payloadTokens[nextRandom() % (sizeof(payloadTokens) / sizeof(payloadTokens[0]))];
+        const uint8_t length = strlen(token);
+        if (size + length + 1 > maxSize) {
+            break;
+        }
+
+        data[size++] = length;
+        memcpy(&data[size], token, length);
+
+        if (nextRandom() % 4 == 0) {
+            data[size + nextRandom() % length] = nextRandom() & 0xFF;
+        }
+
+        size += length;
+    }
+
+    return nextRandom() % size + 1;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+
+    uint8_t data[128];
+    const uint32_t startedAt = millis();
+
+    for (uint32_t i = 0; i < FUZZ_ITERATIONS; i++) {
+        const size_t size = generateInput(data, sizeof(data));
+        LLVMFuzzerTestOneInput(data, size);
+    }
+
+    const uint32_t duration = millis() - startedAt;
+    Serial.print(F("execs: "));
+    Serial.print((uint32_t)FUZZ_ITERATIONS);
+    Serial.print(F(", time [ms]: "));
+    Serial.print(duration);
+    Serial.print(F(", execs/sec: "));
+    Serial.println(
+        duration > 0 ? (uint32_t)((uint64_t)FUZZ_ITERATIONS * 1000 / duration) : 0
+    );
+
+    exit(0);
+}
+
+void loop()
+{
+
+}
+
+#endif
@@ -0,0 +1,275 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static HASwitch* lastSwitch = nullptr;
+
+void onSwitchCommand(bool state, HASwitch* sender)
+{
+    (void)state;
+    lastSwitch = sender;
+}
+
+// the data topic generation used before the context was introduced
+static bool generateDataTopicLegacy(
+    char* output,
+    const char* objectId,
+    const char* topicP
+)
+{
+    const HAMqtt* mqtt = HAMqtt::instance();
+    if (!output || !topicP || !mqtt || !mqtt->getDataPrefix() || !mqtt->getDevice()) {
+        return false;
+    }
+
+    strcpy(output, mqtt->getDataPrefix());
+    strcat_P(output, HASerializerSlash);
+    strcat(output, mqtt->getDevice()->getUniqueId());
+    strcat_P(output, HASerializerSlash);
+
+    if (objectId) {
+        strcat(output, objectId);
+        strcat_P(output, HASerializerSlash);
+    }
+
+    strcat_P(output, topicP);
+    return true;
+}
+
+test(MqttContextTest, prefixes) {
+    initMqttTest(testDeviceId)
+    const HAMqttContext& context = mqtt.getContext();
+
+    assertTrue(context.mqtt() == &mqtt);
+    assertTrue(context.device() == &device);
+    assertStringCaseEqual("testData", context.getDataPrefix());
+    assertEqual((uint16_t)8, context.getDataPrefixLength());
+    assertStringCaseEqual("homeassistant", context.getDiscoveryPrefix());
+    assertEqual((uint16_t)13, context.getDiscoveryPrefixLength());
+
+    mqtt.setDiscoveryPrefix("ha");
+    assertStringCaseEqual("ha", mqtt.getDiscoveryPrefix());
+    assertEqual((uint16_t)2, context.getDiscoveryPrefixLength());
+}
+
+test(MqttContextTest, device_id_length) {
+    static const byte bytesId[] = {0x11, 0x22, 0x33};
+    HADevice device(bytesId, sizeof(bytesId));
+    HADevice emptyDevice;
+
+    assertEqual((uint16_t)6, device.getUniqueIdLength());
+    assertEqual((uint16_t)0, emptyDevice.getUniqueIdLength());
+    assertTrue(emptyDevice.setUniqueId(bytesId, 2));
+    assertEqual((uint16_t)4, emptyDevice.getUniqueIdLength());
+}
+
+test(MqttContextTest, topics) {
+    initMqttTest(testDeviceId)
+    const HAMqttContext& context = mqtt.getContext();
+
+    const uint16_t dataLength = context.calculateDataTopicLength("uniqueId", HAStateTopic);
+    char dataTopic[dataLength];
+    assertTrue(context.generateDataTopic(dataTopic, "uniqueId", HAStateTopic));
+    assertEqual(dataLength, (uint16_t)(strlen(dataTopic) + 1));
+    assertStringCaseEqual("testData/testDevice/uniqueId/stat_t", dataTopic);
+    assertTrue(context.compareDataTopics(dataTopic, "uniqueId", HAStateTopic));
+    assertFalse(context.compareDataTopics(dataTopic, "uniqueId", HACommandTopic));
+
+    const uint16_t configLength = context.calculateConfigTopicLength("switch", "uniqueId");
+    char configTopic[configLength];
+    assertTrue(context.generateConfigTopic(configTopic, "switch", "uniqueId"));
+    assertEqual(configLength, (uint16_t)(strlen(configTopic) + 1));
+    assertStringCaseEqual("homeassistant/switch/testDevice/uniqueId/config", configTopic);
+}
+
+test(MqttContextTest, device_type_binding) {
+    initMqttTest(testDeviceId)
+    HASwitch sw("uniqueSwitch");
+
+    assertTrue(sw.mqtt() == &mqtt);
+}
+
+test(MqttContextTest, multiple_instances) {
+    PubSubClientMock* primaryMock = new PubSubClientMock();
+    HADevice primaryDevice("primary");
+    HAMqtt primary(primaryMock, primaryDevice);
+    primary.setDataPrefix("primaryData");
+    HASwitch primarySwitch("relay");
+
+    PubSubClientMock* backupMock = new PubSubClientMock();
+    HADevice backupDevice("backup");
+    HAMqtt backup(backupMock, backupDevice);
+    backup.setDataPrefix("backupData");
+    HASwitch backupSwitch("relay");
+
+    lastSwitch = nullptr;
+    primarySwitch.onCommand(onSwitchCommand);
+    backupSwitch.onCommand(onSwitchCommand);
+
+    assertTrue(primarySwitch.mqtt() == &primary);
+    assertTrue(backupSwitch.mqtt() == &backup);
+
+    primary.begin("primaryHost");
+    backup.begin("backupHost");
+    primary.loop();
+    backup.loop();
+
+    assertEqual(1, primaryMock->getSubscriptionsNb());
+    assertStringCaseEqual(
+        "primaryData/primary/relay/cmd_t",
+        primaryMock->getSubscriptions()[0].topic
+    );
+    assertEqual(1, backupMock->getSubscriptionsNb());
+    assertStringCaseEqual(
+        "backupData/backup/relay/cmd_t",
+        backupMock->getSubscriptions()[0].topic
+    );
+
+    // the message from the primary broker is not delivered to the backup entities
+    const char* command = "ON";
+    backup.processMessage(
+        "primaryData/primary/relay/cmd_t",
+        reinterpret_cast<const uint8_t*>(command),
+        strlen(command)
+    );
+    assertTrue(lastSwitch == nullptr);
+
+    primary.processMessage(
+        "primaryData/primary/relay/cmd_t",
+        reinterpret_cast<const uint8_t*>(command),
+        strlen(command)
+    );
+    assertTrue(lastSwitch == &primarySwitch);
+
+    PubSubClientMock* mock = primaryMock;
+    assertMqttMessage(
+        0,
+        "homeassistant/switch/primary/relay/config",
+        "{\"uniq_id\":\"relay\",\"opt\":false,\"dev\":{\"ids\":\"primary\"},\"stat_t\":\"primaryData/primary/relay/stat_t\",\"cmd_t\":\"primaryData/primary/relay/cmd_t\"}",
+        true
+    )
+
+    mock = backupMock;
+    assertMqttMessage(
+        0,
+        "homeassistant/switch/backup/relay/config",
+        "{\"uniq_id\":\"relay\",\"opt\":false,\"dev\":{\"ids\":\"backup\"},\"stat_t\":\"backupData/backup/relay/stat_t\",\"cmd_t\":\"backupData/backup/relay/cmd_t\"}",
+        true
+    )
+}
+
+test(MqttContextTest, explicit_device_type_binding) {
+    PubSubClientMock* primaryMock = new PubSubClientMock();
+    HADevice primaryDevice("primary");
+    HAMqtt primary(primaryMock, primaryDevice);
+    PubSubClientMock* backupMock = new PubSubClientMock();
+    HADevice backupDevice("backup");
+    HAMqtt backup(backupMock, backupDevice);
+
+    // bound to the most recently constructed instance by default
+    HASwitch sw("relay");
+    assertTrue(sw.mqtt() == &backup);
+
+    primary.addDeviceType(&sw);
+    assertTrue(sw.mqtt() == &primary);
+    assertTrue(sw.getDevice() == &primaryDevice);
+
+    primary.begin("primaryHost");
+    backup.begin("backupHost");
+    primary.loop();
+    backup.loop();
+
+    assertTrue(primaryMock->getFlushedMessagesNb() > 0);
+    assertStringCaseEqual(
+        "homeassistant/switch/primary/relay/config",
+        primaryMock->getFlushedMessages()[0].topic
+    );
+    assertEqual(0, backupMock->getFlushedMessagesNb());
+    assertEqual(0, backupMock->getSubscriptionsNb());
+}
+
+test(MqttContextTest, device_binding) {
+    PubSubClientMock* primaryMock = new PubSubClientMock();
+    HADevice primaryDevice("primary");
+    HAMqtt primary(primaryMock, primaryDevice);
+    primary.setDataPrefix("primaryData");
+    PubSubClientMock* backupMock = new PubSubClientMock();
+    HADevice backupDevice("backup");
+    HAMqtt backup(backupMock, backupDevice);
+    backup.setDataPrefix("backupData");
+
+    assertTrue(primaryDevice.mqtt() == &primary);
+    assertTrue(backupDevice.mqtt() == &backup);
+    assertTrue(primaryDevice.enableSharedAvailability());
+    assertStringCaseEqual("primaryData/primary/avty_t", primaryDevice.getAvailabilityTopic());
+
+    primary.begin("primaryHost");
+    backup.begin("backupHost");
+    primary.loop();
+    backup.loop();
+    primaryMock->clearFlushedMessages();
+
+    // published by the owner outside of its loop
+    primaryDevice.setAvailability(false);
+    assertEqual(0, backupMock->getFlushedMessagesNb());
+
+    PubSubClientMock* mock = primaryMock;
+    assertSingleMqttMessage("primaryData/primary/avty_t", "offline", true)
+}
+
+test(MqttContextTest, instance_cleared_by_owner_only) {
+    HADevice primaryDevice("primary");
+    HADevice backupDevice("backup");
+    HAMqtt* primary = new HAMqtt(new PubSubClientMock(), primaryDevice);
+    HAMqtt* backup = new HAMqtt(new PubSubClientMock(), backupDevice);
+    assertTrue(HAMqtt::instance() == backup);
+
+    delete primary;
+    assertTrue(HAMqtt::instance() == backup);
+
+    delete backup;
+    assertTrue(HAMqtt::instance() == nullptr);
+}
+
+test(MqttContextTest, topic_generation_benchmark) {
+    static const uint16_t iterationsNb = 10000;
+    initMqttTest(testDeviceId)
+    const HAMqttContext& context = mqtt.getContext();
+
+    const uint16_t topicLength = context.calculateDataTopicLength("uniqueId", HAStateTopic);
+    char legacyTopic[topicLength];
+    char contextTopic[topicLength];
+
+    uint32_t startedAt = micros();
+    for (uint16_t i = 0; i < iterationsNb; i++) {
+        generateDataTopicLegacy(legacyTopic, "uniqueId", HAStateTopic);
+    }
+    const uint32_t legacyTime = micros() - startedAt;
+
+    startedAt = micros();
+    for (uint16_t i = 0; i < iterationsNb; i++) {
+        context.generateDataTopic(contextTopic, "uniqueId", HAStateTopic);
+    }
+    const uint32_t contextTime = micros() - startedAt;
+
+    assertStringCaseEqual(legacyTopic, contextTopic);
+
+    Serial.print(F("10000 data topics [us], singleton: "));
+    Serial.print(legacyTime);
+    Serial.print(F(", context: "));
+    Serial.println(contextTime);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
@@ -0,0 +1,145 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* testUniqueId = "uniqueSensor";
+
+test(MqttTest, custom_transport) {
+    PubSubClientMock transport;
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(transport, device);
+
+    assertTrue(mqtt.getTransport() == &transport);
+    assertTrue(mqtt.begin("testHost", 1234, "testUser", "testPass"));
+    assertStringCaseEqual("testHost", transport.getConnection().domain);
+    assertEqual((uint16_t)1234, transport.getConnection().port);
+}
+
+test(MqttTest, custom_transport_connect) {
+    PubSubClientMock transport;
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(transport, device);
+    mqtt.setDataPrefix("testData");
+
+    HABinarySensor sensor(testUniqueId);
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    assertTrue(mqtt.isConnected());
+    assertStringCaseEqual(testDeviceId, transport.getConnection().id);
+    assertEqual(2, transport.getFlushedMessagesNb()); // config + state
+}
+
+test(MqttTest, custom_transport_message) {
+    PubSubClientMock transport;
+    HADevice device(testDeviceId);
+    HAMqtt mqtt(transport, device);
+    mqtt.setDataPrefix("testData");
+
+    HAButton button(testUniqueId);
+    mqtt.begin("testHost");
+    mqtt.loop();
+
+    assertEqual(1, transport.getSubscriptionsNb());
+    assertStringCaseEqual(
+        "testData/testDevice/uniqueSensor/cmd_t",
+        transport.getSubscriptions()[0].topic
+    );
+}
+
+test(MqttTest, command_wildcard_disabled_by_default) {
+    initMqttTest(testDeviceId)
+
+    assertFalse(mqtt.isCommandWildcardEnabled());
+}
+
+test(MqttTest, command_wildcard_after_begin) {
+    initMqttTest(testDeviceId)
+
+    assertFalse(mqtt.setCommandWildcard(true));
+    assertFalse(mqtt.isCommandWildcardEnabled());
+}
+
+test(MqttTest, command_wildcard_subscription) {
+    initMqttTestWithoutBegin(testDeviceId)
+    assertTrue(mqtt.setCommandWildcard(true));
+    mqtt.begin("testHost", "testUser", "testPass");
+
+    HAButton button(testUniqueId);
+    HASwitch sw("uniqueSwitch");
+    mqtt.loop();
+
+    assertEqual(1, mock->getSubscriptionsNb());
+    assertStringCaseEqual(
+        "testData/testDevice/+/cmd_t",
+        mock->getSubscriptions()[0].topic
+    );
+}
+
+static HAButton* lastPressedButton = nullptr;
+
+void onButtonPressed(HAButton* sender)
+{
+    lastPressedButton = sender;
+}
+
+test(MqttTest, command_wildcard_routing) {
+    initMqttTestWithoutBegin(testDeviceId)
+    assertTrue(mqtt.setCommandWildcard(true));
+    mqtt.begin("testHost", "testUser", "testPass");
+
+    lastPressedButton = nullptr;
+    HAButton buttonA("buttonA");
+    HAButton buttonB("buttonB");
+    buttonA.onPress(onButtonPressed);
+    buttonB.onPress(onButtonPressed);
+    mqtt.loop();
+
+    mock->fakeMessage("testData/testDevice/buttonB/cmd_t", "PRESS");
+    assertTrue(lastPressedButton == &buttonB);
+}
+
+test(MqttTest, command_wildcard_reconnect_packets) {
+    static const uint8_t entitiesNb = 5;
+    const char* ids[entitiesNb] = {"e0", "e1", "e2", "e3", "e4"};
+    uint16_t subscriptionsNb[2] = {0, 0};
+
+    for (uint8_t wildcard = 0; wildcard < 2; wildcard++) {
+        PubSubClientMock* mock = new PubSubClientMock();
+        HADevice device(testDeviceId);
+        HAMqtt mqtt(mock, device, entitiesNb + 1);
+        mqtt.setDataPrefix("testData");
+        assertTrue(mqtt.setCommandWildcard(wildcard == 1));
+        mqtt.begin("testHost");
+
+        HASwitch* switches[entitiesNb];
+        for (uint8_t i = 0; i < entitiesNb; i++) {
+            switches[i] = new HASwitch(ids[i]);
+        }
+
+        mqtt.loop();
+        subscriptionsNb[wildcard] = mock->getSubscriptionsNb();
+
+        for (uint8_t i = 0; i < entitiesNb; i++) {
+            delete switches[i];
+        }
+    }
+
+    // one SUBSCRIBE per entity vs. one per connection
+    assertEqual((uint16_t)entitiesNb, subscriptionsNb[0]);
+    assertEqual((uint16_t)1, subscriptionsNb[1]);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
@@ -0,0 +1,211 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define limitPacketSize(topic, message) \
+    mock->setMaxPacketSize( \
+        HAMqtt::calculatePacketSize(strlen(topic), strlen(message)) \
+    );
+
+#define assertPayloadStats(eOversizeNb, eDegradedNb, eDroppedNb) \
+    assertEqual((uint16_t)eOversizeNb, mqtt.getPayloadStats().oversizeNb); \
+    assertEqual((uint16_t)eDegradedNb, mqtt.getPayloadStats().degradedNb); \
+    assertEqual((uint16_t)eDroppedNb, mqtt.getPayloadStats().droppedNb);
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* configTopic = "homeassistant/cover/testDevice/uniqueCover/config";
+static const char* fullConfig = "{\"name\":\"Garage door\",\"uniq_id\":\"uniqueCover\",\"dev_cla\":\"garage\",\"ic\":\"mdi:garage\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/uniqueCover/stat_t\",\"cmd_t\":\"testData/testDevice/uniqueCover/cmd_t\",\"pos_t\":\"testData/testDevice/uniqueCover/pos_t\"}";
+static const char* baseTopicConfig = "{\"~\":\"testData/testDevice/uniqueCover\",\"name\":\"Garage door\",\"uniq_id\":\"uniqueCover\",\"dev_cla\":\"garage\",\"ic\":\"mdi:garage\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"~/stat_t\",\"cmd_t\":\"~/cmd_t\",\"pos_t\":\"~/pos_t\"}";
+static const char* noIconConfig = "{\"~\":\"testData/testDevice/uniqueCover\",\"name\":\"Garage door\",\"uniq_id\":\"uniqueCover\",\"dev_cla\":\"garage\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"~/stat_t\",\"cmd_t\":\"~/cmd_t\",\"pos_t\":\"~/pos_t\"}";
+static const char* minimalConfig = "{\"~\":\"testData/testDevice/uniqueCover\",\"uniq_id\":\"uniqueCover\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"~/stat_t\",\"cmd_t\":\"~/cmd_t\",\"pos_t\":\"~/pos_t\"}";
+
+static HABaseDeviceType* lastDeviceType = nullptr;
+static uint32_t lastPacketSize = 0;
+static bool lastPublished = false;
+static uint8_t callbackCallsNb = 0;
+
+void onPayloadTooLarge(
+    HABaseDeviceType* deviceType,
+    uint32_t packetSize,
+    bool published
+)
+{
+    lastDeviceType = deviceType;
+    lastPacketSize = packetSize;
+    lastPublished = published;
+    callbackCallsNb++;
+}
+
+void resetCallback()
+{
+    lastDeviceType = nullptr;
+    lastPacketSize = 0;
+    lastPublished = false;
+    callbackCallsNb = 0;
+}
+
+#define prepareCover(cover) \
+    HACover cover("uniqueCover"); \
+    cover.setName("Garage door"); \
+    cover.setDeviceClass("garage"); \
+    cover.setIcon("mdi:garage");
+
+test(PacketSizeTest, packet_size_calculation) {
+    // control byte + remaining length + topic length + topic + payload
+    assertEqual((uint32_t)114, HAMqtt::calculatePacketSize(10, 100));
+    assertEqual((uint32_t)129, HAMqtt::calculatePacketSize(10, 115));
+    assertEqual((uint32_t)131, HAMqtt::calculatePacketSize(10, 116));
+    assertEqual((uint32_t)16388, HAMqtt::calculatePacketSize(0, 16382));
+}
+
+test(PacketSizeTest, no_limit_by_default) {
+    initMqttTest(testDeviceId)
+
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertEqual((uint16_t)0, mqtt.getMaxPacketSize());
+    assertTrue(mqtt.fitsPacket(UINT16_MAX, UINT16_MAX));
+    assertMqttMessage(0, configTopic, fullConfig, true)
+    assertPayloadStats(0, 0, 0)
+}
+
+test(PacketSizeTest, config_fits_exactly) {
+    initMqttTest(testDeviceId)
+    limitPacketSize(configTopic, fullConfig)
+    resetCallback();
+    mqtt.onPayloadTooLarge(onPayloadTooLarge);
+
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertMqttMessage(0, configTopic, fullConfig, true)
+    assertPayloadStats(0, 0, 0)
+    assertEqual((uint8_t)0, callbackCallsNb);
+}
+
+test(PacketSizeTest, base_topic_fallback) {
+    initMqttTest(testDeviceId)
+    limitPacketSize(configTopic, baseTopicConfig)
+    resetCallback();
+    mqtt.onPayloadTooLarge(onPayloadTooLarge);
+
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertMqttMessage(0, configTopic, baseTopicConfig, true)
+    assertPayloadStats(1, 1, 0)
+    assertEqual((uint8_t)1, callbackCallsNb);
+    assertTrue(lastDeviceType == &cover);
+    assertTrue(lastPublished);
+    assertEqual(
+        HAMqtt::calculatePacketSize(strlen(configTopic), strlen(fullConfig)),
+        lastPacketSize
+    );
+    assertEqual(lastPacketSize, mqtt.getPayloadStats().largestPacketSize);
+}
+
+test(PacketSizeTest, icon_is_dropped_first) {
+    initMqttTest(testDeviceId)
+    limitPacketSize(configTopic, noIconConfig)
+
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertMqttMessage(0, configTopic, noIconConfig, true)
+    assertPayloadStats(1, 1, 0)
+}
+
+test(PacketSizeTest, all_optional_properties_dropped) {
+    initMqttTest(testDeviceId)
+    limitPacketSize(configTopic, minimalConfig)
+
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertMqttMessage(0, configTopic, minimalConfig, true)
+    assertPayloadStats(1, 1, 0)
+}
+
+test(PacketSizeTest, config_dropped) {
+    initMqttTest(testDeviceId)
+    mock->setMaxPacketSize(64);
+    resetCallback();
+    mqtt.onPayloadTooLarge(onPayloadTooLarge);
+
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertNoMqttMessage()
+    assertPayloadStats(1, 0, 1)
+    assertEqual((uint8_t)1, callbackCallsNb);
+    assertTrue(lastDeviceType == &cover);
+    assertFalse(lastPublished);
+}
+
+test(PacketSizeTest, data_message_dropped) {
+    initMqttTest(testDeviceId)
+
+    HASensor sensor("uniqueSensor");
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    mock->setMaxPacketSize(64);
+    resetCallback();
+    mqtt.onPayloadTooLarge(onPayloadTooLarge);
+
+    assertFalse(sensor.setValue("this value is too long to fit the packet of 64 bytes"));
+    assertTrue(sensor.setValue("short"));
+
+    assertSingleMqttMessage("testData/testDevice/uniqueSensor/stat_t", "short", true)
+    assertPayloadStats(1, 0, 1)
+    assertEqual((uint8_t)1, callbackCallsNb);
+    assertTrue(lastDeviceType == nullptr);
+    assertFalse(lastPublished);
+}
+
+test(PacketSizeTest, topic_limit_only) {
+    initMqttTest(testDeviceId)
+    mock->setMaxTopicLength(strlen(configTopic));
+    resetCallback();
+    mqtt.onPayloadTooLarge(onPayloadTooLarge);
+
+    // the payload is streamed, so only the topic is limited
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertEqual((uint16_t)0, mqtt.getMaxPacketSize());
+    assertTrue(mqtt.fitsPacket(strlen(configTopic), UINT16_MAX));
+    assertFalse(mqtt.fitsPacket(strlen(configTopic) + 1, 0));
+    assertMqttMessage(0, configTopic, fullConfig, true)
+    assertPayloadStats(0, 0, 0)
+    assertEqual((uint8_t)0, callbackCallsNb);
+}
+
+test(PacketSizeTest, topic_too_long) {
+    initMqttTest(testDeviceId)
+    mock->setMaxTopicLength(strlen(configTopic) - 1);
+    resetCallback();
+    mqtt.onPayloadTooLarge(onPayloadTooLarge);
+
+    prepareCover(cover);
+    mqtt.loop();
+
+    assertNoMqttMessage()
+    assertPayloadStats(1, 0, 1)
+    assertEqual((uint8_t)1, callbackCallsNb);
+    assertFalse(lastPublished);
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
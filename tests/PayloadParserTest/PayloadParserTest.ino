@@ -0,0 +1,343 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define parse(str) \
+    reinterpret_cast<const uint8_t*>(str), strlen(str)
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const uint16_t fuzzMessagesNb = 20000;
+static const uint16_t benchmarkMessagesNb = 10000;
+
+static const char* const coverCommands[] = {
+    HAOpenCommand,
+    HACloseCommand,
+    HAStopCommand
+};
+
+static const char* fuzzTopics[] = {
+    "testData/testDevice/relay/cmd_t",
+    "testData/testDevice/relay/stat_t",
+    "testData/testDevice/door/cmd_t",
+    "testData/testDevice/door/stat_t",
+    "testData/testDevice/blind/cmd_t",
+    "testData/testDevice/blind/stat_t",
+    "testData/testDevice/blind/pos_t",
+    "testData/testDevice/blind/set_pos_t",
+    "testData/testDevice/unknown/cmd_t",
+    "testData/otherDevice/relay/cmd_t"
+};
+
+static const char* fuzzTokens[] = {
+    "ON", "on", "OFF", "off", "LOCK", "UNLOCK", "OPEN", "CLOSE", "STOP",
+    "locked", "unlocked", "open", "closed", "stopped",
+    "0", "-0", "42", "100", "101", "-1", "32767", "-32768", "2147483648", "0042"
+};
+
+static uint32_t randomState = 0;
+static uint16_t switchCallsNb = 0;
+static uint16_t lockCallsNb = 0;
+static uint16_t coverCallsNb = 0;
+static uint16_t positionCallsNb = 0;
+static bool invalidCallback = false;
+
+/**
+ * Deterministic xorshift generator, so the failed run can be repeated.
+ */
+static uint32_t nextRandom()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+/**
+ * Generates random bytes, a valid token or a mutated token.
+ */
+static uint16_t generatePayload(uint8_t* payload, const uint16_t maxLength)
+{
+    const uint8_t mode = nextRandom() % 4;
+    if (mode == 0) {
+        const uint16_t length = nextRandom() % maxLength;
+        for (uint16_t i = 0; i < length; i++) {
+            payload[i] = nextRandom() & 0xFF;
+        }
+
+        return length;
+    }
+
+    const char* token = fuzzTokens[nextRandom() % (sizeof(fuzzTokens) / sizeof(fuzzTokens[0]))];
+    uint16_t length = strlen(token);
+    memcpy(payload, token, length);
+
+    if (mode == 2 && length > 0) {
+        payload[nextRandom() % length] = nextRandom() & 0xFF;
+    } else if (mode == 3 && nextRandom() % 2 == 0) {
+        length--; // truncated token
+    } else if (mode == 3) {
+        payload[length++] = nextRandom() & 0xFF;
+    }
+
+    return length;
+}
+
+/**
+ * Independent implementation of the switch's command check.
+ */
+static bool isSwitchCommand(const uint8_t* payload, const uint16_t length)
+{
+    return (length == 2 && strncasecmp((const char*)payload, "on", 2) == 0) ||
+        (length == 3 && strncasecmp((const char*)payload, "off", 3) == 0);
+}
+
+/**
+ * Independent implementation of the cover's position check.
+ */
+static bool isPositionCommand(const uint8_t* payload, const uint16_t length)
+{
+    const bool negative = (length > 0 && payload[0] == '-');
+    uint16_t i = negative ? 1 : 0;
+    if (i == length) {
+        return false;
+    }
+
+    uint32_t value = 0;
+    for (; i < length; i++) {
+        if (!isdigit(payload[i])) {
+            return false;
+        }
+
+        value = value * 10 + (payload[i] - '0');
+        if (value > 100) {
+            return false;
+        }
+    }
+
+    return (!negative || value == 0);
+}
+
+void onSwitchCommand(bool state, HASwitch* sender)
+{
+    (void)state;
+    (void)sender;
+    switchCallsNb++;
+}
+
+void onLockCommand(HALock::LockCommand command, HALock* sender)
+{
+    (void)sender;
+    invalidCallback |= (command < HALock::CommandLock || command > HALock::CommandOpen);
+    lockCallsNb++;
+}
+
+void onCoverCommand(HACover::CoverCommand command, HACover* sender)
+{
+    (void)sender;
+    invalidCallback |= (command < HACover::CommandOpen || command > HACover::CommandStop);
+    coverCallsNb++;
+}
+
+void onPositionCommand(int16_t position, HACover* sender)
+{
+    (void)sender;
+    invalidCallback |= (
+        position < HACover::ClosedPosition || position > HACover::OpenPosition
+    );
+    positionCallsNb++;
+}
+
+test(PayloadParserTest, integer) {
+    int32_t value = 0;
+
+    assertTrue(HAPayloadParser::parseInteger(parse("42"), value));
+    assertEqual((int32_t)42, value);
+    assertTrue(HAPayloadParser::parseInteger(parse("-7"), value));
+    assertEqual((int32_t)-7, value);
+    assertTrue(HAPayloadParser::parseInteger(parse("0042"), value));
+    assertEqual((int32_t)42, value);
+    assertTrue(HAPayloadParser::parseInteger(parse("2147483647"), value));
+    assertEqual((int32_t)INT32_MAX, value);
+    assertTrue(HAPayloadParser::parseInteger(parse("-2147483648"), value));
+    assertEqual((int32_t)INT32_MIN, value);
+}
+
+test(PayloadParserTest, integer_invalid) {
+    int32_t value = 5;
+
+    assertFalse(HAPayloadParser::parseInteger(parse(""), value));
+    assertFalse(HAPayloadParser::parseInteger(parse("-"), value));
+    assertFalse(HAPayloadParser::parseInteger(parse("+1"), value));
+    assertFalse(HAPayloadParser::parseInteger(parse(" 1"), value));
+    assertFalse(HAPayloadParser::parseInteger(parse("1a"), value));
+    assertFalse(HAPayloadParser::parseInteger(parse("1.5"), value));
+    assertFalse(HAPayloadParser::parseInteger(parse("2147483648"), value));
+    assertFalse(HAPayloadParser::parseInteger(parse("-2147483649"), value));
+    assertFalse(HAPayloadParser::parseInteger(parse("99999999999999999999"), value));
+    assertFalse(HAPayloadParser::parseInteger(nullptr, 0, value));
+    assertEqual((int32_t)5, value);
+}
+
+test(PayloadParserTest, integer_range) {
+    int32_t value = 5;
+
+    assertTrue(HAPayloadParser::parseInteger(parse("0"), value, 0, 100));
+    assertEqual((int32_t)0, value);
+    assertTrue(HAPayloadParser::parseInteger(parse("100"), value, 0, 100));
+    assertEqual((int32_t)100, value);
+    assertFalse(HAPayloadParser::parseInteger(parse("101"), value, 0, 100));
+    assertFalse(HAPayloadParser::parseInteger(parse("-1"), value, 0, 100));
+    assertEqual((int32_t)100, value);
+}
+
+test(PayloadParserTest, bool) {
+    bool value = false;
+
+    assertTrue(HAPayloadParser::parseBool(parse("ON"), value));
+    assertTrue(value);
+    assertTrue(HAPayloadParser::parseBool(parse("off"), value));
+    assertFalse(value);
+    assertTrue(HAPayloadParser::parseBool(parse("On"), value));
+    assertTrue(value);
+    assertTrue(HAPayloadParser::parseBool(parse("OFF"), value));
+    assertFalse(value);
+}
+
+test(PayloadParserTest, bool_invalid) {
+    bool value = true;
+
+    assertFalse(HAPayloadParser::parseBool(parse("OK"), value));
+    assertFalse(HAPayloadParser::parseBool(parse("O"), value));
+    assertFalse(HAPayloadParser::parseBool(parse("ONN"), value));
+    assertFalse(HAPayloadParser::parseBool(parse("OF"), value));
+    assertFalse(HAPayloadParser::parseBool(parse(""), value));
+    assertFalse(HAPayloadParser::parseBool(parse("1"), value));
+    assertTrue(value);
+}
+
+test(PayloadParserTest, enum) {
+    assertEqual((uint8_t)0, HAPayloadParser::parseEnum(parse("OPEN"), coverCommands, 3));
+    assertEqual((uint8_t)1, HAPayloadParser::parseEnum(parse("CLOSE"), coverCommands, 3));
+    assertEqual((uint8_t)2, HAPayloadParser::parseEnum(parse("STOP"), coverCommands, 3));
+}
+
+test(PayloadParserTest, enum_invalid) {
+    assertEqual((uint8_t)HAPayloadParser::NoMatch, HAPayloadParser::parseEnum(parse("open"), coverCommands, 3));
+    assertEqual((uint8_t)HAPayloadParser::NoMatch, HAPayloadParser::parseEnum(parse("OPE"), coverCommands, 3));
+    assertEqual((uint8_t)HAPayloadParser::NoMatch, HAPayloadParser::parseEnum(parse("OPENED"), coverCommands, 3));
+    assertEqual((uint8_t)HAPayloadParser::NoMatch, HAPayloadParser::parseEnum(parse(""), coverCommands, 3));
+    assertEqual((uint8_t)HAPayloadParser::NoMatch, HAPayloadParser::parseEnum(parse("STOP"), coverCommands, 2));
+}
+
+test(PayloadParserTest, equals) {
+    assertTrue(HAPayloadParser::equals(parse("LOCK"), HALockCommand));
+    assertFalse(HAPayloadParser::equals(parse("lock"), HALockCommand));
+    assertTrue(HAPayloadParser::equals(parse("lock"), HALockCommand, true));
+    assertFalse(HAPayloadParser::equals(parse("LOCKS"), HALockCommand, true));
+    assertFalse(HAPayloadParser::equals(parse("LOCK"), nullptr));
+}
+
+test(PayloadParserTest, fuzz_process_message) {
+    initMqttTest(testDeviceId)
+
+    HASwitch relay("relay");
+    HALock door("door");
+    HACover blind("blind");
+    relay.onCommand(onSwitchCommand);
+    relay.setStateRestore(true);
+    door.onCommand(onLockCommand);
+    door.setStateRestore(true);
+    blind.onCommand(onCoverCommand);
+    blind.onPositionCommand(onPositionCommand);
+    blind.setStateRestore(true);
+    mqtt.loop();
+
+    randomState = 0x2545F491;
+    switchCallsNb = 0;
+    lockCallsNb = 0;
+    coverCallsNb = 0;
+    positionCallsNb = 0;
+    invalidCallback = false;
+
+    uint16_t expectedSwitchCallsNb = 0;
+    uint16_t expectedPositionCallsNb = 0;
+    uint8_t buffer[32];
+
+    for (uint16_t i = 0; i < fuzzMessagesNb; i++) {
+        const uint8_t topicIndex = nextRandom() % (sizeof(fuzzTopics) / sizeof(fuzzTopics[0]));
+        const uint16_t length = generatePayload(buffer, sizeof(buffer));
+
+        // exact size of the allocation lets the sanitizer catch reads past the payload
+        uint8_t* payload = new uint8_t[length > 0 ? length : 1];
+        memcpy(payload, buffer, length);
+
+        if (topicIndex == 0 && isSwitchCommand(payload, length)) {
+            expectedSwitchCallsNb++;
+        } else if (topicIndex == 7 && isPositionCommand(payload, length)) {
+            expectedPositionCallsNb++;
+        }
+
+        mqtt.processMessage(fuzzTopics[topicIndex], payload, length);
+        delete[] payload;
+    }
+
+    assertFalse(invalidCallback);
+    assertEqual(expectedSwitchCallsNb, switchCallsNb);
+    assertEqual(expectedPositionCallsNb, positionCallsNb);
+    assertTrue(lockCallsNb > 0);
+    assertTrue(coverCallsNb > 0);
+    assertTrue(expectedSwitchCallsNb > 0);
+    assertTrue(expectedPositionCallsNb > 0);
+}
+
+test(PayloadParserTest, benchmark) {
+    initMqttTest(testDeviceId)
+
+    HASwitch relay("relay");
+    HALock door("door");
+    HACover blind("blind");
+    relay.onCommand(onSwitchCommand);
+    door.onCommand(onLockCommand);
+    blind.onPositionCommand(onPositionCommand);
+    mqtt.loop();
+
+    static const struct {
+        const char* topic;
+        const char* payload;
+    } messages[] = {
+        {"testData/testDevice/relay/cmd_t", "OFF"},
+        {"testData/testDevice/door/cmd_t", "UNLOCK"},
+        {"testData/testDevice/blind/set_pos_t", "100"}
+    };
+
+    for (uint8_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++) {
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(messages[i].payload);
+        const uint16_t length = strlen(messages[i].payload);
+
+        const uint32_t startedAt = micros();
+        for (uint16_t j = 0; j < benchmarkMessagesNb; j++) {
+            mqtt.processMessage(messages[i].topic, payload, length);
+        }
+
+        const uint32_t duration = micros() - startedAt;
+        Serial.print(messages[i].topic);
+        Serial.print(F(" \""));
+        Serial.print(messages[i].payload);
+        Serial.print(F("\": "));
+        Serial.print(duration * 1000UL / benchmarkMessagesNb);
+        Serial.println(F(" ns per message"));
+    }
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
@@ -391,6 +391,118 @@ test(SensorFloatTest, publish_force) {
     assertTrue(result);
 }
 
+test(SensorFloatTest, publish_debounce_quantized) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP1);
+    sensor.setCurrentValue(21.51);
+    bool result = sensor.setValue(21.5399); // renders as 215 too
+
+    assertEqual(mock->getFlushedMessagesNb(), 0);
+    assertTrue(result);
+}
+
+test(SensorFloatTest, publish_hysteresis_suppressed) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP2);
+    sensor.setHysteresis(5);
+    sensor.setCurrentValue(10.0);
+    bool result = sensor.setValue(10.05);
+
+    assertEqual(mock->getFlushedMessagesNb(), 0);
+    assertTrue(result);
+    assertTrue(sensor.setValue(9.95));
+    assertEqual(mock->getFlushedMessagesNb(), 0);
+}
+
+test(SensorFloatTest, publish_hysteresis_exceeded) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP2);
+    sensor.setHysteresis(5);
+    sensor.setCurrentValue(10.0);
+    bool result = sensor.setValue(10.07);
+
+    assertSingleMqttMessage(stateTopic, "1007", true)
+    assertTrue(result);
+}
+
+test(SensorFloatTest, publish_hysteresis_force) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP2);
+    sensor.setHysteresis(5);
+    sensor.setCurrentValue(10.0);
+    bool result = sensor.setValue(10.01, true);
+
+    assertSingleMqttMessage(stateTopic, "1001", true)
+    assertTrue(result);
+}
+
+test(SensorFloatTest, config_decimal_mode) {
+    initMqttTest(testDeviceId)
+
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP2);
+    sensor.setDecimalMode(true);
+    assertEntityConfig(
+        mock,
+        sensor,
+        "{\"uniq_id\":\"uniqueSensor\",\"dev\":{\"ids\":\"testDevice\"},\"stat_t\":\"testData/testDevice/uniqueSensor/stat_t\"}"
+    )
+}
+
+test(SensorFloatTest, decimal_mode_keeps_custom_template) {
+    initMqttTest(testDeviceId)
+
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP2);
+    sensor.setValueTemplate("{{value_json.temp}}");
+    sensor.setDecimalMode(true);
+    assertStringCaseEqual("{{value_json.temp}}", sensor.getValueTemplate());
+
+    sensor.setDecimalMode(false);
+    assertStringCaseEqual("{{value_json.temp}}", sensor.getValueTemplate());
+}
+
+test(SensorFloatTest, decimal_mode_toggles_default_template) {
+    initMqttTest(testDeviceId)
+
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP2);
+    sensor.setDecimalMode(true);
+    assertTrue(sensor.getValueTemplate() == nullptr);
+
+    sensor.setDecimalMode(false);
+    assertTrue(sensor.getValueTemplate() == HAValueTemplateFloatP2);
+}
+
+test(SensorFloatTest, publish_decimal_mode) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP2);
+    sensor.setDecimalMode(true);
+    bool result = sensor.setValue(-0.5);
+
+    assertSingleMqttMessage(stateTopic, "-0.50", true)
+    assertTrue(result);
+}
+
+test(SensorFloatTest, publish_decimal_mode_p0) {
+    initMqttTest(testDeviceId)
+
+    mock->connectDummy();
+    HASensorFloat sensor(testUniqueId, HASensorFloat::PrecisionP0);
+    sensor.setDecimalMode(true);
+    bool result = sensor.setValue(17.6);
+
+    assertSingleMqttMessage(stateTopic, "17", true)
+    assertTrue(result);
+}
+
 void setup()
 {
     Serial.begin(115200);
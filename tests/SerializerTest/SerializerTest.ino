@@ -15,10 +15,10 @@
 #define assertSerializerMqttMessage(expectedJson) \
     assertSingleMqttMessage(testTopic, expectedJson, false)
 
-class DummyDeviceType : public BaseDeviceType
+class DummyDeviceType : public HABaseDeviceType
 {
 public:
-    DummyDeviceType(): BaseDeviceType("testComponent", "testId") { }
+    DummyDeviceType(): HABaseDeviceType("testComponent", "testId") { }
 
 protected:
     virtual void onMqttConnected() override { }
@@ -225,6 +225,18 @@ test(SerializerTest, mixed_elements) {
     assertSerializerMqttMessage("{\"dev_cla\":[\"dev\",\"ic\"],\"avty_t\":\"testData/testDevice/testId/avty_t\",\"dev\":{\"ids\":\"testDevice\"},\"name\":\"TestName\",\"stat_t\":\"testData/testDevice/testId/stat_t\",\"ic\":312346733}")
 }
 
+test(SerializerTest, entries_limit) {
+    prepareTest(1)
+
+    serializer.set(HANameProperty, "TestName");
+    serializer.set(HADeviceClassProperty, "Class");
+    serializer.topic(HAStateTopic);
+    assertEqual((uint8_t)1, serializer.getEntriesNb());
+
+    flushSerializer(mock, serializer)
+    assertSerializerMqttMessage("{\"name\":\"TestName\"}")
+}
+
 void setup()
 {
     Serial.begin(115200);
@@ -13,11 +13,12 @@ void clearTmpBuffer() {
     memset(tmpBuffer, 0, sizeof(tmpBuffer));
 }
 
-test(SerializerTopicsTest, calculate_config_no_mqtt) {
-    // it should return 0 if there is no HAMqtt instance (singleton)
+test(SerializerTopicsTest, calculate_config_no_context) {
+    // it should return 0 if there is no context
     assertEqual(
         (uint16_t)0,
         HASerializer::calculateConfigTopicLength(
+            nullptr,
             "componentName",
             "objectId"
         )
@@ -32,6 +33,7 @@ test(SerializerTopicsTest, calculate_config_invalid_component) {
     assertEqual(
         (uint16_t)0,
         HASerializer::calculateConfigTopicLength(
+            &mqtt.getContext(),
             nullptr,
             "objectId"
         )
@@ -46,6 +48,7 @@ test(SerializerTopicsTest, calculate_config_invalid_object) {
     assertEqual(
         (uint16_t)0,
         HASerializer::calculateConfigTopicLength(
+            &mqtt.getContext(),
             "componentName",
             nullptr
         )
@@ -61,6 +64,7 @@ test(SerializerTopicsTest, calculate_config_invalid_prefix) {
     assertEqual(
         (uint16_t)0,
         HASerializer::calculateConfigTopicLength(
+            &mqtt.getContext(),
             "componentName",
             "objectId"
         )
@@ -80,17 +84,19 @@ test(SerializerTopicsTest, calculate_config) {
     assertEqual(
         (uint16_t)(strlen(expectedTopic) + 1),
         HASerializer::calculateConfigTopicLength(
+            &mqtt.getContext(),
             componentName,
             objectId
         )
     );
 }
 
-test(SerializerTopicsTest, generate_config_no_mqtt) {
+test(SerializerTopicsTest, generate_config_no_context) {
     clearTmpBuffer();
 
-    // it should return false if there is no HAMqtt instance (singleton)
+    // it should return false if there is no context
     assertFalse(HASerializer::generateConfigTopic(
+        nullptr,
         tmpBuffer,
         "componentName",
         "objectId"
@@ -105,6 +111,7 @@ test(SerializerTopicsTest, generate_config_invalid_component) {
 
     // it should return false if componentName is null
     assertFalse(HASerializer::generateConfigTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         nullptr,
         "objectId"
@@ -119,6 +126,7 @@ test(SerializerTopicsTest, generate_config_invalid_object) {
 
     // it should return false if objectId is null
     assertFalse(HASerializer::generateConfigTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         "componentName",
         nullptr
@@ -134,6 +142,7 @@ test(SerializerTopicsTest, generate_config_invalid_prefix) {
 
     // it should return false if discovery prefix is null
     assertFalse(HASerializer::generateConfigTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         "componentName",
         "objectId"
@@ -153,6 +162,7 @@ test(SerializerTopicsTest, generate_config) {
 
     // it should generate valid topic
     assertTrue(HASerializer::generateConfigTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         componentName,
         objectId
@@ -160,11 +170,12 @@ test(SerializerTopicsTest, generate_config) {
     assertStringCaseEqual(expectedTopic, tmpBuffer);
 }
 
-test(SerializerTopicsTest, calculate_data_no_mqtt) {
-    // it should return 0 if there is no HAMqtt instance (singleton)
+test(SerializerTopicsTest, calculate_data_no_context) {
+    // it should return 0 if there is no context
     assertEqual(
         (uint16_t)0,
         HASerializer::calculateDataTopicLength(
+            nullptr,
             "objectId",
             DummyProgmemStr
         )
@@ -180,6 +191,7 @@ test(SerializerTopicsTest, calculate_data_invalid_topic) {
     assertEqual(
         (uint16_t)0,
         HASerializer::calculateDataTopicLength(
+            &mqtt.getContext(),
             "objectId",
             nullptr
         )
@@ -195,6 +207,7 @@ test(SerializerTopicsTest, calculate_data_invalid_prefix) {
     assertEqual(
         (uint16_t)0,
         HASerializer::calculateDataTopicLength(
+            &mqtt.getContext(),
             "objectId",
             DummyProgmemStr
         )
@@ -213,17 +226,19 @@ test(SerializerTopicsTest, calculate_data_partial) {
     assertEqual(
         (uint16_t)strlen(expectedTopic) + 1,
         HASerializer::calculateDataTopicLength(
+            &mqtt.getContext(),
             objectId,
             DummyProgmemStr
         )
     );
 }
 
-test(SerializerTopicsTest, generate_data_no_mqtt) {
+test(SerializerTopicsTest, generate_data_no_context) {
     clearTmpBuffer();
 
-    // it should return false if there is no HAMqtt instance (singleton)
+    // it should return false if there is no context
     assertFalse(HASerializer::generateDataTopic(
+        nullptr,
         tmpBuffer,
         "objectId",
         DummyProgmemStr
@@ -238,6 +253,7 @@ test(SerializerTopicsTest, generate_data_invalid_topic) {
 
     // it should return false if topicP is null
     assertFalse(HASerializer::generateDataTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         "objectId",
         nullptr
@@ -253,6 +269,7 @@ test(SerializerTopicsTest, generate_data_invalid_prefix) {
 
     // it should return false if data prefix is null
     assertFalse(HASerializer::generateDataTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         "objectId",
         DummyProgmemStr
@@ -271,6 +288,7 @@ test(SerializerTopicsTest, generate_data_partial) {
 
     // it should generate valid partial data topic (without objectId)
     assertTrue(HASerializer::generateDataTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         objectId,
         DummyProgmemStr
@@ -289,6 +307,7 @@ test(SerializerTopicsTest, generate_data_full) {
 
     // it should generate valid full data topic
     assertTrue(HASerializer::generateDataTopic(
+        &mqtt.getContext(),
         tmpBuffer,
         objectId,
         DummyProgmemStr
@@ -305,6 +324,7 @@ test(SerializerTopicsTest, compare_invalid_topic) {
     mqtt.setDataPrefix(dataPrefix);
 
     assertFalse(HASerializer::compareDataTopics(
+        &mqtt.getContext(),
         topic,
         objectId,
         DummyProgmemStr
@@ -320,6 +340,7 @@ test(SerializerTopicsTest, compare_matching_topics) {
     mqtt.setDataPrefix(dataPrefix);
 
     assertTrue(HASerializer::compareDataTopics(
+        &mqtt.getContext(),
         topic,
         objectId,
         DummyProgmemStr
@@ -335,6 +356,7 @@ test(SerializerTopicsTest, compare_not_matching_topics) {
     mqtt.setDataPrefix(dataPrefix);
 
     assertFalse(HASerializer::compareDataTopics(
+        &mqtt.getContext(),
         topic,
         objectId,
         DummyProgmemStr
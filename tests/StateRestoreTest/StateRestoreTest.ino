@@ -0,0 +1,243 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+#define prepareTest \
+    HAUtils::setSimulatedTime(startTime); \
+    initMqttTest(testDeviceId) \
+    restoredCallbacksNb = 0; \
+    mqtt.onStatesRestored(onStatesRestored);
+
+#define finishRestore() \
+    HAUtils::advanceSimulatedTime(HAMqtt::DefaultStateRestoreTimeout); \
+    mqtt.loop();
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* switchStateTopic = "testData/testDevice/relay/stat_t";
+static const char* lockStateTopic = "testData/testDevice/lock/stat_t";
+static const char* coverStateTopic = "testData/testDevice/cover/stat_t";
+static const char* coverPositionTopic = "testData/testDevice/cover/pos_t";
+static const uint32_t startTime = 1000;
+static uint8_t restoredCallbacksNb = 0;
+
+void onStatesRestored()
+{
+    restoredCallbacksNb++;
+}
+
+static bool isSubscribed(PubSubClientMock* mock, const char* topic)
+{
+    for (uint8_t i = 0; i < mock->getSubscriptionsNb(); i++) {
+        if (strcmp(mock->getSubscriptions()[i].topic, topic) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+test(StateRestoreTest, disabled_by_default) {
+    prepareTest
+
+    HASwitch relay("relay");
+    mqtt.loop();
+
+    assertFalse(mqtt.isRestoringStates());
+    assertFalse(isSubscribed(mock, switchStateTopic));
+    assertMqttMessage(1, switchStateTopic, "OFF", true)
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, switch_waits_for_retained_state) {
+    prepareTest
+
+    HASwitch relay("relay");
+    relay.setStateRestore(true);
+    mqtt.loop();
+
+    assertTrue(mqtt.isRestoringStates());
+    assertTrue(isSubscribed(mock, switchStateTopic));
+    assertEqual((uint8_t)1, mock->getFlushedMessagesNb()); // config only
+    assertEqual((uint32_t)HAMqtt::DefaultStateRestoreTimeout, mqtt.getIdleTimeout());
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, switch_restored) {
+    prepareTest
+
+    HASwitch relay("relay");
+    relay.setStateRestore(true);
+    mqtt.loop();
+    mock->fakeMessage(switchStateTopic, "on");
+
+    assertTrue(relay.getCurrentState());
+    assertFalse(isSubscribed(mock, switchStateTopic));
+
+    mock->clearFlushedMessages();
+    finishRestore()
+    assertFalse(mqtt.isRestoringStates());
+    assertEqual((uint8_t)1, restoredCallbacksNb);
+    assertNoMqttMessage()
+
+    // the restored state is not published again
+    assertTrue(relay.setState(true));
+    assertNoMqttMessage()
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, switch_not_retained) {
+    prepareTest
+
+    HASwitch relay("relay");
+    relay.setStateRestore(true);
+    relay.setCurrentState(true);
+    mqtt.loop();
+    mock->fakeMessage(switchStateTopic, "invalid");
+    mock->clearFlushedMessages();
+
+    finishRestore()
+    assertFalse(isSubscribed(mock, switchStateTopic));
+    assertSingleMqttMessage(switchStateTopic, "ON", true)
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, switch_set_state_stops_restore) {
+    prepareTest
+
+    HASwitch relay("relay");
+    relay.setStateRestore(true);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    // the state is published even though it's the same as the current one
+    assertTrue(relay.setState(false));
+    assertSingleMqttMessage(switchStateTopic, "OFF", true)
+    assertFalse(isSubscribed(mock, switchStateTopic));
+
+    mock->clearFlushedMessages();
+    mock->fakeMessage(switchStateTopic, "on");
+    finishRestore()
+    assertFalse(relay.getCurrentState());
+    assertNoMqttMessage()
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, lock_restored) {
+    prepareTest
+
+    HALock lock("lock");
+    lock.setStateRestore(true);
+    mqtt.loop();
+    mock->fakeMessage(lockStateTopic, "unlocked");
+    mock->clearFlushedMessages();
+    finishRestore()
+
+    assertEqual(HALock::StateUnlocked, lock.getCurrentState());
+    assertFalse(isSubscribed(mock, lockStateTopic));
+    assertNoMqttMessage()
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, cover_restored) {
+    prepareTest
+
+    HACover cover("cover");
+    cover.setStateRestore(true);
+    mqtt.loop();
+    assertTrue(isSubscribed(mock, coverStateTopic));
+    assertTrue(isSubscribed(mock, coverPositionTopic));
+
+    mock->fakeMessage(coverStateTopic, "opening");
+    mock->fakeMessage(coverPositionTopic, "-45");
+    mock->clearFlushedMessages();
+    finishRestore()
+
+    assertEqual(HACover::StateOpening, cover.getCurrentState());
+    assertEqual((int16_t)-45, cover.getCurrentPosition());
+    assertFalse(isSubscribed(mock, coverStateTopic));
+    assertFalse(isSubscribed(mock, coverPositionTopic));
+    assertNoMqttMessage()
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, cover_partially_restored) {
+    prepareTest
+
+    HACover cover("cover");
+    cover.setStateRestore(true);
+    cover.setCurrentPosition(80);
+    mqtt.loop();
+
+    mock->fakeMessage(coverStateTopic, "closed");
+    mock->fakeMessage(coverPositionTopic, "40000"); // out of range
+    mock->fakeMessage(coverPositionTopic, "1a");
+    mock->clearFlushedMessages();
+    finishRestore()
+
+    assertEqual(HACover::StateClosed, cover.getCurrentState());
+    assertEqual((int16_t)80, cover.getCurrentPosition());
+    assertSingleMqttMessage(coverPositionTopic, "80", true)
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, reconnect_restarts_restore) {
+    prepareTest
+
+    HASwitch relay("relay");
+    relay.setStateRestore(true);
+    mqtt.loop();
+    finishRestore()
+    assertFalse(mqtt.isRestoringStates());
+
+    mock->disconnect();
+    HAUtils::advanceSimulatedTime(HAMqtt::ReconnectInterval);
+    mqtt.loop();
+    assertTrue(mqtt.isConnected());
+    assertTrue(mqtt.isRestoringStates());
+    HAUtils::disableSimulatedTime();
+}
+
+test(StateRestoreTest, reboot_without_flapping) {
+    BrokerMock broker;
+    HADevice device(testDeviceId);
+
+    // the switch was turned on before the reboot
+    {
+        BrokerClientMock transport(broker);
+        HAMqtt mqtt(transport, device);
+        HASwitch relay("relay");
+        mqtt.begin("testHost");
+        mqtt.loop();
+        relay.setState(true);
+        mqtt.disconnect();
+    }
+
+    const uint32_t publishedNb = broker.getStats().publishedNb;
+    BrokerClientMock transport(broker);
+    HAMqtt mqtt(transport, device);
+    HASwitch relay("relay");
+    relay.setStateRestore(true);
+    mqtt.begin("testHost");
+    mqtt.loop();
+    mqtt.loop();
+
+    assertTrue(relay.getCurrentState());
+    assertEqual((uint32_t)1, broker.getStats().publishedNb - publishedNb); // config only
+
+    const BrokerRetainedMessage* state = broker.getRetained("aha/testDevice/relay/stat_t");
+    assertEqual((uint16_t)2, state->length);
+    assertEqual(0, memcmp(state->payload, "on", 2));
+}
+
+void setup()
+{
+    delay(1000);
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+}
@@ -230,6 +230,18 @@ test(SwitchTest, command_off) {
     assertCallback(true, false, &testSwitch)
 }
 
+test(SwitchTest, command_invalid) {
+    prepareTest
+
+    HASwitch testSwitch(testUniqueId);
+    testSwitch.onCommand(onCommandReceived);
+    mock->fakeMessage(commandTopic, "OK"); // the same length as "ON"
+    mock->fakeMessage(commandTopic, "ONE");
+    mock->fakeMessage(commandTopic, "");
+
+    assertCallback(false, false, nullptr)
+}
+
 test(SwitchTest, different_switch_command) {
     prepareTest
 
@@ -0,0 +1,209 @@
+#include <AUnit.h>
+#include <ArduinoHA.h>
+
+using aunit::TestRunner;
+
+static const char* testDeviceId = "testDevice";
+static const char* testUniqueId = "uniqueSensor";
+static const char* stateTopic = "testData/testDevice/uniqueSensor/stat_t";
+
+test(TopicAliasesTest, find_empty) {
+    HATopicAliases aliases(2);
+
+    assertEqual((uint16_t)0, aliases.find("topic"));
+    assertEqual((uint16_t)0, aliases.find(nullptr));
+}
+
+test(TopicAliasesTest, assign) {
+    HATopicAliases aliases(2);
+
+    assertEqual((uint16_t)1, aliases.assign("topic1"));
+    assertEqual((uint16_t)2, aliases.assign("topic2"));
+    assertEqual((uint16_t)1, aliases.find("topic1"));
+    assertEqual((uint16_t)2, aliases.find("topic2"));
+    assertEqual((uint16_t)2, aliases.getAliasesNb());
+}
+
+test(TopicAliasesTest, assign_full) {
+    HATopicAliases aliases(1);
+
+    assertEqual((uint16_t)1, aliases.assign("topic1"));
+    assertEqual((uint16_t)0, aliases.assign("topic2"));
+    assertEqual((uint16_t)0, aliases.find("topic2"));
+}
+
+test(TopicAliasesTest, assign_copies_topic) {
+    HATopicAliases aliases(1);
+    char topic[] = {"topic1"};
+
+    aliases.assign(topic);
+    topic[0] = 'x';
+
+    assertEqual((uint16_t)1, aliases.find("topic1"));
+}
+
+test(TopicAliasesTest, clear) {
+    HATopicAliases aliases(2);
+
+    aliases.assign("topic1");
+    aliases.clear();
+
+    assertEqual((uint16_t)0, aliases.getAliasesNb());
+    assertEqual((uint16_t)0, aliases.find("topic1"));
+    assertEqual((uint16_t)1, aliases.assign("topic2"));
+}
+
+test(TopicAliasesTest, release) {
+    HATopicAliases aliases(2);
+
+    aliases.assign("topic1");
+    aliases.assign("topic2");
+
+    assertFalse(aliases.release(1)); // only the last alias can be released
+    assertFalse(aliases.release(0));
+    assertTrue(aliases.release(2));
+    assertEqual((uint16_t)1, aliases.getAliasesNb());
+    assertEqual((uint16_t)0, aliases.find("topic2"));
+    assertEqual((uint16_t)2, aliases.assign("topic3"));
+}
+
+test(TopicAliasesTest, mqtt_disabled_by_default) {
+    initMqttTest(testDeviceId)
+
+    assertFalse(mqtt.isTopicAliasesEnabled());
+    assertTrue(mqtt.enableTopicAliases(10));
+    assertTrue(mqtt.isTopicAliasesEnabled());
+    assertFalse(mqtt.enableTopicAliases(10)); // already enabled
+}
+
+test(TopicAliasesTest, first_publish_assigns_alias) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableTopicAliases(10);
+    HASensorInteger sensor(testUniqueId);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(sensor.setValue(10));
+    assertSingleMqttMessage(stateTopic, "10", true)
+    assertEqual((uint16_t)1, mock->getFlushedMessages()[0].topicAlias);
+}
+
+test(TopicAliasesTest, failed_publish_releases_alias) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableTopicAliases(10);
+    HASensorInteger sensor(testUniqueId);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    // the topic is published with the alias 1 on connect, so the next one gets 2
+    HASensorInteger other("otherSensor");
+    mock->disconnect();
+    assertFalse(other.setValue(10));
+
+    mock->connectDummy();
+    assertTrue(other.setValue(10));
+    assertSingleMqttMessage("testData/testDevice/otherSensor/stat_t", "10", true)
+    assertEqual((uint16_t)2, mock->getFlushedMessages()[0].topicAlias);
+}
+
+test(TopicAliasesTest, config_is_not_aliased) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableTopicAliases(10);
+    HASensorInteger sensor(testUniqueId);
+    mqtt.loop();
+
+    // config + state published on connect
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertEqual((uint16_t)0, mock->getFlushedMessages()[0].topicAlias);
+    assertEqual((uint16_t)1, mock->getFlushedMessages()[1].topicAlias);
+    assertEqual((uint16_t)1, mock->getTopicAliasesNb());
+}
+
+test(TopicAliasesTest, next_publish_uses_alias) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableTopicAliases(10);
+    HASensorInteger sensor(testUniqueId);
+    mqtt.loop();
+    mock->clearFlushedMessages();
+
+    assertTrue(sensor.setValue(10));
+    assertTrue(sensor.setValue(20));
+
+    // the mock resolves the zero-length topic using the alias mapping
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(1, stateTopic, "20", true)
+    assertEqual((uint16_t)1, mock->getFlushedMessages()[1].topicAlias);
+}
+
+test(TopicAliasesTest, aliases_reset_on_reconnect) {
+    initMqttTest(testDeviceId)
+
+    mqtt.enableTopicAliases(1);
+    HASensorInteger sensor(testUniqueId);
+    mqtt.loop();
+
+    mock->disconnect();
+    mqtt.disconnect();
+    mqtt.begin("testHost", "testUser", "testPass");
+    mock->clearFlushedMessages();
+    mqtt.loop();
+
+    // the topic is sent again with the same alias
+    assertEqual(2, mock->getFlushedMessagesNb());
+    assertMqttMessage(1, stateTopic, "0", true)
+    assertEqual((uint16_t)1, mock->getFlushedMessages()[1].topicAlias);
+}
+
+test(TopicAliasesTest, bytes_on_wire_savings) {
+    static const uint8_t updatesNb = 20;
+    uint32_t plainBytesNb = 0;
+    uint32_t aliasedBytesNb = 0;
+
+    {
+        initMqttTest(testDeviceId)
+
+        mock->connectDummy();
+        HASensorInteger sensor(testUniqueId);
+        for (uint8_t i = 1; i <= updatesNb; i++) {
+            sensor.setValue(i);
+        }
+
+        plainBytesNb = mock->getPublishedBytesNb();
+    }
+
+    {
+        initMqttTest(testDeviceId)
+
+        mqtt.enableTopicAliases(10);
+        mock->connectDummy();
+        HASensorInteger sensor(testUniqueId);
+        for (uint8_t i = 1; i <= updatesNb; i++) {
+            sensor.setValue(i);
+        }
+
+        aliasedBytesNb = mock->getPublishedBytesNb();
+    }
+
+    // each aliased publish saves the topic (39 bytes) but costs 4 bytes of properties
+    const uint32_t topicLength = strlen(stateTopic);
+    assertEqual(
+        plainBytesNb - aliasedBytesNb,
+        (updatesNb - 1) * topicLength - updatesNb * 4
+    );
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+}
+
+void loop()
+{
+    TestRunner::run();
+    delay(1);
+}
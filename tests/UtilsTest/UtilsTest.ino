@@ -8,6 +8,14 @@
     assertStringCaseEqual(F(expectedStr), tmpBuffer); \
 }
 
+#define decimalToStrAssert(value, precision, expectedStr) \
+{ \
+    memset(tmpBuffer, 0, sizeof(tmpBuffer)); \
+    HAUtils::decimalToStr(tmpBuffer, value, precision); \
+    assertStringCaseEqual(F(expectedStr), tmpBuffer); \
+    assertEqual(strlen(expectedStr), (size_t)HAUtils::calculateDecimalSize(value, precision)); \
+}
+
 using aunit::TestRunner;
 
 char tmpBuffer[32];
@@ -73,6 +81,11 @@ test(UtilsTest, calculate_number_unsigned_large) {
     assertEqual(6, HAUtils::calculateNumberSize(864564));
 }
 
+test(UtilsTest, calculate_number_min) {
+    // expects "-2147483648"
+    assertEqual(11, HAUtils::calculateNumberSize(INT32_MIN));
+}
+
 test(UtilsTest, number_to_str_zero) {
     numberToStrAssert(0, "0");
 }
@@ -93,6 +106,46 @@ test(UtilsTest, number_to_str_unsigned_large) {
     numberToStrAssert(864564, "864564");
 }
 
+test(UtilsTest, number_to_str_min) {
+    numberToStrAssert(INT32_MIN, "-2147483648");
+}
+
+test(UtilsTest, decimal_to_str_no_precision) {
+    decimalToStrAssert(-864564, 0, "-864564");
+}
+
+test(UtilsTest, decimal_to_str_zero) {
+    decimalToStrAssert(0, 2, "0.00");
+}
+
+test(UtilsTest, decimal_to_str_unsigned) {
+    decimalToStrAssert(2153, 2, "21.53");
+}
+
+test(UtilsTest, decimal_to_str_signed) {
+    decimalToStrAssert(-2153, 1, "-215.3");
+}
+
+test(UtilsTest, decimal_to_str_leading_zeros) {
+    decimalToStrAssert(5, 3, "0.005");
+}
+
+test(UtilsTest, decimal_to_str_signed_leading_zeros) {
+    decimalToStrAssert(-5, 2, "-0.05");
+}
+
+test(UtilsTest, decimal_to_str_min) {
+    decimalToStrAssert(INT32_MIN, 4, "-214748.3648");
+}
+
+test(UtilsTest, dictionary_length) {
+    static_assert(HADictionaryLength(HAStateTopic) == 6, "compile-time length");
+
+    assertEqual(strlen_P(HASerializerSlash), (size_t)HADictionaryLength(HASerializerSlash));
+    assertEqual(strlen_P(HAUniqueIdProperty), (size_t)HADictionaryLength(HAUniqueIdProperty));
+    assertEqual(strlen_P(HAValueTemplateFloatP4), (size_t)HADictionaryLength(HAValueTemplateFloatP4));
+}
+
 void setup()
 {
     Serial.begin(115200);